@@ -40,12 +40,19 @@ LineGraph::LineGraph(ViewDisplay display) : View(display)
 	_slateProSub = NULL;
 	_slateProLight = NULL;
 
+	_axes = new DisplayList();
+	_axesWidth = 0;
+	_axesHeight = 0;
+	_legend = new DisplayList();
+	_legendWidth = 0;
+
 	// register graphics with base class
 	registerGraphics(_graphics2D);
 }
 
 LineGraph::~LineGraph() {
-	// TODO Auto-generated destructor stub
+	delete _axes;
+	delete _legend;
 }
 
 void LineGraph::update()
@@ -70,14 +77,8 @@ void LineGraph::onRegenerated()
 			_slateProMedium = _graphics2D->createFont(FONT_NAME_SLATE_PRO_LIGHT, NULL, 10, calculateDPI(), new QString("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-,()%0123456789 eE"));
 		}
 
-		// pie slices plus labels
 		double textWidth = 0.0, textHeight = 0.0;
 
-		_graphics2D->setFont(_slatePro);
-		QString titleText("Sample Line Graph");
-		_graphics2D->measureString(titleText, &textWidth, &textHeight);
-		_graphics2D->drawString(titleText, (_width - textWidth) / 2.0, (_height - 100.0));
-
 		double xMarkerValues[9] = { 0.0, 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0 };
 		double yMarkerValues[4] = { 0.0, 50.0, 100.0, 150.0 };
 
@@ -90,76 +91,92 @@ void LineGraph::onRegenerated()
 
 		double originX = 150.0, originY = 350.0, xScale = 500.0 / 4.0, yScale = 550.0 / 160.0;
 
+		// the title and axes only change with the size of the view, so they are captured once and replayed
+		if (_axes->isEmpty() || _axesWidth != _width || _axesHeight != _height) {
+			_graphics2D->beginDisplayList(_axes);
 
-		// markers and labels for axes
-		for (int index = 0; index < 9; index++) {
-			double markerX = originX + xMarkerValues[index] * xScale;
-
-			if (index > 0 && !(index & 1)) {
-				for (int index1 = 1; index1 < 4; index1++) {
-					double markerX1 = originX + (xMarkerValues[index-2] + index1 / 4.0) * xScale;
-					_graphics2D->setColor(COLOR_GREY);
-					_graphics2D->setStroke(_thinStroke);
-					_graphics2D->drawLine(markerX1, originY, markerX1, originY + 15.0);
+			_graphics2D->setFont(_slatePro);
+			QString titleText("Sample Line Graph");
+			_graphics2D->measureString(titleText, &textWidth, &textHeight);
+			_graphics2D->drawString(titleText, (_width - textWidth) / 2.0, (_height - 100.0));
+
+
+			// markers and labels for axes
+			for (int index = 0; index < 9; index++) {
+				double markerX = originX + xMarkerValues[index] * xScale;
+
+				if (index > 0 && !(index & 1)) {
+					for (int index1 = 1; index1 < 4; index1++) {
+						double markerX1 = originX + (xMarkerValues[index-2] + index1 / 4.0) * xScale;
+						_graphics2D->setColor(COLOR_GREY);
+						_graphics2D->setStroke(_thinStroke);
+						_graphics2D->drawLine(markerX1, originY, markerX1, originY + 15.0);
+					}
+				}
+
+				if (!(index & 1)) {
+					_graphics2D->setColor(COLOR_BLACK);
+					_graphics2D->setStroke(_defaultStroke);
+					_graphics2D->drawLine(markerX, originY - 20.0, markerX, originY + 20.0);
+				}
+
+				if (!(index & 1)) {
+					_graphics2D->setFont(_slateProLight);
+					QString markerText = QString::number(xMarkerValues[index]);
+					_graphics2D->measureString(markerText, &textWidth, &textHeight);
+					_graphics2D->drawString(markerText, markerX - textWidth/2.0, originY - 25.0 - textHeight);
 				}
 			}
+			_graphics2D->setFont(_slateProSub);
+			QString xAxisText("time (hours)");
+			_graphics2D->measureString(xAxisText, &textWidth, &textHeight);
+			_graphics2D->drawString(xAxisText, originX + xScale * 2.0 - textWidth / 2.0, originY - 110.0);
+
+			for (int index = 0; index < 4; index++) {
+				double markerY = originY + yMarkerValues[index] * yScale;
+
+				if (index > 0) {
+					for (int index1 = 1; index1 < 5; index1++) {
+						double markerY = originY + (yMarkerValues[index-1] + 50.0 * index1 / 5.0) * yScale;
+						_graphics2D->setColor(COLOR_GREY);
+						_graphics2D->setStroke(_thinStroke);
+						_graphics2D->drawLine(originX, markerY, originX + 15.0, markerY);
+					}
+				}
 
-			if (!(index & 1)) {
 				_graphics2D->setColor(COLOR_BLACK);
 				_graphics2D->setStroke(_defaultStroke);
-				_graphics2D->drawLine(markerX, originY - 20.0, markerX, originY + 20.0);
-			}
+				_graphics2D->drawLine(originX - 20.0, markerY, originX + 20.0, markerY);
 
-			if (!(index & 1)) {
-				_graphics2D->setFont(_slateProLight);
-				QString markerText = QString::number(xMarkerValues[index]);
-				_graphics2D->measureString(markerText, &textWidth, &textHeight);
-				_graphics2D->drawString(markerText, markerX - textWidth/2.0, originY - 25.0 - textHeight);
+				if (index > 0) {
+					_graphics2D->setFont(_slateProLight);
+					QString markerText = QString::number(yMarkerValues[index]);
+					_graphics2D->measureString(markerText, &textWidth, &textHeight);
+					_graphics2D->drawString(markerText, originX - textWidth - 30.0, markerY - textHeight / 2.0);
+				}
 			}
-		}
-		_graphics2D->setFont(_slateProSub);
-		QString xAxisText("time (hours)");
-		_graphics2D->measureString(xAxisText, &textWidth, &textHeight);
-		_graphics2D->drawString(xAxisText, originX + xScale * 2.0 - textWidth / 2.0, originY - 110.0);
 
-		for (int index = 0; index < 4; index++) {
-			double markerY = originY + yMarkerValues[index] * yScale;
+			_graphics2D->rotate(90.0);
 
-			if (index > 0) {
-				for (int index1 = 1; index1 < 5; index1++) {
-					double markerY = originY + (yMarkerValues[index-1] + 50.0 * index1 / 5.0) * yScale;
-					_graphics2D->setColor(COLOR_GREY);
-					_graphics2D->setStroke(_thinStroke);
-					_graphics2D->drawLine(originX, markerY, originX + 15.0, markerY);
-				}
-			}
+			_graphics2D->setFont(_slateProSub);
+			QString yAxisText("voltage (V)");
+			_graphics2D->measureString(yAxisText, &textWidth, &textHeight);
+			_graphics2D->drawString(yAxisText, originY + 80.0 * yScale - textWidth / 2.0, -_width + 20.0);
+
+			_graphics2D->rotate(-90.0);
 
 			_graphics2D->setColor(COLOR_BLACK);
 			_graphics2D->setStroke(_defaultStroke);
-			_graphics2D->drawLine(originX - 20.0, markerY, originX + 20.0, markerY);
+			_graphics2D->drawLine(originX, originY, originX + xScale * 4.3, originY);
+			_graphics2D->drawLine(originX, originY, originX, originY + yScale * 160.0);
+			_graphics2D->drawLine(originX + xScale * 4.3, originY, originX + xScale * 4.3, originY + yScale * 160.0);
+			_graphics2D->endDisplayList();
 
-			if (index > 0) {
-				_graphics2D->setFont(_slateProLight);
-				QString markerText = QString::number(yMarkerValues[index]);
-				_graphics2D->measureString(markerText, &textWidth, &textHeight);
-				_graphics2D->drawString(markerText, originX - textWidth - 30.0, markerY - textHeight / 2.0);
-			}
+			_axesWidth = _width;
+			_axesHeight = _height;
 		}
 
-		_graphics2D->rotate(90.0);
-
-		_graphics2D->setFont(_slateProSub);
-		QString yAxisText("voltage (V)");
-		_graphics2D->measureString(yAxisText, &textWidth, &textHeight);
-		_graphics2D->drawString(yAxisText, originY + 80.0 * yScale - textWidth / 2.0, -_width + 20.0);
-
-		_graphics2D->rotate(-90.0);
-
-		_graphics2D->setColor(COLOR_BLACK);
-		_graphics2D->setStroke(_defaultStroke);
-		_graphics2D->drawLine(originX, originY, originX + xScale * 4.3, originY);
-		_graphics2D->drawLine(originX, originY, originX, originY + yScale * 160.0);
-		_graphics2D->drawLine(originX + xScale * 4.3, originY, originX + xScale * 4.3, originY + yScale * 160.0);
+		_graphics2D->drawDisplayList(_axes);
 
 
 		// lines for graph
@@ -200,80 +217,90 @@ void LineGraph::onRegenerated()
 
 		// Legend
 
-		_graphics2D->setColor(COLOR_BLACK);
+		if (_legend->isEmpty() || _legendWidth != _width) {
+			_graphics2D->beginDisplayList(_legend);
 
-		_graphics2D->setFont(_slateProSub);
-		QString legendTitleText("Legend");
-		_graphics2D->drawString(legendTitleText, 50.0, 170.0);
 
-		_graphics2D->setFont(_slateProLight);
-/*
-		_graphics2D->setGradient(_pieGradientYellowOrange);
-		_graphics2D->fillRect(50.0, 20.0, 50.0, 50.0);
+			_graphics2D->setColor(COLOR_BLACK);
 
-		_graphics2D->setColor(COLOR_BLACK);
-		_graphics2D->setStroke(_thinStroke);
-		_graphics2D->drawRect(50.0, 20.0, 50.0, 50.0);
-*/
-		_graphics2D->setColor(COLOR_BLUE);
-		_graphics2D->setStroke(_defaultStroke);
-		_graphics2D->drawLine(50.0, 40.0, 100.0, 40.0);
+			_graphics2D->setFont(_slateProSub);
+			QString legendTitleText("Legend");
+			_graphics2D->drawString(legendTitleText, 50.0, 170.0);
 
-		_graphics2D->setColor(COLOR_BLACK);
-		QString legendText1("item 1");
-		_graphics2D->drawString(legendText1, 120.0, 30.0);
+			_graphics2D->setFont(_slateProLight);
+	/*
+			_graphics2D->setGradient(_pieGradientYellowOrange);
+			_graphics2D->fillRect(50.0, 20.0, 50.0, 50.0);
 
-/*
-		_graphics2D->setGradient(_pieGradientRedCrimson);
-		_graphics2D->fillRect(50.0, 90.0, 50.0, 50.0);
+			_graphics2D->setColor(COLOR_BLACK);
+			_graphics2D->setStroke(_thinStroke);
+			_graphics2D->drawRect(50.0, 20.0, 50.0, 50.0);
+	*/
+			_graphics2D->setColor(COLOR_BLUE);
+			_graphics2D->setStroke(_defaultStroke);
+			_graphics2D->drawLine(50.0, 40.0, 100.0, 40.0);
 
-		_graphics2D->setColor(COLOR_BLACK);
-		_graphics2D->setStroke(_thinStroke);
-		_graphics2D->drawRect(50.0, 90.0, 50.0, 50.0);
-*/
-		_graphics2D->setColor(COLOR_RED);
-		_graphics2D->setStroke(_thickStroke);
-		_graphics2D->drawLine(50.0, 110.0, 100.0, 110.0);
+			_graphics2D->setColor(COLOR_BLACK);
+			QString legendText1("item 1");
+			_graphics2D->drawString(legendText1, 120.0, 30.0);
 
-		_graphics2D->setColor(COLOR_BLACK);
-		QString legendText2("item 2");
-		_graphics2D->drawString(legendText2, 120.0, 100.0);
+	/*
+			_graphics2D->setGradient(_pieGradientRedCrimson);
+			_graphics2D->fillRect(50.0, 90.0, 50.0, 50.0);
 
+			_graphics2D->setColor(COLOR_BLACK);
+			_graphics2D->setStroke(_thinStroke);
+			_graphics2D->drawRect(50.0, 90.0, 50.0, 50.0);
+	*/
+			_graphics2D->setColor(COLOR_RED);
+			_graphics2D->setStroke(_thickStroke);
+			_graphics2D->drawLine(50.0, 110.0, 100.0, 110.0);
 
-/*
-		_graphics2D->setGradient(_pieGradientBlueSlate);
-		_graphics2D->fillRect(_width / 2.0 + 50.0, 20.0, 50.0, 50.0);
+			_graphics2D->setColor(COLOR_BLACK);
+			QString legendText2("item 2");
+			_graphics2D->drawString(legendText2, 120.0, 100.0);
 
-		_graphics2D->setColor(COLOR_BLACK);
-		_graphics2D->setStroke(_thinStroke);
-		_graphics2D->drawRect(_width / 2.0 + 50.0, 20.0, 50.0, 50.0);
-*/
 
-		_graphics2D->setColor(COLOR_BLACK);
-		_graphics2D->setStroke(_thinStroke);
-		_graphics2D->drawLine(_width / 2.0 + 50.0, 60.0, _width / 2.0 + 100.0, 60.0);
+	/*
+			_graphics2D->setGradient(_pieGradientBlueSlate);
+			_graphics2D->fillRect(_width / 2.0 + 50.0, 20.0, 50.0, 50.0);
 
-		_graphics2D->setColor(COLOR_BLACK);
-		QString legendText3("item 3");
-		_graphics2D->drawString(legendText3, _width / 2.0 + 120.0, 30.0);
+			_graphics2D->setColor(COLOR_BLACK);
+			_graphics2D->setStroke(_thinStroke);
+			_graphics2D->drawRect(_width / 2.0 + 50.0, 20.0, 50.0, 50.0);
+	*/
 
-/*
-		_graphics2D->setGradient(_pieGradientPurpleViolet);
-		_graphics2D->fillRect(_width / 2.0 + 50.0, 90.0, 50.0, 50.0);
+			_graphics2D->setColor(COLOR_BLACK);
+			_graphics2D->setStroke(_thinStroke);
+			_graphics2D->drawLine(_width / 2.0 + 50.0, 60.0, _width / 2.0 + 100.0, 60.0);
+
+			_graphics2D->setColor(COLOR_BLACK);
+			QString legendText3("item 3");
+			_graphics2D->drawString(legendText3, _width / 2.0 + 120.0, 30.0);
+
+	/*
+			_graphics2D->setGradient(_pieGradientPurpleViolet);
+			_graphics2D->fillRect(_width / 2.0 + 50.0, 90.0, 50.0, 50.0);
 
-		_graphics2D->setColor(COLOR_BLACK);
-		_graphics2D->setStroke(_thinStroke);
-		_graphics2D->drawRect(_width / 2.0 + 50.0, 90.0, 50.0, 50.0);
-*/
+			_graphics2D->setColor(COLOR_BLACK);
+			_graphics2D->setStroke(_thinStroke);
+			_graphics2D->drawRect(_width / 2.0 + 50.0, 90.0, 50.0, 50.0);
+	*/
+
+			_graphics2D->setColor(COLOR_GREEN);
+			_graphics2D->setStroke(_evenDashesStroke);
+			_graphics2D->drawLine(_width / 2.0 + 50.0, 110.0, _width / 2.0 + 100.0, 110.0);
 
-		_graphics2D->setColor(COLOR_GREEN);
-		_graphics2D->setStroke(_evenDashesStroke);
-		_graphics2D->drawLine(_width / 2.0 + 50.0, 110.0, _width / 2.0 + 100.0, 110.0);
+			_graphics2D->setColor(COLOR_BLACK);
+			QString legendText4("item 4");
+			_graphics2D->drawString(legendText4, _width / 2.0 + 120.0, 100.0);
 
-		_graphics2D->setColor(COLOR_BLACK);
-		QString legendText4("item 4");
-		_graphics2D->drawString(legendText4, _width / 2.0 + 120.0, 100.0);
+			_graphics2D->endDisplayList();
+
+			_legendWidth = _width;
+		}
 
+		_graphics2D->drawDisplayList(_legend);
 
 
 		_graphics2D->done();
@@ -60,6 +60,13 @@ private:
 	Font*      _slateProLight;
 	Font*      _slateProMedium;
 
+	// static parts of the graph, re-captured only when the view is resized
+	DisplayList* _axes;
+	int          _axesWidth;
+	int          _axesHeight;
+	DisplayList* _legend;
+	int          _legendWidth;
+
 	Graphics2D* _graphics2D;
 };
 
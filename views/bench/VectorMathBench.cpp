@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks the VectorMath kernels against plain reference loops, then times them over a million segments.
+//
+// bench.pro builds this once with the vector kernels and once, with CONFIG+=scalar, with the plain loops the kernels
+// fall back to, so that both can be run on the same device or simulator and their times compared.
+
+#include "VectorMath.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace views::graphics;
+
+// limits
+#define BENCH_SEGMENTS		1000000
+#define BENCH_PASSES		20
+#define CHECK_SEGMENTS		1027		// not a multiple of any vector width, so the tail loops are checked too
+#define CHECK_TOLERANCE		1.0e-6		// relative to the size of the values worked with, the NEON kernels use a refined reciprocal square root estimate
+#define COORDINATE_RANGE	1000.0
+
+static unsigned int _seed = 12345;
+
+// repeatable pseudo random coordinates, so that every run sees the same points
+static GLfloat randomCoordinate()
+{
+	_seed = _seed * 1103515245u + 12345u;
+	return (GLfloat)((_seed >> 8) % 100000) * COORDINATE_RANGE / 100000.0;
+}
+
+// makes count segments joining count + 1 points, every seventh of them empty
+static GLfloat* createPoints(int count)
+{
+	GLfloat* points = new GLfloat[(count + 1) * 2];
+
+	for(int index = 0; index <= count; index++) {
+		if (index > 0 && index % 7 == 0) {
+			points[index * 2 + 0] = points[index * 2 - 2];
+			points[index * 2 + 1] = points[index * 2 - 1];
+		} else {
+			points[index * 2 + 0] = randomCoordinate();
+			points[index * 2 + 1] = randomCoordinate();
+		}
+	}
+
+	return points;
+}
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+}
+
+// compares count results against their reference values, worked out from values up to range in size, reporting the first one out of tolerance
+static bool matches(const char* name, const GLfloat* results, const double* reference, int count, double range)
+{
+	for(int index = 0; index < count; index++) {
+		double difference = fabs(results[index] - reference[index]);
+		double scale = fabs(reference[index]) > range ? fabs(reference[index]) : range;
+
+		if (difference > CHECK_TOLERANCE * scale) {
+			printf("%s: value %d is %.9g, expected %.9g\n", name, index, results[index], reference[index]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool checkTransformPoints(const GLfloat* points, int count)
+{
+	const GLfloat affine[6] = { 0.8, -0.6, 0.6, 0.8, 12.5, -40.25 };
+
+	GLfloat* results = new GLfloat[count * 2];
+	double* reference = new double[count * 2];
+
+	for(int index = 0; index < count; index++) {
+		double x = points[index * 2 + 0];
+		double y = points[index * 2 + 1];
+
+		reference[index * 2 + 0] = affine[0] * x + affine[2] * y + affine[4];
+		reference[index * 2 + 1] = affine[1] * x + affine[3] * y + affine[5];
+	}
+
+	transformPoints(affine, points, count, results);
+	bool passed = matches("transformPoints", results, reference, count * 2, COORDINATE_RANGE);
+
+	// the result may be the points themselves
+	for(int index = 0; index < count * 2; index++) {
+		results[index] = points[index];
+	}
+	transformPoints(affine, results, count, results);
+	passed = matches("transformPoints in place", results, reference, count * 2, COORDINATE_RANGE) && passed;
+
+	delete [] results;
+	delete [] reference;
+
+	return passed;
+}
+
+static bool checkSegments(const GLfloat* points, int count)
+{
+	const GLfloat halfWidth = 3.5;
+
+	GLfloat* directions = new GLfloat[count * 2];
+	GLfloat* lengths = new GLfloat[count];
+	GLfloat* outlines = new GLfloat[count * 8];
+	double* referenceDirections = new double[count * 2];
+	double* referenceLengths = new double[count];
+	double* referenceOutlines = new double[count * 8];
+
+	for(int index = 0; index < count; index++) {
+		double dx = (double)points[index * 2 + 2] - points[index * 2 + 0];
+		double dy = (double)points[index * 2 + 3] - points[index * 2 + 1];
+		double length = sqrt(dx * dx + dy * dy);
+
+		if (length > 0.0) {
+			dx /= length;
+			dy /= length;
+		}
+
+		referenceDirections[index * 2 + 0] = dx;
+		referenceDirections[index * 2 + 1] = dy;
+		referenceLengths[index] = length;
+
+		double nx = -dy * halfWidth;
+		double ny = dx * halfWidth;
+
+		referenceOutlines[index * 8 + 0] = points[index * 2 + 0] + nx;
+		referenceOutlines[index * 8 + 1] = points[index * 2 + 1] + ny;
+		referenceOutlines[index * 8 + 2] = points[index * 2 + 0] - nx;
+		referenceOutlines[index * 8 + 3] = points[index * 2 + 1] - ny;
+		referenceOutlines[index * 8 + 4] = points[index * 2 + 2] + nx;
+		referenceOutlines[index * 8 + 5] = points[index * 2 + 3] + ny;
+		referenceOutlines[index * 8 + 6] = points[index * 2 + 2] - nx;
+		referenceOutlines[index * 8 + 7] = points[index * 2 + 3] - ny;
+	}
+
+	segmentDirections(points, count, directions, lengths);
+	extrudeSegments(points, directions, count, halfWidth, outlines);
+
+	bool passed = matches("segmentDirections directions", directions, referenceDirections, count * 2, 1.0);
+	passed = matches("segmentDirections lengths", lengths, referenceLengths, count, 1.0) && passed;
+	passed = matches("extrudeSegments", outlines, referenceOutlines, count * 8, COORDINATE_RANGE) && passed;
+
+	// empty segments have to come out as exactly nothing rather than within tolerance of it
+	for(int index = 7; index < count; index += 7) {
+		if (directions[index * 2 - 2] != 0.0 || directions[index * 2 - 1] != 0.0 || lengths[index - 1] != 0.0) {
+			printf("segmentDirections: empty segment %d is not zero\n", index - 1);
+			passed = false;
+			break;
+		}
+	}
+
+	delete [] directions;
+	delete [] lengths;
+	delete [] outlines;
+	delete [] referenceDirections;
+	delete [] referenceLengths;
+	delete [] referenceOutlines;
+
+	return passed;
+}
+
+int main(int argc, char** argv)
+{
+	(void)argc;
+	(void)argv;
+
+#if defined(VECTORMATH_SCALAR)
+	printf("VectorMath: plain loops\n");
+#elif defined(__ARM_NEON__)
+	printf("VectorMath: NEON\n");
+#elif defined(__SSE__)
+	printf("VectorMath: SSE\n");
+#else
+	printf("VectorMath: plain loops, no vector unit in this build\n");
+#endif
+
+	GLfloat* checkPoints = createPoints(CHECK_SEGMENTS);
+
+	bool passed = checkTransformPoints(checkPoints, CHECK_SEGMENTS + 1);
+	passed = checkSegments(checkPoints, CHECK_SEGMENTS) && passed;
+
+	delete [] checkPoints;
+
+	printf("check: %s\n", passed ? "passed" : "FAILED");
+
+	GLfloat* points = createPoints(BENCH_SEGMENTS);
+	GLfloat* directions = new GLfloat[BENCH_SEGMENTS * 2];
+	GLfloat* lengths = new GLfloat[BENCH_SEGMENTS];
+	GLfloat* outlines = new GLfloat[BENCH_SEGMENTS * 8];
+	GLfloat* transformed = new GLfloat[(BENCH_SEGMENTS + 1) * 2];
+
+	const GLfloat affine[6] = { 0.8, -0.6, 0.6, 0.8, 12.5, -40.25 };
+
+	double bestStroke = 1.0e9;
+	double bestTransform = 1.0e9;
+
+	// the best of a number of passes, which leaves out the first touch of the memory and whatever else the machine was doing
+	for(int pass = 0; pass < BENCH_PASSES; pass++) {
+		double start = now();
+		segmentDirections(points, BENCH_SEGMENTS, directions, lengths);
+		extrudeSegments(points, directions, BENCH_SEGMENTS, 2.0, outlines);
+		double stroke = now() - start;
+
+		start = now();
+		transformPoints(affine, points, BENCH_SEGMENTS + 1, transformed);
+		double transform = now() - start;
+
+		if (stroke < bestStroke) {
+			bestStroke = stroke;
+		}
+		if (transform < bestTransform) {
+			bestTransform = transform;
+		}
+	}
+
+	printf("directions and extrusion of %d segments: %.2f ms\n", BENCH_SEGMENTS, bestStroke);
+	printf("transform of %d points: %.2f ms\n", BENCH_SEGMENTS + 1, bestTransform);
+
+	delete [] points;
+	delete [] directions;
+	delete [] lengths;
+	delete [] outlines;
+	delete [] transformed;
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
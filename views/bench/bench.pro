@@ -0,0 +1,26 @@
+# Standalone benchmark of the VectorMath kernels, built straight from the library source without the rest of libviews.
+#
+#   qmake bench.pro                   the vector kernels - NEON on the device, SSE on the simulator
+#   qmake bench.pro CONFIG+=scalar    the plain loops, to compare against
+#
+# Either build checks its kernels against reference loops before timing them, and exits with a failure if they differ.
+
+TEMPLATE = app
+TARGET = vectormath-bench
+
+CONFIG += console warn_on
+QT = core
+
+DEFINES += GLES2
+
+INCLUDEPATH += $$quote($$PWD/../include/views/graphics)
+
+SOURCES += $$quote($$PWD/../src/VectorMath.cpp) \
+           $$quote($$PWD/VectorMathBench.cpp)
+
+HEADERS += $$quote($$PWD/../include/views/graphics/VectorMath.hpp)
+
+scalar {
+	DEFINES += VECTORMATH_SCALAR
+	TARGET = vectormath-bench-scalar
+}
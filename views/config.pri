@@ -5,6 +5,9 @@ device {
     CONFIG(debug, debug|release) {
         SOURCES +=  $$quote($$BASEDIR/src/Canvas.cpp) \
                  $$quote($$BASEDIR/src/CanvasView.cpp) \
+                 $$quote($$BASEDIR/src/CommandBuffer.cpp) \
+                 $$quote($$BASEDIR/src/DashIterator.cpp) \
+                 $$quote($$BASEDIR/src/DisplayList.cpp) \
                  $$quote($$BASEDIR/src/GamepadEvent.cpp) \
                  $$quote($$BASEDIR/src/Graphics.cpp) \
                  $$quote($$BASEDIR/src/Graphics2D.cpp) \
@@ -12,7 +15,11 @@ device {
                  $$quote($$BASEDIR/src/MouseEvent.cpp) \
                  $$quote($$BASEDIR/src/MultitouchEvent.cpp) \
                  $$quote($$BASEDIR/src/NativeWindow.cpp) \
+                 $$quote($$BASEDIR/src/Path2D.cpp) \
                  $$quote($$BASEDIR/src/PhotoView.cpp) \
+                 $$quote($$BASEDIR/src/VectorMath.cpp) \
+                 $$quote($$BASEDIR/src/VertexBatch.cpp) \
+                 $$quote($$BASEDIR/src/VertexStream.cpp) \
                  $$quote($$BASEDIR/src/VideoView.cpp) \
                  $$quote($$BASEDIR/src/View.cpp) \
                  $$quote($$BASEDIR/src/ViewControl.cpp) \
@@ -28,8 +35,16 @@ device {
                  $$quote($$BASEDIR/include/views/event/MouseEvent.hpp) \
                  $$quote($$BASEDIR/include/views/event/MultitouchEvent.hpp) \
                  $$quote($$BASEDIR/include/views/graphics/CanvasView.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/CommandBuffer.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/CommandStream.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/DashIterator.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/DisplayList.hpp) \
                  $$quote($$BASEDIR/include/views/graphics/Graphics.hpp) \
                  $$quote($$BASEDIR/include/views/graphics/Graphics2D.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/Path2D.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/VectorMath.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/VertexBatch.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/VertexStream.hpp) \
                  $$quote($$BASEDIR/include/views/media/PhotoView.hpp) \
                  $$quote($$BASEDIR/include/views/media/VideoView.hpp) \
                  $$quote($$BASEDIR/src/NativeWindow.hpp) \
@@ -39,6 +54,9 @@ device {
     CONFIG(release, debug|release) {
         SOURCES +=  $$quote($$BASEDIR/src/Canvas.cpp) \
                  $$quote($$BASEDIR/src/CanvasView.cpp) \
+                 $$quote($$BASEDIR/src/CommandBuffer.cpp) \
+                 $$quote($$BASEDIR/src/DashIterator.cpp) \
+                 $$quote($$BASEDIR/src/DisplayList.cpp) \
                  $$quote($$BASEDIR/src/GamepadEvent.cpp) \
                  $$quote($$BASEDIR/src/Graphics.cpp) \
                  $$quote($$BASEDIR/src/Graphics2D.cpp) \
@@ -46,7 +64,11 @@ device {
                  $$quote($$BASEDIR/src/MouseEvent.cpp) \
                  $$quote($$BASEDIR/src/MultitouchEvent.cpp) \
                  $$quote($$BASEDIR/src/NativeWindow.cpp) \
+                 $$quote($$BASEDIR/src/Path2D.cpp) \
                  $$quote($$BASEDIR/src/PhotoView.cpp) \
+                 $$quote($$BASEDIR/src/VectorMath.cpp) \
+                 $$quote($$BASEDIR/src/VertexBatch.cpp) \
+                 $$quote($$BASEDIR/src/VertexStream.cpp) \
                  $$quote($$BASEDIR/src/VideoView.cpp) \
                  $$quote($$BASEDIR/src/View.cpp) \
                  $$quote($$BASEDIR/src/ViewControl.cpp) \
@@ -62,8 +84,16 @@ device {
                  $$quote($$BASEDIR/include/views/event/MouseEvent.hpp) \
                  $$quote($$BASEDIR/include/views/event/MultitouchEvent.hpp) \
                  $$quote($$BASEDIR/include/views/graphics/CanvasView.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/CommandBuffer.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/CommandStream.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/DashIterator.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/DisplayList.hpp) \
                  $$quote($$BASEDIR/include/views/graphics/Graphics.hpp) \
                  $$quote($$BASEDIR/include/views/graphics/Graphics2D.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/Path2D.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/VectorMath.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/VertexBatch.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/VertexStream.hpp) \
                  $$quote($$BASEDIR/include/views/media/PhotoView.hpp) \
                  $$quote($$BASEDIR/include/views/media/VideoView.hpp) \
                  $$quote($$BASEDIR/src/NativeWindow.hpp) \
@@ -75,6 +105,9 @@ simulator {
     CONFIG(debug, debug|release) {
         SOURCES +=  $$quote($$BASEDIR/src/Canvas.cpp) \
                  $$quote($$BASEDIR/src/CanvasView.cpp) \
+                 $$quote($$BASEDIR/src/CommandBuffer.cpp) \
+                 $$quote($$BASEDIR/src/DashIterator.cpp) \
+                 $$quote($$BASEDIR/src/DisplayList.cpp) \
                  $$quote($$BASEDIR/src/GamepadEvent.cpp) \
                  $$quote($$BASEDIR/src/Graphics.cpp) \
                  $$quote($$BASEDIR/src/Graphics2D.cpp) \
@@ -82,7 +115,11 @@ simulator {
                  $$quote($$BASEDIR/src/MouseEvent.cpp) \
                  $$quote($$BASEDIR/src/MultitouchEvent.cpp) \
                  $$quote($$BASEDIR/src/NativeWindow.cpp) \
+                 $$quote($$BASEDIR/src/Path2D.cpp) \
                  $$quote($$BASEDIR/src/PhotoView.cpp) \
+                 $$quote($$BASEDIR/src/VectorMath.cpp) \
+                 $$quote($$BASEDIR/src/VertexBatch.cpp) \
+                 $$quote($$BASEDIR/src/VertexStream.cpp) \
                  $$quote($$BASEDIR/src/VideoView.cpp) \
                  $$quote($$BASEDIR/src/View.cpp) \
                  $$quote($$BASEDIR/src/ViewControl.cpp) \
@@ -98,8 +135,16 @@ simulator {
                  $$quote($$BASEDIR/include/views/event/MouseEvent.hpp) \
                  $$quote($$BASEDIR/include/views/event/MultitouchEvent.hpp) \
                  $$quote($$BASEDIR/include/views/graphics/CanvasView.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/CommandBuffer.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/CommandStream.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/DashIterator.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/DisplayList.hpp) \
                  $$quote($$BASEDIR/include/views/graphics/Graphics.hpp) \
                  $$quote($$BASEDIR/include/views/graphics/Graphics2D.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/Path2D.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/VectorMath.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/VertexBatch.hpp) \
+                 $$quote($$BASEDIR/include/views/graphics/VertexStream.hpp) \
                  $$quote($$BASEDIR/include/views/media/PhotoView.hpp) \
                  $$quote($$BASEDIR/include/views/media/VideoView.hpp) \
                  $$quote($$BASEDIR/src/NativeWindow.hpp) \
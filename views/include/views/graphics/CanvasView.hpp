@@ -63,6 +63,39 @@ public Q_SLOTS:
 	// create a new image texture
     int createImageTexture(int imageID, int scaling, int tiling, float uScale, float vScale, int leftMargin, int rightMargin, int topMargin, int bottomMargin);
 
+	// Creates a new empty path.
+	int createPath();
+
+	// Frees the specified path, which must not be drawn in a frame that is not done yet.
+	void freePath(int pathID);
+
+	// Starts a new subpath of the specified path at the point (x, y).
+	void moveTo(int pathID, double x, double y);
+
+	// Adds a straight line to the point (x, y) to the specified path.
+	void lineTo(int pathID, double x, double y);
+
+	// Adds a quadratic curve through the control point (cx, cy) to the point (x, y) to the specified path.
+	void quadTo(int pathID, double cx, double cy, double x, double y);
+
+	// Adds a cubic curve through the control points (c1x, c1y) and (c2x, c2y) to the point (x, y) to the specified path.
+	void cubicTo(int pathID, double c1x, double c1y, double c2x, double c2y, double x, double y);
+
+	// Adds an arc of the given radius rounding the corner at (x1, y1) on the way to (x2, y2) to the specified path.
+	void arcTo(int pathID, double x1, double y1, double x2, double y2, double radius);
+
+	// Closes the current subpath of the specified path.
+	void closePath(int pathID);
+
+	// Discards every segment of the specified path.
+	void clearPath(int pathID);
+
+	// Sets which points the specified path fills where its subpaths overlap or cross, one of the FILL_RULE values.
+	void setFillRule(int pathID, int fillRule);
+
+	// Sets whether the specified path is filled by triangulating it or through the stencil buffer, one of the FILL_MODE values.
+	void setFillMode(int pathID, int fillMode);
+
 	// Concatenates the current Graphics2D Transform with a rotation transform.
 	void 	rotate(double theta);
 
@@ -156,6 +189,9 @@ public Q_SLOTS:
 	// Draws the outline of the specified rectangle.
 	void drawRect(double x, double y, double width, double height);
 
+	// Draws the outline of the specified path with the current stroke.
+	void drawPath(int pathID);
+
 	// Draws an outlined round-cornered rectangle using this graphics context's current color.
 	void drawRoundRect(double x, double y, double width, double height, double arcWidth, double arcHeight);
 
@@ -177,6 +213,9 @@ public Q_SLOTS:
 	// Fills a closed polygon defined by arrays of x and y coordinates.
 	void fillPolygon(QVariantList xPoints, QVariantList yPoints, int nPoints);
 
+	// Fills the subpaths of the specified path.
+	void fillPath(int pathID);
+
 	// Fills the specified rounded corner rectangle with the current color.
 	void fillRoundRect(double x, double y, double width, double height, double arcWidth, double arcHeight);
 
@@ -193,6 +232,8 @@ protected:
 	QMap<int,ImageData*> _imageIDMap;
 	int _imageTextureID;
 	QMap<int,ImageTexture*> _imageTextureIDMap;
+	int _pathID;
+	QMap<int,Path2D*> _pathIDMap;
 	int _strokeID;
 	QMap<int,Stroke*> _strokeIDMap;
 
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef COMMANDBUFFER_HPP
+#define COMMANDBUFFER_HPP
+
+#include <stdlib.h>
+
+#include "Graphics.hpp"
+
+namespace views {
+	namespace graphics {
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef enum RenderCommand {
+	RENDER_SKIP = 0,
+	RENDER_CLEAR_RECT,
+	RENDER_CLIP_RECT,
+	RENDER_DRAW_ARC,
+	RENDER_FILL_ARC,
+	RENDER_DRAW_IMAGE,
+	RENDER_DRAW_LINE,
+	RENDER_DRAW_POLYLINE,
+	RENDER_DRAW_ROUNDRECT,
+	RENDER_FILL_ROUNDRECT,
+	RENDER_DRAW_STRING,
+	RENDER_FILL_POLYGON,
+	RENDER_SET_BACKGROUND,
+	RENDER_SET_COLOR,
+	RENDER_SET_FONT,
+	RENDER_SET_GRADIENT,
+	RENDER_SET_IMAGE_TEXTURE,
+	RENDER_SET_STROKE,
+	RENDER_TRANSFORM,
+	RENDER_TRANSFORM_ROTATE,
+	RENDER_TRANSFORM_TRANSLATE,
+	RENDER_TRANSFORM_SCALE,
+	RENDER_TRANSFORM_SHEAR,
+	RENDER_SAVE_STATE,
+	RENDER_RESTORE_STATE,
+	RENDER_DRAW_MESH,      // triangles tessellated at done() - floats hold the (x,y) then the (u,v) of each vertex, then the coverage alpha of each for edge fringes, ints the vertex and index counts followed by 16-bit indices
+	RENDER_DRAW_PATH,      // the Path2D to outline, replaced by its meshes at done()
+	RENDER_FILL_PATH,      // the Path2D to fill, replaced by its meshes at done()
+	RENDER_FILL_STENCIL,   // outlines filled through the stencil buffer - floats hold the (x,y) of every outline point then the (x,y) and (u,v) of the covering quad, ints the fill rule, outline and point counts followed by the point count of each outline
+	RENDER_DRAW_INSTANCES, // copies of a triangle mesh - floats hold the (x,y) of each mesh vertex then the x, y, scale and (r,g,b,a) of each copy, ints the mesh vertex and copy counts
+	RENDER_XXX
+} RenderCommand;
+
+// header of a single recorded command - the payload follows directly in memory as pointers, floats and then ints
+typedef struct RenderCommandHeader
+{
+	RenderCommand command; // the command to render
+	int size;              // size of the whole record in bytes, header and padding included
+	int pointerCount;      // number of pointers in the payload
+	int floatCount;        // number of floats in the payload
+	int intCount;          // number of ints in the payload
+
+} RenderCommandHeader;
+
+// a block of memory holding consecutive command records
+typedef struct CommandChunk
+{
+	unsigned char* data;        // record storage
+	int size;                   // capacity in bytes
+	int used;                   // bytes currently holding records
+	bool owned;                 // true if data was allocated by the buffer and must be freed
+	struct CommandChunk* next;  // next chunk in the stream
+
+} CommandChunk;
+
+// position of a reader within a command buffer
+typedef struct CommandCursor
+{
+	CommandChunk* chunk;
+	int offset;
+
+} CommandCursor;
+
+#if defined(__cplusplus)
+}
+#endif
+
+// limits
+#define COMMAND_BUFFER_CHUNK_SIZE	65536
+#define COMMAND_RECORD_ALIGNMENT	8
+#define COMMAND_RECORD_ALIGN(size)	(((size) + COMMAND_RECORD_ALIGNMENT - 1) & ~(COMMAND_RECORD_ALIGNMENT - 1))
+#define COMMAND_HEADER_SIZE			COMMAND_RECORD_ALIGN(sizeof(RenderCommandHeader))
+
+// payload accessors for a recorded command
+inline void** commandPointers(const RenderCommandHeader* header)
+{
+	return (void**)((unsigned char*)header + COMMAND_HEADER_SIZE);
+}
+
+inline GLfloat* commandFloats(const RenderCommandHeader* header)
+{
+	return (GLfloat*)(commandPointers(header) + header->pointerCount);
+}
+
+inline int* commandInts(const RenderCommandHeader* header)
+{
+	return (int*)(commandFloats(header) + header->floatCount);
+}
+
+// An arena of tagged, variable length command records which grows in chunks and keeps its memory across resets.
+class Q_DECL_EXPORT CommandBuffer {
+
+public:
+	CommandBuffer(int chunkSize = COMMAND_BUFFER_CHUNK_SIZE);
+	virtual ~CommandBuffer();
+
+	// appends a new record with room for the given payload and returns its header
+	RenderCommandHeader* append(RenderCommand command, int pointerCount, int floatCount, int intCount);
+
+	// appends a copy of a record from another buffer and returns the new header
+	RenderCommandHeader* appendCopy(const RenderCommandHeader* header);
+
+	// appends copies of all the records in another buffer, leaving out skipped ones
+	void appendBuffer(CommandBuffer* buffer);
+
+	// replaces the contents of the buffer with records held in memory the buffer does not own, such as a mapped file
+	void attach(unsigned char* data, int size, int count);
+
+	// rewinds the buffer to empty, keeping the allocated chunks for reuse
+	void reset();
+
+	// frees all chunks beyond the first one
+	void trim();
+
+	// returns the number of records in the buffer
+	int count();
+
+	// returns the number of bytes holding records
+	int bytesUsed();
+
+	// positions a cursor at the first record
+	void begin(CommandCursor* cursor);
+
+	// returns the record at the cursor and advances it, or NULL at the end of the buffer
+	RenderCommandHeader* next(CommandCursor* cursor);
+
+protected:
+	CommandChunk* createChunk(int size);
+
+	int _chunkSize;
+	int _count;
+
+	CommandChunk* _firstChunk;
+	CommandChunk* _currentChunk;
+};
+
+	}
+}
+
+#endif /* COMMANDBUFFER_HPP */
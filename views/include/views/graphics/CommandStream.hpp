@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef COMMANDSTREAM_HPP
+#define COMMANDSTREAM_HPP
+
+#include "CommandBuffer.hpp"
+
+namespace views {
+	namespace graphics {
+
+// On-disk layout of a recorded command stream:
+//
+//   CommandStreamHeader
+//   resource table - one CommandResourceHeader plus payload per font, image, stroke, gradient or image texture
+//   command records - laid out exactly as in a CommandBuffer so they can be mapped and rendered in place
+//
+// Pointers in the records are written as 1-based indices into the resource table (0 for NULL), and the texture
+// name of a RENDER_DRAW_IMAGE record as the index of its image. Fonts and images are not stored, only a content
+// hash which is matched against the fonts and images supplied when the stream is loaded.
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct CommandStreamHeader
+{
+	int magic;           // COMMAND_STREAM_MAGIC
+	int version;         // COMMAND_STREAM_VERSION
+	int pointerSize;     // size of a pointer slot in the records - a stream only maps on a matching ABI
+	int resourceCount;   // number of entries in the resource table
+	int resourceOffset;  // file offset of the resource table
+	int resourceBytes;   // size of the resource table
+	int commandCount;    // number of command records
+	int commandOffset;   // file offset of the command records
+	int commandBytes;    // size of the command records
+
+} CommandStreamHeader;
+
+typedef enum CommandResourceType {
+	RESOURCE_FONT = 1,
+	RESOURCE_IMAGE,
+	RESOURCE_STROKE,
+	RESOURCE_GRADIENT,
+	RESOURCE_IMAGE_TEXTURE
+} CommandResourceType;
+
+// header of a resource table entry - the payload follows directly in memory
+typedef struct CommandResourceHeader
+{
+	int type;                 // CommandResourceType
+	int size;                 // size of the whole entry in bytes, header and padding included
+	unsigned char hash[16];   // MD5 content hash of fonts and images, zero otherwise
+
+} CommandResourceHeader;
+
+// stroke payload, followed by dashCount dash lengths
+typedef struct StreamStroke
+{
+	GLfloat width;
+	int cap;
+	int join;
+	GLfloat miterLimit;
+	int dashCount;
+	GLfloat dashPhase;
+
+} StreamStroke;
+
+// gradient payload, followed by segments + 1 RGBA colors and segments * 2 + 1 percentages
+typedef struct StreamGradient
+{
+	int segments;
+	GLfloat radius;
+	GLfloat angle;
+	GLfloat originU;
+	GLfloat originV;
+
+} StreamGradient;
+
+// image texture payload
+typedef struct StreamImageTexture
+{
+	int image;           // 1-based index of the image in the resource table
+	int scaling;
+	int tiling;
+	GLfloat uScale;
+	GLfloat vScale;
+	int leftMargin;
+	int rightMargin;
+	int topMargin;
+	int bottomMargin;
+
+} StreamImageTexture;
+
+#if defined(__cplusplus)
+}
+#endif
+
+#define COMMAND_STREAM_MAGIC	0x5343564c // "LVCS"
+#define COMMAND_STREAM_VERSION	1
+
+	}
+}
+
+#endif /* COMMANDSTREAM_HPP */
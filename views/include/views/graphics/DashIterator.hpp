@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef DASHITERATOR_HPP
+#define DASHITERATOR_HPP
+
+#include <stdlib.h>
+
+#include "Graphics.hpp"
+
+namespace views {
+	namespace graphics {
+
+// Walks a dash pattern along a path one segment at a time, handing out the inked stretches of each segment in a single pass.
+class Q_DECL_EXPORT DashIterator {
+
+public:
+	DashIterator();
+	virtual ~DashIterator();
+
+	// starts the pattern at the beginning of a path, dashPhase into it, and returns false if the pattern would not dash anything
+	bool begin(const GLfloat* dash, int dashCount, GLfloat dashPhase);
+
+	// moves on to the next segment of the path, of the given length
+	void nextSegment(GLfloat length);
+
+	// returns the next inked stretch of the current segment as distances from its start, or false once the segment is used up
+	bool nextSpan(GLfloat* from, GLfloat* to);
+
+	// returns true if the last stretch starts a new dash rather than carrying one on from the previous segment
+	bool startsDash();
+
+	// returns true if the last stretch ends its dash rather than carrying on into the next segment
+	bool endsDash();
+
+protected:
+	const GLfloat* _dash;
+	int _dashCount;
+
+	int _dashIndex;
+	GLfloat _dashRemaining;
+
+	GLfloat _segmentLength;
+	GLfloat _segmentPosition;
+
+	bool _inDash;
+	bool _startsDash;
+	bool _endsDash;
+};
+
+	}
+}
+
+#endif /* DASHITERATOR_HPP */
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef DISPLAYLIST_HPP
+#define DISPLAYLIST_HPP
+
+#include <QList>
+
+#include "CommandBuffer.hpp"
+
+namespace views {
+	namespace graphics {
+
+struct Stroke;
+struct Gradient;
+struct ImageTexture;
+class Graphics2D;
+
+// A retained sequence of Graphics2D commands, captured once with Graphics2D::beginDisplayList / endDisplayList and
+// replayed any number of times with Graphics2D::drawDisplayList.
+// Fonts, strokes, gradients and image textures used while capturing are referenced, not copied, and must outlive the list.
+// Lines, curves, shapes and paths are tessellated once when capture ends, with the stroke and curve tolerance in effect then,
+// so later changes to a captured path or stroke and replaying at a larger scale do not change the baked geometry.
+class Q_DECL_EXPORT DisplayList {
+
+public:
+	DisplayList();
+	virtual ~DisplayList();
+
+	// discards the captured commands
+	void clear();
+
+	// returns true if no commands have been captured
+	bool isEmpty();
+
+	// returns the captured commands
+	CommandBuffer* commands();
+
+	// returns the captured commands with their geometry tessellated into meshes, as they are replayed
+	CommandBuffer* bakedCommands();
+
+	// replaces the commands with records held in a mapped command stream file, taking ownership of the mapping,
+	// with the Graphics2D that loaded it freeing the gradients it created
+	void map(Graphics2D* graphics2D, unsigned char* mapping, size_t mappingLength, unsigned char* commands, int commandBytes, int commandCount);
+
+	// takes ownership of a stroke, gradient or image texture referenced by the commands
+	void retain(Stroke* stroke);
+	void retain(Gradient* gradient);
+	void retain(ImageTexture* imageTexture);
+
+protected:
+	CommandBuffer* _commands;
+	CommandBuffer* _bakedCommands;
+
+	// mapped command stream, if any, and the objects created while loading it
+	unsigned char* _mapping;
+	size_t _mappingLength;
+	Graphics2D* _graphics2D;
+	QList<Stroke*> _strokes;
+	QList<Gradient*> _gradients;
+	QList<ImageTexture*> _imageTextures;
+};
+
+	}
+}
+
+#endif /* DISPLAYLIST_HPP */
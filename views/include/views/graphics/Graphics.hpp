@@ -24,12 +24,13 @@
 #ifdef GLES1
 #include <GLES/gl.h>
 #include <GLES/glext.h>
+#elif defined(GLES3)
+// the gles3 build defines GLES2 as well, for everything the two have in common
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
 #elif defined(GLES2)
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
-#elif defined(GLES3)
-#include <GLES2/gl3.h>
-#include <GLES2/gl2ext.h>
 #else
 error libviews should be compiled with either GLES1 or GLES2 -D flags.
 #endif
@@ -46,6 +47,19 @@ using namespace bb::utility;
 namespace views {
 	namespace graphics {
 
+// eglSwapBuffersWithDamageKHR / EXT, looked up at run time since not every driver has it
+typedef EGLBoolean (EGLAPIENTRY *SwapBuffersWithDamage)(EGLDisplay display, EGLSurface surface, EGLint* rects, EGLint rectCount);
+
+// vertex attribute locations below this are switched on and off through the state tracker
+#define MAX_TRACKED_VERTEX_ATTRIBS 8
+
+// fixed function client arrays, combined as a mask for the state tracker
+typedef enum ClientArray {
+	CLIENT_VERTEX_ARRAY = 0x01,			// GL_VERTEX_ARRAY
+	CLIENT_TEXTURE_COORD_ARRAY = 0x02,	// GL_TEXTURE_COORD_ARRAY
+	CLIENT_COLOR_ARRAY = 0x04			// GL_COLOR_ARRAY
+} ClientArray;
+
 class Q_DECL_EXPORT Graphics : public QObject {
 
 Q_OBJECT
@@ -64,10 +78,17 @@ public:
 	virtual void renderSafe(bool saveRender);
 	virtual void cleanup();
 
+	// marks the surface contents as lost, so that the next render draws and swaps in full
+	void invalidate();
+
+	// GL state changes issued, and those skipped because the state was already set, while rendering the last frame
+	int stateChangesIssued();
+	int stateChangesAvoided();
+
 	void setSize(int width, int height);
 
 	int regenerateCleanup();
-	int regenerate(screen_window_t screenWindow);
+	virtual int regenerate(screen_window_t screenWindow);
 
 
 	// image utility functions
@@ -124,6 +145,36 @@ public:
 protected:
 	int nextp2(int x);
 
+	// asks for the surface contents to be kept across swaps so that a frame can be redrawn in part, or lets the driver discard them again
+	void preserveSwapBuffers(bool preserve);
+
+	// limits the next swap to a rectangle in window coordinates, when the driver can take the hint
+	void setSwapDamage(int x, int y, int width, int height);
+
+	// returns true if there is something new to render since the last swap
+	virtual bool frameChanged();
+
+	// forgets the GL state last set, since anything may have touched it between frames, and starts counting changes for a new frame
+	void beginStateTracking();
+	// keeps the counts of the frame just rendered
+	void endStateTracking();
+
+	// set GL state, calling GL only when the value differs from the one last set
+	void setBlending(bool blending);
+	void setBlendFunc(GLenum source, GLenum destination);
+	void bindTexture(GLuint texture);
+#ifdef GLES1
+	void setTexturing(bool texturing);
+	// enables exactly the ClientArray arrays in the mask
+	void useClientArrays(unsigned int arrays);
+#elif defined(GLES2)
+	void useProgram(GLuint program);
+	// enables exactly the vertex attribute arrays whose location bits are set in the mask
+	void useVertexAttribArrays(unsigned int locations);
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+
 	Graphics* _master;
 
 	ImageData* _renderedImage;
@@ -151,6 +202,32 @@ protected:
 	EGLDisplay _eglDisplay;
 	static EGLConfig  _eglConfig;
 
+	// surface contents were asked to survive a swap, do survive it, must be redrawn in full before they can be patched, and the area posted by the next swap
+	bool _preserveRequested;
+	bool _surfacePreserved;
+	bool _fullRedraw;
+	bool _partialSwap;
+	EGLint _swapDamage[4];
+	static SwapBuffersWithDamage _eglSwapBuffersWithDamage;
+
+	// shadow copy of the GL state last set, which parts of it are known, and the changes issued and avoided this frame and the last
+	unsigned int _stateKnown;
+	unsigned int _stateArraysKnown;
+	unsigned int _stateArrays;
+	GLuint _stateProgram;
+	GLuint _stateTexture;
+	GLenum _stateBlendSource;
+	GLenum _stateBlendDestination;
+	bool _stateBlending;
+	bool _stateTexturing;
+	int _stateChangesIssued;
+	int _stateChangesAvoided;
+	int _stateChangesIssuedCount;
+	int _stateChangesAvoidedCount;
+
+	// bits of stencil buffer in the chosen config, 0 if there is none
+	static EGLint _eglStencilSize;
+
 	static EGLDisplay _eglDeviceDisplay;
 	static EGLDisplay _eglHDMIDisplay;
 
@@ -36,10 +36,20 @@
 
 #include <bb/cascades/TouchEvent>
 
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
 #include <QtCore/QObject>
 #include <QtCore/QString>
+#include <QtCore/QVector>
 
 #include "Graphics.hpp"
+#include "CommandBuffer.hpp"
+#include "DisplayList.hpp"
+#include "CommandStream.hpp"
+#include "VertexBatch.hpp"
+#include "VertexStream.hpp"
+#include "DashIterator.hpp"
+#include "Path2D.hpp"
 
 namespace views {
 	namespace graphics {
@@ -80,6 +90,8 @@ typedef struct Font {
 	ImageData* image;
 } Font;
 
+#define GRADIENT_LOOKUP_SIZE	256
+
 typedef struct Gradient
 {
 	int segments; // the number of segments defining the gradient mapping.
@@ -89,6 +101,11 @@ typedef struct Gradient
 	GLfloat angle; // angle of gradient map (0 for linear gradients, > 0 for radial gradients)
 	GLfloat originU; // U coordinate of origin (default 0.0)
 	GLfloat originV; // U coordinate of origin (default 0.0)
+	GLubyte lookup[GRADIENT_LOOKUP_SIZE * 4]; // RGBA colors at evenly spaced points from the start to the end of the mapping, baked when the gradient is created and again by Graphics2D::updateGradient after the mapping is changed in place
+	unsigned int lookupHash; // hash of the mapping the lookup colors were baked from
+	GLuint lookupTexture; // texture holding the lookup colors, uploaded the first time the gradient is drawn (0 until then)
+	unsigned int lookupUploaded; // lookupHash of the colors last uploaded to the lookup texture
+	int lookupContext; // the context the lookup texture was created in
 
 } Gradient;
 
@@ -147,33 +164,90 @@ typedef enum StrokeJoin {
     JOIN_ROUND, // Joins path segments by rounding off the corner at a radius of half the line width.
 } StrokeJoin;
 
+// drawing state saved around a replayed display list
+typedef struct RenderState
+{
+	GLColor foregroundColor;
+	GLColor backgroundColor;
+	Font* font;
+	Gradient* gradient;
+	ImageTexture* imageTexture;
+	Stroke* stroke;
+#ifdef GLES2
+	GLfloat transformMatrix[16];
+#endif
+
+} RenderState;
+
+// a draw of a completed frame as compared against the next one to find what changed
+typedef struct DamageDraw
+{
+	unsigned int hash;  // the command together with the state, transform and clip it is drawn with
+	bool bounded;       // false if the area covered could not be worked out
+	GLfloat bounds[4];  // min x, min y, max x, max y in window coordinates
+
+} DamageDraw;
+
+// the state records in effect at some point of a list, NULL where nothing has been recorded yet
+typedef struct DrawState
+{
+	RenderCommandHeader* color;
+	RenderCommandHeader* gradient; // NULL again once a color clears it
+	RenderCommandHeader* font;
+	RenderCommandHeader* imageTexture;
+	RenderCommandHeader* stroke;
+	RenderCommandHeader* background;
+
+} DrawState;
+
+// a draw waiting to be placed by reorderCommands()
+typedef struct ReorderDraw
+{
+	RenderCommandHeader* command;
+	DrawState state;
+	int known;           // DRAW_STATE_* parts recorded before the draw
+	int program;
+	GLuint texture;
+	bool bounded;        // false if the bounds could not be worked out, so the draw overlaps anything
+	GLfloat bounds[4];   // min x, min y, max x, max y
+	int next;            // next draw in the same group
+
+} ReorderDraw;
+
+// draws sharing a program and texture which can be drawn one after the other
+typedef struct ReorderGroup
+{
+	int program;
+	GLuint texture;
+	bool bounded;
+	GLfloat bounds[4];
+	int unknown;         // DRAW_STATE_* parts not recorded before some draw in the group
+	int first;
+	int last;
+
+} ReorderGroup;
+
+// uniform and attribute locations of a shader program, looked up once after it is linked - -1 for any it does not have
+typedef struct ProgramLocations
+{
+	GLint position;         // a_position
+	GLint texcoord;         // a_texcoord
+	GLint maskTexcoord;     // a_maskTexcoord
+	GLint alpha;            // a_alpha
+	GLint projectionMatrix; // u_projectionMatrix
+	GLint modelViewMatrix;  // u_modelViewMatrix
+	GLint texture;          // u_texture
+	GLint color;            // u_color
+	GLint gradient;         // u_gradient
+	GLint radius;           // u_radius
+	GLint angle;            // u_angle
+	GLint origin;           // u_origin
+	GLint fringe;           // u_fringe
+	GLint instance;         // a_instance
+	GLint instanceColor;    // a_instanceColor
+
+} ProgramLocations;
 
-typedef enum RenderCommand {
-	RENDER_SKIP = 0,
-	RENDER_CLEAR_RECT,
-	RENDER_CLIP_RECT,
-	RENDER_DRAW_ARC,
-	RENDER_FILL_ARC,
-	RENDER_DRAW_IMAGE,
-	RENDER_DRAW_LINE,
-	RENDER_DRAW_POLYLINE,
-	RENDER_DRAW_ROUNDRECT,
-	RENDER_FILL_ROUNDRECT,
-	RENDER_DRAW_STRING,
-	RENDER_FILL_POLYGON,
-	RENDER_SET_BACKGROUND,
-	RENDER_SET_COLOR,
-	RENDER_SET_FONT,
-	RENDER_SET_GRADIENT,
-	RENDER_SET_IMAGE_TEXTURE,
-	RENDER_SET_STROKE,
-	RENDER_TRANSFORM,
-	RENDER_TRANSFORM_ROTATE,
-	RENDER_TRANSFORM_TRANSLATE,
-	RENDER_TRANSFORM_SCALE,
-	RENDER_TRANSFORM_SHEAR,
-	RENDER_XXX
-} RenderCommand;
 
 #if defined(__cplusplus)
 }
@@ -312,18 +386,36 @@ VeraSeBd.ttf	Bitstream Vera Serif Bold
  */
 
 // limits
-#define MAX_RENDER_COMMANDS	10000
 #define MAX_VERTEX_COORDINATES	1000
+#define MAX_RENDER_STATES		16
+#define MESH_CACHE_SIZE			(1024 * 1024)
+#define CURVE_TOLERANCE			0.25
+#define MIN_CURVE_TOLERANCE		0.01
+#define STROKE_MAX_ROUND_STEPS	64
+#define STENCIL_THRESHOLD		1024
+#define FRINGE_MITER_LIMIT		4.0
+#define INSTANCE_FLOATS			7
 
 class Q_DECL_EXPORT Graphics2D : public Graphics {
 
 Q_OBJECT
 
+	/*!
+	 * @brief How far in pixels on screen the segments of arcs, round rectangles, round joins and caps may stray from the true curve.
+	 */
+	Q_PROPERTY(float tolerance READ tolerance WRITE setTolerance)
+
+	/*!
+	 * @brief Whether the edges of lines, arcs, round rectangles, polygons and paths fade out over a pixel rather than stepping.
+	 */
+	Q_PROPERTY(bool antialiasing READ antialiasing WRITE setAntialiasing)
+
 public:
 	Graphics2D(int display, Graphics2D* master = NULL);
 	virtual ~Graphics2D();
 
 	int initialize(screen_window_t screenWindow);
+	int regenerate(screen_window_t screenWindow);
 	void cleanup();
 
 public Q_SLOTS:
@@ -345,6 +437,12 @@ public Q_SLOTS:
 	// create a new gradient
     Gradient* createGradient(int segments, GLColor* colors, float* percentages, float radius = 0.0, float angle = 0.0, float originU = 0.0, float originV = 0.0);
 
+	// Bakes the lookup colors of a gradient again after its mapping has been changed in place.
+	void updateGradient(Gradient* gradient);
+
+	// Frees the specified gradient, along with its lookup texture once the next frame is rendered.
+	void freeGradient(Gradient* gradient);
+
 	// create a new image texture
     ImageTexture* createImageTexture(ImageData* image, int scaling, int tiling, float uScale, float vScale, int leftMargin, int rightMargin, int topMargin, int bottomMargin);
 
@@ -465,6 +563,9 @@ public Q_SLOTS:
 	// Draws the outline of an oval.
 	void drawOval(double x, double y, double width, double height);
 
+	// Draws the outline of the specified path with the current stroke.
+	void drawPath(Path2D* path);
+
 	// Draws a closed polygon defined by arrays of x and y coordinates.
 	void drawPolygon(int* xPoints, int* yPoints, int nPoints);
 
@@ -516,6 +617,12 @@ public Q_SLOTS:
 	// Fills the specified rectangle.
 	void fillRect(double x, double y, double width, double height);
 
+	// Fills the subpaths of the specified path, each one as if it were closed.
+	void fillPath(Path2D* path);
+
+	// Fills copies of a mesh of triangles, each scaled by its scale (1 without scales), moved to its (x,y) position and filled with its color (the current color without colors).
+	void drawInstances(const GLfloat* meshCoords, int meshVertexCount, const GLfloat* positions, const GLfloat* scales, const GLColor* colors, int instanceCount);
+
 	// Fills a closed polygon defined by arrays of x and y coordinates.
 	void fillPolygon(int* xPoints, int* yPoints, int nPoints);
 
@@ -528,79 +635,276 @@ public Q_SLOTS:
 	// Fills the specified rounded corner rectangle with the current color.
 	void fillRoundRect(double x, double y, double width, double height, double arcWidth, double arcHeight);
 
+	// Starts capturing subsequent drawing calls into the specified display list instead of the current frame.
+	void beginDisplayList(DisplayList* displayList);
+
+	// Stops capturing drawing calls into the current display list.
+	void endDisplayList();
+
+	// Replays the specified display list, leaving the drawing state as it was before the call.
+	void drawDisplayList(DisplayList* displayList);
+
+	// Replays the specified display list translated and scaled, leaving the drawing state as it was before the call.
+	void drawDisplayList(DisplayList* displayList, double tx, double ty, double sx = 1.0, double sy = 1.0);
+
+	// Returns the number of commands removed from the last completed frame by the state optimization pass.
+	int removedCommandCount();
+
+	// Returns the number of draw calls issued for the last rendered frame.
+	int drawCallCount();
+
+	// Turns on or off grouping of non-overlapping draws by shader program and texture when a frame is completed.
+	void setCommandReordering(bool reorder);
+
+	// Returns the number of program switches the reordering pass saved in the last completed frame.
+	int programSwitchesSaved();
+
+	// Turns on or off redrawing only the area that changed since the last rendered frame.
+	void setPartialRedraw(bool partial);
+
+	// Returns the number of pixels redrawn for the last rendered frame.
+	int redrawnPixelCount();
+
+	// Returns the number of completed frames dropped because they repeated the last published one.
+	int skippedFrameCount();
+
+	// Sets the number of bytes the tessellated arcs and round rectangles kept for reuse may take up.
+	void setMeshCacheSize(int bytes);
+
+	// Returns the number of arcs, round rectangles and paths whose meshes were reused from the cache or tessellated anew.
+	int meshCacheHits();
+	int meshCacheMisses();
+
+	// Sets the number of flattened points above which paths filled in FILL_MODE_AUTO go through the stencil buffer rather than being triangulated.
+	void setStencilThreshold(int points);
+	int stencilThreshold();
+
+	// Sets how far in pixels on screen curves may stray from their true shape, trading smoothness for vertices.
+	void setTolerance(float tolerance);
+	float tolerance();
+
+	// Sets how far in pixels on screen polylines may be simplified from the points they were drawn with, dropping the points that add no visible detail, or 0 to draw every point.
+	void setPolylineTolerance(float tolerance);
+	float polylineTolerance();
+
+	// Returns the number of polyline points dropped by simplification from the last tessellated frame.
+	int removedVertexCount();
+
+	// Turns on or off a one pixel fringe fading out around the edges of tessellated strokes and fills, smoothing them without a multisampled surface.
+	void setAntialiasing(bool antialiasing);
+	bool antialiasing();
+
+	// Writes the commands of the next completed frame to a command stream file.
+	void captureFrame(const QString& fileName);
+
+	// Writes the commands captured in a display list to a command stream file.
+	int saveDisplayList(DisplayList* displayList, const QString& fileName);
+
+	// Maps a command stream file into a display list, matching its fonts and images by content hash against the ones given.
+	int loadDisplayList(DisplayList* displayList, const QString& fileName, const QList<Font*>& fonts, const QList<ImageData*>& images);
+
 
 public:
 	void render();
 
 protected:
 
+	// Returns true if a frame has been published since this context last rendered.
+	bool frameChanged();
+
+#ifdef GLES2
+	// Looks up the uniform and attribute locations of every shader program, so that drawing never has to.
+	void loadProgramLocations();
+
+	// Returns the lookup texture of a gradient, uploading its baked colors the first time it is drawn and again after they are updated.
+	GLuint gradientTexture(Gradient* gradient);
+
+	// Deletes the lookup textures of freed gradients that were created in this context.
+	void deleteFreedTextures();
+#endif
+
 	// view transform functions
 	void setupView(int x, int y, int width, int height);
 
 	// low level primitives
-	// Renders a quad or triangle.
-	void renderDrawTriangles(int renderCount, int renderPoints);
+	// Adds a mesh tessellated at record time to the current batch, submitting the batch first if it was built with another color or gradient.
+	void renderDrawMesh(RenderCommandHeader* command);
+
+	// Submits the batched quads and triangles, then the edge fringes batched with them.
+	void flushBatch();
+
+	// Submits one batch with a single indexed draw, blending it by the coverage of its vertices if it holds edge fringes.
+	void drawBatch(VertexBatch* batch, bool fringed);
+
+	// Grows the text quad arrays to hold at least the given number of characters.
+	void reserveRenderCoords(int characters);
+
+	// Marks the pixels covered by outlines in the stencil buffer by their fill rule, then draws their covering quad over the marked pixels.
+	void renderFillStencil(RenderCommandHeader* command);
+
+	// Draws copies of a mesh with one instanced draw, or with their vertices expanded into one array draw where there is no instancing.
+	void renderDrawInstances(RenderCommandHeader* command);
+
+	// Returns scratch space for count floats of expanded instance vertices, reused from one draw to the next.
+	GLfloat* instanceCoords(int count);
+
+	// Creates or looks up the texture holding a font's glyphs.
+	int createFontTexture(Font* font);
+
+	// Creates or looks up the texture holding an image.
+	int createTextureForImage(ImageData* image, GLuint* texture);
+
+	// Computes the content hash identifying a font or an image in a command stream file.
+	void hashFont(Font* font, unsigned char* hash);
+	void hashImage(ImageData* image, unsigned char* hash);
+
+	// Drops state commands that do not change the effective state and merges consecutive transforms, returning the number of commands removed.
+	int optimizeCommands(CommandBuffer* commands);
+
+	// Regroups non-overlapping draws by program and texture while keeping the order of overlapping ones, returning the number of program switches saved.
+	int reorderCommands(CommandBuffer* commands, CommandBuffer* reordered);
+
+	// Works out the window area where a completed frame differs from the previous one, returning false if it has to be redrawn in full.
+	bool damageCommands(CommandBuffer* commands, GLfloat* damage);
+
+	// Adds an area to the damage waiting for the next render.
+	void includeDamage(const GLfloat* damage);
+
+	// Hashes every command of a list along with its payload.
+	unsigned int hashCommands(CommandBuffer* commands);
+
+	// Copies a list of commands, replacing lines, polylines, arcs, round rectangles and polygons with the triangle meshes they are drawn with.
+	void tessellateCommands(CommandBuffer* commands, CommandBuffer* tessellated);
+
+	// Tessellates the captured commands of a display list into the meshes it is replayed with.
+	void bakeDisplayList(DisplayList* displayList);
+
+	// Adds quads or triangles to the mesh being tessellated, appending the mesh first if they would not fit.
+	void tessellateTriangles(CommandBuffer* tessellated, int renderCount, int renderPoints);
+
+	// Appends the mesh being tessellated as a draw command, followed by its edge fringe when antialiasing, and starts a new one.
+	void emitMesh(CommandBuffer* tessellated);
+
+	// Appends a band as wide as the current fringe around the outside edges of the mesh being tessellated, fading from covered to clear, as meshes of their own.
+	void emitFringe(CommandBuffer* tessellated);
+
+	// Returns scratch space for count fringe vertex indices, reused from one call to the next.
+	int* fringeVertices(int count);
+
+	// Returns scratch space for count fringe vertex normal coordinates, reused from one call to the next.
+	GLfloat* fringeNormals(int count);
+
+	// Returns scratch space for count fringe edges, reused from one call to the next.
+	quint64* fringeEdges(int count);
+
+	// Returns scratch space for count dash coordinates, reused from one call to the next.
+	float* tessellateDashCoords(int count);
+
+	// Returns scratch space for count polygon or polyline corner indices, reused from one call to the next.
+	int* tessellatePolygonLinks(int count);
+
+	// Returns scratch space for count simplified polyline coordinates, reused from one call to the next.
+	GLfloat* tessellateSimplifyCoords(int count);
+
+	// Copies the points of a polyline that stray more than the current simplification tolerance from the lines between their neighbours, always keeping both ends, and returns how many were kept.
+	int simplifyPolyline(const GLfloat* points, int count, GLfloat* simplified);
+
+	// Returns scratch space for count floats of stroke points, directions and outlines, reused from one call to the next.
+	GLfloat* tessellateStrokeCoords(int count);
+
+	// Works out the bounds the texture coordinates of a stroke are spread over, from its points and the current stroke width.
+	void strokeBounds(const GLfloat* points, int count, GLfloat* bounds);
+
+	// Outlines a sequence of connected points with the current stroke, joining the end back to the start rather than capping both when closed.
+	void strokePolyline(CommandBuffer* tessellated, const GLfloat* points, int count, bool closed, const GLfloat* bounds);
+
+	// Outlines a sequence of connected points with the current stroke, cut into dashes in one pass along it when the stroke has a dash pattern.
+	void strokeDashed(CommandBuffer* tessellated, const GLfloat* points, int count, bool closed, const GLfloat* bounds);
+
+	// Outlines a run of distinct points into the mesh being tessellated, which has room for it, with the joins and caps of the current stroke.
+	void strokeRun(const GLfloat* points, const int* corners, int count, bool closed, bool startCap, bool endCap, const GLfloat* bounds);
+
+	// Tessellates an arc or round rectangle at the origin, or reuses the cached meshes for the same shape and stroke, and appends them moved into place.
+	void tessellateCached(RenderCommandHeader* command, CommandBuffer* tessellated);
+
+	// Writes a list of commands to a command stream file.
+	int writeCommandStream(CommandBuffer* commands, const QString& fileName);
+
+	// Appends a command to the display list being captured or else to the current frame.
+	RenderCommandHeader* appendCommand(RenderCommand command, int pointerCount, int floatCount, int intCount);
+
+	// Pushes the current rendering state.
+	void renderSaveState(RenderCommandHeader* command);
+
+	// Pops the most recently saved rendering state.
+	void renderRestoreState(RenderCommandHeader* command);
 
 
 	// Clears the specified rectangle by filling it with the background color of the current drawing surface.
-	void renderClearRect(int commandCount);
+	void renderClearRect(RenderCommandHeader* command);
 
 	// Intersects the current clip with the specified rectangle.
-	void renderClipRect(int commandCount);
+	void renderClipRect(RenderCommandHeader* command);
 
 	// Concatenates the current Graphics2D Transform with a rotation transform.
-	void 	renderRotate(int commandCount);
+	void 	renderRotate(RenderCommandHeader* command);
 
 	// Concatenates the current Graphics2D Transform with a scaling transformation Subsequent rendering is resized according to the specified scaling factors relative to the previous scaling.
-	void 	renderScale(int commandCount);
+	void 	renderScale(RenderCommandHeader* command);
 
 	// Concatenates the current Graphics2D Transform with a translation transform.
-	void 	renderTranslate(int commandCount);
+	void 	renderTranslate(RenderCommandHeader* command);
 
 	// Concatenates the current Graphics2D Transform with a shearing transform.
-	void 	renderShear(int commandCount);
+	void 	renderShear(RenderCommandHeader* command);
 
 	// Overwrites the Transform in the Graphics2D context.
-	void 	renderTransform(int commandCount);
+	void 	renderTransform(RenderCommandHeader* command);
 
 	// Sets the background color for the Graphics2D context.
-	void    renderSetBackground(int commandCount);
+	void    renderSetBackground(RenderCommandHeader* command);
 
 	// Sets this graphics context's current color to the specified color.
-	void renderSetColor(int commandCount);
+	void renderSetColor(RenderCommandHeader* command);
 
 	// Sets this graphics context's font to the specified font.
-	void renderSetFont(int commandCount);
+	void renderSetFont(RenderCommandHeader* command);
 
 	// Sets this graphics context's gradient to the specified gradient.
-	void renderSetGradient(int commandCount);
+	void renderSetGradient(RenderCommandHeader* command);
 
 	// Sets this graphics context's image texture to the specified image texture.
-	void renderSetImageTexture(int commandCount);
+	void renderSetImageTexture(RenderCommandHeader* command);
 
 	// Sets the Stroke for the Graphics2D context.
-    void renderSetStroke(int commandCount);
+    void renderSetStroke(RenderCommandHeader* command);
 
 	// Draws the outline of a circular or elliptical arc covering the specified rectangle.
-	void renderDrawFillArc(int commandCount);
+	void tessellateArc(RenderCommandHeader* command, CommandBuffer* tessellated);
 
 	// Draws as much of the specified area of the specified image as is currently available, scaling it on the fly to fit inside the specified area of the destination drawable surface.
-	void renderDrawImage(int commandCount);
+	void renderDrawImage(RenderCommandHeader* command);
 
 	// Renders a line, using the current color, between the points (x1, y1) and (x2, y2) in this graphics context's coordinate system.
-	void renderDrawLine(int commandCount);
+	void tessellateLine(RenderCommandHeader* command, CommandBuffer* tessellated);
 
 	// Draws a sequence of connected lines defined by arrays of x and y coordinates.
-	void renderDrawPolyline(int commandCount);
+	void tessellatePolyline(RenderCommandHeader* command, CommandBuffer* tessellated);
 
 	// Draws a sequence of connected lines defined by arrays of x and y coordinates.
-	void renderDrawFillRoundRect(int commandCount);
+	void tessellateRoundRect(RenderCommandHeader* command, CommandBuffer* tessellated);
 
 	// Renders the text specified by the specified String, using the current text attribute state in the Graphics2D context.
-	void 	renderDrawString(int commandCount);
+	void 	renderDrawString(RenderCommandHeader* command);
+
+	// Fills the specified polygon, as a fan if it is convex and by clipping ears off it otherwise.
+	void tessellatePolygon(RenderCommandHeader* command, CommandBuffer* tessellated);
 
-	// Fills the specified polygon.
-	void renderFillPolygon(int commandCount);
+	// Fills an outline of count (x,y) points with the given texture coordinates into the mesh being tessellated.
+	void fillOutline(CommandBuffer* tessellated, const GLfloat* polygon, const GLfloat* textureCoords, int count);
+
+	// Flattens, strokes or fills a path to the current tolerance, or reuses the meshes cached on it for the same tolerance and stroke, and appends them.
+	void tessellatePath(RenderCommandHeader* command, CommandBuffer* tessellated);
 
 
 	// defaults for drawing
@@ -616,24 +920,79 @@ protected:
 	ImageTexture* _currentImageTexture;
 	Stroke* _currentStroke;
 
-	int _commandCount;
-	RenderCommand* _drawCommands;
-
-	int _currentDrawFloatIndex;
-	int* _drawFloatIndices;
-	GLfloat* _drawFloats;
-
-	int _currentDrawIntIndex;
-	int* _drawIntIndices;
-	int* _drawInts;
-/*
-	int _currentDrawBoolIndex;
-	int* _drawBoolIndices;
-	bool* _drawBools;
-*/
-	int _currentDrawPointerIndex;
-	int* _drawPointerIndices;
-	void** _drawPointers;
+	// recorded commands - recording, ready to present and being rendered
+	CommandBuffer* _recordCommands;
+	CommandBuffer* _readyCommands;
+	CommandBuffer* _renderCommands;
+	bool _commandsReady;
+
+	// display list being captured and the drawing state to return to when it ends
+	DisplayList* _displayList;
+	RenderState _displayListState;
+
+	// command stream file to write the next completed frame to
+	QString _captureFileName;
+
+	// commands removed from the last completed frame
+	int _removedCommandCount;
+
+	// draws are regrouped by program into the spare list at done() when set
+	bool _commandReordering;
+	CommandBuffer* _reorderedCommands;
+	int _programSwitchesSaved;
+	QVector<ReorderDraw> _reorderDraws;
+	QVector<ReorderGroup> _reorderGroups;
+
+	// draws of the last completed frame, and the area changed since the last rendered one
+	QVector<DamageDraw> _damageDraws;
+	QVector<DamageDraw> _frameDraws;
+	GLfloat _pendingDamage[4];
+	bool _pendingFullDamage;
+	bool _partialRedraw;
+	int _redrawnPixelCount;
+
+	// hash of the last published frame, identical frames dropped since, and frames published and rendered by this context
+	unsigned int _frameHash;
+	bool _frameHashValid;
+	int _skippedFrameCount;
+	int _publishedFrames;
+	int _renderedFrames;
+
+	// geometry is tessellated into the spare list at done(), with the stroke in effect, the tolerance in its own coordinates and scratch space of its own
+	CommandBuffer* _tessellatedCommands;
+	Stroke* _tessellateStroke;
+	GLfloat _curveTolerance;
+	GLfloat _tessellateTolerance;
+	int _stencilThreshold;
+	bool _antialiasing;
+	GLfloat _tessellateFringe;
+	GLfloat _polylineTolerance;
+	GLfloat _tessellateSimplify;
+	int _removedVertexCount;
+	GLfloat* _tessellateVertexCoords;
+	GLfloat* _tessellateTextureCoords;
+	float* _tessellateDashCoords;
+	int _tessellateDashCapacity;
+	int* _tessellatePolygonLinks;
+	int _tessellatePolygonCapacity;
+	GLfloat* _tessellateStrokeCoords;
+	int _tessellateStrokeCapacity;
+	GLfloat* _tessellateSimplifyCoords;
+	int _tessellateSimplifyCapacity;
+	VertexBatch* _tessellateMesh;
+	VertexBatch* _fringeMesh;
+	int* _fringeVertices;
+	int _fringeVertexCapacity;
+	GLfloat* _fringeNormals;
+	int _fringeNormalCapacity;
+	quint64* _fringeEdges;
+	int _fringeEdgeCapacity;
+
+	// origin relative meshes of recently drawn arcs and round rectangles, least recently used dropped first
+	QCache<QByteArray, QByteArray> _meshCache;
+	CommandBuffer* _meshCacheCommands;
+	int _meshCacheHits;
+	int _meshCacheMisses;
 
 	// current values for rendering
 	GLColor _renderForegroundColor;
@@ -642,15 +1001,37 @@ protected:
 	Gradient* _renderGradient;
 	ImageTexture* _renderImageTexture;
 	Stroke* _renderStroke;
+	RenderState _renderStates[MAX_RENDER_STATES];
+	int _renderStateCount;
 #ifdef GLES2
 	GLfloat* _transformMatrix;
 	GLfloat* _renderModelMatrix;
 #endif
 
+	// text quads being drawn, with room for _renderCoordsCapacity characters
 	GLuint* _renderVertexIndices;
 	GLfloat* _renderVertexCoords;
 	GLfloat* _renderTextureCoords;
 	GLfloat* _renderMaskTextureCoords;
+	int _renderCoordsCapacity;
+
+	// buffers geometry is streamed through in this view's context, and those of the view being rendered
+	VertexStream* _vertexStream;
+	VertexStream* _renderStream;
+
+	// instance vertices expanded for a draw
+	GLfloat* _instanceCoords;
+	int _instanceCapacity;
+
+	// geometry and its edge fringes waiting to be drawn, and the color or gradient they are drawn with
+	VertexBatch* _renderBatch;
+	VertexBatch* _fringeBatch;
+	GLColor _batchColor;
+	Gradient* _batchGradient;
+
+	// draw calls issued so far in the frame being rendered and in the last complete one
+	int _drawCalls;
+	int _drawCallCount;
 
 #ifdef GLES2
 	GLuint   _polyColorRenderingProgram;
@@ -660,6 +1041,13 @@ protected:
 	GLuint   _textRenderingProgram;
 	GLuint   _textGradientRenderingProgram;
 	GLuint   _textImageTextureRenderingProgram;
+	GLuint   _instanceRenderingProgram;
+	ProgramLocations _polyColorLocations;
+	ProgramLocations _polyTextureLocations;
+	ProgramLocations _polyGradientLocations;
+	ProgramLocations _textLocations;
+	ProgramLocations _textGradientLocations;
+	ProgramLocations _instanceLocations;
 	GLfloat* _orthoMatrix;
 	GLfloat* _scaleMatrix;
 #endif
@@ -667,8 +1055,11 @@ protected:
 
 	// state variables
 	QMap<ImageData*,int> _glTextureIDImageMap;
+	QVector<GLuint> _lookupTextures; // gradient lookup textures created in this context
+	QVector<GLuint> _freedTextures; // lookup textures of freed gradients, deleted by the next render
+	int _contextId; // tells the contexts lookup textures were created in apart
 	QMutex _drawMutex;
-	QMutex _refreshMutex;
+	QMutex _refreshMutex; // only held while swapping the command lists
 	bool _drawing;
 
 	Graphics2D* _master2D;
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef PATH2D_HPP
+#define PATH2D_HPP
+
+#include <stdlib.h>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
+#include <QtCore/QVector>
+
+#include "Graphics.hpp"
+
+namespace views {
+	namespace graphics {
+
+typedef enum PathSegment {
+	SEG_CLOSE, // Closes the current subpath with a straight line back to its first point, which is joined rather than capped.
+	SEG_MOVETO, // Starts a new subpath at a point.
+	SEG_LINETO, // A straight line from the current point to a point.
+	SEG_QUADTO, // A quadratic Bezier curve from the current point through one control point to a point.
+	SEG_CUBICTO, // A cubic Bezier curve from the current point through two control points to a point.
+} PathSegment;
+
+typedef enum PathFillRule {
+	FILL_RULE_NONZERO, // Fills the points the outline winds around any number of times other than zero, counting clockwise against counter clockwise.
+	FILL_RULE_EVENODD, // Fills the points an odd number of edges away from the outside.
+} PathFillRule;
+
+typedef enum PathFillMode {
+	FILL_MODE_AUTO, // Triangulates simple outlines and goes through the stencil buffer for the rest, see Graphics2D::setStencilThreshold.
+	FILL_MODE_TRIANGULATE, // Cuts each subpath into triangles on the CPU, which ignores the fill rule and may go wrong for outlines that cross themselves.
+	FILL_MODE_STENCIL, // Marks the filled pixels in the stencil buffer with a fan of each subpath and then covers them, whatever the outlines look like. Triangulates when the surface has no stencil buffer.
+} PathFillMode;
+
+// limits
+#define PATH_MESH_CACHE_SIZE	(256 * 1024)
+#define PATH_MAX_CURVE_STEPS	256
+
+// A shape made of straight and curved segments, built once and drawn or filled any number of times with Graphics2D::drawPath / fillPath.
+// The flattened outline and the meshes it is drawn with are kept on the path and reused until it changes.
+// Paths are referenced by the commands drawing them, not copied, and must not change or be freed until the frame drawing them is done.
+class Q_DECL_EXPORT Path2D {
+
+public:
+	Path2D();
+	virtual ~Path2D();
+
+	// starts a new subpath at the point (x, y)
+	void moveTo(double x, double y);
+
+	// adds a straight line from the current point to the point (x, y)
+	void lineTo(double x, double y);
+
+	// adds a quadratic curve from the current point to the point (x, y), pulled towards the control point (cx, cy)
+	void quadTo(double cx, double cy, double x, double y);
+
+	// adds a cubic curve from the current point to the point (x, y), leaving along (c1x, c1y) and arriving along (c2x, c2y)
+	void cubicTo(double c1x, double c1y, double c2x, double c2y, double x, double y);
+
+	// adds an arc of the given radius touching the line from the current point to (x1, y1) and the line from there to (x2, y2), joined to the current point by a straight line
+	void arcTo(double x1, double y1, double x2, double y2, double radius);
+
+	// closes the current subpath with a straight line back to where it started
+	void close();
+
+	// discards every segment
+	void clear();
+
+	// returns true if the path has no segments
+	bool isEmpty();
+
+	// sets which points the subpaths fill when they overlap or cross themselves, one of the FILL_RULE values
+	void setFillRule(int fillRule);
+	int fillRule();
+
+	// sets how fills are drawn, one of the FILL_MODE values
+	void setFillMode(int fillMode);
+	int fillMode();
+
+	// returns a number that changes whenever the path does, and is never shared by two paths
+	int version();
+
+	// works out min x, min y, max x, max y of the points and control points, returning false if the path is empty
+	bool bounds(GLfloat* bounds);
+
+	// cuts the curves into straight lines no further than tolerance from them, reusing the last result for the same tolerance, and returns the number of subpaths
+	int flatten(GLfloat tolerance);
+
+	// returns the (x,y) points of a flattened subpath, which end back on the first one if the subpath is closed
+	const GLfloat* subpath(int index, int* count);
+
+	// returns true if a flattened subpath was closed with a CLOSE segment, rather than just ending where it started
+	bool subpathClosed(int index);
+
+	// returns the meshes last cached for the given kind of draw, or NULL
+	QByteArray* meshes(const QByteArray& key);
+
+	// keeps the meshes for a kind of draw until the path changes, taking ownership of them, and returns false if they were too big to keep
+	bool cacheMeshes(const QByteArray& key, QByteArray* meshes);
+
+protected:
+	// starts a subpath at (x, y) if there is no current point, or again where the last one started if it was closed
+	void beginSegment(double x, double y);
+
+	// appends a segment and its points
+	void appendSegment(int segment, const GLfloat* coords, int count);
+
+	// appends an arc around (cx, cy) as cubic curves of a quarter turn at most
+	void appendArc(double cx, double cy, double radius, double startAngle, double sweep);
+
+	// drops the flattened outline and meshes and takes a new version
+	void changed();
+
+	// segments, and the points and control points of all of them in order
+	QVector<int> _segments;
+	QVector<GLfloat> _coords;
+
+	GLfloat _startX;
+	GLfloat _startY;
+	GLfloat _currentX;
+	GLfloat _currentY;
+
+	int _fillRule;
+	int _fillMode;
+
+	int _version;
+
+	// flattened subpaths as their first point, point count and whether they were closed
+	int _flatVersion;
+	GLfloat _flatTolerance;
+	QVector<GLfloat> _flatPoints;
+	QVector<int> _flatSubpaths;
+
+	QCache<QByteArray, QByteArray> _meshCache;
+};
+
+	}
+}
+
+#endif /* PATH2D_HPP */
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef VECTORMATH_HPP
+#define VECTORMATH_HPP
+
+#include <stdlib.h>
+
+// only the GL types are needed, which lets the benchmark build this on its own
+#ifdef GLES1
+#include <GLES/gl.h>
+#elif defined(GLES3)
+#include <GLES3/gl3.h>
+#elif defined(GLES2)
+#include <GLES2/gl2.h>
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+
+#include <QtGlobal>
+
+namespace views {
+	namespace graphics {
+
+// Vertex kernels, vectorized with NEON on the device and SSE on the simulator, and plain loops anywhere else.
+
+// multiplies two 4x4 matrices laid out the way the renderer keeps them, result[i*4+j] = sum of first[i*4+k] * second[k*4+j] - result may be either of them
+Q_DECL_EXPORT void multiplyMatrix(const GLfloat* first, const GLfloat* second, GLfloat* result);
+
+// transforms count (x,y) points by the affine transform a, b, c, d, e, f for x' = a x + c y + e and y' = b x + d y + f - result may be points
+Q_DECL_EXPORT void transformPoints(const GLfloat* affine, const GLfloat* points, int count, GLfloat* result);
+
+// works out the unit (x,y) direction and the length of each of count segments joining count + 1 consecutive points, with no direction for empty ones
+Q_DECL_EXPORT void segmentDirections(const GLfloat* points, int count, GLfloat* directions, GLfloat* lengths);
+
+// pushes the ends of each of count segments out either side by halfWidth along its normal, as start left, start right, end left and end right (x,y) pairs
+Q_DECL_EXPORT void extrudeSegments(const GLfloat* points, const GLfloat* directions, int count, GLfloat halfWidth, GLfloat* outlines);
+
+	}
+}
+
+#endif /* VECTORMATH_HPP */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef VERTEXBATCH_HPP
+#define VERTEXBATCH_HPP
+
+#include <stdlib.h>
+
+#include "Graphics.hpp"
+
+namespace views {
+	namespace graphics {
+
+// limits
+#define VERTEX_BATCH_INITIAL_VERTICES	1024
+#define VERTEX_BATCH_MAX_VERTICES		65536
+
+// A growable stream of 2D vertices with texture coordinates, coverage alphas and 16-bit triangle indices, kept across resets.
+class Q_DECL_EXPORT VertexBatch {
+
+public:
+	VertexBatch();
+	virtual ~VertexBatch();
+
+	// rewinds the batch to empty, keeping the allocated arrays for reuse
+	void reset();
+
+	// returns true if nothing has been added since the last reset
+	bool isEmpty();
+
+	// returns the number of vertices and indices in the batch
+	int vertexCount();
+	int indexCount();
+
+	// returns true if the given number of vertices still fits under the 16-bit index limit
+	bool hasRoomFor(int vertexCount);
+
+	// returns true if any vertex added since the last reset is only partly covered
+	bool hasAlphas();
+
+	// vertex (x,y) pairs, texture (u,v) pairs, coverage alphas and triangle indices
+	GLfloat* vertexCoords();
+	GLfloat* textureCoords();
+	GLfloat* vertexAlphas();
+	GLushort* indices();
+
+	// returns the (r,g,b,a) of each vertex, the given color with its alpha scaled by the coverage of the vertex
+	GLfloat* vertexColors(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+
+	// adds one vertex, fully covered unless an alpha is given, and returns its index
+	int addVertex(GLfloat x, GLfloat y, GLfloat u, GLfloat v, GLfloat alpha = 1.0);
+
+	// adds a triangle between three vertices already in the batch
+	void addTriangle(int index1, int index2, int index3);
+
+	// adds triangle strips of stripPoints vertices each, laid out one after the other, as indexed triangles with the same winding
+	void addStrips(const GLfloat* vertexCoords, const GLfloat* textureCoords, int stripCount, int stripPoints);
+
+	// adds an indexed triangle mesh, fully covered if there are no alphas, offsetting its indices past the vertices already in the batch
+	void addMesh(const GLfloat* vertexCoords, const GLfloat* textureCoords, const GLfloat* alphas, int vertexCount, const GLushort* indices, int indexCount);
+
+protected:
+	void reserveVertices(int count);
+	void reserveIndices(int count);
+
+	GLfloat* _vertexCoords;
+	GLfloat* _textureCoords;
+	GLfloat* _vertexAlphas;
+	GLfloat* _vertexColors;
+	GLushort* _indices;
+
+	int _vertexCount;
+	int _vertexCapacity;
+	int _indexCount;
+	int _indexCapacity;
+	int _colorCapacity;
+	bool _hasAlphas;
+};
+
+	}
+}
+
+#endif /* VERTEXBATCH_HPP */
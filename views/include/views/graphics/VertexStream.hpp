@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef VERTEXSTREAM_HPP
+#define VERTEXSTREAM_HPP
+
+#include <stdlib.h>
+
+#include "Graphics.hpp"
+
+namespace views {
+	namespace graphics {
+
+// limits
+#define VERTEX_STREAM_INITIAL_VERTEX_BYTES	(256 * 1024)
+#define VERTEX_STREAM_INITIAL_INDEX_BYTES	(64 * 1024)
+
+// A vertex buffer and index buffer pair that draws stream their geometry through, filled front to back and orphaned when full.
+class Q_DECL_EXPORT VertexStream {
+
+public:
+	VertexStream();
+	virtual ~VertexStream();
+
+	// generates the buffers in the current GL context, which has to stay current while they are used
+	void create();
+
+	// binds both buffers, which stay bound for the writes and draws that follow
+	void bind();
+
+	// makes room for the vertex and index bytes of one draw, orphaning a buffer that cannot take them so that all of the draw lands in the same storage
+	void reserve(int vertexBytes, int indexBytes);
+
+	// copies data after what was already written to the bound buffers and returns its byte offset, to be passed in place of a client array pointer
+	const GLvoid* writeVertices(const GLvoid* data, int bytes);
+	const GLvoid* writeIndices(const GLvoid* data, int bytes);
+
+	// returns the number of times a buffer was orphaned for lack of room
+	int orphanCount();
+
+protected:
+	void orphan(GLenum target, int* capacity, int* used, int bytes);
+	const GLvoid* write(GLenum target, int* capacity, int* used, const GLvoid* data, int bytes);
+
+	GLuint _vertexBuffer;
+	GLuint _indexBuffer;
+
+	int _vertexCapacity;
+	int _vertexUsed;
+	int _indexCapacity;
+	int _indexUsed;
+	int _orphanCount;
+};
+
+	}
+}
+
+#endif /* VERTEXSTREAM_HPP */
@@ -27,6 +27,7 @@ CanvasView::CanvasView(ViewDisplay display) : View(display)
 	int _gradientID = 0;
 	int _imageTextureID = 0;
 	int _strokeID = 0;
+	_pathID = 0;
 
 	_graphics2D = new Graphics2D(DISPLAY_DEVICE);
 	registerGraphics(_graphics2D);
@@ -35,6 +36,7 @@ CanvasView::CanvasView(ViewDisplay display) : View(display)
 
 CanvasView::~CanvasView()
 {
+	qDeleteAll(_pathIDMap);
 }
 
 // resets the context to a default state
@@ -168,6 +170,116 @@ int CanvasView::createImageTexture(int imageID, int scaling, int tiling, float u
 	return _strokeID;
 }
 
+// Creates a new empty path.
+int CanvasView::createPath()
+{
+	Path2D* path = new Path2D();
+	_pathID++;
+	_pathIDMap.insert(_pathID, path);
+
+	return _pathID;
+}
+
+// Frees the specified path, which must not be drawn in a frame that is not done yet.
+void CanvasView::freePath(int pathID)
+{
+	Path2D* path = _pathIDMap.take(pathID);
+
+	if (path) {
+		delete path;
+	}
+}
+
+// Starts a new subpath of the specified path at the point (x, y).
+void CanvasView::moveTo(int pathID, double x, double y)
+{
+	Path2D* path = _pathIDMap.value(pathID);
+
+	if (path) {
+		path->moveTo(x, y);
+	}
+}
+
+// Adds a straight line to the point (x, y) to the specified path.
+void CanvasView::lineTo(int pathID, double x, double y)
+{
+	Path2D* path = _pathIDMap.value(pathID);
+
+	if (path) {
+		path->lineTo(x, y);
+	}
+}
+
+// Adds a quadratic curve through the control point (cx, cy) to the point (x, y) to the specified path.
+void CanvasView::quadTo(int pathID, double cx, double cy, double x, double y)
+{
+	Path2D* path = _pathIDMap.value(pathID);
+
+	if (path) {
+		path->quadTo(cx, cy, x, y);
+	}
+}
+
+// Adds a cubic curve through the control points (c1x, c1y) and (c2x, c2y) to the point (x, y) to the specified path.
+void CanvasView::cubicTo(int pathID, double c1x, double c1y, double c2x, double c2y, double x, double y)
+{
+	Path2D* path = _pathIDMap.value(pathID);
+
+	if (path) {
+		path->cubicTo(c1x, c1y, c2x, c2y, x, y);
+	}
+}
+
+// Adds an arc of the given radius rounding the corner at (x1, y1) on the way to (x2, y2) to the specified path.
+void CanvasView::arcTo(int pathID, double x1, double y1, double x2, double y2, double radius)
+{
+	Path2D* path = _pathIDMap.value(pathID);
+
+	if (path) {
+		path->arcTo(x1, y1, x2, y2, radius);
+	}
+}
+
+// Closes the current subpath of the specified path.
+void CanvasView::closePath(int pathID)
+{
+	Path2D* path = _pathIDMap.value(pathID);
+
+	if (path) {
+		path->close();
+	}
+}
+
+// Discards every segment of the specified path.
+void CanvasView::clearPath(int pathID)
+{
+	Path2D* path = _pathIDMap.value(pathID);
+
+	if (path) {
+		path->clear();
+	}
+}
+
+// Sets which points the specified path fills where its subpaths overlap or cross, one of the FILL_RULE values.
+void CanvasView::setFillRule(int pathID, int fillRule)
+{
+	Path2D* path = _pathIDMap.value(pathID);
+
+	if (path) {
+		path->setFillRule(fillRule);
+	}
+}
+
+// Sets whether the specified path is filled by triangulating it or through the stencil buffer, one of the FILL_MODE values.
+void CanvasView::setFillMode(int pathID, int fillMode)
+{
+	Path2D* path = _pathIDMap.value(pathID);
+
+	if (path) {
+		path->setFillMode(fillMode);
+	}
+}
+
 // Concatenates the current Graphics2D Transform with a rotation transform.
 void CanvasView::rotate(double theta)
 {
@@ -451,6 +563,12 @@ void CanvasView::drawRect(double x, double y, double width, double height)
 	_graphics2D->drawRect(x, y, width, height);
 }
 
+// Draws the outline of the specified path with the current stroke.
+void CanvasView::drawPath(int pathID)
+{
+	_graphics2D->drawPath(_pathIDMap.value(pathID));
+}
+
 // Draws an outlined round-cornered rectangle using this graphics context's current color.
 void CanvasView::drawRoundRect(double x, double y, double width, double height, double arcWidth, double arcHeight)
 {
@@ -521,6 +639,12 @@ void CanvasView::fillPolygon(QVariantList xPoints, QVariantList yPoints, int nPo
 	}
 }
 
+// Fills the subpaths of the specified path.
+void CanvasView::fillPath(int pathID)
+{
+	_graphics2D->fillPath(_pathIDMap.value(pathID));
+}
+
 // Fills the specified rounded corner rectangle with the current color.
 void CanvasView::fillRoundRect(double x, double y, double width, double height, double arcWidth, double arcHeight)
 {
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CommandBuffer.hpp"
+
+#include <string.h>
+
+#include <QDebug>
+
+namespace views {
+	namespace graphics {
+
+CommandBuffer::CommandBuffer(int chunkSize)
+{
+	_chunkSize = chunkSize;
+	_count = 0;
+
+	_firstChunk = createChunk(_chunkSize);
+	_currentChunk = _firstChunk;
+}
+
+CommandBuffer::~CommandBuffer()
+{
+	CommandChunk* chunk = _firstChunk;
+	while (chunk) {
+		CommandChunk* next = chunk->next;
+
+		if (chunk->owned && chunk->data) {
+			delete [] chunk->data;
+		}
+		delete chunk;
+
+		chunk = next;
+	}
+}
+
+// allocates a new, unlinked chunk of at least the given size
+CommandChunk* CommandBuffer::createChunk(int size)
+{
+	CommandChunk* chunk = new CommandChunk;
+
+	chunk->data = new unsigned char[size];
+	chunk->size = size;
+	chunk->used = 0;
+	chunk->owned = true;
+	chunk->next = NULL;
+
+	//qDebug()  << "CommandBuffer::createChunk: " << size;
+
+	return chunk;
+}
+
+RenderCommandHeader* CommandBuffer::append(RenderCommand command, int pointerCount, int floatCount, int intCount)
+{
+	int size = COMMAND_RECORD_ALIGN(COMMAND_HEADER_SIZE + pointerCount * sizeof(void*) + floatCount * sizeof(GLfloat) + intCount * sizeof(int));
+
+	if (_currentChunk->used + size > _currentChunk->size) {
+		// move on to the next chunk, reusing one kept from a previous frame if it is big enough
+		CommandChunk* next = _currentChunk->next;
+		if (next == NULL || !next->owned || next->size < size) {
+			CommandChunk* chunk = createChunk(size > _chunkSize ? size : _chunkSize);
+			chunk->next = next;
+			_currentChunk->next = chunk;
+			next = chunk;
+		}
+
+		_currentChunk = next;
+		_currentChunk->used = 0;
+	}
+
+	RenderCommandHeader* header = (RenderCommandHeader*)(_currentChunk->data + _currentChunk->used);
+	header->command = command;
+	header->size = size;
+	header->pointerCount = pointerCount;
+	header->floatCount = floatCount;
+	header->intCount = intCount;
+
+	_currentChunk->used += size;
+	_count++;
+
+	return header;
+}
+
+RenderCommandHeader* CommandBuffer::appendCopy(const RenderCommandHeader* header)
+{
+	RenderCommandHeader* copy = append(header->command, header->pointerCount, header->floatCount, header->intCount);
+
+	memcpy(commandPointers(copy), commandPointers(header), header->size - COMMAND_HEADER_SIZE);
+
+	return copy;
+}
+
+void CommandBuffer::appendBuffer(CommandBuffer* buffer)
+{
+	CommandCursor cursor;
+	RenderCommandHeader* header;
+
+	if (buffer == this) {
+		qCritical() << "CommandBuffer::appendBuffer: a buffer cannot be appended to itself\n";
+		return;
+	}
+
+	buffer->begin(&cursor);
+	while((header = buffer->next(&cursor)) != NULL) {
+		if (header->command != RENDER_SKIP) {
+			appendCopy(header);
+		}
+	}
+}
+
+void CommandBuffer::attach(unsigned char* data, int size, int count)
+{
+	trim();
+
+	// the first chunk stays empty so that later appends never write into the attached memory
+	CommandChunk* chunk = new CommandChunk;
+
+	chunk->data = data;
+	chunk->size = size;
+	chunk->used = size;
+	chunk->owned = false;
+	chunk->next = NULL;
+
+	_firstChunk->next = chunk;
+	_currentChunk = chunk;
+	_count = count;
+}
+
+void CommandBuffer::reset()
+{
+	CommandChunk* chunk = _firstChunk;
+	while (chunk) {
+		chunk->used = 0;
+		chunk = chunk->next;
+	}
+
+	_currentChunk = _firstChunk;
+	_count = 0;
+}
+
+void CommandBuffer::trim()
+{
+	CommandChunk* chunk = _firstChunk->next;
+	while (chunk) {
+		CommandChunk* next = chunk->next;
+
+		if (chunk->owned && chunk->data) {
+			delete [] chunk->data;
+		}
+		delete chunk;
+
+		chunk = next;
+	}
+
+	_firstChunk->next = NULL;
+	_firstChunk->used = 0;
+	_currentChunk = _firstChunk;
+	_count = 0;
+}
+
+int CommandBuffer::count()
+{
+	return _count;
+}
+
+int CommandBuffer::bytesUsed()
+{
+	int used = 0;
+
+	CommandChunk* chunk = _firstChunk;
+	while (chunk) {
+		used += chunk->used;
+		if (chunk == _currentChunk) {
+			break;
+		}
+		chunk = chunk->next;
+	}
+
+	return used;
+}
+
+void CommandBuffer::begin(CommandCursor* cursor)
+{
+	cursor->chunk = _firstChunk;
+	cursor->offset = 0;
+}
+
+RenderCommandHeader* CommandBuffer::next(CommandCursor* cursor)
+{
+	while (cursor->chunk && cursor->offset >= cursor->chunk->used) {
+		if (cursor->chunk == _currentChunk) {
+			cursor->chunk = NULL;
+		} else {
+			cursor->chunk = cursor->chunk->next;
+			cursor->offset = 0;
+		}
+	}
+
+	if (cursor->chunk == NULL) {
+		return NULL;
+	}
+
+	RenderCommandHeader* header = (RenderCommandHeader*)(cursor->chunk->data + cursor->offset);
+	cursor->offset += header->size;
+
+	return header;
+}
+
+	}
+}
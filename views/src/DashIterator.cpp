@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DashIterator.hpp"
+
+#include <math.h>
+
+#include <QDebug>
+
+namespace views {
+	namespace graphics {
+
+DashIterator::DashIterator()
+{
+	_dash = NULL;
+	_dashCount = 0;
+
+	_dashIndex = 0;
+	_dashRemaining = 0.0;
+
+	_segmentLength = 0.0;
+	_segmentPosition = 0.0;
+
+	_inDash = false;
+	_startsDash = false;
+	_endsDash = false;
+}
+
+DashIterator::~DashIterator()
+{
+}
+
+bool DashIterator::begin(const GLfloat* dash, int dashCount, GLfloat dashPhase)
+{
+	_dash = dash;
+	_dashCount = dashCount;
+
+	_segmentLength = 0.0;
+	_segmentPosition = 0.0;
+
+	_inDash = false;
+	_startsDash = false;
+	_endsDash = false;
+
+	if (dash == NULL || dashCount < 2) {
+		return false;
+	}
+
+	GLfloat patternLength = 0.0;
+	for(int index = 0; index < dashCount; index++) {
+		if (dash[index] < 0.0) {
+			qCritical() << "DashIterator::begin: negative dash length " << dash[index];
+			return false;
+		}
+		patternLength += dash[index];
+	}
+
+	if (patternLength <= 0.0) {
+		return false;
+	}
+
+	// the phase only matters modulo the length of the whole pattern
+	GLfloat phase = fmod(dashPhase, patternLength);
+	if (phase < 0.0) {
+		phase += patternLength;
+	}
+
+	_dashIndex = 0;
+	_dashRemaining = dash[0];
+
+	for(int skipped = 0; phase > 0.0 && phase >= _dashRemaining && skipped < dashCount; skipped++) {
+		phase -= _dashRemaining;
+		_dashIndex = (_dashIndex + 1) % dashCount;
+		_dashRemaining = dash[_dashIndex];
+	}
+
+	_dashRemaining -= phase;
+	if (_dashRemaining < 0.0) {
+		_dashRemaining = 0.0;
+	}
+
+	return true;
+}
+
+void DashIterator::nextSegment(GLfloat length)
+{
+	_segmentLength = length;
+	_segmentPosition = 0.0;
+}
+
+bool DashIterator::nextSpan(GLfloat* from, GLfloat* to)
+{
+	while (_segmentPosition < _segmentLength) {
+		GLfloat start = _segmentPosition;
+		bool inked = (_dashIndex % 2) == 0;
+		bool entryEnds = _dashRemaining <= _segmentLength - _segmentPosition;
+
+		if (entryEnds) {
+			_segmentPosition += _dashRemaining;
+			_dashIndex = (_dashIndex + 1) % _dashCount;
+			_dashRemaining = _dash[_dashIndex];
+		} else {
+			_dashRemaining -= _segmentLength - _segmentPosition;
+			_segmentPosition = _segmentLength;
+		}
+
+		if (inked) {
+			*from = start;
+			*to = _segmentPosition;
+
+			// with an odd number of entries the pattern wraps onto another inked entry, which carries the same dash on
+			_startsDash = !_inDash;
+			_endsDash = entryEnds && (_dashIndex % 2) != 0;
+			_inDash = !_endsDash;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool DashIterator::startsDash()
+{
+	return _startsDash;
+}
+
+bool DashIterator::endsDash()
+{
+	return _endsDash;
+}
+
+	}
+}
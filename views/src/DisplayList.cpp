@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "DisplayList.hpp"
+#include "Graphics2D.hpp"
+
+#include <sys/mman.h>
+
+#include <QDebug>
+
+namespace views {
+	namespace graphics {
+
+DisplayList::DisplayList()
+{
+	// static content is usually small, so grow in smaller steps than a frame
+	_commands = new CommandBuffer(COMMAND_BUFFER_CHUNK_SIZE / 16);
+	_bakedCommands = new CommandBuffer(COMMAND_BUFFER_CHUNK_SIZE / 16);
+
+	_mapping = NULL;
+	_mappingLength = 0;
+	_graphics2D = NULL;
+}
+
+DisplayList::~DisplayList()
+{
+	clear();
+
+	if (_commands) {
+		delete _commands;
+	}
+
+	if (_bakedCommands) {
+		delete _bakedCommands;
+	}
+}
+
+void DisplayList::clear()
+{
+	//qDebug()  << "DisplayList::clear: " << _commands->count();
+
+	_commands->trim();
+	_bakedCommands->trim();
+
+	// loaded strokes and gradients point into the mapping for their arrays, so they go first
+	while (!_strokes.isEmpty()) {
+		delete _strokes.takeFirst();
+	}
+
+	// gradients that were drawn hold a lookup texture, which only a Graphics2D can let go of
+	while (!_gradients.isEmpty()) {
+		if (_graphics2D) {
+			_graphics2D->freeGradient(_gradients.takeFirst());
+		} else {
+			delete _gradients.takeFirst();
+		}
+	}
+
+	while (!_imageTextures.isEmpty()) {
+		delete _imageTextures.takeFirst();
+	}
+
+	if (_mapping) {
+		munmap(_mapping, _mappingLength);
+		_mapping = NULL;
+		_mappingLength = 0;
+	}
+
+	_graphics2D = NULL;
+}
+
+bool DisplayList::isEmpty()
+{
+	return _commands->count() == 0;
+}
+
+CommandBuffer* DisplayList::commands()
+{
+	return _commands;
+}
+
+CommandBuffer* DisplayList::bakedCommands()
+{
+	return _bakedCommands;
+}
+
+void DisplayList::map(Graphics2D* graphics2D, unsigned char* mapping, size_t mappingLength, unsigned char* commands, int commandBytes, int commandCount)
+{
+	_commands->attach(commands, commandBytes, commandCount);
+
+	_mapping = mapping;
+	_mappingLength = mappingLength;
+	_graphics2D = graphics2D;
+}
+
+void DisplayList::retain(Stroke* stroke)
+{
+	_strokes.append(stroke);
+}
+
+void DisplayList::retain(Gradient* gradient)
+{
+	_gradients.append(gradient);
+}
+
+void DisplayList::retain(ImageTexture* imageTexture)
+{
+	_imageTextures.append(imageTexture);
+}
+
+	}
+}
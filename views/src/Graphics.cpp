@@ -16,6 +16,7 @@
 
 #include <math.h>
 #include <pthread.h>
+#include <string.h>
 
 #include "Graphics.hpp"
 #include "View.hpp"
@@ -33,6 +34,15 @@ bool       Graphics::_eglInitialized = false;
 EGLConfig  Graphics::_eglConfig;
 EGLDisplay Graphics::_eglDeviceDisplay;
 EGLDisplay Graphics::_eglHDMIDisplay;
+SwapBuffersWithDamage Graphics::_eglSwapBuffersWithDamage = NULL;
+EGLint     Graphics::_eglStencilSize = 0;
+
+// parts of the GL state the tracker holds a known value for
+#define STATE_PROGRAM		0x01
+#define STATE_BLENDING		0x02
+#define STATE_BLEND_FUNC	0x04
+#define STATE_TEXTURE		0x08
+#define STATE_TEXTURING		0x10
 
 Graphics::Graphics(int display, Graphics *master = NULL) : _width(0), _height(0)
 {
@@ -48,6 +58,25 @@ Graphics::Graphics(int display, Graphics *master = NULL) : _width(0), _height(0)
 
 	_renderedImage = NULL;
 
+	_preserveRequested = false;
+	_surfacePreserved = false;
+	_fullRedraw = true;
+	_partialSwap = false;
+
+	_stateKnown = 0;
+	_stateArraysKnown = 0;
+	_stateArrays = 0;
+	_stateProgram = 0;
+	_stateTexture = 0;
+	_stateBlendSource = GL_ONE;
+	_stateBlendDestination = GL_ZERO;
+	_stateBlending = false;
+	_stateTexturing = false;
+	_stateChangesIssued = 0;
+	_stateChangesAvoided = 0;
+	_stateChangesIssuedCount = 0;
+	_stateChangesAvoidedCount = 0;
+
 	qDebug()  << "Graphics: Graphics " << _eglDisplay;
 }
 
@@ -63,6 +92,9 @@ int Graphics::initialize(screen_window_t screenWindow)
 
 #ifdef GLES1
     _eglContext = eglCreateContext(_eglDisplay, _eglConfig, EGL_NO_CONTEXT, NULL);
+#elif defined(GLES3)
+    EGLint attributes[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+    _eglContext = eglCreateContext(_eglDisplay, _eglConfig, EGL_NO_CONTEXT, attributes);
 #elif defined(GLES2)
     EGLint attributes[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
     _eglContext = eglCreateContext(_eglDisplay, _eglConfig, EGL_NO_CONTEXT, attributes);
@@ -86,6 +118,11 @@ int Graphics::initialize(screen_window_t screenWindow)
 
 	getGLContext();
 
+	// a new surface starts out discarding its contents on every swap
+	_preserveRequested = false;
+	_surfacePreserved = false;
+	_fullRedraw = true;
+
     EGLint interval = 1;
     status = eglSwapInterval(_eglDisplay, interval);
 	if (status != EGL_TRUE) {
@@ -121,6 +158,7 @@ int Graphics::initializeEGL() {
                            EGL_BLUE_SIZE,       8,
                            EGL_SURFACE_TYPE,    EGL_WINDOW_BIT,
                            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES_BIT,
+                           EGL_STENCIL_SIZE,    8,
                            EGL_NONE};
 
     _eglDeviceDisplay = EGL_NO_DISPLAY;
@@ -138,6 +176,13 @@ int Graphics::initializeEGL() {
         return EXIT_FAILURE;
     }
 
+    const char* extensions = eglQueryString(_eglDeviceDisplay, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_KHR_swap_buffers_with_damage")) {
+    	_eglSwapBuffersWithDamage = (SwapBuffersWithDamage)eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+    } else if (extensions && strstr(extensions, "EGL_EXT_swap_buffers_with_damage")) {
+    	_eglSwapBuffersWithDamage = (SwapBuffersWithDamage)eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+    }
+
 	returnCode = eglBindAPI(EGL_OPENGL_ES_API);
 
     if (returnCode != EGL_TRUE) {
@@ -154,9 +199,23 @@ int Graphics::initializeEGL() {
 #error libviews should be compiled with either GLES1 or GLES2 -D flags.
 #endif
 
-    if(!eglChooseConfig(_eglDeviceDisplay, attribList, &_eglConfig, 1, &numConfigs)) {
-        perror("eglChooseConfig");
-        return EXIT_FAILURE;
+    // prefer a config with a stencil buffer, for filling complex paths, and then one which can keep the surface contents across swaps, for partial redraws
+    EGLint surfaceTypes[] = { EGL_WINDOW_BIT | EGL_SWAP_BEHAVIOR_PRESERVED_BIT, EGL_WINDOW_BIT, EGL_WINDOW_BIT | EGL_SWAP_BEHAVIOR_PRESERVED_BIT, EGL_WINDOW_BIT };
+
+    numConfigs = 0;
+    for(int attempt = 0; attempt < 4 && numConfigs == 0; attempt++) {
+    	attribList[7] = surfaceTypes[attempt];
+    	attribList[10] = attempt < 2 ? EGL_STENCIL_SIZE : EGL_NONE;
+
+        if(!eglChooseConfig(_eglDeviceDisplay, attribList, &_eglConfig, 1, &numConfigs)) {
+            perror("eglChooseConfig");
+            return EXIT_FAILURE;
+        }
+    }
+
+    _eglStencilSize = 0;
+    if (numConfigs > 0) {
+    	eglGetConfigAttrib(_eglDeviceDisplay, _eglConfig, EGL_STENCIL_SIZE, &_eglStencilSize);
     }
 
 	_eglInitialized = true;
@@ -318,6 +377,11 @@ int Graphics::regenerate(screen_window_t screenWindow)
 
 	getGLContext();
 
+	// a new surface starts out discarding its contents on every swap
+	_preserveRequested = false;
+	_surfacePreserved = false;
+	_fullRedraw = true;
+
     status = eglSwapInterval(_eglDisplay, interval);
 	if (status != EGL_TRUE) {
 		eglPrintError("eglSwapInterval");
@@ -351,6 +415,9 @@ void Graphics::clear()
 
 	swapBuffers();
 
+	// the surface no longer holds the last frame
+	_fullRedraw = true;
+
 	unlockRendering();
 }
 
@@ -366,6 +433,12 @@ void Graphics::renderSafe(bool saveRender)
 
 	lockRendering();
 
+	// nothing new to show and the surface still holds the last frame, so neither render nor swap
+	if (!saveRender && !_fullRedraw && !frameChanged()) {
+		unlockRendering();
+		return;
+	}
+
 	getGLContext();
 
 	render();
@@ -379,6 +452,178 @@ void Graphics::renderSafe(bool saveRender)
 	unlockRendering();
 }
 
+void Graphics::invalidate()
+{
+	_fullRedraw = true;
+}
+
+bool Graphics::frameChanged()
+{
+	return true;
+}
+
+int Graphics::stateChangesIssued()
+{
+	return _master->_stateChangesIssuedCount;
+}
+
+int Graphics::stateChangesAvoided()
+{
+	return _master->_stateChangesAvoidedCount;
+}
+
+void Graphics::beginStateTracking()
+{
+	_stateKnown = 0;
+	_stateArraysKnown = 0;
+
+	_stateChangesIssued = 0;
+	_stateChangesAvoided = 0;
+}
+
+void Graphics::endStateTracking()
+{
+	_stateChangesIssuedCount = _stateChangesIssued;
+	_stateChangesAvoidedCount = _stateChangesAvoided;
+}
+
+void Graphics::setBlending(bool blending)
+{
+	if ((_stateKnown & STATE_BLENDING) && _stateBlending == blending) {
+		_stateChangesAvoided++;
+		return;
+	}
+
+	if (blending) {
+		glEnable(GL_BLEND);
+	} else {
+		glDisable(GL_BLEND);
+	}
+
+	_stateBlending = blending;
+	_stateKnown |= STATE_BLENDING;
+	_stateChangesIssued++;
+}
+
+void Graphics::setBlendFunc(GLenum source, GLenum destination)
+{
+	if ((_stateKnown & STATE_BLEND_FUNC) && _stateBlendSource == source && _stateBlendDestination == destination) {
+		_stateChangesAvoided++;
+		return;
+	}
+
+	glBlendFunc(source, destination);
+
+	_stateBlendSource = source;
+	_stateBlendDestination = destination;
+	_stateKnown |= STATE_BLEND_FUNC;
+	_stateChangesIssued++;
+}
+
+// binds to GL_TEXTURE_2D of the active texture unit, which is always the first
+void Graphics::bindTexture(GLuint texture)
+{
+	if ((_stateKnown & STATE_TEXTURE) && _stateTexture == texture) {
+		_stateChangesAvoided++;
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	_stateTexture = texture;
+	_stateKnown |= STATE_TEXTURE;
+	_stateChangesIssued++;
+}
+
+#ifdef GLES1
+void Graphics::setTexturing(bool texturing)
+{
+	if ((_stateKnown & STATE_TEXTURING) && _stateTexturing == texturing) {
+		_stateChangesAvoided++;
+		return;
+	}
+
+	if (texturing) {
+		glEnable(GL_TEXTURE_2D);
+	} else {
+		glDisable(GL_TEXTURE_2D);
+	}
+
+	_stateTexturing = texturing;
+	_stateKnown |= STATE_TEXTURING;
+	_stateChangesIssued++;
+}
+
+void Graphics::useClientArrays(unsigned int arrays)
+{
+	static const GLenum clientArrays[3] = { GL_VERTEX_ARRAY, GL_TEXTURE_COORD_ARRAY, GL_COLOR_ARRAY };
+
+	for(int index = 0; index < 3; index++) {
+		unsigned int bit = 1 << index;
+
+		if ((_stateArraysKnown & bit) && (_stateArrays & bit) == (arrays & bit)) {
+			// only count the arrays that would otherwise have been enabled
+			if (arrays & bit) {
+				_stateChangesAvoided++;
+			}
+			continue;
+		}
+
+		if (arrays & bit) {
+			glEnableClientState(clientArrays[index]);
+		} else {
+			glDisableClientState(clientArrays[index]);
+		}
+		_stateChangesIssued++;
+	}
+
+	_stateArrays = arrays;
+	_stateArraysKnown = 0x07;
+}
+
+#elif defined(GLES2)
+void Graphics::useProgram(GLuint program)
+{
+	if ((_stateKnown & STATE_PROGRAM) && _stateProgram == program) {
+		_stateChangesAvoided++;
+		return;
+	}
+
+	glUseProgram(program);
+
+	_stateProgram = program;
+	_stateKnown |= STATE_PROGRAM;
+	_stateChangesIssued++;
+}
+
+void Graphics::useVertexAttribArrays(unsigned int locations)
+{
+	for(int location = 0; location < MAX_TRACKED_VERTEX_ATTRIBS; location++) {
+		unsigned int bit = 1 << location;
+
+		if ((_stateArraysKnown & bit) && (_stateArrays & bit) == (locations & bit)) {
+			// only count the arrays that would otherwise have been enabled
+			if (locations & bit) {
+				_stateChangesAvoided++;
+			}
+			continue;
+		}
+
+		if (locations & bit) {
+			glEnableVertexAttribArray(location);
+		} else {
+			glDisableVertexAttribArray(location);
+		}
+		_stateChangesIssued++;
+	}
+
+	_stateArrays = locations;
+	_stateArraysKnown = (1 << MAX_TRACKED_VERTEX_ATTRIBS) - 1;
+}
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+
 int Graphics::setCaptureRect(int x, int y, int width, int height)
 {
 	_captureX = x;
@@ -401,6 +646,8 @@ void Graphics::setSize(int width, int height)
 
 	_width = width;
 	_height = height;
+
+	_fullRedraw = true;
 }
 
 int Graphics::getNativeWindowUsage()
@@ -852,10 +1099,38 @@ void Graphics::swapBuffers()
 {
 	EGLBoolean status;
 
-    status = eglSwapBuffers(_eglDisplay, _eglSurface);
+	if (_partialSwap && _eglSwapBuffersWithDamage) {
+		status = _eglSwapBuffersWithDamage(_eglDisplay, _eglSurface, _swapDamage, 1);
+	} else {
+		status = eglSwapBuffers(_eglDisplay, _eglSurface);
+	}
     if (status != EGL_TRUE) {
         eglPrintError("eglSwapBuffers");
     }
+
+    _partialSwap = false;
+}
+
+void Graphics::preserveSwapBuffers(bool preserve)
+{
+	EGLBoolean status;
+
+	status = eglSurfaceAttrib(_eglDisplay, _eglSurface, EGL_SWAP_BEHAVIOR, preserve ? EGL_BUFFER_PRESERVED : EGL_BUFFER_DESTROYED);
+
+	// without it every frame is drawn in full
+	_preserveRequested = preserve;
+	_surfacePreserved = preserve && status == EGL_TRUE;
+	_fullRedraw = true;
+}
+
+void Graphics::setSwapDamage(int x, int y, int width, int height)
+{
+	_swapDamage[0] = x;
+	_swapDamage[1] = y;
+	_swapDamage[2] = width;
+	_swapDamage[3] = height;
+
+	_partialSwap = width > 0 && height > 0;
 }
 
 void Graphics::eglPrintError(const char *msg) {
@@ -15,9 +15,18 @@
  */
 
 #include "Graphics2D.hpp"
+#include "VectorMath.hpp"
 #include <math.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QFile>
+#include <QtAlgorithms>
+#include <QVector>
 
 using namespace bb::cascades;
 
@@ -27,14 +36,17 @@ namespace views {
 #ifdef GLES2
 // shaders for 2D graphics
 
-// vertex shader for 2D projection
+// vertex shader for 2D projection, passing on how much of an edge fringe covers each vertex
 const char* vSource_2D =
 		"attribute vec2 a_position;\r\n"
+		"attribute float a_alpha;\r\n"
 		"uniform mat4 u_modelViewMatrix;\r\n"
 		"uniform mat4 u_projectionMatrix;\r\n"
+		"varying float v_alpha;\r\n"
 		"void main()\r\n"
 		"{\r\n"
 		"    gl_Position = u_projectionMatrix * u_modelViewMatrix * vec4(a_position, 0.0, 1.0);\r\n"
+		"    v_alpha = a_alpha;\r\n"
 		"}";
 
 const char* vSource_2DTexture =
@@ -49,6 +61,21 @@ const char* vSource_2DTexture =
 		"    v_texcoord = a_texcoord;\r\n"
 		"}";
 
+const char* vSource_2DAlphaTexture =
+		"attribute vec2 a_position;\r\n"
+		"attribute vec2 a_texcoord;\r\n"
+		"attribute float a_alpha;\r\n"
+		"uniform mat4 u_modelViewMatrix;\r\n"
+		"uniform mat4 u_projectionMatrix;\r\n"
+		"varying vec2 v_texcoord;\r\n"
+		"varying float v_alpha;\r\n"
+		"void main()\r\n"
+		"{\r\n"
+		"    gl_Position = u_projectionMatrix * u_modelViewMatrix * vec4(a_position, 0.0, 1.0);\r\n"
+		"    v_texcoord = a_texcoord;\r\n"
+		"    v_alpha = a_alpha;\r\n"
+		"}";
+
 const char* vSource_2DMaskTexture =
 		"attribute vec2 a_position;\r\n"
 		"attribute vec2 a_texcoord;\r\n"
@@ -80,6 +107,20 @@ const char* fSource_2DTexture =
 		"    gl_FragColor = texture2D(u_texture, v_texcoord);\r\n"
 		"}";
 
+// copies of a mesh, each scaled, moved and colored by values that change once per copy
+const char* vSource_2DInstance =
+		"attribute vec2 a_position;\r\n"
+		"attribute vec3 a_instance;\r\n"
+		"attribute vec4 a_instanceColor;\r\n"
+		"uniform mat4 u_modelViewMatrix;\r\n"
+		"uniform mat4 u_projectionMatrix;\r\n"
+		"varying vec4 v_color;\r\n"
+		"void main()\r\n"
+		"{\r\n"
+		"    gl_Position = u_projectionMatrix * u_modelViewMatrix * vec4(a_position * a_instance.z + a_instance.xy, 0.0, 1.0);\r\n"
+		"    v_color = a_instanceColor;\r\n"
+		"}";
+
 // fragment shader for solid color
 const char* fSource_solidColor =
 		"#ifdef GL_ES\r\n"
@@ -90,9 +131,25 @@ const char* fSource_solidColor =
 		"    #endif\r\n"
 		"#endif\r\n"
 		"uniform vec4 u_color;\r\n"
+		"varying float v_alpha;\r\n"
+		"void main()\r\n"
+		"{\r\n"
+        "    gl_FragColor = vec4(u_color.rgb, u_color.a * v_alpha);\r\n"
+		"}";
+
+// fragment shader for a color given with each vertex
+const char* fSource_vertexColor =
+		"#ifdef GL_ES\r\n"
+		"    #ifdef GL_FRAGMENT_PRECISION_HIGH\r\n"
+		"        precision highp float;\r\n"
+		"    #else\r\n"
+		"        precision mediump float;\r\n"
+		"    #endif\r\n"
+		"#endif\r\n"
+		"varying vec4 v_color;\r\n"
 		"void main()\r\n"
 		"{\r\n"
-        "    gl_FragColor = u_color;\r\n"
+		"    gl_FragColor = v_color;\r\n"
 		"}";
 
 const char* fSource_uvtest =
@@ -118,73 +175,34 @@ const char* fSource_gradient =
 		"    #endif\r\n"
 		"#endif\r\n"
 		"varying vec2 v_texcoord;\r\n"
-		"varying vec2 v_maskTexcoord;\r\n"
-		"uniform int u_segments;\r\n"
-		"uniform vec4[20] u_colors;\r\n"
-		"uniform float[41] u_percentages;\r\n"
+		"varying float v_alpha;\r\n"
 		"uniform float u_radius;\r\n"
 		"uniform float u_angle;\r\n"
 		"uniform vec2 u_origin;\r\n"
+		"uniform sampler2D u_gradient;\r\n"
+		"uniform float u_fringe;\r\n"
 		"void main()\r\n"
 		"{\r\n"
-		"    float r;\r\n"
-		"    float g;\r\n"
-		"    float b;\r\n"
-		"    float a;\r\n"
 		"    float u;\r\n"
 		"    float v;\r\n"
-		"    float rotu;\r\n"
-		"    float rotv;\r\n"
-		"    float length;\r\n"
 		"    float percent;\r\n"
-		"    float realpercent;\r\n"
-		"    float factor;\r\n"
-		"    float realfactor;\r\n"
-		"    int index;\r\n"
+		"    vec4 color;\r\n"
 		"    \r\n"
-		"    r = 0.0;\r\n"
-		"    g = 0.0;\r\n"
-		"    b = 0.0;\r\n"
-		"    a = 1.0;\r\n"
 		"    u = v_texcoord.x - u_origin.x;\r\n"
 		"    v = v_texcoord.y - u_origin.y;\r\n"
 		"    if (u_radius > 0.0) {\r\n"
-		"        length = sqrt(u*u + v*v);\r\n"
-		"        percent = length / u_radius;\r\n"
+		"        percent = sqrt(u*u + v*v) / u_radius;\r\n"
 		"    } else {\r\n"
-		"        rotu = cos(radians(u_angle))*u + sin(radians(u_angle))*v;\r\n"
-		"        rotv = cos(radians(u_angle+90.0))*u + sin(radians(u_angle+90.0))*v;\r\n"
-		"        percent = rotu;\r\n"
+		"        percent = cos(radians(u_angle))*u + sin(radians(u_angle))*v;\r\n"
 		"    }\r\n"
 		"    if (percent < 0.0) {\r\n"
 		"        percent += 1.0;\r\n"
 		"    }\r\n"
-		"    if (percent > 1.0) {\r\n"
-		"        percent = 1.0;\r\n"
-		"    }\r\n"
-		"    if (percent < 0.0) {\r\n"
-		"        percent = 0.0;\r\n"
-		"    }\r\n"
+		"    percent = clamp(percent, 0.0, 1.0);\r\n"
 		"    \r\n"
-		"    if (u_segments > 0) {\r\n"
-		"        for (index = 0; index < 2*u_segments; index += 2) {\r\n"
-		"            if (percent >= u_percentages[ index] && percent <= u_percentages[ index+2]) {\r\n"
-		"                factor = (percent - u_percentages[ index]) / (u_percentages[ index+2] - u_percentages[ index]);\r\n"
-		"                if (factor <= u_percentages[ index+1]) {\r\n"
-		"                    realfactor = 0.5 * (factor - u_percentages[ index]) / (u_percentages[ index+1] - u_percentages[ index]);\r\n"
-		"                }\r\n"
-		"                if (factor > u_percentages[index+1]) {\r\n"
-		"                    realfactor = 0.5 + (factor - u_percentages[ index+1]) / (u_percentages[ index+2] - u_percentages[ index+1]);\r\n"
-		"                }\r\n"
-		"                realpercent = (1.0 - realfactor) * u_percentages[ index] + realfactor * u_percentages[ index+2];\r\n"
-		"                r = (1.0-realpercent) * u_colors[ 0].x + realpercent * u_colors[ 1].x;\r\n"
-		"                g = (1.0-realpercent) * u_colors[ 0].y + realpercent * u_colors[ 1].y;\r\n"
-		"                b = (1.0-realpercent) * u_colors[ 0].z + realpercent * u_colors[ 1].z;\r\n"
-		"                a = (1.0-realpercent) * u_colors[ 0].a + realpercent * u_colors[ 1].a;\r\n"
-		"            }\r\n"
-		"        }\r\n"
-		"    }\r\n"
-		"    gl_FragColor = vec4(r, g, b, a);\r\n"
+		"    // the 256 lookup colors are sampled from the center of the first to the center of the last\r\n"
+		"    color = texture2D(u_gradient, vec2(percent * 0.99609375 + 0.001953125, 0.5));\r\n"
+		"    gl_FragColor = vec4(color.rgb, mix(color.a, 1.0, u_fringe) * v_alpha);\r\n"
 		"}";
 
 const char* fSource_2DMaskGradient =
@@ -197,74 +215,33 @@ const char* fSource_2DMaskGradient =
 		"#endif\r\n"
 		"varying vec2 v_texcoord;\r\n"
 		"varying vec2 v_maskTexcoord;\r\n"
-		"uniform int u_segments;\r\n"
-		"uniform vec4[20] u_colors;\r\n"
-		"uniform float[41] u_percentages;\r\n"
 		"uniform float u_radius;\r\n"
 		"uniform float u_angle;\r\n"
 		"uniform vec2 u_origin;\r\n"
+		"uniform sampler2D u_gradient;\r\n"
 		"uniform sampler2D u_texture;\r\n"
 		"void main()\r\n"
 		"{\r\n"
-		"    float r;\r\n"
-		"    float g;\r\n"
-		"    float b;\r\n"
-		"    float a;\r\n"
 		"    float u;\r\n"
 		"    float v;\r\n"
-		"    float rotu;\r\n"
-		"    float rotv;\r\n"
-		"    float length;\r\n"
 		"    float percent;\r\n"
-		"    float realpercent;\r\n"
-		"    float factor;\r\n"
-		"    float realfactor;\r\n"
-		"    int index;\r\n"
+		"    vec4 color;\r\n"
 		"    \r\n"
-		"    r = 0.0;\r\n"
-		"    g = 0.0;\r\n"
-		"    b = 0.0;\r\n"
-		"    a = 1.0;\r\n"
 		"    u = v_texcoord.x - u_origin.x;\r\n"
 		"    v = v_texcoord.y - u_origin.y;\r\n"
 		"    if (u_radius > 0.0) {\r\n"
-		"        length = sqrt(u*u + v*v);\r\n"
-		"        percent = length / u_radius;\r\n"
+		"        percent = sqrt(u*u + v*v) / u_radius;\r\n"
 		"    } else {\r\n"
-		"        rotu = cos(radians(u_angle))*u + sin(radians(u_angle))*v;\r\n"
-		"        rotv = cos(radians(u_angle+90.0))*u + sin(radians(u_angle+90.0))*v;\r\n"
-		"        percent = rotu;\r\n"
+		"        percent = cos(radians(u_angle))*u + sin(radians(u_angle))*v;\r\n"
 		"    }\r\n"
 		"    if (percent < 0.0) {\r\n"
 		"        percent += 1.0;\r\n"
 		"    }\r\n"
-		"    if (percent > 1.0) {\r\n"
-		"        percent = 1.0;\r\n"
-		"    }\r\n"
-		"    if (percent < 0.0) {\r\n"
-		"        percent = 0.0;\r\n"
-		"    }\r\n"
+		"    percent = clamp(percent, 0.0, 1.0);\r\n"
 		"    \r\n"
-		"    if (u_segments > 0) {\r\n"
-		"        for (index = 0; index < 2*u_segments; index += 2) {\r\n"
-		"            if (percent >= u_percentages[ index] && percent <= u_percentages[ index+2]) {\r\n"
-		"                factor = (percent - u_percentages[ index]) / (u_percentages[ index+2] - u_percentages[ index]);\r\n"
-		"                if (factor <= u_percentages[ index+1]) {\r\n"
-		"                    realfactor = 0.5 * (factor - u_percentages[ index]) / (u_percentages[ index+1] - u_percentages[ index]);\r\n"
-		"                }\r\n"
-		"                if (factor > u_percentages[index+1]) {\r\n"
-		"                    realfactor = 0.5 + (factor - u_percentages[ index+1]) / (u_percentages[ index+2] - u_percentages[ index+1]);\r\n"
-		"                }\r\n"
-		"                realpercent = (1.0 - realfactor) * u_percentages[ index] + realfactor * u_percentages[ index+2];\r\n"
-		"                r = (1.0-realpercent) * u_colors[ 0].x + realpercent * u_colors[ 1].x;\r\n"
-		"                g = (1.0-realpercent) * u_colors[ 0].y + realpercent * u_colors[ 1].y;\r\n"
-		"                b = (1.0-realpercent) * u_colors[ 0].z + realpercent * u_colors[ 1].z;\r\n"
-		"                a = (1.0-realpercent) * u_colors[ 0].a + realpercent * u_colors[ 1].a;\r\n"
-		"            }\r\n"
-		"        }\r\n"
-		"    }\r\n"
-		"    vec4 temp = texture2D(u_texture, v_maskTexcoord);\r\n"
-		"    gl_FragColor = vec4(r, g, b, a) * temp;\r\n"
+		"    // the 256 lookup colors are sampled from the center of the first to the center of the last\r\n"
+		"    color = texture2D(u_gradient, vec2(percent * 0.99609375 + 0.001953125, 0.5));\r\n"
+		"    gl_FragColor = color * texture2D(u_texture, v_maskTexcoord);\r\n"
 		"}";
 
 
@@ -298,65 +275,114 @@ Graphics2D::Graphics2D(int display, Graphics2D* master) : Graphics(display, mast
 		_master2D = this;
 	}
 
-	// let set some reasonable limits for the time being
-	_commandCount = 0;
-	if (_master2D != this) {
-		_drawCommands = NULL;
-	} else {
-		_drawCommands = new RenderCommand[MAX_RENDER_COMMANDS];
-	}
-
-	_currentDrawFloatIndex = 0;
-	if (_master2D != this) {
-		_drawFloatIndices = NULL;
-		_drawFloats = NULL;
-	} else {
-		_drawFloatIndices = new int[2*MAX_RENDER_COMMANDS];
-		_drawFloats = new GLfloat[2*MAX_RENDER_COMMANDS];
-	}
-
-	_currentDrawIntIndex = 0;
+	// recorded commands live in growable buffers owned by the master - one being recorded, one ready to present and one being rendered
 	if (_master2D != this) {
-		_drawIntIndices = NULL;
-		_drawInts = NULL;
+		_recordCommands = NULL;
+		_readyCommands = NULL;
+		_renderCommands = NULL;
+		_reorderedCommands = NULL;
 	} else {
-		_drawIntIndices = new int[2*MAX_RENDER_COMMANDS];
-		_drawInts = new int[2*MAX_RENDER_COMMANDS];
+		_recordCommands = new CommandBuffer();
+		_readyCommands = new CommandBuffer();
+		_renderCommands = new CommandBuffer();
+		_reorderedCommands = new CommandBuffer();
 	}
-
-	_currentDrawPointerIndex = 0;
-	if (_master2D != this) {
-		_drawPointerIndices = NULL;
-		_drawPointers = NULL;
-	} else {
-		_drawPointerIndices = new int[2*MAX_RENDER_COMMANDS];
-		_drawPointers = new void*[MAX_RENDER_COMMANDS];
+	_commandsReady = false;
+	_commandReordering = false;
+	_programSwitchesSaved = 0;
+
+	// nothing has been drawn yet, so the first frame is drawn in full
+	_pendingDamage[0] = 1.0e30;
+	_pendingDamage[1] = 1.0e30;
+	_pendingDamage[2] = -1.0e30;
+	_pendingDamage[3] = -1.0e30;
+	_pendingFullDamage = true;
+	_partialRedraw = true;
+	_redrawnPixelCount = 0;
+
+	_frameHash = 0;
+	_frameHashValid = false;
+	_skippedFrameCount = 0;
+	_publishedFrames = 0;
+	_renderedFrames = 0;
+
+	_displayList = NULL;
+	_renderStateCount = 0;
+	_removedCommandCount = 0;
+
+	_renderVertexIndices = NULL;
+	_renderVertexCoords = NULL;
+	_renderTextureCoords = NULL;
+	_renderMaskTextureCoords = NULL;
+	_renderCoordsCapacity = 0;
+
+	if (_master2D == this) {
+		reserveRenderCoords(MAX_VERTEX_COORDINATES / 8);
 	}
 
+	// every view has its own context, and so its own buffers
+	_vertexStream = new VertexStream();
+	_renderStream = NULL;
 
-	if (_master2D != this) {
-		_renderVertexIndices = NULL;
-	} else {
-		_renderVertexIndices = new GLuint[MAX_VERTEX_COORDINATES];
-	}
+	_instanceCoords = NULL;
+	_instanceCapacity = 0;
 
 	if (_master2D != this) {
-		_renderVertexCoords = NULL;
+		_renderBatch = NULL;
+		_fringeBatch = NULL;
 	} else {
-		_renderVertexCoords = new GLfloat[MAX_VERTEX_COORDINATES];
+		_renderBatch = new VertexBatch();
+		_fringeBatch = new VertexBatch();
 	}
+	_batchGradient = NULL;
+	_drawCalls = 0;
+	_drawCallCount = 0;
 
 	if (_master2D != this) {
-		_renderTextureCoords = NULL;
+		_tessellatedCommands = NULL;
+		_tessellateVertexCoords = NULL;
+		_tessellateTextureCoords = NULL;
+		_tessellateMesh = NULL;
+		_fringeMesh = NULL;
 	} else {
-		_renderTextureCoords = new GLfloat[MAX_VERTEX_COORDINATES];
+		_tessellatedCommands = new CommandBuffer();
+		_tessellateVertexCoords = new GLfloat[MAX_VERTEX_COORDINATES];
+		_tessellateTextureCoords = new GLfloat[MAX_VERTEX_COORDINATES];
+		_tessellateMesh = new VertexBatch();
+		_fringeMesh = new VertexBatch();
 	}
+	_tessellateStroke = NULL;
+	_curveTolerance = CURVE_TOLERANCE;
+	_tessellateTolerance = CURVE_TOLERANCE;
+	_stencilThreshold = STENCIL_THRESHOLD;
+	_antialiasing = false;
+	_tessellateFringe = 0.0;
+	_polylineTolerance = 0.0;
+	_tessellateSimplify = 0.0;
+	_removedVertexCount = 0;
+	_tessellateDashCoords = NULL;
+	_tessellateDashCapacity = 0;
+	_tessellatePolygonLinks = NULL;
+	_tessellatePolygonCapacity = 0;
+	_tessellateStrokeCoords = NULL;
+	_tessellateStrokeCapacity = 0;
+	_tessellateSimplifyCoords = NULL;
+	_tessellateSimplifyCapacity = 0;
+	_fringeVertices = NULL;
+	_fringeVertexCapacity = 0;
+	_fringeNormals = NULL;
+	_fringeNormalCapacity = 0;
+	_fringeEdges = NULL;
+	_fringeEdgeCapacity = 0;
 
 	if (_master2D != this) {
-		_renderMaskTextureCoords = NULL;
+		_meshCacheCommands = NULL;
 	} else {
-		_renderMaskTextureCoords = new GLfloat[MAX_VERTEX_COORDINATES];
+		_meshCacheCommands = new CommandBuffer(4096);
 	}
+	_meshCache.setMaxCost(MESH_CACHE_SIZE);
+	_meshCacheHits = 0;
+	_meshCacheMisses = 0;
 
 #ifdef GLES2
 	// allocate transformation matrices
@@ -405,6 +431,7 @@ Graphics2D::Graphics2D(int display, Graphics2D* master) : Graphics(display, mast
 
 	_defaultStroke = createStroke(1.0);
 
+	_contextId = 0;
 	_drawing = false;
 }
 
@@ -426,51 +453,116 @@ Graphics2D::~Graphics2D()
 	}
 #endif
 
-	if (_drawCommands) {
-		delete _drawCommands;
+	if (_recordCommands) {
+		delete _recordCommands;
+	}
+
+	if (_readyCommands) {
+		delete _readyCommands;
 	}
 
-	if (_drawFloatIndices) {
-		delete _drawFloatIndices;
+	if (_renderCommands) {
+		delete _renderCommands;
 	}
 
-	if (_drawFloats) {
-		delete _drawFloats;
+	if (_reorderedCommands) {
+		delete _reorderedCommands;
 	}
 
-	if (_drawIntIndices) {
-		delete _drawIntIndices;
+	if (_renderVertexIndices) {
+		delete [] _renderVertexIndices;
 	}
-	if (_drawInts) {
-		delete _drawInts;
+
+	if (_renderVertexCoords) {
+		delete [] _renderVertexCoords;
 	}
 
-	if (_drawPointerIndices) {
-		delete _drawPointerIndices;
+	if (_renderTextureCoords) {
+		delete [] _renderTextureCoords;
 	}
 
-	if (_drawPointers) {
-		delete _drawPointers;
+	if (_renderMaskTextureCoords) {
+		delete [] _renderMaskTextureCoords;
 	}
 
-	if (_renderVertexIndices) {
-		delete _renderVertexIndices;
+	if (_vertexStream) {
+		delete _vertexStream;
 	}
 
-	if (_renderVertexCoords) {
-		delete _renderVertexCoords;
+	if (_instanceCoords) {
+		delete [] _instanceCoords;
 	}
 
-	if (_renderTextureCoords) {
-		delete _renderTextureCoords;
+	if (_renderBatch) {
+		delete _renderBatch;
 	}
 
-	if (_renderMaskTextureCoords) {
-		delete _renderMaskTextureCoords;
+	if (_fringeBatch) {
+		delete _fringeBatch;
+	}
+
+	if (_tessellatedCommands) {
+		delete _tessellatedCommands;
+	}
+
+	if (_tessellateVertexCoords) {
+		delete [] _tessellateVertexCoords;
+	}
+
+	if (_tessellateTextureCoords) {
+		delete [] _tessellateTextureCoords;
+	}
+
+	if (_tessellateDashCoords) {
+		delete [] _tessellateDashCoords;
+	}
+
+	if (_tessellatePolygonLinks) {
+		delete [] _tessellatePolygonLinks;
+	}
+
+	if (_tessellateStrokeCoords) {
+		delete [] _tessellateStrokeCoords;
+	}
+
+	if (_tessellateSimplifyCoords) {
+		delete [] _tessellateSimplifyCoords;
+	}
+
+	if (_tessellateMesh) {
+		delete _tessellateMesh;
+	}
+
+	if (_fringeMesh) {
+		delete _fringeMesh;
+	}
+
+	if (_fringeVertices) {
+		delete [] _fringeVertices;
+	}
+
+	if (_fringeNormals) {
+		delete [] _fringeNormals;
+	}
+
+	if (_fringeEdges) {
+		delete [] _fringeEdges;
+	}
+
+	if (_meshCacheCommands) {
+		delete _meshCacheCommands;
 	}
 }
 
 void Graphics2D::cleanup() {
+#ifdef GLES2
+	// the lookup textures go with the context - gradients drawn in a new one upload their colors again
+	if (_lookupTextures.size() > 0) {
+		glDeleteTextures(_lookupTextures.size(), _lookupTextures.constData());
+		_lookupTextures.clear();
+	}
+#endif
+
 	QList<ImageData*> textureImages = _glTextureIDImageMap.keys();
 
 	if (_glTextureIDImageMap.size() > 0) {
@@ -482,6 +574,9 @@ void Graphics2D::cleanup() {
 	}
 }
 
+// numbers the contexts lookup textures are created in
+static int contextCount = 0;
+
 int Graphics2D::initialize(screen_window_t screenWindow)
 {
 	qDebug()  << "Graphics2D::initialize";
@@ -501,7 +596,7 @@ int Graphics2D::initialize(screen_window_t screenWindow)
 			qCritical() << "Initialize _polyTextureRenderingProgram failed\n";
 		}
 
-		_polyGradientRenderingProgram = loadShader(vSource_2DTexture, fSource_gradient);
+		_polyGradientRenderingProgram = loadShader(vSource_2DAlphaTexture, fSource_gradient);
 		if(_polyGradientRenderingProgram == 0) {
 			qCritical() << "Initialize _polyGradientRenderingProgram failed\n";
 		}
@@ -516,7 +611,18 @@ int Graphics2D::initialize(screen_window_t screenWindow)
 		if(_textGradientRenderingProgram == 0) {
 			qCritical() << "Initialize _textGradientRenderingProgram failed\n";
 		}
+
+		_instanceRenderingProgram = loadShader(vSource_2DInstance, fSource_vertexColor);
+		if(_instanceRenderingProgram == 0) {
+			qCritical() << "Initialize _instanceRenderingProgram failed\n";
+		}
+
+		loadProgramLocations();
 #endif
+
+		_contextId = ++contextCount;
+
+		_vertexStream->create();
 	}
 
 	qDebug()  << "Graphics2D::initialize " << ":" << returnCode;
@@ -524,14 +630,187 @@ int Graphics2D::initialize(screen_window_t screenWindow)
     return returnCode;
 }
 
+int Graphics2D::regenerate(screen_window_t screenWindow)
+{
+	int returnCode = Graphics::regenerate(screenWindow);
+
+#ifdef GLES2
+	if (returnCode == EXIT_SUCCESS) {
+		// the programs are whatever the context now holds, so their locations are looked up again rather than trusted
+		loadProgramLocations();
+	}
+#endif
+
+	return returnCode;
+}
+
+// FNV-1a hash over a block of memory, continuing from the given hash
+static unsigned int hashData(unsigned int hash, const void* data, int size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+
+	for(int index = 0; index < size; index++) {
+		hash = (hash ^ bytes[index]) * 16777619u;
+	}
+
+	return hash;
+}
+
+// hashes the mapping of a gradient, which can be changed in place after the gradient is created
+static unsigned int hashGradient(unsigned int hash, const Gradient* gradient)
+{
+	hash = hashData(hash, &gradient->segments, sizeof(int));
+	hash = hashData(hash, gradient->colors, sizeof(GLColor) * (gradient->segments + 1));
+	hash = hashData(hash, gradient->percentages, sizeof(GLfloat) * (gradient->segments * 2 + 1));
+	hash = hashData(hash, &gradient->radius, sizeof(GLfloat));
+	hash = hashData(hash, &gradient->angle, sizeof(GLfloat));
+	hash = hashData(hash, &gradient->originU, sizeof(GLfloat));
+	hash = hashData(hash, &gradient->originV, sizeof(GLfloat));
+
+	return hash;
+}
+
+// clamps a color component and scales it to a byte
+static GLubyte colorByte(GLfloat component)
+{
+	if (component <= 0.0) {
+		return 0;
+	}
+	if (component >= 1.0) {
+		return 255;
+	}
+	return (GLubyte)(component * 255.0 + 0.5);
+}
+
+// works out the colors of a gradient at its lookup points, mapping each point through the segments the way the gradient shaders did for every fragment
+static void bakeGradient(Gradient* gradient)
+{
+	GLfloat* percentages = gradient->percentages;
+
+	for(int texel = 0; texel < GRADIENT_LOOKUP_SIZE; texel++) {
+		GLfloat percent = texel / (GLfloat)(GRADIENT_LOOKUP_SIZE - 1);
+		GLColor color = { 0.0, 0.0, 0.0, 1.0 };
+
+		for(int index = 0; index < 2 * gradient->segments; index += 2) {
+			if (percent >= percentages[index] && percent <= percentages[index+2]) {
+				GLfloat factor = (percent - percentages[index]) / (percentages[index+2] - percentages[index]);
+				GLfloat realFactor;
+
+				if (factor <= percentages[index+1]) {
+					realFactor = 0.5 * (factor - percentages[index]) / (percentages[index+1] - percentages[index]);
+				} else {
+					realFactor = 0.5 + (factor - percentages[index+1]) / (percentages[index+2] - percentages[index+1]);
+				}
+
+				GLfloat realPercent = (1.0 - realFactor) * percentages[index] + realFactor * percentages[index+2];
+
+				color.red = (1.0 - realPercent) * gradient->colors[0].red + realPercent * gradient->colors[1].red;
+				color.green = (1.0 - realPercent) * gradient->colors[0].green + realPercent * gradient->colors[1].green;
+				color.blue = (1.0 - realPercent) * gradient->colors[0].blue + realPercent * gradient->colors[1].blue;
+				color.alpha = (1.0 - realPercent) * gradient->colors[0].alpha + realPercent * gradient->colors[1].alpha;
+			}
+		}
+
+		gradient->lookup[texel*4+0] = colorByte(color.red);
+		gradient->lookup[texel*4+1] = colorByte(color.green);
+		gradient->lookup[texel*4+2] = colorByte(color.blue);
+		gradient->lookup[texel*4+3] = colorByte(color.alpha);
+	}
+
+	gradient->lookupHash = hashGradient(2166136261u, gradient);
+}
+
+#ifdef GLES2
+// looks up every location a draw may need in a program, leaving -1 for those it does not have
+static void findProgramLocations(GLuint program, ProgramLocations* locations)
+{
+	locations->position = glGetAttribLocation(program, "a_position");
+	locations->texcoord = glGetAttribLocation(program, "a_texcoord");
+	locations->maskTexcoord = glGetAttribLocation(program, "a_maskTexcoord");
+	locations->alpha = glGetAttribLocation(program, "a_alpha");
+	locations->projectionMatrix = glGetUniformLocation(program, "u_projectionMatrix");
+	locations->modelViewMatrix = glGetUniformLocation(program, "u_modelViewMatrix");
+	locations->texture = glGetUniformLocation(program, "u_texture");
+	locations->color = glGetUniformLocation(program, "u_color");
+	locations->gradient = glGetUniformLocation(program, "u_gradient");
+	locations->radius = glGetUniformLocation(program, "u_radius");
+	locations->angle = glGetUniformLocation(program, "u_angle");
+	locations->origin = glGetUniformLocation(program, "u_origin");
+	locations->fringe = glGetUniformLocation(program, "u_fringe");
+	locations->instance = glGetAttribLocation(program, "a_instance");
+	locations->instanceColor = glGetAttribLocation(program, "a_instanceColor");
+}
+
+// Looks up the uniform and attribute locations of every shader program, so that drawing never has to.
+void Graphics2D::loadProgramLocations()
+{
+	findProgramLocations(_polyColorRenderingProgram, &_polyColorLocations);
+	findProgramLocations(_polyTextureRenderingProgram, &_polyTextureLocations);
+	findProgramLocations(_polyGradientRenderingProgram, &_polyGradientLocations);
+	findProgramLocations(_textRenderingProgram, &_textLocations);
+	findProgramLocations(_textGradientRenderingProgram, &_textGradientLocations);
+	findProgramLocations(_instanceRenderingProgram, &_instanceLocations);
+}
+
+// Returns the lookup texture of a gradient, uploading its baked colors the first time it is drawn and again after they are updated.
+GLuint Graphics2D::gradientTexture(Gradient* gradient)
+{
+	// a texture made in a context that has since gone away is no longer there to be updated
+	if (gradient->lookupTexture != 0 && gradient->lookupContext != _contextId) {
+		gradient->lookupTexture = 0;
+	}
+
+	if (gradient->lookupTexture == 0) {
+		glGenTextures(1, &(gradient->lookupTexture));
+		gradient->lookupContext = _contextId;
+		gradient->lookupUploaded = gradient->lookupHash;
+		_lookupTextures.append(gradient->lookupTexture);
+
+		bindTexture(gradient->lookupTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, GRADIENT_LOOKUP_SIZE, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, gradient->lookup);
+	} else if (gradient->lookupUploaded != gradient->lookupHash) {
+		gradient->lookupUploaded = gradient->lookupHash;
+
+		bindTexture(gradient->lookupTexture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GRADIENT_LOOKUP_SIZE, 1, GL_RGBA, GL_UNSIGNED_BYTE, gradient->lookup);
+	}
+
+	return gradient->lookupTexture;
+}
+
+// Deletes the lookup textures of freed gradients that were created in this context.
+void Graphics2D::deleteFreedTextures()
+{
+	_master2D->_drawMutex.lock();
+
+	for(int index = 0; index < _master2D->_freedTextures.size(); ) {
+		int lookupIndex = _lookupTextures.indexOf(_master2D->_freedTextures[index]);
+
+		if (lookupIndex < 0) {
+			index++;
+			continue;
+		}
+
+		glDeleteTextures(1, &_lookupTextures[lookupIndex]);
+		_lookupTextures.remove(lookupIndex);
+		_master2D->_freedTextures.remove(index);
+	}
+
+	_master2D->_drawMutex.unlock();
+}
+#endif
+
 bool Graphics2D::reset()
 {
 	//qDebug()  << "Graphics2D::reset";
 
 	bool proceed = false;
 
-	_master2D->_refreshMutex.lock();
-
 	_master2D->_drawMutex.lock();
 
 	if (_master2D->_drawing == false) {
@@ -542,29 +821,13 @@ bool Graphics2D::reset()
 	_master2D->_drawMutex.unlock();
 
 	if (proceed) {
-		_master2D->_commandCount = 0;
-		_master2D->_currentDrawFloatIndex = 0;
-		_master2D->_currentDrawIntIndex = 0;
-		_master2D->_currentDrawPointerIndex = 0;
-
-#ifdef GLES2
-		// setup with identity matrix
-		memset(_transformMatrix, 0, sizeof(GLfloat) * 4 * 4);
-		_transformMatrix[0]  = 1.0f;
-		_transformMatrix[5]  = 1.0f;
-		_transformMatrix[10] = 1.0f;
-		_transformMatrix[15] = 1.0f;
-
-		int i, j, k;
-		memset(_renderModelMatrix, 0, sizeof(GLfloat) * 4 * 4);
-		for(i = 0; i < 4; i++) {
-			for(j = 0; j < 4; j++) {
-				for(k = 0; k < 4; k++) {
-					_renderModelMatrix[i * 4 + j] += _transformMatrix[i * 4 + k] * _scaleMatrix[k * 4 + j];
-				}
-			}
+		if (_master2D->_displayList) {
+			qCritical() << "Graphics2D::reset: display list capture was not ended\n";
+			_master2D->endDisplayList();
 		}
-#endif
+
+		// the back list is only ever touched by the recording thread, so no lock is needed to rewind it
+		_master2D->_recordCommands->reset();
 
 		// set the default foreground color and background color
 		_master2D->setColor(_defaultForegroundColor);
@@ -589,11 +852,69 @@ void Graphics2D::done()
 
 	if (_master2D->_drawing == true) {
 		_master2D->_drawing = false;
+
+		_master2D->_removedCommandCount = _master2D->optimizeCommands(_master2D->_recordCommands);
+
+		//qDebug()  << "Graphics2D::done: removed " << _master2D->_removedCommandCount << " of " << _master2D->_recordCommands->count() << " commands";
+
+		if (_master2D->_commandReordering) {
+			_master2D->_programSwitchesSaved = _master2D->reorderCommands(_master2D->_recordCommands, _master2D->_reorderedCommands);
+
+			CommandBuffer* recordCommands = _master2D->_recordCommands;
+			_master2D->_recordCommands = _master2D->_reorderedCommands;
+			_master2D->_reorderedCommands = recordCommands;
+
+			// the state written out with each draw repeats what is already in effect more often than not
+			_master2D->optimizeCommands(_master2D->_recordCommands);
+		} else {
+			_master2D->_programSwitchesSaved = 0;
+		}
+
+		if (!_master2D->_captureFileName.isEmpty()) {
+			_master2D->writeCommandStream(_master2D->_recordCommands, _master2D->_captureFileName);
+			_master2D->_captureFileName = QString();
+		}
+
+		unsigned int frameHash = _master2D->hashCommands(_master2D->_recordCommands);
+
+		if (_master2D->_frameHashValid && frameHash == _master2D->_frameHash) {
+			// the same commands as the last published frame - that one stays in place and nothing needs rendering
+			_master2D->_skippedFrameCount++;
+		} else {
+			_master2D->_frameHash = frameHash;
+			_master2D->_frameHashValid = true;
+
+			// geometry is turned into triangles here, off the render thread and outside the render lock
+			_master2D->tessellateCommands(_master2D->_recordCommands, _master2D->_tessellatedCommands);
+
+			CommandBuffer* recordCommands = _master2D->_recordCommands;
+			_master2D->_recordCommands = _master2D->_tessellatedCommands;
+			_master2D->_tessellatedCommands = recordCommands;
+
+			GLfloat damage[4];
+			bool damageKnown = _master2D->damageCommands(_master2D->_recordCommands, damage);
+
+			// publish the recorded list, taking back whichever list render() has not picked up yet
+			_master2D->_refreshMutex.lock();
+
+			CommandBuffer* readyCommands = _master2D->_readyCommands;
+			_master2D->_readyCommands = _master2D->_recordCommands;
+			_master2D->_recordCommands = readyCommands;
+			_master2D->_commandsReady = true;
+			_master2D->_publishedFrames++;
+
+			// a frame that was never rendered leaves its damage behind for the one that replaces it
+			if (damageKnown) {
+				_master2D->includeDamage(damage);
+			} else {
+				_master2D->_pendingFullDamage = true;
+			}
+
+			_master2D->_refreshMutex.unlock();
+		}
 	}
 
 	_master2D->_drawMutex.unlock();
-
-	_master2D->_refreshMutex.unlock();
 }
 
 // creates a new font
@@ -910,11 +1231,45 @@ Gradient* Graphics2D::createGradient(int segments, GLColor* colors, float* perce
 		gradient->angle = angle;
 		gradient->originU = originU;
 		gradient->originV = originV;
+		gradient->lookupTexture = 0;
+		gradient->lookupUploaded = 0;
+		gradient->lookupContext = 0;
+
+		bakeGradient(gradient);
 	}
 
 	return gradient;
 }
 
+// Bakes the lookup colors of a gradient again after its mapping has been changed in place.
+void Graphics2D::updateGradient(Gradient* gradient)
+{
+	if (!gradient) {
+		return;
+	}
+
+	bakeGradient(gradient);
+}
+
+// Frees the specified gradient, along with its lookup texture once the next frame is rendered.
+void Graphics2D::freeGradient(Gradient* gradient)
+{
+	if (!gradient) {
+		return;
+	}
+
+	// the texture belongs to the rendering context, so it is deleted from there
+	if (gradient->lookupTexture != 0) {
+		_master2D->_drawMutex.lock();
+
+		_master2D->_freedTextures.append(gradient->lookupTexture);
+
+		_master2D->_drawMutex.unlock();
+	}
+
+	delete gradient;
+}
+
 // create a new image texture
 ImageTexture* Graphics2D::createImageTexture(ImageData* image, int scaling, int tiling, float uScale, float vScale, int leftMargin, int rightMargin, int topMargin, int bottomMargin)
 {
@@ -959,13 +1314,10 @@ void Graphics2D::rotate(double theta)
 {
 	//qDebug()  << "Graphics2D::rotate: " << theta;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	RenderCommandHeader* command = appendCommand(RENDER_TRANSFORM_ROTATE, 0, 1, 0);
+	GLfloat* floats = commandFloats(command);
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)theta;
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_TRANSFORM_ROTATE;
+	*floats++ = (GLfloat)theta;
 }
 
 // Concatenates the current Graphics2D Transform with a scaling transformation Subsequent rendering is resized according to the specified scaling factors relative to the previous scaling.
@@ -973,14 +1325,11 @@ void Graphics2D::scale(double sx, double sy)
 {
 	//qDebug()  << "Graphics2D::rotate: " << sx << ":" << sy;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)sx;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)sy;
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawFloatIndex-1;
+	RenderCommandHeader* command = appendCommand(RENDER_TRANSFORM_SCALE, 0, 2, 0);
+	GLfloat* floats = commandFloats(command);
 
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_TRANSFORM_SCALE;
+	*floats++ = (GLfloat)sx;
+	*floats++ = (GLfloat)sy;
 }
 
 // Translates the origin of the Graphics2D context to the point (x, y) in the current coordinate system.
@@ -994,14 +1343,11 @@ void Graphics2D::translate(double tx, double ty)
 {
 	//qDebug()  << "Graphics2D::translate: " << tx << ":" << ty;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	RenderCommandHeader* command = appendCommand(RENDER_TRANSFORM_TRANSLATE, 0, 2, 0);
+	GLfloat* floats = commandFloats(command);
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)tx;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)ty;
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_TRANSFORM_TRANSLATE;
+	*floats++ = (GLfloat)tx;
+	*floats++ = (GLfloat)ty;
 }
 
 // Concatenates the current Graphics2D Transform with a shearing transform.
@@ -1015,14 +1361,11 @@ void Graphics2D::shear(double shx, double shy)
 {
 	//qDebug()  << "Graphics2D::shear: " << shx << ":" << shy;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)shx;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)shy;
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawFloatIndex-1;
+	RenderCommandHeader* command = appendCommand(RENDER_TRANSFORM_SHEAR, 0, 2, 0);
+	GLfloat* floats = commandFloats(command);
 
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_TRANSFORM_SHEAR;
+	*floats++ = (GLfloat)shx;
+	*floats++ = (GLfloat)shy;
 }
 
 // Overwrites the Transform in the Graphics2D context.
@@ -1030,17 +1373,14 @@ void Graphics2D::transform(double** matrix)
 {
 	//qDebug()  << "Graphics2D::transform: " << matrix;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	RenderCommandHeader* command = appendCommand(RENDER_TRANSFORM, 0, 9, 0);
+	GLfloat* floats = commandFloats(command);
 
 	for(int i = 0; i < 3; i++) {
 		for(int j = 0; j < 3; j++) {
-			_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)matrix[i][j];
+			*floats++ = (GLfloat)matrix[i][j];
 		}
 	}
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_TRANSFORM_SHEAR;
 }
 
 // Clears the specified rectangle by filling it with the background color of the current drawing surface.
@@ -1048,16 +1388,13 @@ void Graphics2D::clearRect(int x, int y, int width, int height)
 {
 	//qDebug()  << "Graphics2D::clearRect: " << x << "," << y << " , " << width << " x " << height;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
-
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = x;
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = y;
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = width;
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = height;
-
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
+	RenderCommandHeader* command = appendCommand(RENDER_CLEAR_RECT, 0, 0, 4);
+	int* ints = commandInts(command);
 
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_CLEAR_RECT;
+	*ints++ = x;
+	*ints++ = y;
+	*ints++ = width;
+	*ints++ = height;
 }
 
 // Intersects the current clip with the specified rectangle.
@@ -1065,16 +1402,13 @@ void Graphics2D::clipRect(int x, int y, int width, int height)
 {
 	//qDebug()  << "Graphics2D::clipRect: " << x << "," << y << " , " << width << " x " << height;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
+	RenderCommandHeader* command = appendCommand(RENDER_CLIP_RECT, 0, 0, 4);
+	int* ints = commandInts(command);
 
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = x;
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = y;
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = width;
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = height;
-
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_CLIP_RECT;
+	*ints++ = x;
+	*ints++ = y;
+	*ints++ = width;
+	*ints++ = height;
 }
 
 // Returns the background color used for clearing a region.
@@ -1123,18 +1457,13 @@ void Graphics2D::setBackground(const GLColor& color)
 
 	//qDebug()  << "Graphics2D::setBackground: (rgba) " << color.red << "," << color.green << "," << color.blue << "," << color.alpha;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = color.red;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = color.green;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = color.blue;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = color.alpha;
-
-	//qDebug()  << "Graphics2D::setBackground " << _drawFloats[_master2D->_currentDrawFloatIndex-4] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-3] << " " <<  _drawFloats[_master2D->_currentDrawFloatIndex-2] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-1];
+	RenderCommandHeader* command = appendCommand(RENDER_SET_BACKGROUND, 0, 4, 0);
+	GLfloat* floats = commandFloats(command);
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_SET_BACKGROUND;
+	*floats++ = color.red;
+	*floats++ = color.green;
+	*floats++ = color.blue;
+	*floats++ = color.alpha;
 }
 
 // Sets this graphics context's current color to the specified color.
@@ -1147,18 +1476,13 @@ void Graphics2D::setColor(const GLColor& color)
 
 	//qDebug()  << "Graphics2D::setColor: (rgba) " << color.red << "," << color.green << "," << color.blue << "," << color.alpha;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = color.red;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = color.green;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = color.blue;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = color.alpha;
-
-	//qDebug()  << "Graphics2D::setColor " << _drawFloats[_master2D->_currentDrawFloatIndex-4] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-3] << " " <<  _drawFloats[_master2D->_currentDrawFloatIndex-2] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-1];
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _currentDrawFloatIndex-1;
+	RenderCommandHeader* command = appendCommand(RENDER_SET_COLOR, 0, 4, 0);
+	GLfloat* floats = commandFloats(command);
 
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_SET_COLOR;
+	*floats++ = color.red;
+	*floats++ = color.green;
+	*floats++ = color.blue;
+	*floats++ = color.alpha;
 }
 
 // Sets this graphics context's font to the specified font.
@@ -1166,6 +1490,21 @@ void Graphics2D::setFont(Font* font)
 {
 	//qDebug()  << "Graphics2D::setFont: " << font;
 
+	int returnCode = createFontTexture(font);
+
+	if (EXIT_SUCCESS != returnCode) {
+		qDebug() << "Graphics2D::setFont: Unable to create texture\n";
+	} else {
+		_master2D->_currentFont = font;
+
+		RenderCommandHeader* command = appendCommand(RENDER_SET_FONT, 1, 0, 0);
+		commandPointers(command)[0] = font;
+	}
+}
+
+// Creates or looks up the texture holding a font's glyphs.
+int Graphics2D::createFontTexture(Font* font)
+{
 	int returnCode = EXIT_SUCCESS;
 
 	if (!_glTextureIDImageMap.contains(font->image)) {
@@ -1184,44 +1523,41 @@ void Graphics2D::setFont(Font* font)
 		font->fontTexture = _glTextureIDImageMap.value(font->image);
 	}
 
-	if (EXIT_SUCCESS != returnCode) {
-		qDebug() << "Graphics2D::setFont: Unable to create texture\n";
-	} else {
-		_master2D->_currentFont = font;
-
-		_master2D->_drawPointerIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawPointerIndex;
-
-		_master2D->_drawPointers[_master2D->_currentDrawPointerIndex++] = font;
-
-		_master2D->_drawPointerIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawPointerIndex-1;
-
-		_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_SET_FONT;
-	}
+	return returnCode;
 }
 
-void Graphics2D::setGradient(Gradient* gradient)
+// Creates or looks up the texture holding an image.
+int Graphics2D::createTextureForImage(ImageData* image, GLuint* texture)
 {
-	qDebug()  << "Graphics2D::setGradient: " << gradient;
-
-	_master2D->_currentGradient = gradient;
-
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawPointerIndex;
+	int returnCode = EXIT_SUCCESS;
+	float tex_x = 1.0, tex_y = 1.0;
 
-	_master2D->_drawPointers[_master2D->_currentDrawPointerIndex++] = gradient;
+	if (!_glTextureIDImageMap.contains(image)) {
+		returnCode = createTexture2D(image, NULL, NULL, &tex_x, &tex_y, texture);
 
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawPointerIndex-1;
+		if (EXIT_SUCCESS == returnCode) {
+			_glTextureIDImageMap.insert(image, *texture);
+		}
+	} else {
+		*texture = _glTextureIDImageMap.value(image);
+	}
 
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_SET_GRADIENT;
+	return returnCode;
+}
 
-	_master2D->_currentImageTexture = NULL;
+void Graphics2D::setGradient(Gradient* gradient)
+{
+	qDebug()  << "Graphics2D::setGradient: " << gradient;
 
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawPointerIndex;
+	_master2D->_currentGradient = gradient;
 
-	_master2D->_drawPointers[_master2D->_currentDrawPointerIndex++] = NULL;
+	RenderCommandHeader* command = appendCommand(RENDER_SET_GRADIENT, 1, 0, 0);
+	commandPointers(command)[0] = gradient;
 
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawPointerIndex-1;
+	_master2D->_currentImageTexture = NULL;
 
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_SET_IMAGE_TEXTURE;
+	command = appendCommand(RENDER_SET_IMAGE_TEXTURE, 1, 0, 0);
+	commandPointers(command)[0] = NULL;
 }
 
 void Graphics2D::setImageTexture(ImageTexture* imageTexture)
@@ -1230,23 +1566,13 @@ void Graphics2D::setImageTexture(ImageTexture* imageTexture)
 
 	_master2D->_currentImageTexture = imageTexture;
 
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawPointerIndex;
-
-	_master2D->_drawPointers[_master2D->_currentDrawPointerIndex++] = imageTexture;
-
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawPointerIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_SET_IMAGE_TEXTURE;
+	RenderCommandHeader* command = appendCommand(RENDER_SET_IMAGE_TEXTURE, 1, 0, 0);
+	commandPointers(command)[0] = imageTexture;
 
 	_master2D->_currentGradient = NULL;
 
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawPointerIndex;
-
-	_master2D->_drawPointers[_master2D->_currentDrawPointerIndex++] = NULL;
-
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawPointerIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_SET_GRADIENT;
+	command = appendCommand(RENDER_SET_GRADIENT, 1, 0, 0);
+	commandPointers(command)[0] = NULL;
 }
 
 void Graphics2D::setStroke(Stroke *stroke)
@@ -1255,13 +1581,8 @@ void Graphics2D::setStroke(Stroke *stroke)
 
 	_master2D->_currentStroke = stroke;
 
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawPointerIndex;
-
-	_master2D->_drawPointers[_master2D->_currentDrawPointerIndex++] = stroke;
-
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawPointerIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_SET_STROKE;
+	RenderCommandHeader* command = appendCommand(RENDER_SET_STROKE, 1, 0, 0);
+	commandPointers(command)[0] = stroke;
 }
 
 
@@ -1275,20 +1596,15 @@ void Graphics2D::drawArc(double x, double y, double width, double height, double
 {
 	//qDebug()  << "Graphics2D::drawArc: " << x << "," << y << " size " << width << "x" << height << " sweep " << startAngle << ", " << arcAngle;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)y;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)width;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)height;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)startAngle;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)arcAngle;
-
-	//qDebug()  << "Graphics2D::drawArc segment " <<  _drawFloats[_master2D->_currentDrawFloatIndex-4] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-3] << " " <<  _drawFloats[_master2D->_currentDrawFloatIndex-2] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-1];
+	RenderCommandHeader* command = appendCommand(RENDER_DRAW_ARC, 0, 6, 0);
+	GLfloat* floats = commandFloats(command);
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] =_master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_DRAW_ARC;
+	*floats++ = (GLfloat)x;
+	*floats++ = (GLfloat)y;
+	*floats++ = (GLfloat)width;
+	*floats++ = (GLfloat)height;
+	*floats++ = (GLfloat)startAngle;
+	*floats++ = (GLfloat)arcAngle;
 }
 
 // Draws as much of the specified image as is currently available.
@@ -1333,7 +1649,6 @@ void Graphics2D::drawImage(ImageData* image, int dx1, int dy1, int dx2, int dy2,
 void Graphics2D::drawImage(ImageData* image, double x, double y)
 {
 	_master2D->drawImage(image, x, y, x + image->width(), y + image->height(), 0, 0, image->width(), image->height(), COLOR_TRANSPARENT);
-
 }
 
 // Draws as much of the specified image as is currently available.
@@ -1384,8 +1699,6 @@ void Graphics2D::drawImage(ImageData* image, double dx1, double dy1, double dx2,
 		_master2D->setColor(saveColor);
 	}
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
-
 	int returnCode = EXIT_SUCCESS;
 	if (!_glTextureIDImageMap.contains(image)) {
 		returnCode = createTexture2D(image, NULL, NULL, &tex_x, &tex_y, &photo);
@@ -1422,36 +1735,30 @@ void Graphics2D::drawImage(ImageData* image, double dx1, double dy1, double dx2,
 		imageVertices[6] = _photoPosX + _photoSizeX;
 		imageVertices[7] = _photoPosY + _photoSizeY;
 
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageTexCoord[0];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageTexCoord[1];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageTexCoord[2];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageTexCoord[3];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageTexCoord[4];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageTexCoord[5];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageTexCoord[6];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageTexCoord[7];
-
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageVertices[0];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageVertices[1];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageVertices[2];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageVertices[3];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageVertices[4];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageVertices[5];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageVertices[6];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = imageVertices[7];
+		RenderCommandHeader* command = appendCommand(RENDER_DRAW_IMAGE, 0, 16, 1);
+		GLfloat* floats = commandFloats(command);
+		int* ints = commandInts(command);
+
+		*floats++ = imageTexCoord[0];
+		*floats++ = imageTexCoord[1];
+		*floats++ = imageTexCoord[2];
+		*floats++ = imageTexCoord[3];
+		*floats++ = imageTexCoord[4];
+		*floats++ = imageTexCoord[5];
+		*floats++ = imageTexCoord[6];
+		*floats++ = imageTexCoord[7];
+
+		*floats++ = imageVertices[0];
+		*floats++ = imageVertices[1];
+		*floats++ = imageVertices[2];
+		*floats++ = imageVertices[3];
+		*floats++ = imageVertices[4];
+		*floats++ = imageVertices[5];
+		*floats++ = imageVertices[6];
+		*floats++ = imageVertices[7];
+
+		*ints++ = photo;
 	}
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawFloatIndex-1;
-
-
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
-
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = photo;
-
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
-
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_DRAW_IMAGE;
 }
 
 // Draws a line, using the current color, between the points (x1, y1) and (x2, y2) in this graphics context's coordinate system.
@@ -1465,18 +1772,13 @@ void Graphics2D::drawLine(double x1, double y1, double x2, double y2)
 {
 	//qDebug()  << "Graphics2D::drawLine: " << x1 << "," << y1 << " to " << x2 << "," << y2;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)x1;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)y1;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)x2;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)y2;
+	RenderCommandHeader* command = appendCommand(RENDER_DRAW_LINE, 0, 4, 0);
+	GLfloat* floats = commandFloats(command);
 
-	//qDebug()  << "Graphics2D::drawLine segment " <<  _drawFloats[_master2D->_currentDrawFloatIndex-4] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-3] << " " <<  _drawFloats[_master2D->_currentDrawFloatIndex-2] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-1];
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] =_master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_DRAW_LINE;
+	*floats++ = (GLfloat)x1;
+	*floats++ = (GLfloat)y1;
+	*floats++ = (GLfloat)x2;
+	*floats++ = (GLfloat)y2;
 }
 
 // Draws the outline of an oval.
@@ -1491,6 +1793,17 @@ void Graphics2D::drawOval(double x, double y, double width, double height)
 	drawArc(x, y, width, height, 0.0, 360.0);
 }
 
+// Draws the outline of the specified path with the current stroke.
+void Graphics2D::drawPath(Path2D* path)
+{
+	if (path == NULL || path->isEmpty()) {
+		return;
+	}
+
+	RenderCommandHeader* command = appendCommand(RENDER_DRAW_PATH, 1, 0, 0);
+	commandPointers(command)[0] = path;
+}
+
 // Draws a closed polygon defined by arrays of x and y coordinates.
 void Graphics2D::drawPolygon(int* xPoints, int* yPoints, int nPoints)
 {
@@ -1522,28 +1835,21 @@ void Graphics2D::drawPolygon(double* xPoints, double* yPoints, int nPoints)
 
 	int numberPoints = nPoints+1;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
+	RenderCommandHeader* command = appendCommand(RENDER_DRAW_POLYLINE, 0, numberPoints * 2, 1);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = numberPoints;
-
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
-
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	*ints++ = numberPoints;
 
 	for(int index = 0; index < numberPoints; index++) {
 		if (index < (numberPoints-1)) {
-			_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = xPoints[index];
-			_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = yPoints[index];
+			*floats++ = xPoints[index];
+			*floats++ = yPoints[index];
 		} else {
-			_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = xPoints[0];
-			_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = yPoints[0];
+			*floats++ = xPoints[0];
+			*floats++ = yPoints[0];
 		}
 	}
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] =_master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_DRAW_POLYLINE;
 }
 
 // Draws a sequence of connected lines defined by arrays of x and y coordinates.
@@ -1577,23 +1883,16 @@ void Graphics2D::drawPolyline(double* xPoints, double* yPoints, int nPoints)
 
 	int numberPoints = nPoints;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
-
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = numberPoints;
-
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
-
+	RenderCommandHeader* command = appendCommand(RENDER_DRAW_POLYLINE, 0, numberPoints * 2, 1);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	*ints++ = numberPoints;
 
 	for(int index = 0; index < numberPoints; index++) {
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = xPoints[index];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = yPoints[index];
+		*floats++ = xPoints[index];
+		*floats++ = yPoints[index];
 	}
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] =_master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_DRAW_POLYLINE;
 }
 
 // Draws the outline of the specified rectangle.
@@ -1608,33 +1907,26 @@ void Graphics2D::drawRect(double x, double y, double width, double height)
 
 	int numberPoints = 5;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
-
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = numberPoints;
-
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
+	RenderCommandHeader* command = appendCommand(RENDER_DRAW_POLYLINE, 0, numberPoints * 2, 1);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
+	*ints++ = numberPoints;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	*floats++ = x;
+	*floats++ = y;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y;
+	*floats++ = x + width;
+	*floats++ = y;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x + width;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y;
+	*floats++ = x + width;
+	*floats++ = y + height;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x + width;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y + height;
+	*floats++ = x;
+	*floats++ = y + height;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y + height;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y;
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] =_master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_DRAW_POLYLINE;
+	*floats++ = x;
+	*floats++ = y;
 }
 
 
@@ -1650,28 +1942,20 @@ void Graphics2D::drawRoundRect(double x, double y, double width, double height,
 
 	int numberPoints = 5;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
-
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = numberPoints;
+	RenderCommandHeader* command = appendCommand(RENDER_DRAW_ROUNDRECT, 0, 6, 1);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
+	*ints++ = numberPoints;
 
+	*floats++ = x;
+	*floats++ = y;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = width;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = height;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = arcWidth;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = arcHeight;
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] =_master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_DRAW_ROUNDRECT;
+	*floats++ = width;
+	*floats++ = height;
 
+	*floats++ = arcWidth;
+	*floats++ = arcHeight;
 }
 
 
@@ -1757,21 +2041,21 @@ void Graphics2D::drawString(QString text, int x, int y)
 // Draws the text given by the specified string, using this graphics context's current font and color.
 void Graphics2D::drawString(QString text, double x, double y)
 {
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawPointerIndex;
-
-	_master2D->_drawPointers[_master2D->_currentDrawPointerIndex++] = (void*)(new QString(text));
-
-	_master2D->_drawPointerIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawPointerIndex-1;
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	// the text is kept in the command itself as a count followed by UCS-4 code points
+	QVector<uint> characters = text.toUcs4();
+	int length = characters.size();
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y;
+	RenderCommandHeader* command = appendCommand(RENDER_DRAW_STRING, 0, 2, length + 1);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawFloatIndex-1;
+	*floats++ = x;
+	*floats++ = y;
 
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_DRAW_STRING;
+	*ints++ = length;
+	for(int index = 0; index < length; index++) {
+		*ints++ = (int)characters[index];
+	}
 }
 
 // Fills a circular or elliptical arc covering the specified rectangle.
@@ -1784,20 +2068,15 @@ void Graphics2D::fillArc(double x, double y, double width, double height, double
 {
 	//qDebug()  << "Graphics2D::drawArc: " << x << "," << y << " size " << width << "x" << height << " sweep " << startAngle << ", " << arcAngle;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)y;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)width;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)height;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)startAngle;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (GLfloat)arcAngle;
-
-	//qDebug()  << "Graphics2D::drawArc segment " <<  _drawFloats[_master2D->_currentDrawFloatIndex-4] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-3] << " " <<  _drawFloats[_master2D->_currentDrawFloatIndex-2] << "," << _drawFloats[_master2D->_currentDrawFloatIndex-1];
+	RenderCommandHeader* command = appendCommand(RENDER_FILL_ARC, 0, 6, 0);
+	GLfloat* floats = commandFloats(command);
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] =_master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_FILL_ARC;
+	*floats++ = (GLfloat)x;
+	*floats++ = (GLfloat)y;
+	*floats++ = (GLfloat)width;
+	*floats++ = (GLfloat)height;
+	*floats++ = (GLfloat)startAngle;
+	*floats++ = (GLfloat)arcAngle;
 }
 
 // Fills an oval bounded by the specified rectangle with the current color.
@@ -1826,43 +2105,80 @@ void Graphics2D::fillRect(double x, double y, double width, double height)
 
 	int numberPoints = 4;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
+	RenderCommandHeader* command = appendCommand(RENDER_FILL_POLYGON, 0, numberPoints * 4, 1);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = numberPoints;
+	*ints++ = numberPoints;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
+	// corners in outline order, as the polygon tessellator expects
+	*floats++ = x;
+	*floats++ = y;
 
+	*floats++ = x + width;
+	*floats++ = y;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	*floats++ = x + width;
+	*floats++ = y + height;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y + height;
+	*floats++ = x;
+	*floats++ = y + height;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x + width;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y + height;
+	// texture coordinates
+	*floats++ = 0.0;
+	*floats++ = 0.0;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y;
+	*floats++ = 1.0;
+	*floats++ = 0.0;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x + width;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y;
+	*floats++ = 1.0;
+	*floats++ = 1.0;
 
-	// texture coordinates
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 0;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 1.0;
+	*floats++ = 0.0;
+	*floats++ = 1.0;
+}
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 1.0;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 1.0;
+// Fills the subpaths of the specified path, each one as if it were closed.
+void Graphics2D::fillPath(Path2D* path)
+{
+	if (path == NULL || path->isEmpty()) {
+		return;
+	}
+
+	RenderCommandHeader* command = appendCommand(RENDER_FILL_PATH, 1, 0, 0);
+	commandPointers(command)[0] = path;
+}
+
+// Fills copies of a mesh of triangles, each scaled by its scale (1 without scales), moved to its (x,y) position and filled with its color (the current color without colors).
+void Graphics2D::drawInstances(const GLfloat* meshCoords, int meshVertexCount, const GLfloat* positions, const GLfloat* scales, const GLColor* colors, int instanceCount)
+{
+	if (meshVertexCount < 3 || instanceCount <= 0) {
+		return;
+	}
+
+	RenderCommandHeader* command = appendCommand(RENDER_DRAW_INSTANCES, 0, meshVertexCount * 2 + instanceCount * INSTANCE_FLOATS, 2);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 0.0;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 0.0;
+	ints[0] = meshVertexCount;
+	ints[1] = instanceCount;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 1.0;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 0.0;
+	memcpy(floats, meshCoords, meshVertexCount * 2 * sizeof(GLfloat));
+	floats += meshVertexCount * 2;
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] =_master2D->_currentDrawFloatIndex-1;
+	const GLColor& color = _master2D->_foregroundColor;
 
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_FILL_POLYGON;
+	for(int index = 0; index < instanceCount; index++) {
+		const GLColor& instanceColor = colors ? colors[index] : color;
+
+		*floats++ = positions[index*2+0];
+		*floats++ = positions[index*2+1];
+		*floats++ = scales ? scales[index] : 1.0;
+		*floats++ = instanceColor.red;
+		*floats++ = instanceColor.green;
+		*floats++ = instanceColor.blue;
+		*floats++ = instanceColor.alpha;
+	}
 }
 
 // Draws a closed polygon defined by arrays of x and y coordinates.
@@ -1894,14 +2210,11 @@ void Graphics2D::fillPolygon(double* xPoints, double* yPoints, int nPoints)
 {
 	//qDebug()  << "Graphics2D::drawPolygon: " << xPoints << " " << yPoints << " " << nPoints;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
+	RenderCommandHeader* command = appendCommand(RENDER_FILL_POLYGON, 0, nPoints * 4, 1);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = nPoints;
-
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
-
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	*ints++ = nPoints;
 
 	float x = 0.0, y = 0.0, minX = 1.0e6, minY = 1.0e6, maxX = -1.0e6, maxY = -1.0e6;
 
@@ -1928,26 +2241,22 @@ void Graphics2D::fillPolygon(double* xPoints, double* yPoints, int nPoints)
 	y /= nPoints;
 
 	for(int index = 0; index < nPoints; index++) {
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = xPoints[index];
-		_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = yPoints[index];
+		*floats++ = xPoints[index];
+		*floats++ = yPoints[index];
 	}
 
 	for(int index = 0; index < nPoints; index++) {
 		if (minX == maxX) {
-			_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 0.0;
+			*floats++ = 0.0;
 		} else {
-			_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (xPoints[index] - minX) / (maxX - minX);
+			*floats++ = (xPoints[index] - minX) / (maxX - minX);
 		}
 		if (minY == maxY) {
-			_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = 0.0;
+			*floats++ = 0.0;
 		} else {
-			_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = (yPoints[index] - minY) / (maxY - minY);
+			*floats++ = (yPoints[index] - minY) / (maxY - minY);
 		}
 	}
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] =_master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_FILL_POLYGON;
 }
 
 // Draws an outlined round-cornered rectangle using this graphics context's current color.
@@ -1962,28 +2271,20 @@ void Graphics2D::fillRoundRect(double x, double y, double width, double height,
 
 	int numberPoints = 4;
 
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawIntIndex;
-
-	_master2D->_drawInts[_master2D->_currentDrawIntIndex++] = numberPoints;
-
-	_master2D->_drawIntIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawIntIndex-1;
-
+	RenderCommandHeader* command = appendCommand(RENDER_FILL_ROUNDRECT, 0, 6, 1);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+0] = _master2D->_currentDrawFloatIndex;
+	*ints++ = numberPoints;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = x;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = y;
+	*floats++ = x;
+	*floats++ = y;
 
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = width;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = height;
-
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = arcWidth;
-	_master2D->_drawFloats[_master2D->_currentDrawFloatIndex++] = arcHeight;
-
-	_master2D->_drawFloatIndices[_master2D->_commandCount*2+1] = _master2D->_currentDrawFloatIndex-1;
-
-	_master2D->_drawCommands[_master2D->_commandCount++] = RENDER_FILL_ROUNDRECT;
+	*floats++ = width;
+	*floats++ = height;
 
+	*floats++ = arcWidth;
+	*floats++ = arcHeight;
 }
 
 
@@ -2045,15 +2346,7 @@ void Graphics2D::setupView(int x, int y, int width, int height)
 		//qDebug()  << " " << _scaleMatrix[index];
 	}
 
-	int i, j, k;
-	memset(_renderModelMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_renderModelMatrix[i * 4 + j] += _transformMatrix[i * 4 + k] * _scaleMatrix[k * 4 + j];
-			}
-		}
-	}
+	multiplyMatrix(_transformMatrix, _scaleMatrix, _renderModelMatrix);
 
 	//qDebug()  << "Graphics2D::setupView: transform matrix: \n" ;;
 	for(int index = 0; index < 16; index++) {
@@ -2070,1016 +2363,4215 @@ void Graphics2D::setupView(int x, int y, int width, int height)
 #endif
 }
 
-void Graphics2D::render() {
+// Appends a command to the display list being captured or else to the current frame.
+RenderCommandHeader* Graphics2D::appendCommand(RenderCommand command, int pointerCount, int floatCount, int intCount)
+{
+	if (_master2D->_displayList) {
+		return _master2D->_displayList->commands()->append(command, pointerCount, floatCount, intCount);
+	}
 
-	int renderCommandCount;
+	return _master2D->_recordCommands->append(command, pointerCount, floatCount, intCount);
+}
 
-	//qDebug()  << "Graphics2D::render ";
+// Starts capturing subsequent drawing calls into the specified display list instead of the current frame.
+void Graphics2D::beginDisplayList(DisplayList* displayList)
+{
+	//qDebug()  << "Graphics2D::beginDisplayList: " << displayList;
 
-	_master2D->_refreshMutex.lock();
+	if (_master2D->_displayList) {
+		qCritical() << "Graphics2D::beginDisplayList: already capturing a display list\n";
+		return;
+	}
 
-#ifdef GLES1
-	//Common GL ES1 setup
-	glShadeModel(GL_SMOOTH);
-#elif defined(GLES2)
-#else
-#error libviews should be compiled with either GLES1 or GLES2 -D flags.
-#endif
+	// remember the drawing state so that the captured calls do not leak into the frame being recorded
+	_master2D->_displayListState.foregroundColor = _master2D->_foregroundColor;
+	_master2D->_displayListState.backgroundColor = _master2D->_backgroundColor;
+	_master2D->_displayListState.font = _master2D->_currentFont;
+	_master2D->_displayListState.gradient = _master2D->_currentGradient;
+	_master2D->_displayListState.imageTexture = _master2D->_currentImageTexture;
+	_master2D->_displayListState.stroke = _master2D->_currentStroke;
 
-	glEnable(GL_CULL_FACE);
+	displayList->clear();
 
-	// setup view
-	_master2D->setupView(0, 0, _width, _height);
+	_master2D->_displayList = displayList;
 
-	// start rendering primitives
-	for(renderCommandCount = 0; renderCommandCount < _commandCount; renderCommandCount++) {
+	// strokes are baked into the geometry, so the list starts with the one in effect now rather than the one it is replayed with
+	if (_master2D->_currentStroke) {
+		_master2D->setStroke(_master2D->_currentStroke);
+	}
+}
 
-		//qDebug()  << "Graphics2D::render: " << index << ":" << _master2D->_drawCommands[renderCommandCount];
+// Stops capturing drawing calls into the current display list.
+void Graphics2D::endDisplayList()
+{
+	//qDebug()  << "Graphics2D::endDisplayList: " << _master2D->_displayList;
 
-		switch(_master2D->_drawCommands[renderCommandCount]) {
-		case RENDER_CLEAR_RECT:
-			_master2D->renderClearRect(renderCommandCount);
-			break;
-		case RENDER_CLIP_RECT:
-			_master2D->renderClipRect(renderCommandCount);
-			break;
-		case RENDER_TRANSFORM:
-			_master2D->renderTransform(renderCommandCount);
-			break;
-		case RENDER_TRANSFORM_ROTATE:
-			_master2D->renderRotate(renderCommandCount);
-			break;
-		case RENDER_TRANSFORM_TRANSLATE:
-			_master2D->renderTranslate(renderCommandCount);
-			break;
-		case RENDER_TRANSFORM_SCALE:
-			_master2D->renderScale(renderCommandCount);
-			break;
-		case RENDER_TRANSFORM_SHEAR:
-			_master2D->renderShear(renderCommandCount);
-			break;
-		case RENDER_SET_BACKGROUND:
-			_master2D->renderSetBackground(renderCommandCount);
-			break;
-		case RENDER_SET_COLOR:
-			_master2D->renderSetColor(renderCommandCount);
-			break;
-		case RENDER_SET_FONT:
-			_master2D->renderSetFont(renderCommandCount);
-			break;
-		case RENDER_SET_GRADIENT:
-			_master2D->renderSetGradient(renderCommandCount);
-			break;
-		case RENDER_SET_IMAGE_TEXTURE:
-			_master2D->renderSetImageTexture(renderCommandCount);
-			break;
-		case RENDER_SET_STROKE:
-			_master2D->renderSetStroke(renderCommandCount);
-			break;
-		case RENDER_DRAW_ARC:
-		case RENDER_FILL_ARC:
-			_master2D->renderDrawFillArc(renderCommandCount);
-			break;
-		case RENDER_DRAW_IMAGE:
-			_master2D->renderDrawImage(renderCommandCount);
-			break;
-		case RENDER_DRAW_LINE:
-			_master2D->renderDrawLine(renderCommandCount);
-			break;
-		case RENDER_DRAW_POLYLINE:
-			_master2D->renderDrawPolyline(renderCommandCount);
-			break;
-		case RENDER_DRAW_ROUNDRECT:
-		case RENDER_FILL_ROUNDRECT:
-			_master2D->renderDrawFillRoundRect(renderCommandCount);
-			break;
-		case RENDER_DRAW_STRING:
-			_master2D->renderDrawString(renderCommandCount);
-			break;
-		case RENDER_FILL_POLYGON:
-			_master2D->renderFillPolygon(renderCommandCount);
-			break;
-		default:
-			break;
-		}
+	if (_master2D->_displayList == NULL) {
+		return;
 	}
 
-	_master2D->_refreshMutex.unlock();
+	_master2D->optimizeCommands(_master2D->_displayList->commands());
+	_master2D->bakeDisplayList(_master2D->_displayList);
+
+	_master2D->_displayList = NULL;
+
+	_master2D->_foregroundColor = _master2D->_displayListState.foregroundColor;
+	_master2D->_backgroundColor = _master2D->_displayListState.backgroundColor;
+	_master2D->_currentFont = _master2D->_displayListState.font;
+	_master2D->_currentGradient = _master2D->_displayListState.gradient;
+	_master2D->_currentImageTexture = _master2D->_displayListState.imageTexture;
+	_master2D->_currentStroke = _master2D->_displayListState.stroke;
 }
 
+// Replays the specified display list, leaving the drawing state as it was before the call.
+void Graphics2D::drawDisplayList(DisplayList* displayList)
+{
+	_master2D->drawDisplayList(displayList, 0.0, 0.0, 1.0, 1.0);
+}
 
-// Concatenates the current Graphics2D Transform with a rotation transform.
-void Graphics2D::renderRotate(int commandCount)
+// Replays the specified display list translated and scaled, leaving the drawing state as it was before the call.
+void Graphics2D::drawDisplayList(DisplayList* displayList, double tx, double ty, double sx, double sy)
 {
-	//qDebug()  << "Graphics2D::rrenderRotate: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1];
+	//qDebug()  << "Graphics2D::drawDisplayList: " << displayList << " : " << tx << "," << ty << " : " << sx << "," << sy;
 
-	GLfloat theta  = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
+	if (displayList == NULL || displayList->isEmpty()) {
+		return;
+	}
 
-#ifdef GLES1
-	glRotatef(theta, 0.0, 0.0, 1.0);
-#elif defined(GLES2)
-	GLfloat tempMatrix[16], rotateMatrix[16];
-	memset(rotateMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	memcpy(tempMatrix, _transformMatrix, sizeof(GLfloat) * 4 * 4);
+	if (displayList == _master2D->_displayList) {
+		qCritical() << "Graphics2D::drawDisplayList: a display list cannot be drawn into itself\n";
+		return;
+	}
 
-	rotateMatrix[0] = cosf(theta * M_PI / 180.0);
-	rotateMatrix[1] = sinf(theta * M_PI / 180.0);
-	rotateMatrix[4] = cosf((theta + 90.0) * M_PI / 180.0);
-	rotateMatrix[5] = sinf((theta + 90.0) * M_PI / 180.0);
-	rotateMatrix[15] = 1.0f;
+	appendCommand(RENDER_SAVE_STATE, 0, 0, 0);
 
-	int i, j, k;
-	memset(_transformMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_transformMatrix[i * 4 + j] += tempMatrix[i * 4 + k] * rotateMatrix[k * 4 + j];
-			}
-		}
+	if (tx != 0.0 || ty != 0.0) {
+		_master2D->translate(tx, ty);
 	}
 
-	memset(_renderModelMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_renderModelMatrix[i * 4 + j] += _transformMatrix[i * 4 + k] * _scaleMatrix[k * 4 + j];
-			}
-		}
+	if (sx != 1.0 || sy != 1.0) {
+		_master2D->scale(sx, sy);
 	}
 
-#else
-#error libviews should be compiled with either GLES1 or GLES2 -D flags.
-#endif
+	// a frame gets the baked meshes, while a list being captured or a frame being written to a file keeps the recorded
+	// geometry, since command streams are loaded without meshes
+	_master2D->_drawMutex.lock();
+	bool capturing = !_master2D->_captureFileName.isEmpty();
+	_master2D->_drawMutex.unlock();
+
+	if (_master2D->_displayList) {
+		_master2D->_displayList->commands()->appendBuffer(displayList->commands());
+	} else if (capturing) {
+		_master2D->_recordCommands->appendBuffer(displayList->commands());
+	} else {
+		_master2D->_recordCommands->appendBuffer(displayList->bakedCommands());
+	}
+
+	appendCommand(RENDER_RESTORE_STATE, 0, 0, 0);
 }
 
-// Concatenates the current Graphics2D Transform with a scaling transformation Subsequent rendering is resized according to the specified scaling factors relative to the previous scaling.
-void Graphics2D::renderScale(int commandCount)
+// Returns the number of commands removed from the last completed frame by optimizeCommands().
+int Graphics2D::removedCommandCount()
 {
-	//qDebug()  << "Graphics2D::renderScale: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1];
-
-	GLfloat sx  = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	GLfloat sy  = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
+	return _master2D->_removedCommandCount;
+}
 
-#ifdef GLES1
-	glScalef(sx, sy, 0.0);
-#elif defined(GLES2)
-	GLfloat tempMatrix[16], scaleMatrix[16];
-	memset(scaleMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	memcpy(tempMatrix, _transformMatrix, sizeof(GLfloat) * 4 * 4);
+// Turns on or off grouping of non-overlapping draws by shader program and texture when a frame is completed.
+void Graphics2D::setCommandReordering(bool reorder)
+{
+	_master2D->_drawMutex.lock();
 
-	scaleMatrix[0] = sx;
-	scaleMatrix[5] = sy;
-	scaleMatrix[15] = 1.0f;
+	_master2D->_commandReordering = reorder;
 
-	int i, j, k;
-	memset(_transformMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_transformMatrix[i * 4 + j] += tempMatrix[i * 4 + k] * scaleMatrix[k * 4 + j];
-			}
-		}
-	}
+	_master2D->_drawMutex.unlock();
+}
 
-	memset(_renderModelMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_renderModelMatrix[i * 4 + j] += _transformMatrix[i * 4 + k] * _scaleMatrix[k * 4 + j];
-			}
-		}
-	}
+// Returns the number of program switches the reordering pass saved in the last completed frame.
+int Graphics2D::programSwitchesSaved()
+{
+	return _master2D->_programSwitchesSaved;
+}
 
-#else
-#error libviews should be compiled with either GLES1 or GLES2 -D flags.
-#endif
+// Returns the number of draw calls issued for the last rendered frame.
+int Graphics2D::drawCallCount()
+{
+	return _master2D->_drawCallCount;
 }
 
-// Concatenates the current Graphics2D Transform with a translation transform.
-void Graphics2D::renderTranslate(int commandCount)
+// Turns on or off redrawing only the area that changed since the last rendered frame.
+void Graphics2D::setPartialRedraw(bool partial)
 {
-	//qDebug()  << "Graphics2D::renderTranslate: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1];
+	_master2D->_refreshMutex.lock();
 
-	GLfloat tx  = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	GLfloat ty  = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
+	_master2D->_partialRedraw = partial;
 
-#ifdef GLES1
-	glTranslatef(tx, ty, 0.0);
-#elif defined(GLES2)
-	GLfloat tempMatrix[16], translateMatrix[16];
-	memset(translateMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	memcpy(tempMatrix, _transformMatrix, sizeof(GLfloat) * 4 * 4);
+	_master2D->_refreshMutex.unlock();
+}
 
-	translateMatrix[0]  = 1.0f;
-	translateMatrix[5]  = 1.0f;
-	translateMatrix[10] = 1.0f;
-	translateMatrix[12] = tx;
-	translateMatrix[13] = ty;
-	translateMatrix[15] = 1.0f;
+// Returns the number of pixels redrawn for the last rendered frame.
+int Graphics2D::redrawnPixelCount()
+{
+	return _master2D->_redrawnPixelCount;
+}
 
-	int i, j, k;
-	memset(_transformMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_transformMatrix[i * 4 + j] += tempMatrix[i * 4 + k] * translateMatrix[k * 4 + j];
-			}
+// Returns the number of completed frames dropped because they repeated the last published one.
+int Graphics2D::skippedFrameCount()
+{
+	return _master2D->_skippedFrameCount;
+}
+
+// Sets the number of bytes the tessellated arcs and round rectangles kept for reuse may take up.
+void Graphics2D::setMeshCacheSize(int bytes)
+{
+	_master2D->_drawMutex.lock();
+
+	_master2D->_meshCache.setMaxCost(bytes);
+
+	_master2D->_drawMutex.unlock();
+}
+
+// Returns the number of arcs and round rectangles whose meshes were reused from the cache.
+int Graphics2D::meshCacheHits()
+{
+	return _master2D->_meshCacheHits;
+}
+
+// Returns the number of arcs and round rectangles that had to be tessellated because their meshes were not cached.
+int Graphics2D::meshCacheMisses()
+{
+	return _master2D->_meshCacheMisses;
+}
+
+// Sets how far in pixels on screen curves may stray from their true shape, trading smoothness for vertices.
+void Graphics2D::setTolerance(float tolerance)
+{
+	if (tolerance < MIN_CURVE_TOLERANCE) {
+		tolerance = MIN_CURVE_TOLERANCE;
+	}
+
+	_master2D->_drawMutex.lock();
+
+	_master2D->_curveTolerance = tolerance;
+
+	// the next frame has to be tessellated again even if it is recorded the same
+	_master2D->_frameHashValid = false;
+
+	_master2D->_drawMutex.unlock();
+}
+
+// Returns how far in pixels on screen curves may stray from their true shape.
+float Graphics2D::tolerance()
+{
+	return _master2D->_curveTolerance;
+}
+
+// Sets how far in pixels on screen polylines may be simplified from the points they were drawn with, or 0 to draw every point.
+void Graphics2D::setPolylineTolerance(float tolerance)
+{
+	if (tolerance < 0.0) {
+		tolerance = 0.0;
+	}
+
+	_master2D->_drawMutex.lock();
+
+	_master2D->_polylineTolerance = tolerance;
+
+	// the next frame has to be tessellated again even if it is recorded the same
+	_master2D->_frameHashValid = false;
+
+	_master2D->_drawMutex.unlock();
+}
+
+// Returns how far in pixels on screen polylines may be simplified, 0 if they are not.
+float Graphics2D::polylineTolerance()
+{
+	return _master2D->_polylineTolerance;
+}
+
+// Returns the number of polyline points dropped by simplification from the last tessellated frame.
+int Graphics2D::removedVertexCount()
+{
+	return _master2D->_removedVertexCount;
+}
+
+// Turns on or off a one pixel fringe fading out around the edges of tessellated strokes and fills.
+void Graphics2D::setAntialiasing(bool antialiasing)
+{
+	_master2D->_drawMutex.lock();
+
+	_master2D->_antialiasing = antialiasing;
+
+	// the next frame has to be tessellated again even if it is recorded the same
+	_master2D->_frameHashValid = false;
+
+	_master2D->_drawMutex.unlock();
+}
+
+// Returns true if tessellated strokes and fills get a fringe fading out around their edges.
+bool Graphics2D::antialiasing()
+{
+	return _master2D->_antialiasing;
+}
+
+// Sets the number of flattened points above which paths filled in FILL_MODE_AUTO go through the stencil buffer rather than being triangulated.
+void Graphics2D::setStencilThreshold(int points)
+{
+	_master2D->_drawMutex.lock();
+
+	_master2D->_stencilThreshold = points;
+
+	// the next frame has to be tessellated again even if it is recorded the same
+	_master2D->_frameHashValid = false;
+
+	_master2D->_drawMutex.unlock();
+}
+
+// Returns the number of flattened points above which paths are filled through the stencil buffer.
+int Graphics2D::stencilThreshold()
+{
+	return _master2D->_stencilThreshold;
+}
+
+// Returns true if a frame has been published since this context last rendered.
+bool Graphics2D::frameChanged()
+{
+	bool changed;
+
+	_master2D->_refreshMutex.lock();
+
+	changed = _master2D->_publishedFrames != _renderedFrames;
+
+	_master2D->_refreshMutex.unlock();
+
+	return changed;
+}
+
+// returns true if two records of the same kind carry the same payload
+static bool samePayload(RenderCommandHeader* command1, RenderCommandHeader* command2)
+{
+	return command1->size == command2->size && memcmp(commandPointers(command1), commandPointers(command2), command1->size - COMMAND_HEADER_SIZE) == 0;
+}
+
+// returns true if a transform record leaves the transform unchanged
+static bool identityTransform(RenderCommandHeader* command)
+{
+	GLfloat* floats = commandFloats(command);
+
+	switch(command->command) {
+	case RENDER_TRANSFORM_ROTATE:
+		return floats[0] == 0.0f;
+	case RENDER_TRANSFORM_TRANSLATE:
+		return floats[0] == 0.0f && floats[1] == 0.0f;
+	case RENDER_TRANSFORM_SCALE:
+		return floats[0] == 1.0f && floats[1] == 1.0f;
+	default:
+		return false;
+	}
+}
+
+// Drops state commands that do not change the effective state and merges consecutive transforms, returning the number of commands removed.
+int Graphics2D::optimizeCommands(CommandBuffer* commands)
+{
+	CommandCursor cursor;
+	RenderCommandHeader* command;
+
+	// per state command kind - the record whose value is in effect, the value in effect at the last draw, and a record not yet used by any draw
+	RenderCommandHeader* effective[RENDER_XXX];
+	RenderCommandHeader* committed[RENDER_XXX];
+	RenderCommandHeader* pending[RENDER_XXX];
+
+	// setting a color also clears the gradient, so whether a gradient is in effect is tracked on its own (-1 unknown, 0 none, 1 set)
+	int gradientSet = -1;
+
+	// last transform followed by nothing but state changes
+	RenderCommandHeader* transform = NULL;
+
+	int removed = 0;
+
+	// nothing is known about the state left over from the previous frame
+	memset(effective, 0, sizeof(effective));
+	memset(committed, 0, sizeof(committed));
+	memset(pending, 0, sizeof(pending));
+
+	commands->begin(&cursor);
+	while((command = commands->next(&cursor)) != NULL) {
+		RenderCommand kind = command->command;
+
+		switch(kind) {
+		case RENDER_SKIP:
+			break;
+
+		case RENDER_SET_BACKGROUND:
+		case RENDER_SET_COLOR:
+		case RENDER_SET_FONT:
+		case RENDER_SET_GRADIENT:
+		case RENDER_SET_IMAGE_TEXTURE:
+		case RENDER_SET_STROKE:
+		{
+			bool redundant = effective[kind] && samePayload(effective[kind], command);
+
+			if (kind == RENDER_SET_COLOR) {
+				redundant = redundant && gradientSet == 0;
+			} else if (kind == RENDER_SET_GRADIENT) {
+				if (commandPointers(command)[0] == NULL) {
+					redundant = gradientSet == 0;
+				} else {
+					redundant = redundant && gradientSet == 1;
+				}
+			}
+
+			if (redundant) {
+				command->command = RENDER_SKIP;
+				removed++;
+				break;
+			}
+
+			// a value that was never drawn with is dead once it is overwritten
+			if (pending[kind]) {
+				pending[kind]->command = RENDER_SKIP;
+				removed++;
+
+				if (kind != RENDER_SET_COLOR && kind != RENDER_SET_GRADIENT && committed[kind] && samePayload(committed[kind], command)) {
+					command->command = RENDER_SKIP;
+					removed++;
+
+					effective[kind] = committed[kind];
+					pending[kind] = NULL;
+					break;
+				}
+			}
+
+			effective[kind] = command;
+			pending[kind] = command;
+
+			if (kind == RENDER_SET_COLOR) {
+				gradientSet = 0;
+			} else if (kind == RENDER_SET_GRADIENT) {
+				gradientSet = commandPointers(command)[0] != NULL ? 1 : 0;
+			}
+		}
+			break;
+
+		case RENDER_TRANSFORM_ROTATE:
+		case RENDER_TRANSFORM_TRANSLATE:
+		case RENDER_TRANSFORM_SCALE:
+			if (transform && transform->command == kind) {
+				GLfloat* floats = commandFloats(transform);
+				GLfloat* mergeFloats = commandFloats(command);
+
+				if (kind == RENDER_TRANSFORM_ROTATE) {
+					floats[0] += mergeFloats[0];
+				} else if (kind == RENDER_TRANSFORM_TRANSLATE) {
+					floats[0] += mergeFloats[0];
+					floats[1] += mergeFloats[1];
+				} else {
+					floats[0] *= mergeFloats[0];
+					floats[1] *= mergeFloats[1];
+				}
+
+				command->command = RENDER_SKIP;
+				removed++;
+
+				command = transform;
+			}
+
+			if (identityTransform(command)) {
+				command->command = RENDER_SKIP;
+				removed++;
+
+				transform = NULL;
+			} else {
+				transform = command;
+			}
+			break;
+
+		case RENDER_TRANSFORM:
+		case RENDER_TRANSFORM_SHEAR:
+			transform = NULL;
+			break;
+
+		default:
+			// anything else draws with the state in effect
+			for(int index = 0; index < RENDER_XXX; index++) {
+				if (pending[index]) {
+					committed[index] = pending[index];
+					pending[index] = NULL;
+				}
+			}
+
+			transform = NULL;
+
+			// a restore brings back a state that is not tracked here
+			if (kind == RENDER_RESTORE_STATE) {
+				memset(effective, 0, sizeof(effective));
+				memset(committed, 0, sizeof(committed));
+				gradientSet = -1;
+			}
+			break;
+		}
+	}
+
+	return removed;
+}
+
+// shader programs draws are grouped by when reordering
+typedef enum DrawProgram {
+	DRAW_PROGRAM_NONE = 0,
+	DRAW_PROGRAM_COLOR,
+	DRAW_PROGRAM_GRADIENT,
+	DRAW_PROGRAM_TEXTURE,
+	DRAW_PROGRAM_TEXT,
+	DRAW_PROGRAM_TEXT_GRADIENT
+} DrawProgram;
+
+// parts of the drawing state a draw may depend on
+#define DRAW_STATE_COLOR			0x01
+#define DRAW_STATE_FONT				0x02
+#define DRAW_STATE_IMAGE_TEXTURE	0x04
+#define DRAW_STATE_STROKE			0x08
+#define DRAW_STATE_BACKGROUND		0x10
+#define DRAW_STATE_ALL				0x1f
+
+// how many groups back a draw may move
+#define REORDER_WINDOW	32
+
+// returns the mask of the state parts recorded in a state
+static int knownState(const DrawState* state)
+{
+	int known = 0;
+
+	if (state->color || state->gradient) {
+		known |= DRAW_STATE_COLOR;
+	}
+	if (state->font) {
+		known |= DRAW_STATE_FONT;
+	}
+	if (state->imageTexture) {
+		known |= DRAW_STATE_IMAGE_TEXTURE;
+	}
+	if (state->stroke) {
+		known |= DRAW_STATE_STROKE;
+	}
+	if (state->background) {
+		known |= DRAW_STATE_BACKGROUND;
+	}
+
+	return known;
+}
+
+// tracks a state command in a state
+static void updateDrawState(DrawState* state, RenderCommandHeader* command)
+{
+	switch(command->command) {
+	case RENDER_SET_BACKGROUND:
+		state->background = command;
+		break;
+	case RENDER_SET_COLOR:
+		state->color = command;
+		state->gradient = NULL;
+		break;
+	case RENDER_SET_FONT:
+		state->font = command;
+		break;
+	case RENDER_SET_GRADIENT:
+		state->gradient = command;
+		break;
+	case RENDER_SET_IMAGE_TEXTURE:
+		state->imageTexture = command;
+		break;
+	case RENDER_SET_STROKE:
+		state->stroke = command;
+		break;
+	default:
+		break;
+	}
+}
+
+// appends copies of the state records needed to bring the emitted state to the given one
+static void emitDrawState(CommandBuffer* commands, DrawState* emitted, const DrawState* state)
+{
+	if (state->color && (state->color != emitted->color || (state->gradient == NULL && emitted->gradient != NULL))) {
+		commands->appendCopy(state->color);
+		emitted->color = state->color;
+		emitted->gradient = NULL;
+	}
+	if (state->gradient && state->gradient != emitted->gradient) {
+		commands->appendCopy(state->gradient);
+		emitted->gradient = state->gradient;
+	}
+	if (state->font && state->font != emitted->font) {
+		commands->appendCopy(state->font);
+		emitted->font = state->font;
+	}
+	if (state->imageTexture && state->imageTexture != emitted->imageTexture) {
+		commands->appendCopy(state->imageTexture);
+		emitted->imageTexture = state->imageTexture;
+	}
+	if (state->stroke && state->stroke != emitted->stroke) {
+		commands->appendCopy(state->stroke);
+		emitted->stroke = state->stroke;
+	}
+	if (state->background && state->background != emitted->background) {
+		commands->appendCopy(state->background);
+		emitted->background = state->background;
+	}
+}
+
+// grows a bounding box to take in a point
+static void includePoint(GLfloat* bounds, GLfloat x, GLfloat y)
+{
+	if (x < bounds[0]) {
+		bounds[0] = x;
+	}
+	if (y < bounds[1]) {
+		bounds[1] = y;
+	}
+	if (x > bounds[2]) {
+		bounds[2] = x;
+	}
+	if (y > bounds[3]) {
+		bounds[3] = y;
+	}
+}
+
+// works out the area a draw command covers in its own coordinate system, returning false if it cannot be known
+static bool commandBounds(RenderCommandHeader* command, Stroke* stroke, Font* font, GLfloat* bounds)
+{
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
+	GLfloat margin = 0.0;
+
+	bounds[0] = 1.0e30;
+	bounds[1] = 1.0e30;
+	bounds[2] = -1.0e30;
+	bounds[3] = -1.0e30;
+
+	switch(command->command) {
+	case RENDER_DRAW_LINE:
+	case RENDER_DRAW_POLYLINE:
+	case RENDER_DRAW_ARC:
+	case RENDER_DRAW_ROUNDRECT:
+	case RENDER_DRAW_PATH:
+		if (stroke == NULL) {
+			return false;
+		}
+
+		// miter joins may stick out past half the width, and square caps reach as far again along a diagonal
+		margin = stroke->width / 2.0;
+		if (stroke->join == JOIN_MITER) {
+			margin *= stroke->miterLimit >= 1.0 ? stroke->miterLimit : 10.0;
+		} else if (stroke->cap == CAP_SQUARE) {
+			margin *= M_SQRT2;
+		}
+		break;
+	default:
+		break;
+	}
+
+	switch(command->command) {
+	case RENDER_DRAW_LINE:
+		includePoint(bounds, floats[0], floats[1]);
+		includePoint(bounds, floats[2], floats[3]);
+		break;
+	case RENDER_DRAW_POLYLINE:
+	case RENDER_FILL_POLYGON:
+		for(int index = 0; index < ints[0]; index++) {
+			includePoint(bounds, floats[index*2+0], floats[index*2+1]);
+		}
+		break;
+	case RENDER_DRAW_ARC:
+	case RENDER_FILL_ARC:
+		// arcs are traced at width and height away from x and y
+		includePoint(bounds, floats[0] - fabs(floats[2]), floats[1] - fabs(floats[3]));
+		includePoint(bounds, floats[0] + fabs(floats[2]), floats[1] + fabs(floats[3]));
+		break;
+	case RENDER_DRAW_ROUNDRECT:
+	case RENDER_FILL_ROUNDRECT:
+		includePoint(bounds, floats[0], floats[1]);
+		includePoint(bounds, floats[0] + floats[2], floats[1] + floats[3]);
+		break;
+	case RENDER_DRAW_PATH:
+	case RENDER_FILL_PATH:
+		if (!((Path2D*)commandPointers(command)[0])->bounds(bounds)) {
+			return false;
+		}
+		break;
+	case RENDER_DRAW_MESH:
+		// the stroke width is already part of the tessellated outline
+		for(int index = 0; index < ints[0]; index++) {
+			includePoint(bounds, floats[index*2+0], floats[index*2+1]);
+		}
+		break;
+	case RENDER_FILL_STENCIL:
+		// nothing is drawn outside the covering quad
+		for(int index = 0; index < 4; index++) {
+			includePoint(bounds, floats[ints[2]*2+index*2+0], floats[ints[2]*2+index*2+1]);
+		}
+		break;
+	case RENDER_DRAW_INSTANCES:
+	{
+		// each copy covers the box of the mesh, scaled and moved with it
+		GLfloat mesh[4] = { 1.0e30, 1.0e30, -1.0e30, -1.0e30 };
+		GLfloat* instances = floats + ints[0] * 2;
+
+		for(int index = 0; index < ints[0]; index++) {
+			includePoint(mesh, floats[index*2+0], floats[index*2+1]);
+		}
+
+		for(int index = 0; index < ints[1]; index++) {
+			GLfloat* values = instances + index * INSTANCE_FLOATS;
+
+			includePoint(bounds, values[0] + values[2] * mesh[0], values[1] + values[2] * mesh[1]);
+			includePoint(bounds, values[0] + values[2] * mesh[2], values[1] + values[2] * mesh[3]);
+		}
+	}
+		break;
+	case RENDER_DRAW_IMAGE:
+		for(int index = 0; index < 4; index++) {
+			includePoint(bounds, floats[8+index*2+0], floats[8+index*2+1]);
+		}
+		break;
+	case RENDER_DRAW_STRING:
+	{
+		if (font == NULL || !font->initialized) {
+			return false;
+		}
+
+		int textLength = ints[0];
+		int* characters = ints + 1;
+		int previousCharMapIndex = 0;
+		GLfloat penX = 0.0;
+
+		includePoint(bounds, floats[0], floats[1]);
+
+		for(int index = 0; index < textLength; index++) {
+			int charMapIndex = 0;
+			for(int charIndex = 0; charIndex < font->numberCharacters; charIndex++) {
+				if (font->charMap[charIndex] == characters[index]) {
+					charMapIndex = charIndex;
+					break;
+				}
+			}
+
+			if (index > 0) {
+				penX += font->kerning[previousCharMapIndex * font->numberCharacters + charMapIndex];
+			}
+
+			GLfloat charX = floats[0] + penX + font->offsetX[charMapIndex];
+			GLfloat charY = floats[1] + font->offsetY[charMapIndex];
+
+			includePoint(bounds, charX, charY);
+			includePoint(bounds, charX + font->width[charMapIndex], charY + font->height[charMapIndex]);
+
+			penX += font->advance[charMapIndex];
+			previousCharMapIndex = charMapIndex;
+		}
+	}
+		break;
+	default:
+		return false;
+	}
+
+	bounds[0] -= margin;
+	bounds[1] -= margin;
+	bounds[2] += margin;
+	bounds[3] += margin;
+
+	return true;
+}
+
+// returns true if two bounding boxes overlap
+static bool boundsOverlap(const GLfloat* bounds1, const GLfloat* bounds2)
+{
+	return bounds1[0] <= bounds2[2] && bounds2[0] <= bounds1[2] && bounds1[1] <= bounds2[3] && bounds2[1] <= bounds1[3];
+}
+
+// appends the grouped draws of one run between barriers, returning the number of program switches in the new order
+static int emitDrawGroups(CommandBuffer* reordered, DrawState* emitted, QVector<ReorderDraw>& draws, QVector<ReorderGroup>& groups, int* program)
+{
+	int switches = 0;
+
+	for(int groupIndex = 0; groupIndex < groups.size(); groupIndex++) {
+		for(int drawIndex = groups[groupIndex].first; drawIndex >= 0; drawIndex = draws[drawIndex].next) {
+			ReorderDraw* draw = &draws[drawIndex];
+
+			if (*program != DRAW_PROGRAM_NONE && draw->program != *program) {
+				switches++;
+			}
+			*program = draw->program;
+
+			emitDrawState(reordered, emitted, &draw->state);
+			reordered->appendCopy(draw->command);
+		}
+	}
+
+	// keep the reserved memory for the next run
+	draws.resize(0);
+	groups.resize(0);
+
+	return switches;
+}
+
+// Regroups non-overlapping draws by program and texture while keeping the order of overlapping ones, returning the number of program switches saved.
+int Graphics2D::reorderCommands(CommandBuffer* commands, CommandBuffer* reordered)
+{
+	CommandCursor cursor;
+	RenderCommandHeader* command;
+
+	// state in effect in the original list and in the list being written
+	DrawState state;
+	DrawState emitted;
+
+	// draws since the last barrier, grouped by program and texture - kept from frame to frame so that their storage is reused
+	QVector<ReorderDraw>& draws = _reorderDraws;
+	QVector<ReorderGroup>& groups = _reorderGroups;
+
+	int originalProgram = DRAW_PROGRAM_NONE;
+	int reorderedProgram = DRAW_PROGRAM_NONE;
+	int originalSwitches = 0;
+	int reorderedSwitches = 0;
+
+	memset(&state, 0, sizeof(state));
+	memset(&emitted, 0, sizeof(emitted));
+
+	draws.resize(0);
+	groups.resize(0);
+
+	reordered->reset();
+
+	commands->begin(&cursor);
+	while((command = commands->next(&cursor)) != NULL) {
+		switch(command->command) {
+		case RENDER_SKIP:
+			break;
+
+		case RENDER_SET_BACKGROUND:
+		case RENDER_SET_COLOR:
+		case RENDER_SET_FONT:
+		case RENDER_SET_GRADIENT:
+		case RENDER_SET_IMAGE_TEXTURE:
+		case RENDER_SET_STROKE:
+			// state is written out with the draws that use it
+			updateDrawState(&state, command);
+			break;
+
+		case RENDER_DRAW_ARC:
+		case RENDER_FILL_ARC:
+		case RENDER_DRAW_IMAGE:
+		case RENDER_DRAW_LINE:
+		case RENDER_DRAW_POLYLINE:
+		case RENDER_DRAW_ROUNDRECT:
+		case RENDER_FILL_ROUNDRECT:
+		case RENDER_DRAW_STRING:
+		case RENDER_FILL_POLYGON:
+		case RENDER_DRAW_PATH:
+		case RENDER_FILL_PATH:
+		case RENDER_DRAW_MESH:
+		{
+			ReorderDraw draw;
+			Stroke* stroke = state.stroke ? (Stroke*)commandPointers(state.stroke)[0] : NULL;
+			Font* font = state.font ? (Font*)commandPointers(state.font)[0] : NULL;
+			bool gradient = state.gradient && commandPointers(state.gradient)[0] != NULL;
+
+			draw.command = command;
+			draw.state = state;
+			draw.known = knownState(&state);
+			draw.texture = 0;
+			draw.next = -1;
+
+			if (command->command == RENDER_DRAW_IMAGE) {
+				draw.program = DRAW_PROGRAM_TEXTURE;
+				draw.texture = commandInts(command)[0];
+			} else if (command->command == RENDER_DRAW_STRING) {
+				draw.program = gradient ? DRAW_PROGRAM_TEXT_GRADIENT : DRAW_PROGRAM_TEXT;
+				draw.texture = font ? font->fontTexture : 0;
+			} else {
+				draw.program = gradient ? DRAW_PROGRAM_GRADIENT : DRAW_PROGRAM_COLOR;
+			}
+
+			draw.bounded = commandBounds(command, stroke, font, draw.bounds);
+
+			if (originalProgram != DRAW_PROGRAM_NONE && draw.program != originalProgram) {
+				originalSwitches++;
+			}
+			originalProgram = draw.program;
+
+			// move back to the latest group with the same program and texture, unless something in between is overlapped
+			// or was drawn with state recorded only later
+			int target = -1;
+			for(int groupIndex = groups.size() - 1; groupIndex >= 0 && groupIndex >= groups.size() - REORDER_WINDOW; groupIndex--) {
+				ReorderGroup* group = &groups[groupIndex];
+
+				if (group->program == draw.program && group->texture == draw.texture) {
+					target = groupIndex;
+					break;
+				}
+
+				if (!group->bounded || !draw.bounded || boundsOverlap(group->bounds, draw.bounds) || (group->unknown & draw.known) != 0) {
+					break;
+				}
+			}
+
+			int drawIndex = draws.size();
+			draws.append(draw);
+
+			if (target < 0) {
+				ReorderGroup group;
+
+				group.program = draw.program;
+				group.texture = draw.texture;
+				group.bounded = draw.bounded;
+				memcpy(group.bounds, draw.bounds, sizeof(group.bounds));
+				group.unknown = DRAW_STATE_ALL & ~draw.known;
+				group.first = drawIndex;
+				group.last = drawIndex;
+
+				groups.append(group);
+			} else {
+				ReorderGroup* group = &groups[target];
+
+				group->bounded = group->bounded && draw.bounded;
+				if (draw.bounded) {
+					includePoint(group->bounds, draw.bounds[0], draw.bounds[1]);
+					includePoint(group->bounds, draw.bounds[2], draw.bounds[3]);
+				}
+				group->unknown |= DRAW_STATE_ALL & ~draw.known;
+
+				draws[group->last].next = drawIndex;
+				group->last = drawIndex;
+			}
+		}
+			break;
+
+		default:
+			// clears, clips, transforms and saved states are barriers - everything before them is written out first
+			reorderedSwitches += emitDrawGroups(reordered, &emitted, draws, groups, &reorderedProgram);
+
+			emitDrawState(reordered, &emitted, &state);
+			reordered->appendCopy(command);
+			break;
+		}
+	}
+
+	reorderedSwitches += emitDrawGroups(reordered, &emitted, draws, groups, &reorderedProgram);
+
+	// leave the state as the original list does for whatever is drawn next
+	emitDrawState(reordered, &emitted, &state);
+
+	return originalSwitches - reorderedSwitches;
+}
+
+// how many draws of the previous frame may be passed over looking for a match
+#define DAMAGE_MATCH_WINDOW	64
+
+// hashes what a stroke draws with, the dash lengths rather than where they are kept
+static unsigned int hashStroke(unsigned int hash, const Stroke* stroke)
+{
+	hash = hashData(hash, &stroke->width, sizeof(GLfloat));
+	hash = hashData(hash, &stroke->cap, sizeof(int));
+	hash = hashData(hash, &stroke->join, sizeof(int));
+	hash = hashData(hash, &stroke->miterLimit, sizeof(GLfloat));
+	hash = hashData(hash, &stroke->dashPhase, sizeof(GLfloat));
+	hash = hashData(hash, &stroke->dashCount, sizeof(int));
+	if (stroke->dashCount > 0) {
+		hash = hashData(hash, stroke->dash, sizeof(GLfloat) * stroke->dashCount);
+	}
+
+	return hash;
+}
+
+// hashes the kind and payload of a command, leaving out the alignment padding
+static unsigned int hashCommand(unsigned int hash, const RenderCommandHeader* command)
+{
+	if (command == NULL) {
+		int none = RENDER_XXX;
+		return hashData(hash, &none, sizeof(none));
+	}
+
+	unsigned char* payload = (unsigned char*)commandPointers(command);
+	unsigned char* payloadEnd = (unsigned char*)(commandInts(command) + command->intCount);
+
+	hash = hashData(hash, &command->command, sizeof(command->command));
+	hash = hashData(hash, payload, payloadEnd - payload);
+
+	// a path is drawn as it is when the frame is done, so it counts as changed whenever it has been
+	if (command->command == RENDER_DRAW_PATH || command->command == RENDER_FILL_PATH) {
+		int version = ((Path2D*)commandPointers(command)[0])->version();
+		hash = hashData(hash, &version, sizeof(version));
+	}
+
+	// strokes, gradients and image textures are public and can be changed in place between frames, so what they hold counts along with the pointer
+	void* resource = command->pointerCount > 0 ? commandPointers(command)[0] : NULL;
+
+	if (resource != NULL) {
+		switch(command->command) {
+		case RENDER_SET_STROKE:
+			hash = hashStroke(hash, (Stroke*)resource);
+			break;
+		case RENDER_SET_GRADIENT:
+			hash = hashData(hash, &((Gradient*)resource)->lookupHash, sizeof(unsigned int));
+			break;
+		case RENDER_SET_IMAGE_TEXTURE:
+			hash = hashData(hash, resource, sizeof(ImageTexture));
+			break;
+		default:
+			break;
+		}
+	}
+
+	return hash;
+}
+
+// multiplies 2D affine transforms held as a, b, c, d, e, f for x' = a x + c y + e and y' = b x + d y + f, applying second before first
+static void multiplyAffine(const GLfloat* first, const GLfloat* second, GLfloat* result)
+{
+	result[0] = first[0] * second[0] + first[2] * second[1];
+	result[1] = first[1] * second[0] + first[3] * second[1];
+	result[2] = first[0] * second[2] + first[2] * second[3];
+	result[3] = first[1] * second[2] + first[3] * second[3];
+	result[4] = first[0] * second[4] + first[2] * second[5] + first[4];
+	result[5] = first[1] * second[4] + first[3] * second[5] + first[5];
+}
+
+// concatenates a transform the way the render functions do - before the current one with GLES1 and after it with GLES2
+static void concatenateAffine(GLfloat* affine, const GLfloat* transform)
+{
+	GLfloat result[6];
+
+#ifdef GLES1
+	multiplyAffine(affine, transform, result);
+#elif defined(GLES2)
+	multiplyAffine(transform, affine, result);
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+
+	memcpy(affine, result, sizeof(result));
+}
+
+// grows a damage area by a draw, returning false if the draw could be anywhere
+static bool includeDamageDraw(GLfloat* damage, const DamageDraw* draw)
+{
+	if (!draw->bounded) {
+		return false;
+	}
+
+	includePoint(damage, draw->bounds[0], draw->bounds[1]);
+	includePoint(damage, draw->bounds[2], draw->bounds[3]);
+
+	return true;
+}
+
+// Works out the window area where a completed frame differs from the previous one, returning false if it has to be redrawn in full.
+bool Graphics2D::damageCommands(CommandBuffer* commands, GLfloat* damage)
+{
+	CommandCursor cursor;
+	RenderCommandHeader* command;
+
+	DrawState state;
+	GLfloat affine[6] = { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+	bool affineKnown = true;
+	int clip[4] = { 0, 0, _width, _height };
+
+	// state, transform and clip brought back by a restore
+	DrawState savedStates[MAX_RENDER_STATES];
+	GLfloat savedAffines[MAX_RENDER_STATES][6];
+	bool savedAffineKnown[MAX_RENDER_STATES];
+	int saveCount = 0;
+
+	bool known = true;
+
+	memset(&state, 0, sizeof(state));
+
+	damage[0] = 1.0e30;
+	damage[1] = 1.0e30;
+	damage[2] = -1.0e30;
+	damage[3] = -1.0e30;
+
+	_frameDraws.resize(0);
+
+	commands->begin(&cursor);
+	while((command = commands->next(&cursor)) != NULL) {
+		GLfloat* floats = commandFloats(command);
+		int* ints = commandInts(command);
+		GLfloat transform[6] = { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+
+		switch(command->command) {
+		case RENDER_SKIP:
+			break;
+
+		case RENDER_SET_BACKGROUND:
+		case RENDER_SET_COLOR:
+		case RENDER_SET_FONT:
+		case RENDER_SET_GRADIENT:
+		case RENDER_SET_IMAGE_TEXTURE:
+		case RENDER_SET_STROKE:
+			updateDrawState(&state, command);
+			break;
+
+		case RENDER_TRANSFORM_ROTATE:
+			transform[0] = cosf(floats[0] * M_PI / 180.0);
+			transform[1] = sinf(floats[0] * M_PI / 180.0);
+			transform[2] = -transform[1];
+			transform[3] = transform[0];
+			concatenateAffine(affine, transform);
+			break;
+		case RENDER_TRANSFORM_TRANSLATE:
+			transform[4] = floats[0];
+			transform[5] = floats[1];
+			concatenateAffine(affine, transform);
+			break;
+		case RENDER_TRANSFORM_SCALE:
+			transform[0] = floats[0];
+			transform[3] = floats[1];
+			concatenateAffine(affine, transform);
+			break;
+
+		case RENDER_TRANSFORM:
+		case RENDER_TRANSFORM_SHEAR:
+			// these replace the model view matrix with GLES1, so what follows is not tracked
+			affineKnown = false;
+			break;
+
+		case RENDER_SAVE_STATE:
+			if (saveCount < MAX_RENDER_STATES) {
+				savedStates[saveCount] = state;
+				memcpy(savedAffines[saveCount], affine, sizeof(affine));
+				savedAffineKnown[saveCount] = affineKnown;
+			}
+			saveCount++;
+			break;
+
+		case RENDER_RESTORE_STATE:
+			if (saveCount == 0) {
+				break;
+			}
+			saveCount--;
+			if (saveCount < MAX_RENDER_STATES) {
+				state = savedStates[saveCount];
+				memcpy(affine, savedAffines[saveCount], sizeof(affine));
+				affineKnown = savedAffineKnown[saveCount];
+			}
+			break;
+
+		case RENDER_CLIP_RECT:
+		case RENDER_CLEAR_RECT:
+			// both set up the view for the rectangle, which also resets the model view matrix with GLES1
+			memcpy(clip, ints, sizeof(clip));
+#ifdef GLES1
+			memcpy(affine, transform, sizeof(affine));
+			affineKnown = true;
+#endif
+			if (command->command == RENDER_CLIP_RECT) {
+				break;
+			}
+			// fall through - a clear is drawn over the whole surface since glClear ignores the viewport
+
+		default:
+		{
+			DamageDraw draw;
+
+			draw.hash = hashCommand(2166136261u, command);
+			draw.hash = hashCommand(draw.hash, state.color);
+			draw.hash = hashCommand(draw.hash, state.gradient);
+			draw.hash = hashCommand(draw.hash, state.font);
+			draw.hash = hashCommand(draw.hash, state.imageTexture);
+			draw.hash = hashCommand(draw.hash, state.stroke);
+			draw.hash = hashCommand(draw.hash, state.background);
+			draw.hash = hashData(draw.hash, affine, sizeof(affine));
+			draw.hash = hashData(draw.hash, clip, sizeof(clip));
+
+			if (command->command == RENDER_CLEAR_RECT) {
+				draw.bounded = true;
+				draw.bounds[0] = 0.0;
+				draw.bounds[1] = 0.0;
+				draw.bounds[2] = _width;
+				draw.bounds[3] = _height;
+			} else {
+				GLfloat bounds[4];
+				Stroke* stroke = state.stroke ? (Stroke*)commandPointers(state.stroke)[0] : NULL;
+				Font* font = state.font ? (Font*)commandPointers(state.font)[0] : NULL;
+
+				draw.bounded = affineKnown && commandBounds(command, stroke, font, bounds);
+
+				if (draw.bounded) {
+					GLfloat corners[8] = { bounds[0], bounds[1], bounds[2], bounds[1], bounds[0], bounds[3], bounds[2], bounds[3] };
+
+					draw.bounds[0] = 1.0e30;
+					draw.bounds[1] = 1.0e30;
+					draw.bounds[2] = -1.0e30;
+					draw.bounds[3] = -1.0e30;
+
+					transformPoints(affine, corners, 4, corners);
+
+					for(int index = 0; index < 4; index++) {
+						includePoint(draw.bounds, corners[index*2+0], corners[index*2+1]);
+					}
+
+					// nothing is drawn outside the viewport
+					draw.bounds[0] = qMax(draw.bounds[0], (GLfloat)clip[0]);
+					draw.bounds[1] = qMax(draw.bounds[1], (GLfloat)clip[1]);
+					draw.bounds[2] = qMin(draw.bounds[2], (GLfloat)(clip[0] + clip[2]));
+					draw.bounds[3] = qMin(draw.bounds[3], (GLfloat)(clip[1] + clip[3]));
+
+					if (draw.bounds[0] > draw.bounds[2] || draw.bounds[1] > draw.bounds[3]) {
+						break;
+					}
+				}
+			}
+
+			_frameDraws.append(draw);
+		}
+			break;
+		}
+	}
+
+	// match the draws in order against the previous frame - unmatched draws on either side are what changed, and since
+	// the matched ones keep their order every pixel outside the damage is drawn by the same draws as before
+	int previous = 0;
+
+	for(int drawIndex = 0; drawIndex < _frameDraws.size(); drawIndex++) {
+		DamageDraw* draw = &_frameDraws[drawIndex];
+		int match = -1;
+
+		for(int index = previous; index < _damageDraws.size() && index < previous + DAMAGE_MATCH_WINDOW; index++) {
+			DamageDraw* candidate = &_damageDraws[index];
+
+			if (candidate->hash == draw->hash && candidate->bounded == draw->bounded && memcmp(candidate->bounds, draw->bounds, sizeof(draw->bounds)) == 0) {
+				match = index;
+				break;
+			}
+		}
+
+		if (match < 0) {
+			known = includeDamageDraw(damage, draw) && known;
+		} else {
+			for(int index = previous; index < match; index++) {
+				known = includeDamageDraw(damage, &_damageDraws[index]) && known;
+			}
+			previous = match + 1;
+		}
+	}
+
+	for(int index = previous; index < _damageDraws.size(); index++) {
+		known = includeDamageDraw(damage, &_damageDraws[index]) && known;
+	}
+
+	// keep this frame to compare the next one against, reusing the old storage
+	_damageDraws.swap(_frameDraws);
+
+	return known;
+}
+
+// Hashes every command of a list along with its payload.
+unsigned int Graphics2D::hashCommands(CommandBuffer* commands)
+{
+	CommandCursor cursor;
+	RenderCommandHeader* command;
+
+	unsigned int hash = 2166136261u;
+
+	commands->begin(&cursor);
+	while((command = commands->next(&cursor)) != NULL) {
+		if (command->command != RENDER_SKIP) {
+			hash = hashCommand(hash, command);
+		}
+	}
+
+	return hash;
+}
+
+// Adds an area to the damage waiting for the next render.
+void Graphics2D::includeDamage(const GLfloat* damage)
+{
+	if (damage[0] > damage[2] || damage[1] > damage[3]) {
+		return;
+	}
+
+	includePoint(_pendingDamage, damage[0], damage[1]);
+	includePoint(_pendingDamage, damage[2], damage[3]);
+}
+
+// Writes the commands of the next completed frame to a command stream file.
+void Graphics2D::captureFrame(const QString& fileName)
+{
+	_master2D->_drawMutex.lock();
+
+	_master2D->_captureFileName = fileName;
+
+	_master2D->_drawMutex.unlock();
+}
+
+// Writes the commands captured in a display list to a command stream file.
+int Graphics2D::saveDisplayList(DisplayList* displayList, const QString& fileName)
+{
+	return writeCommandStream(displayList->commands(), fileName);
+}
+
+// Computes the content hash identifying an image in a command stream file.
+void Graphics2D::hashImage(ImageData* image, unsigned char* hash)
+{
+	QCryptographicHash md5(QCryptographicHash::Md5);
+
+	int width = image->width();
+	int height = image->height();
+
+	md5.addData((const char*)&width, sizeof(width));
+	md5.addData((const char*)&height, sizeof(height));
+	md5.addData((const char*)image->constPixels(), image->bytesPerLine() * height);
+
+	memcpy(hash, md5.result().constData(), 16);
+}
+
+// Computes the content hash identifying a font in a command stream file.
+void Graphics2D::hashFont(Font* font, unsigned char* hash)
+{
+	QCryptographicHash md5(QCryptographicHash::Md5);
+	unsigned char imageHash[16];
+
+	// the glyph atlas plus the size and character set it was rendered for
+	hashImage(font->image, imageHash);
+
+	md5.addData((const char*)imageHash, sizeof(imageHash));
+	md5.addData((const char*)&font->pt, sizeof(font->pt));
+	md5.addData((const char*)&font->numberCharacters, sizeof(font->numberCharacters));
+	md5.addData((const char*)font->charMap, sizeof(int) * font->numberCharacters);
+
+	memcpy(hash, md5.result().constData(), 16);
+}
+
+// numbers a resource referenced by a command stream, returning its 1-based index
+static int streamResourceIndex(QList<void*>& resources, QList<int>& resourceTypes, int type, void* resource)
+{
+	if (resource == NULL) {
+		return 0;
+	}
+
+	int index = resources.indexOf(resource);
+	if (index < 0) {
+		resources.append(resource);
+		resourceTypes.append(type);
+		index = resources.size() - 1;
+	}
+
+	return index + 1;
+}
+
+// Writes a list of commands to a command stream file.
+int Graphics2D::writeCommandStream(CommandBuffer* commands, const QString& fileName)
+{
+	CommandCursor cursor;
+	RenderCommandHeader* command;
+	QList<void*> resources;
+	QList<int> resourceTypes;
+	QByteArray resourceBytes;
+	QByteArray commandBytes;
+	int commandCount = 0;
+
+	//qDebug()  << "Graphics2D::writeCommandStream: " << fileName << " : " << commands->count();
+
+	// copy the records, replacing pointers and texture names by resource indices
+	commands->begin(&cursor);
+	while((command = commands->next(&cursor)) != NULL) {
+		int offset = commandBytes.size();
+		commandBytes.append((const char*)command, command->size);
+
+		RenderCommandHeader* copy = (RenderCommandHeader*)(commandBytes.data() + offset);
+		void** pointers = commandPointers(copy);
+		int* ints = commandInts(copy);
+		int index = 0;
+
+		switch(copy->command) {
+		case RENDER_SET_FONT:
+			index = streamResourceIndex(resources, resourceTypes, RESOURCE_FONT, pointers[0]);
+			break;
+		case RENDER_SET_STROKE:
+			index = streamResourceIndex(resources, resourceTypes, RESOURCE_STROKE, pointers[0]);
+			break;
+		case RENDER_SET_GRADIENT:
+			index = streamResourceIndex(resources, resourceTypes, RESOURCE_GRADIENT, pointers[0]);
+			break;
+		case RENDER_SET_IMAGE_TEXTURE:
+			if (pointers[0]) {
+				streamResourceIndex(resources, resourceTypes, RESOURCE_IMAGE, ((ImageTexture*)pointers[0])->image);
+			}
+			index = streamResourceIndex(resources, resourceTypes, RESOURCE_IMAGE_TEXTURE, pointers[0]);
+			break;
+		case RENDER_DRAW_IMAGE:
+			ints[0] = streamResourceIndex(resources, resourceTypes, RESOURCE_IMAGE, _glTextureIDImageMap.key(ints[0]));
+			break;
+		case RENDER_DRAW_PATH:
+		case RENDER_FILL_PATH:
+			// paths live in the application rather than the stream, so they are left out
+			qCritical() << "Graphics2D::writeCommandStream: leaving out a path in " << fileName << "\n";
+			commandBytes.resize(offset);
+			continue;
+		case RENDER_SKIP:
+			// commands dropped by optimizeCommands are not worth keeping
+			commandBytes.resize(offset);
+			continue;
+		case RENDER_DRAW_MESH:
+		case RENDER_FILL_STENCIL:
+			// tessellated geometry is not loaded back, only what it was tessellated from
+			qCritical() << "Graphics2D::writeCommandStream: leaving out a mesh in " << fileName << "\n";
+			commandBytes.resize(offset);
+			continue;
+		default:
+			break;
+		}
+
+		if (copy->pointerCount > 0) {
+			pointers[0] = (void*)(intptr_t)index;
+		}
+
+		commandCount++;
+	}
+
+	// resource table
+	for(int index = 0; index < resources.size(); index++) {
+		int offset = resourceBytes.size();
+		CommandResourceHeader resourceHeader;
+
+		memset(&resourceHeader, 0, sizeof(resourceHeader));
+		resourceHeader.type = resourceTypes.at(index);
+
+		resourceBytes.append((const char*)&resourceHeader, sizeof(resourceHeader));
+
+		switch(resourceHeader.type) {
+		case RESOURCE_FONT:
+			hashFont((Font*)resources.at(index), resourceHeader.hash);
+			break;
+		case RESOURCE_IMAGE:
+			hashImage((ImageData*)resources.at(index), resourceHeader.hash);
+			break;
+		case RESOURCE_STROKE:
+		{
+			Stroke* stroke = (Stroke*)resources.at(index);
+			StreamStroke streamStroke;
+
+			streamStroke.width = stroke->width;
+			streamStroke.cap = stroke->cap;
+			streamStroke.join = stroke->join;
+			streamStroke.miterLimit = stroke->miterLimit;
+			streamStroke.dashCount = stroke->dash ? stroke->dashCount : 0;
+			streamStroke.dashPhase = stroke->dashPhase;
+
+			resourceBytes.append((const char*)&streamStroke, sizeof(streamStroke));
+			resourceBytes.append((const char*)stroke->dash, sizeof(GLfloat) * streamStroke.dashCount);
+		}
+			break;
+		case RESOURCE_GRADIENT:
+		{
+			Gradient* gradient = (Gradient*)resources.at(index);
+			StreamGradient streamGradient;
+
+			streamGradient.segments = gradient->segments;
+			streamGradient.radius = gradient->radius;
+			streamGradient.angle = gradient->angle;
+			streamGradient.originU = gradient->originU;
+			streamGradient.originV = gradient->originV;
+
+			resourceBytes.append((const char*)&streamGradient, sizeof(streamGradient));
+			resourceBytes.append((const char*)gradient->colors, sizeof(GLColor) * (gradient->segments + 1));
+			resourceBytes.append((const char*)gradient->percentages, sizeof(GLfloat) * (gradient->segments * 2 + 1));
+		}
+			break;
+		case RESOURCE_IMAGE_TEXTURE:
+		{
+			ImageTexture* imageTexture = (ImageTexture*)resources.at(index);
+			StreamImageTexture streamImageTexture;
+
+			streamImageTexture.image = resources.indexOf(imageTexture->image) + 1;
+			streamImageTexture.scaling = imageTexture->scaling;
+			streamImageTexture.tiling = imageTexture->tiling;
+			streamImageTexture.uScale = imageTexture->uScale;
+			streamImageTexture.vScale = imageTexture->vScale;
+			streamImageTexture.leftMargin = imageTexture->leftMargin;
+			streamImageTexture.rightMargin = imageTexture->rightMargin;
+			streamImageTexture.topMargin = imageTexture->topMargin;
+			streamImageTexture.bottomMargin = imageTexture->bottomMargin;
+
+			resourceBytes.append((const char*)&streamImageTexture, sizeof(streamImageTexture));
+		}
+			break;
+		default:
+			break;
+		}
+
+		// pad the entry and fill in the final header
+		int size = COMMAND_RECORD_ALIGN(resourceBytes.size() - offset);
+		resourceBytes.resize(offset + size);
+		resourceHeader.size = size;
+		memcpy(resourceBytes.data() + offset, &resourceHeader, sizeof(resourceHeader));
+	}
+
+	CommandStreamHeader header;
+	header.magic = COMMAND_STREAM_MAGIC;
+	header.version = COMMAND_STREAM_VERSION;
+	header.pointerSize = sizeof(void*);
+	header.resourceCount = resources.size();
+	header.resourceOffset = COMMAND_RECORD_ALIGN(sizeof(header));
+	header.resourceBytes = resourceBytes.size();
+	header.commandCount = commandCount;
+	header.commandOffset = header.resourceOffset + header.resourceBytes;
+	header.commandBytes = commandBytes.size();
+
+	QByteArray headerBytes((const char*)&header, sizeof(header));
+	headerBytes.resize(header.resourceOffset);
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qCritical() << "Graphics2D::writeCommandStream: unable to open " << fileName << "\n";
+		return EXIT_FAILURE;
+	}
+
+	int returnCode = EXIT_SUCCESS;
+	if (file.write(headerBytes.constData(), headerBytes.size()) != headerBytes.size()
+			|| file.write(resourceBytes.constData(), resourceBytes.size()) != resourceBytes.size()
+			|| file.write(commandBytes.constData(), commandBytes.size()) != commandBytes.size()) {
+		qCritical() << "Graphics2D::writeCommandStream: unable to write " << fileName << "\n";
+		returnCode = EXIT_FAILURE;
+	}
+
+	file.close();
+
+	return returnCode;
+}
+
+// returns true if a loaded record is a known command whose pointers, floats and ints all fit inside it
+static bool commandFits(const RenderCommandHeader* command)
+{
+	if ((int)command->command < RENDER_SKIP || (int)command->command >= RENDER_XXX
+			|| command->pointerCount < 0 || command->floatCount < 0 || command->intCount < 0) {
+		return false;
+	}
+
+	// divided rather than multiplied out so that a corrupt count cannot overflow
+	size_t payloadBytes = command->size - COMMAND_HEADER_SIZE;
+
+	if ((size_t)command->pointerCount > payloadBytes / sizeof(void*)) {
+		return false;
+	}
+	payloadBytes -= command->pointerCount * sizeof(void*);
+
+	if ((size_t)command->floatCount > payloadBytes / sizeof(GLfloat)) {
+		return false;
+	}
+	payloadBytes -= command->floatCount * sizeof(GLfloat);
+
+	if ((size_t)command->intCount > payloadBytes / sizeof(int)) {
+		return false;
+	}
+
+	return true;
+}
+
+// returns true if a loaded record carries everything its kind is read with, and the counts in its ints stay within its floats and ints
+static bool commandLoadable(const RenderCommandHeader* command)
+{
+	const int* ints = commandInts((RenderCommandHeader*)command);
+	int pointerCount = 0, floatCount = 0, intCount = 0;
+
+	switch(command->command) {
+	case RENDER_CLEAR_RECT:
+	case RENDER_CLIP_RECT:
+		intCount = 4;
+		break;
+	case RENDER_DRAW_ARC:
+	case RENDER_FILL_ARC:
+	case RENDER_DRAW_ROUNDRECT:
+	case RENDER_FILL_ROUNDRECT:
+		floatCount = 6;
+		break;
+	case RENDER_DRAW_IMAGE:
+		// the texture name is patched from the first int
+		floatCount = 16;
+		intCount = 1;
+		break;
+	case RENDER_DRAW_LINE:
+	case RENDER_SET_BACKGROUND:
+	case RENDER_SET_COLOR:
+		floatCount = 4;
+		break;
+	case RENDER_DRAW_POLYLINE:
+		// a point count followed by the (x,y) of each point
+		return command->intCount >= 1 && ints[0] >= 0 && ints[0] <= command->floatCount / 2;
+	case RENDER_FILL_POLYGON:
+		// a point count followed by the (x,y) of each point, then the (u,v) of each
+		return command->intCount >= 1 && ints[0] >= 0 && ints[0] <= command->floatCount / 4;
+	case RENDER_DRAW_STRING:
+		// the (x,y) of the text, and a character count followed by the characters
+		return command->floatCount >= 2 && command->intCount >= 1 && ints[0] >= 0 && ints[0] <= command->intCount - 1;
+	case RENDER_DRAW_INSTANCES:
+		// a mesh vertex and copy count, as drawInstances records them, then the (x,y) of each vertex followed by each copy
+		return command->intCount >= 2 && ints[0] >= 3 && ints[1] >= 1 && ints[0] <= command->floatCount / 2
+				&& ints[1] <= (command->floatCount - ints[0] * 2) / INSTANCE_FLOATS;
+	case RENDER_SET_FONT:
+	case RENDER_SET_GRADIENT:
+	case RENDER_SET_IMAGE_TEXTURE:
+	case RENDER_SET_STROKE:
+		pointerCount = 1;
+		break;
+	case RENDER_TRANSFORM:
+		floatCount = 9;
+		break;
+	case RENDER_TRANSFORM_ROTATE:
+		floatCount = 1;
+		break;
+	case RENDER_TRANSFORM_TRANSLATE:
+	case RENDER_TRANSFORM_SCALE:
+	case RENDER_TRANSFORM_SHEAR:
+		floatCount = 2;
+		break;
+	case RENDER_SAVE_STATE:
+	case RENDER_RESTORE_STATE:
+		break;
+	default:
+		// paths are never written, and skipped records, meshes and stencil fills only exist once a frame is optimized or tessellated
+		return false;
+	}
+
+	return command->pointerCount >= pointerCount && command->floatCount >= floatCount && command->intCount >= intCount;
+}
+
+// returns the type of resource a command refers to through its pointer, 0 for a command without one
+static int commandResourceType(RenderCommand command)
+{
+	switch(command) {
+	case RENDER_SET_FONT:
+		return RESOURCE_FONT;
+	case RENDER_SET_GRADIENT:
+		return RESOURCE_GRADIENT;
+	case RENDER_SET_IMAGE_TEXTURE:
+		return RESOURCE_IMAGE_TEXTURE;
+	case RENDER_SET_STROKE:
+		return RESOURCE_STROKE;
+	default:
+		return 0;
+	}
+}
+
+// Maps a command stream file into a display list, matching its fonts and images by content hash against the ones given.
+int Graphics2D::loadDisplayList(DisplayList* displayList, const QString& fileName, const QList<Font*>& fonts, const QList<ImageData*>& images)
+{
+	struct stat fileStat;
+
+	//qDebug()  << "Graphics2D::loadDisplayList: " << displayList << " : " << fileName;
+
+	int fd = open(fileName.toLocal8Bit().constData(), O_RDONLY);
+	if (fd < 0) {
+		qCritical() << "Graphics2D::loadDisplayList: unable to open " << fileName << "\n";
+		return EXIT_FAILURE;
+	}
+
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(CommandStreamHeader)) {
+		qCritical() << "Graphics2D::loadDisplayList: not a command stream " << fileName << "\n";
+		close(fd);
+		return EXIT_FAILURE;
+	}
+
+	// a private mapping lets the resource references be patched in place without touching the file
+	size_t length = fileStat.st_size;
+	unsigned char* data = (unsigned char*)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED) {
+		qCritical() << "Graphics2D::loadDisplayList: unable to map " << fileName << "\n";
+		return EXIT_FAILURE;
+	}
+
+	CommandStreamHeader* header = (CommandStreamHeader*)data;
+	if (header->magic != COMMAND_STREAM_MAGIC || header->version != COMMAND_STREAM_VERSION || header->pointerSize != (int)sizeof(void*)
+			|| header->resourceCount < 0 || header->resourceOffset < (int)sizeof(CommandStreamHeader) || header->resourceBytes < 0 || header->commandBytes < 0
+			|| (size_t)header->resourceOffset + header->resourceBytes > length
+			|| header->commandOffset != COMMAND_RECORD_ALIGN(header->commandOffset)
+			|| (size_t)header->commandOffset + header->commandBytes > length) {
+		qCritical() << "Graphics2D::loadDisplayList: unsupported command stream " << fileName << "\n";
+		munmap(data, length);
+		return EXIT_FAILURE;
+	}
+
+	displayList->clear();
+
+	// resolve the resource table
+	QVector<void*> resolved(header->resourceCount);
+	QVector<int> types(header->resourceCount);
+	QVector<GLuint> textures(header->resourceCount);
+	int returnCode = EXIT_SUCCESS;
+
+	unsigned char* resourceData = data + header->resourceOffset;
+	unsigned char* resourceEnd = resourceData + header->resourceBytes;
+
+	for(int index = 0; index < header->resourceCount && returnCode == EXIT_SUCCESS; index++) {
+		CommandResourceHeader* resourceHeader = (CommandResourceHeader*)resourceData;
+		unsigned char hash[16];
+
+		if (resourceData + sizeof(CommandResourceHeader) > resourceEnd || resourceHeader->size < (int)sizeof(CommandResourceHeader) || resourceData + resourceHeader->size > resourceEnd) {
+			qCritical() << "Graphics2D::loadDisplayList: corrupt resource table in " << fileName << "\n";
+			returnCode = EXIT_FAILURE;
+			break;
+		}
+
+		unsigned char* payload = resourceData + sizeof(CommandResourceHeader);
+		size_t payloadBytes = resourceHeader->size - sizeof(CommandResourceHeader);
+
+		resolved[index] = NULL;
+		types[index] = resourceHeader->type;
+		textures[index] = 0;
+
+		switch(resourceHeader->type) {
+		case RESOURCE_FONT:
+			for(int fontIndex = 0; fontIndex < fonts.size(); fontIndex++) {
+				hashFont(fonts.at(fontIndex), hash);
+				if (memcmp(hash, resourceHeader->hash, sizeof(hash)) == 0) {
+					resolved[index] = fonts.at(fontIndex);
+					returnCode = createFontTexture(fonts.at(fontIndex));
+					break;
+				}
+			}
+			break;
+		case RESOURCE_IMAGE:
+			for(int imageIndex = 0; imageIndex < images.size(); imageIndex++) {
+				hashImage(images.at(imageIndex), hash);
+				if (memcmp(hash, resourceHeader->hash, sizeof(hash)) == 0) {
+					resolved[index] = images.at(imageIndex);
+					returnCode = createTextureForImage(images.at(imageIndex), &textures[index]);
+					break;
+				}
+			}
+			break;
+		case RESOURCE_STROKE:
+		{
+			StreamStroke* streamStroke = (StreamStroke*)payload;
+
+			// the dash lengths follow the stroke inside the entry
+			if (payloadBytes < sizeof(StreamStroke) || streamStroke->dashCount < 0
+					|| (size_t)streamStroke->dashCount > (payloadBytes - sizeof(StreamStroke)) / sizeof(GLfloat)) {
+				qCritical() << "Graphics2D::loadDisplayList: corrupt stroke " << index << " in " << fileName << "\n";
+				returnCode = EXIT_FAILURE;
+				break;
+			}
+
+			Stroke* stroke = new Stroke;
+
+			stroke->width = streamStroke->width;
+			stroke->cap = streamStroke->cap;
+			stroke->join = streamStroke->join;
+			stroke->miterLimit = streamStroke->miterLimit;
+			stroke->dash = streamStroke->dashCount > 0 ? (GLfloat*)(streamStroke + 1) : NULL;
+			stroke->dashCount = streamStroke->dashCount;
+			stroke->dashPhase = streamStroke->dashPhase;
+
+			displayList->retain(stroke);
+			resolved[index] = stroke;
+		}
+			break;
+		case RESOURCE_GRADIENT:
+		{
+			StreamGradient* streamGradient = (StreamGradient*)payload;
+
+			// segments + 1 colors and segments * 2 + 1 percentages follow the gradient inside the entry
+			size_t gradientBytes = sizeof(StreamGradient) + sizeof(GLColor) + sizeof(GLfloat);
+			if (payloadBytes < gradientBytes || streamGradient->segments < 0
+					|| (size_t)streamGradient->segments > (payloadBytes - gradientBytes) / (sizeof(GLColor) + 2 * sizeof(GLfloat))) {
+				qCritical() << "Graphics2D::loadDisplayList: corrupt gradient " << index << " in " << fileName << "\n";
+				returnCode = EXIT_FAILURE;
+				break;
+			}
+
+			Gradient* gradient = new Gradient;
+
+			gradient->segments = streamGradient->segments;
+			gradient->colors = (GLColor*)(streamGradient + 1);
+			gradient->percentages = (GLfloat*)(gradient->colors + streamGradient->segments + 1);
+			gradient->radius = streamGradient->radius;
+			gradient->angle = streamGradient->angle;
+			gradient->originU = streamGradient->originU;
+			gradient->originV = streamGradient->originV;
+			gradient->lookupTexture = 0;
+			gradient->lookupUploaded = 0;
+			gradient->lookupContext = 0;
+
+			bakeGradient(gradient);
+
+			displayList->retain(gradient);
+			resolved[index] = gradient;
+		}
+			break;
+		case RESOURCE_IMAGE_TEXTURE:
+		{
+			StreamImageTexture* streamImageTexture = (StreamImageTexture*)payload;
+
+			if (payloadBytes < sizeof(StreamImageTexture)) {
+				qCritical() << "Graphics2D::loadDisplayList: corrupt image texture " << index << " in " << fileName << "\n";
+				returnCode = EXIT_FAILURE;
+				break;
+			}
+
+			// images are always numbered before the image textures that use them
+			if (streamImageTexture->image < 1 || streamImageTexture->image > index || resolved[streamImageTexture->image - 1] == NULL) {
+				break;
+			}
+
+			ImageTexture* imageTexture = new ImageTexture;
+
+			imageTexture->image = (ImageData*)resolved[streamImageTexture->image - 1];
+			imageTexture->scaling = streamImageTexture->scaling;
+			imageTexture->tiling = streamImageTexture->tiling;
+			imageTexture->uScale = streamImageTexture->uScale;
+			imageTexture->vScale = streamImageTexture->vScale;
+			imageTexture->leftMargin = streamImageTexture->leftMargin;
+			imageTexture->rightMargin = streamImageTexture->rightMargin;
+			imageTexture->topMargin = streamImageTexture->topMargin;
+			imageTexture->bottomMargin = streamImageTexture->bottomMargin;
+
+			displayList->retain(imageTexture);
+			resolved[index] = imageTexture;
+		}
+			break;
+		default:
+			break;
+		}
+
+		if (returnCode == EXIT_SUCCESS && resolved[index] == NULL) {
+			qCritical() << "Graphics2D::loadDisplayList: unresolved resource " << index << " of type " << resourceHeader->type << " in " << fileName << "\n";
+			returnCode = EXIT_FAILURE;
+		}
+
+		resourceData += resourceHeader->size;
+	}
+
+	// patch the records in place
+	unsigned char* commandData = data + header->commandOffset;
+	unsigned char* commandEnd = commandData + header->commandBytes;
+	int commandCount = 0;
+
+	while (returnCode == EXIT_SUCCESS && commandData < commandEnd) {
+		RenderCommandHeader* command = (RenderCommandHeader*)commandData;
+
+		if (commandData + COMMAND_HEADER_SIZE > commandEnd || command->size < (int)COMMAND_HEADER_SIZE || commandData + command->size > commandEnd
+				|| command->size != COMMAND_RECORD_ALIGN(command->size) || !commandFits(command) || !commandLoadable(command)) {
+			qCritical() << "Graphics2D::loadDisplayList: corrupt command record in " << fileName << "\n";
+			returnCode = EXIT_FAILURE;
+			break;
+		}
+
+		void** pointers = commandPointers(command);
+		int* ints = commandInts(command);
+
+		// a resource has to be of the kind the command is rendered with, or none at all
+		int resourceType = commandResourceType(command->command);
+
+		for(int index = 0; index < command->pointerCount; index++) {
+			intptr_t resource = (intptr_t)pointers[index];
+
+			if (resource != 0 && (resourceType == 0 || resource < 0 || resource > header->resourceCount || types[resource - 1] != resourceType)) {
+				returnCode = EXIT_FAILURE;
+				break;
+			}
+
+			pointers[index] = resource != 0 ? resolved[resource - 1] : NULL;
+		}
+
+		if (returnCode != EXIT_SUCCESS) {
+			qCritical() << "Graphics2D::loadDisplayList: command refers to a missing resource in " << fileName << "\n";
+			break;
+		}
+
+		if (command->command == RENDER_DRAW_IMAGE) {
+			ints[0] = ints[0] > 0 && ints[0] <= header->resourceCount ? textures[ints[0] - 1] : 0;
+		}
+
+		commandData += command->size;
+		commandCount++;
+	}
+
+	if (returnCode != EXIT_SUCCESS) {
+		displayList->clear();
+		munmap(data, length);
+		return returnCode;
+	}
+
+	displayList->map(_master2D, data, length, data + header->commandOffset, header->commandBytes, commandCount);
+
+	_master2D->bakeDisplayList(displayList);
+
+	return EXIT_SUCCESS;
+}
+
+// returns true if a command has to see everything before it on screen, or changes the transform or viewport the batched geometry is drawn with
+static bool endsBatch(RenderCommand command)
+{
+	switch(command) {
+	case RENDER_CLEAR_RECT:
+	case RENDER_CLIP_RECT:
+	case RENDER_DRAW_IMAGE:
+	case RENDER_DRAW_STRING:
+	case RENDER_DRAW_INSTANCES:
+	case RENDER_TRANSFORM:
+	case RENDER_TRANSFORM_ROTATE:
+	case RENDER_TRANSFORM_TRANSLATE:
+	case RENDER_TRANSFORM_SCALE:
+	case RENDER_TRANSFORM_SHEAR:
+	case RENDER_RESTORE_STATE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void Graphics2D::render() {
+
+	CommandCursor cursor;
+	RenderCommandHeader* command;
+
+	// window area redrawn - x, y, width and height
+	int redraw[4] = { 0, 0, _width, _height };
+	bool partial = false;
+
+	//qDebug()  << "Graphics2D::render ";
+
+#ifdef GLES2
+	deleteFreedTextures();
+#endif
+
+	// pick up the most recently completed list, if any - otherwise the current one is rendered again
+	_master2D->_refreshMutex.lock();
+
+	// keeping the surface contents across swaps costs a copy on every swap, so it is only asked for while frames are redrawn in part
+	if (_master2D->_partialRedraw != _preserveRequested) {
+		preserveSwapBuffers(_master2D->_partialRedraw);
+	}
+
+	if (_master2D->_commandsReady) {
+		CommandBuffer* renderCommands = _master2D->_renderCommands;
+		_master2D->_renderCommands = _master2D->_readyCommands;
+		_master2D->_readyCommands = renderCommands;
+		_master2D->_commandsReady = false;
+
+		// only the damage since the last pick up needs redrawing, as long as the surface still holds that frame
+		partial = _master2D->_partialRedraw && !_master2D->_pendingFullDamage && _surfacePreserved && !_fullRedraw;
+
+		if (partial) {
+			GLfloat* damage = _master2D->_pendingDamage;
+
+			// round out and leave a pixel for antialiased edges
+			int x1 = qMax((int)floorf(damage[0]) - 1, 0);
+			int y1 = qMax((int)floorf(damage[1]) - 1, 0);
+			int x2 = qMin((int)ceilf(damage[2]) + 1, _width);
+			int y2 = qMin((int)ceilf(damage[3]) + 1, _height);
+
+			redraw[0] = x1;
+			redraw[1] = y1;
+			redraw[2] = qMax(x2 - x1, 0);
+			redraw[3] = qMax(y2 - y1, 0);
+		}
+
+		_master2D->_pendingDamage[0] = 1.0e30;
+		_master2D->_pendingDamage[1] = 1.0e30;
+		_master2D->_pendingDamage[2] = -1.0e30;
+		_master2D->_pendingDamage[3] = -1.0e30;
+		_master2D->_pendingFullDamage = false;
+	}
+
+	// whatever has been published so far is on the surface once this render is swapped
+	_renderedFrames = _master2D->_publishedFrames;
+
+	_master2D->_refreshMutex.unlock();
+
+	if (partial) {
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(redraw[0], redraw[1], redraw[2], redraw[3]);
+	}
+
+#ifdef GLES1
+	//Common GL ES1 setup
+	glShadeModel(GL_SMOOTH);
+#elif defined(GLES2)
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+
+	glEnable(GL_CULL_FACE);
+
+	// stencil fills leave the buffer clear behind them, but it holds nothing useful after a swap
+	if (_eglStencilSize > 0) {
+		glClearStencil(0);
+		glClear(GL_STENCIL_BUFFER_BIT);
+	}
+
+#ifdef GLES2
+	// each pass starts from the identity transform
+	memset(_master2D->_transformMatrix, 0, sizeof(GLfloat) * 4 * 4);
+	_master2D->_transformMatrix[0]  = 1.0f;
+	_master2D->_transformMatrix[5]  = 1.0f;
+	_master2D->_transformMatrix[10] = 1.0f;
+	_master2D->_transformMatrix[15] = 1.0f;
+#endif
+
+	// setup view
+	_master2D->setupView(0, 0, _width, _height);
+
+	_master2D->_renderStateCount = 0;
+
+	_master2D->_renderBatch->reset();
+	_master2D->_fringeBatch->reset();
+	_master2D->_drawCalls = 0;
+
+	// GL state is only known from here on, as it is set by this frame
+	_master2D->beginStateTracking();
+
+	// geometry is streamed through the buffers of the context being rendered to
+	_master2D->_renderStream = _vertexStream;
+	_vertexStream->bind();
+
+	// start rendering primitives
+	_master2D->_renderCommands->begin(&cursor);
+	while((command = _master2D->_renderCommands->next(&cursor)) != NULL) {
+
+		//qDebug()  << "Graphics2D::render: " << command->command << ":" << command->size;
+
+		if (endsBatch(command->command)) {
+			_master2D->flushBatch();
+		}
+
+		switch(command->command) {
+		case RENDER_CLEAR_RECT:
+			_master2D->renderClearRect(command);
+			break;
+		case RENDER_CLIP_RECT:
+			_master2D->renderClipRect(command);
+			break;
+		case RENDER_TRANSFORM:
+			_master2D->renderTransform(command);
+			break;
+		case RENDER_TRANSFORM_ROTATE:
+			_master2D->renderRotate(command);
+			break;
+		case RENDER_TRANSFORM_TRANSLATE:
+			_master2D->renderTranslate(command);
+			break;
+		case RENDER_TRANSFORM_SCALE:
+			_master2D->renderScale(command);
+			break;
+		case RENDER_TRANSFORM_SHEAR:
+			_master2D->renderShear(command);
+			break;
+		case RENDER_SET_BACKGROUND:
+			_master2D->renderSetBackground(command);
+			break;
+		case RENDER_SET_COLOR:
+			_master2D->renderSetColor(command);
+			break;
+		case RENDER_SET_FONT:
+			_master2D->renderSetFont(command);
+			break;
+		case RENDER_SET_GRADIENT:
+			_master2D->renderSetGradient(command);
+			break;
+		case RENDER_SET_IMAGE_TEXTURE:
+			_master2D->renderSetImageTexture(command);
+			break;
+		case RENDER_SET_STROKE:
+			_master2D->renderSetStroke(command);
+			break;
+		case RENDER_DRAW_MESH:
+			_master2D->renderDrawMesh(command);
+			break;
+		case RENDER_FILL_STENCIL:
+			_master2D->renderFillStencil(command);
+			break;
+		case RENDER_DRAW_INSTANCES:
+			_master2D->renderDrawInstances(command);
+			break;
+		case RENDER_DRAW_IMAGE:
+			_master2D->renderDrawImage(command);
+			break;
+		case RENDER_DRAW_STRING:
+			_master2D->renderDrawString(command);
+			break;
+		case RENDER_SAVE_STATE:
+			_master2D->renderSaveState(command);
+			break;
+		case RENDER_RESTORE_STATE:
+			_master2D->renderRestoreState(command);
+			break;
+		default:
+			break;
+		}
+	}
+
+	_master2D->flushBatch();
+
+	_master2D->_drawCallCount = _master2D->_drawCalls;
+	_master2D->endStateTracking();
+
+	if (partial) {
+		glDisable(GL_SCISSOR_TEST);
+
+		setSwapDamage(redraw[0], redraw[1], redraw[2], redraw[3]);
+	} else {
+		_fullRedraw = false;
+	}
+
+	_master2D->_redrawnPixelCount = redraw[2] * redraw[3];
+}
+
+
+// Concatenates the current Graphics2D Transform with a rotation transform.
+void Graphics2D::renderRotate(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::rrenderRotate: " << command->command << " : " << command->size;
+
+	GLfloat* floats = commandFloats(command);
+
+	GLfloat theta  = floats[0];
+
+#ifdef GLES1
+	glRotatef(theta, 0.0, 0.0, 1.0);
+#elif defined(GLES2)
+	GLfloat rotateMatrix[16];
+	memset(rotateMatrix, 0, sizeof(GLfloat) * 4 * 4);
+
+	rotateMatrix[0] = cosf(theta * M_PI / 180.0);
+	rotateMatrix[1] = sinf(theta * M_PI / 180.0);
+	rotateMatrix[4] = cosf((theta + 90.0) * M_PI / 180.0);
+	rotateMatrix[5] = sinf((theta + 90.0) * M_PI / 180.0);
+	rotateMatrix[15] = 1.0f;
+
+	multiplyMatrix(_transformMatrix, rotateMatrix, _transformMatrix);
+
+	multiplyMatrix(_transformMatrix, _scaleMatrix, _renderModelMatrix);
+
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+}
+
+// Concatenates the current Graphics2D Transform with a scaling transformation Subsequent rendering is resized according to the specified scaling factors relative to the previous scaling.
+void Graphics2D::renderScale(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderScale: " << command->command << " : " << command->size;
+
+	GLfloat* floats = commandFloats(command);
+
+	GLfloat sx  = floats[0];
+	GLfloat sy  = floats[1];
+
+#ifdef GLES1
+	glScalef(sx, sy, 0.0);
+#elif defined(GLES2)
+	GLfloat scaleMatrix[16];
+	memset(scaleMatrix, 0, sizeof(GLfloat) * 4 * 4);
+
+	scaleMatrix[0] = sx;
+	scaleMatrix[5] = sy;
+	scaleMatrix[15] = 1.0f;
+
+	multiplyMatrix(_transformMatrix, scaleMatrix, _transformMatrix);
+
+	multiplyMatrix(_transformMatrix, _scaleMatrix, _renderModelMatrix);
+
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+}
+
+// Concatenates the current Graphics2D Transform with a translation transform.
+void Graphics2D::renderTranslate(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderTranslate: " << command->command << " : " << command->size;
+
+	GLfloat* floats = commandFloats(command);
+
+	GLfloat tx  = floats[0];
+	GLfloat ty  = floats[1];
+
+#ifdef GLES1
+	glTranslatef(tx, ty, 0.0);
+#elif defined(GLES2)
+	GLfloat translateMatrix[16];
+	memset(translateMatrix, 0, sizeof(GLfloat) * 4 * 4);
+
+	translateMatrix[0]  = 1.0f;
+	translateMatrix[5]  = 1.0f;
+	translateMatrix[10] = 1.0f;
+	translateMatrix[12] = tx;
+	translateMatrix[13] = ty;
+	translateMatrix[15] = 1.0f;
+
+	multiplyMatrix(_transformMatrix, translateMatrix, _transformMatrix);
+
+	multiplyMatrix(_transformMatrix, _scaleMatrix, _renderModelMatrix);
+
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+}
+
+// Concatenates the current Graphics2D Transform with a shearing transform.
+void Graphics2D::renderShear(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderShear: " << command->command << " : " << command->size;
+
+	GLfloat* floats = commandFloats(command);
+
+	GLfloat shx  = floats[0];
+	GLfloat shy  = floats[1];
+
+	GLfloat shearMatrix[16];
+	memset(shearMatrix, 0, sizeof(GLfloat) * 4 * 4);
+
+	shearMatrix[0] = 1.0f;
+	shearMatrix[1] = shy;
+	shearMatrix[4] = shx;
+	shearMatrix[5] = 1.0f;
+	shearMatrix[15] = 1.0f;
+
+	// TODO: fix this
+#ifdef GLES1
+    glMatrixMode(GL_MODELVIEW);
+
+    glLoadIdentity();
+
+	glMultMatrixf(shearMatrix);
+#elif defined(GLES2)
+	multiplyMatrix(_transformMatrix, shearMatrix, _transformMatrix);
+
+	multiplyMatrix(_transformMatrix, _scaleMatrix, _renderModelMatrix);
+
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+}
+
+// Overwrites the Transform in the Graphics2D context.
+void Graphics2D::renderTransform(RenderCommandHeader* command)
+{
+	GLfloat* floats = commandFloats(command);
+
+	//qDebug()  << "Graphics2D::renderShear: " << command->command << " : " << command->size;
+	GLfloat transformMatrix[16];
+
+	transformMatrix[ 0]  = floats[0];
+	transformMatrix[ 1]  = floats[1];
+	transformMatrix[ 2]  = 0.0;
+	transformMatrix[ 3]  = floats[2];
+	transformMatrix[ 4]  = floats[3];
+	transformMatrix[ 5]  = floats[4];
+	transformMatrix[ 6]  = 0.0;
+	transformMatrix[ 7]  = floats[5];
+	transformMatrix[ 8]  = 0.0;
+	transformMatrix[ 9]  = 0.0;
+	transformMatrix[10]  = 1.0;
+	transformMatrix[11]  = 0.0;
+	transformMatrix[12]  = floats[6];
+	transformMatrix[13]  = floats[7];
+	transformMatrix[14]  = 0.0;
+	transformMatrix[15]  = floats[8];
+
+#ifdef GLES1
+    glMatrixMode(GL_MODELVIEW);
+
+    glLoadIdentity();
+
+	glMultMatrixf(transformMatrix);
+#elif defined(GLES2)
+	memcpy(transformMatrix, _transformMatrix, sizeof(GLfloat) * 4 * 4);
+
+	multiplyMatrix(transformMatrix, _scaleMatrix, _renderModelMatrix);
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+}
+
+// Pushes the current rendering state.
+void Graphics2D::renderSaveState(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderSaveState: " << command->command << " : " << _renderStateCount;
+
+	if (_renderStateCount < MAX_RENDER_STATES) {
+		RenderState* state = &_renderStates[_renderStateCount];
+
+		state->foregroundColor = _renderForegroundColor;
+		state->backgroundColor = _renderBackgroundColor;
+		state->font = _renderFont;
+		state->gradient = _renderGradient;
+		state->imageTexture = _renderImageTexture;
+		state->stroke = _renderStroke;
+
+#ifdef GLES1
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+#elif defined(GLES2)
+		memcpy(state->transformMatrix, _transformMatrix, sizeof(GLfloat) * 4 * 4);
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+	} else {
+		qCritical() << "Graphics2D::renderSaveState: display lists nested too deeply\n";
+	}
+
+	// keep counting so that the matching restores stay paired
+	_renderStateCount++;
+}
+
+// Pops the most recently saved rendering state.
+void Graphics2D::renderRestoreState(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderRestoreState: " << command->command << " : " << _renderStateCount;
+
+	if (_renderStateCount == 0) {
+		return;
+	}
+
+	_renderStateCount--;
+
+	if (_renderStateCount < MAX_RENDER_STATES) {
+		RenderState* state = &_renderStates[_renderStateCount];
+
+		_renderForegroundColor = state->foregroundColor;
+		_renderBackgroundColor = state->backgroundColor;
+		_renderFont = state->font;
+		_renderGradient = state->gradient;
+		_renderImageTexture = state->imageTexture;
+		_renderStroke = state->stroke;
+
+#ifdef GLES1
+		glMatrixMode(GL_MODELVIEW);
+		glPopMatrix();
+#elif defined(GLES2)
+		memcpy(_transformMatrix, state->transformMatrix, sizeof(GLfloat) * 4 * 4);
+
+		multiplyMatrix(_transformMatrix, _scaleMatrix, _renderModelMatrix);
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+	}
+}
+
+// Sets the background color for the Graphics2D context.
+void Graphics2D::renderSetBackground(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderSetBackground: " << command->command << " : " << command->size;
+
+	GLfloat* floats = commandFloats(command);
+
+	_renderBackgroundColor.red   = floats[0];
+	_renderBackgroundColor.green = floats[1];
+	_renderBackgroundColor.blue  = floats[2];
+	_renderBackgroundColor.alpha = floats[3];
+}
+
+// Sets this graphics context's current color to the specified color.
+void Graphics2D::renderSetColor(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderSetColor: " << command->command << " : " << command->size;
+
+	GLfloat* floats = commandFloats(command);
+
+	_renderForegroundColor.red   = floats[0];
+	_renderForegroundColor.green = floats[1];
+	_renderForegroundColor.blue  = floats[2];
+	_renderForegroundColor.alpha = floats[3];
+
+	_renderGradient = NULL;
+}
+
+// Sets this graphics context's current color to the specified color.
+void Graphics2D::renderSetFont(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderSetFont: " << command->command << " : " << command->size;
+
+	void** pointers = commandPointers(command);
+
+	_renderFont = (Font*)pointers[0];
+}
+
+// Sets this graphics context's current color to the specified color.
+void Graphics2D::renderSetGradient(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderSetGradient: " << command->command << " : " << command->size;
+
+	void** pointers = commandPointers(command);
+
+	_renderGradient = (Gradient*)pointers[0];
+}
+
+// Sets this graphics context's image texture to the specified image texture.
+void Graphics2D::renderSetImageTexture(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderSetImageTexture: " << command->command << " : " << command->size;
+
+	void** pointers = commandPointers(command);
+
+	_renderImageTexture = (ImageTexture*)pointers[0];
+}
+
+// Sets this graphics context's current color to the specified color.
+void Graphics2D::renderSetStroke(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderSetStroke: " << command->command << " : " << command->size;
+
+	void** pointers = commandPointers(command);
+
+	_renderStroke = (Stroke*)pointers[0];
+}
+
+// Clears the specified rectangle by filling it with the background color of the current drawing surface.
+void Graphics2D::renderClearRect(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderClearRect: " << command->command << " : " << command->size;
+
+	int* ints = commandInts(command);
+
+	setupView(ints[0], ints[1], ints[2], ints[3]);
+
+	glClearColor(_renderBackgroundColor.red, _renderBackgroundColor.green, _renderBackgroundColor.blue, _renderBackgroundColor.alpha);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+// Intersects the current clip with the specified rectangle.
+void Graphics2D::renderClipRect(RenderCommandHeader* command)
+{
+	//qDebug()  << "Graphics2D::renderClipRect: " << command->command << " : " << command->size;
+
+	int* ints = commandInts(command);
+
+	setupView(ints[0], ints[1], ints[2], ints[3]);
+}
+
+// Render a line, using the current color, between the points (x1, y1) and (x2, y2) in this graphics context's coordinate system.
+void Graphics2D::tessellateLine(RenderCommandHeader* command, CommandBuffer* tessellated)
+{
+	//qDebug()  << "Graphics2D::tessellateLine: " << command->command << " : " << command->size;
+
+	GLfloat* floats = commandFloats(command);
+
+	// the gradient or texture is spread over the whole line rather than over each dash
+	GLfloat bounds[4] = { 1.0e30, 1.0e30, -1.0e30, -1.0e30 };
+	strokeBounds(floats, 2, bounds);
+
+	strokeDashed(tessellated, floats, 2, false, bounds);
+}
+
+// Draws a sequence of connected lines defined by arrays of x and y coordinates.
+void Graphics2D::tessellatePolyline(RenderCommandHeader* command, CommandBuffer* tessellated)
+{
+	//qDebug()  << "Graphics2D::tessellatePolyline: " << command->command;
+
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
+
+	int numberPoints = ints[0];
+
+	// the gradient or texture is spread over the whole polyline rather than over each dash
+	GLfloat bounds[4] = { 1.0e30, 1.0e30, -1.0e30, -1.0e30 };
+	strokeBounds(floats, numberPoints, bounds);
+
+	// dense input such as ink or long data series has far more points than show on screen
+	if (_tessellateSimplify > 0.0 && numberPoints > 2) {
+		GLfloat* simplified = tessellateSimplifyCoords(numberPoints * 2);
+		int simplifiedPoints = simplifyPolyline(floats, numberPoints, simplified);
+
+		_removedVertexCount += numberPoints - simplifiedPoints;
+
+		floats = simplified;
+		numberPoints = simplifiedPoints;
+	}
+
+	// polygons are recorded as polylines coming back to their first point
+	bool closed = numberPoints > 2 && floats[0] == floats[numberPoints*2-2] && floats[1] == floats[numberPoints*2-1];
+
+	strokeDashed(tessellated, floats, numberPoints, closed, bounds);
+}
+
+// Copies the points of a polyline that stray more than the current simplification tolerance from the lines between their neighbours, always keeping both ends, and returns how many were kept.
+int Graphics2D::simplifyPolyline(const GLfloat* points, int count, GLfloat* simplified)
+{
+	GLfloat squaredTolerance = _tessellateSimplify * _tessellateSimplify;
+
+	// points within the tolerance of the last one kept are dropped first, which cheaply thins out input sampled much finer than the tolerance
+	int kept = 1;
+	simplified[0] = points[0];
+	simplified[1] = points[1];
+
+	for(int index = 1; index < count; index++) {
+		GLfloat dx = points[index*2+0] - simplified[(kept-1)*2+0];
+		GLfloat dy = points[index*2+1] - simplified[(kept-1)*2+1];
+
+		if (dx * dx + dy * dy > squaredTolerance || index == count - 1) {
+			simplified[kept*2+0] = points[index*2+0];
+			simplified[kept*2+1] = points[index*2+1];
+			kept++;
+		}
+	}
+
+	if (kept <= 2) {
+		return kept;
+	}
+
+	// then Ramer-Douglas-Peucker - a run keeps its farthest point from the line joining its ends if that strays past the tolerance and is split there,
+	// worked through with a stack of runs rather than recursion since series may have tens of thousands of points
+	int* keep = tessellatePolygonLinks(kept * 3);
+	int* runs = keep + kept;
+	int runCount = 0;
+
+	memset(keep, 0, sizeof(int) * kept);
+	keep[0] = 1;
+	keep[kept-1] = 1;
+
+	runs[runCount++] = 0;
+	runs[runCount++] = kept - 1;
+
+	while (runCount > 0) {
+		int last = runs[--runCount];
+		int first = runs[--runCount];
+
+		GLfloat x = simplified[first*2+0];
+		GLfloat y = simplified[first*2+1];
+		GLfloat dx = simplified[last*2+0] - x;
+		GLfloat dy = simplified[last*2+1] - y;
+		GLfloat squaredLength = dx * dx + dy * dy;
+
+		GLfloat farthest = squaredTolerance;
+		int split = -1;
+
+		for(int index = first + 1; index < last; index++) {
+			// distance to the segment rather than the whole line, so that strokes doubling back on themselves keep their turning points
+			GLfloat px = simplified[index*2+0] - x;
+			GLfloat py = simplified[index*2+1] - y;
+
+			if (squaredLength > 0.0) {
+				GLfloat along = (px * dx + py * dy) / squaredLength;
+				if (along > 1.0) {
+					along = 1.0;
+				} else if (along < 0.0) {
+					along = 0.0;
+				}
+				px -= along * dx;
+				py -= along * dy;
+			}
+
+			GLfloat squared = px * px + py * py;
+			if (squared > farthest) {
+				farthest = squared;
+				split = index;
+			}
+		}
+
+		if (split >= 0) {
+			keep[split] = 1;
+
+			runs[runCount++] = first;
+			runs[runCount++] = split;
+			runs[runCount++] = split;
+			runs[runCount++] = last;
+		}
+	}
+
+	int simplifiedCount = 0;
+	for(int index = 0; index < kept; index++) {
+		if (keep[index]) {
+			simplified[simplifiedCount*2+0] = simplified[index*2+0];
+			simplified[simplifiedCount*2+1] = simplified[index*2+1];
+			simplifiedCount++;
+		}
+	}
+
+	return simplifiedCount;
+}
+
+// Outlines a sequence of connected points with the current stroke, cut into dashes in one pass along it when the stroke has a dash pattern.
+void Graphics2D::strokeDashed(CommandBuffer* tessellated, const GLfloat* points, int count, bool closed, const GLfloat* bounds)
+{
+	DashIterator dashes;
+
+	if (!dashes.begin(_tessellateStroke->dash, _tessellateStroke->dashCount, _tessellateStroke->dashPhase)) {
+		strokePolyline(tessellated, points, count, closed, bounds);
+		return;
+	}
+
+	// a dash holds at most every point of the polyline plus the two where it starts and ends
+	float* dashCoords = tessellateDashCoords((count + 2) * 2);
+	int dashPoints = 0;
+
+	GLfloat dx, dy, length, from, to;
+
+	for(int index = 0; index < (count-1); index++) {
+		const GLfloat* point = points + index*2;
+
+		dx = point[2] - point[0];
+		dy = point[3] - point[1];
+		length = sqrt(dx * dx + dy * dy);
+
+		dashes.nextSegment(length);
+
+		while (dashes.nextSpan(&from, &to)) {
+			if (dashes.startsDash()) {
+				dashCoords[0] = point[0] + from * dx / length;
+				dashCoords[1] = point[1] + from * dy / length;
+				dashPoints = 1;
+			}
+
+			dashCoords[dashPoints*2+0] = point[0] + to * dx / length;
+			dashCoords[dashPoints*2+1] = point[1] + to * dy / length;
+			dashPoints++;
+
+			if (dashes.endsDash()) {
+				strokePolyline(tessellated, dashCoords, dashPoints, false, bounds);
+				dashPoints = 0;
+			}
+		}
+	}
+
+	// the last dash is cut short by the end of the polyline
+	if (dashPoints > 0) {
+		strokePolyline(tessellated, dashCoords, dashPoints, false, bounds);
+	}
+}
+
+// returns the angle in degrees a curve of the given radius can turn through per segment while staying within tolerance of it
+static double curveAngleStep(double radius, double tolerance)
+{
+	double step = 45.0;
+
+	if (radius > tolerance) {
+		step = 2.0 * acos(1.0 - tolerance / radius) * 180.0 / M_PI;
+	}
+
+	return step < 45.0 ? step : 45.0;
+}
+
+// an outline vertex, with u,v spread over the bounds of the whole stroke
+static int addStrokeVertex(VertexBatch* mesh, const GLfloat* bounds, GLfloat x, GLfloat y)
+{
+	GLfloat u = 0.0, v = 0.0;
+
+	if (bounds[2] > bounds[0]) {
+		u = (x - bounds[0]) / (bounds[2] - bounds[0]);
+	}
+	if (bounds[3] > bounds[1]) {
+		v = (y - bounds[1]) / (bounds[3] - bounds[1]);
+	}
+
+	return mesh->addVertex(x, y, u, v);
+}
+
+// adds a triangle counter clockwise whichever order its corners come in, so that it is not culled, and leaves out empty ones
+static void addStrokeTriangle(VertexBatch* mesh, int index1, int index2, int index3)
+{
+	GLfloat* coords = mesh->vertexCoords();
+	GLfloat area = (coords[index2*2+0] - coords[index1*2+0]) * (coords[index3*2+1] - coords[index1*2+1])
+			- (coords[index2*2+1] - coords[index1*2+1]) * (coords[index3*2+0] - coords[index1*2+0]);
+
+	if (area > 0.0) {
+		mesh->addTriangle(index1, index2, index3);
+	} else if (area < 0.0) {
+		mesh->addTriangle(index1, index3, index2);
+	}
+}
+
+// returns the number of steps that keeps a round join or cap of the given sweep within tolerance of the true circle
+static int roundSteps(GLfloat radius, GLfloat sweep, GLfloat tolerance)
+{
+	GLfloat step = curveAngleStep(radius, tolerance) * M_PI / 180.0;
+
+	int steps = (int)ceil(fabs(sweep) / step);
+	if (steps < 1) {
+		steps = 1;
+	}
+	if (steps > STROKE_MAX_ROUND_STEPS) {
+		steps = STROKE_MAX_ROUND_STEPS;
+	}
+
+	return steps;
+}
+
+// fans round a center vertex from one outline vertex to another, adding the vertices in between
+static void addStrokeFan(VertexBatch* mesh, const GLfloat* bounds, GLfloat tolerance, int center, GLfloat x, GLfloat y, GLfloat radius, GLfloat angle, GLfloat sweep, int from, int to)
+{
+	int steps = roundSteps(radius, sweep, tolerance);
+	int last = from;
+
+	for(int step = 1; step < steps; step++) {
+		GLfloat stepAngle = angle + sweep * step / steps;
+		int vertex = addStrokeVertex(mesh, bounds, x + radius * cos(stepAngle), y + radius * sin(stepAngle));
+		addStrokeTriangle(mesh, center, last, vertex);
+		last = vertex;
+	}
+
+	addStrokeTriangle(mesh, center, last, to);
+}
+
+// Works out the bounds the texture coordinates of a stroke are spread over, from its points and the current stroke width.
+void Graphics2D::strokeBounds(const GLfloat* points, int count, GLfloat* bounds)
+{
+	GLfloat halfWidth = _tessellateStroke->width / 2.0;
+
+	for(int index = 0; index < count; index++) {
+		includePoint(bounds, points[index*2+0], points[index*2+1]);
+	}
+
+	bounds[0] -= halfWidth;
+	bounds[1] -= halfWidth;
+	bounds[2] += halfWidth;
+	bounds[3] += halfWidth;
+}
+
+// Outlines a sequence of connected points with the current stroke, joining the end back to the start rather than capping both when closed.
+void Graphics2D::strokePolyline(CommandBuffer* tessellated, const GLfloat* points, int count, bool closed, const GLfloat* bounds)
+{
+	if (count <= 0) {
+		return;
+	}
+
+	// repeated points have no direction to outline along
+	int* corners = tessellatePolygonLinks(count);
+	int cornerCount = 0;
+
+	for(int index = 0; index < count; index++) {
+		if (cornerCount > 0 && points[index*2+0] == points[corners[cornerCount-1]*2+0] && points[index*2+1] == points[corners[cornerCount-1]*2+1]) {
+			continue;
 		}
+		corners[cornerCount++] = index;
 	}
 
-	memset(_renderModelMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_renderModelMatrix[i * 4 + j] += _transformMatrix[i * 4 + k] * _scaleMatrix[k * 4 + j];
+	// a closed outline ends back on its first point, which is joined to rather than outlined again
+	closed = closed && cornerCount > 2 && points[corners[0]*2+0] == points[corners[cornerCount-1]*2+0] && points[corners[0]*2+1] == points[corners[cornerCount-1]*2+1];
+	if (closed) {
+		cornerCount--;
+	}
+
+	// joins and caps take a handful of vertices each, or a fan of them when they are round
+	int cornerVertices = 5;
+	if (_tessellateStroke->join == JOIN_ROUND || _tessellateStroke->cap == CAP_ROUND) {
+		cornerVertices += STROKE_MAX_ROUND_STEPS;
+	}
+
+	int runLength = VERTEX_BATCH_MAX_VERTICES / cornerVertices - 2;
+
+	if (cornerCount <= runLength) {
+		if (!_tessellateMesh->hasRoomFor((cornerCount + 2) * cornerVertices)) {
+			emitMesh(tessellated);
+		}
+
+		strokeRun(points, corners, cornerCount, closed, true, true, bounds);
+		return;
+	}
+
+	// too long for 16-bit indices - outline it in runs which share their end points, with a plain butt between them
+	if (closed) {
+		cornerCount++;
+	}
+
+	int start = 0;
+	while (start < cornerCount - 1) {
+		int length = cornerCount - start;
+		if (length > runLength) {
+			length = runLength;
+		}
+
+		emitMesh(tessellated);
+
+		strokeRun(points, corners + start, length, false, start == 0, start + length == cornerCount, bounds);
+
+		start += length - 1;
+	}
+}
+
+// Outlines a run of distinct points into the mesh being tessellated, which has room for it, with the joins and caps of the current stroke.
+void Graphics2D::strokeRun(const GLfloat* points, const int* corners, int count, bool closed, bool startCap, bool endCap, const GLfloat* bounds)
+{
+	VertexBatch* mesh = _tessellateMesh;
+	GLfloat halfWidth = _tessellateStroke->width / 2.0;
+	int cap = _tessellateStroke->cap;
+	int join = _tessellateStroke->join;
+
+	// a miter limit below one cannot be met, so it is taken to mean the usual default
+	GLfloat miterLimit = _tessellateStroke->miterLimit >= 1.0 ? _tessellateStroke->miterLimit : 10.0;
+
+	if (halfWidth <= 0.0) {
+		return;
+	}
+
+	if (count == 1) {
+		// a lone point only shows up through its caps
+		GLfloat x = points[corners[0]*2+0];
+		GLfloat y = points[corners[0]*2+1];
+
+		if (cap == CAP_ROUND) {
+			int center = addStrokeVertex(mesh, bounds, x, y);
+			int first = addStrokeVertex(mesh, bounds, x + halfWidth, y);
+			addStrokeFan(mesh, bounds, _tessellateTolerance, center, x, y, halfWidth, 0.0, 2.0 * M_PI, first, first);
+		} else if (cap == CAP_SQUARE) {
+			int corner1 = addStrokeVertex(mesh, bounds, x - halfWidth, y - halfWidth);
+			int corner2 = addStrokeVertex(mesh, bounds, x + halfWidth, y - halfWidth);
+			int corner3 = addStrokeVertex(mesh, bounds, x + halfWidth, y + halfWidth);
+			int corner4 = addStrokeVertex(mesh, bounds, x - halfWidth, y + halfWidth);
+			addStrokeTriangle(mesh, corner1, corner2, corner3);
+			addStrokeTriangle(mesh, corner1, corner3, corner4);
+		}
+		return;
+	}
+
+	int segmentCount = closed ? count : count - 1;
+
+	// the points are gathered one after the other, coming back to the first when closed, so that the directions and outlines of all the segments are worked out in one go
+	GLfloat* runPoints = tessellateStrokeCoords((segmentCount + 1) * 2 + segmentCount * 11);
+	GLfloat* directions = runPoints + (segmentCount + 1) * 2;
+	GLfloat* lengths = directions + segmentCount * 2;
+	GLfloat* outlines = lengths + segmentCount;
+
+	for(int index = 0; index <= segmentCount; index++) {
+		runPoints[index*2+0] = points[corners[index % count]*2+0];
+		runPoints[index*2+1] = points[corners[index % count]*2+1];
+	}
+
+	segmentDirections(runPoints, segmentCount, directions, lengths);
+	extrudeSegments(runPoints, directions, segmentCount, halfWidth, outlines);
+
+	// left and right outline vertices where the current segment starts, and where the closing segment ends
+	int left = -1, right = -1, closingLeft = -1, closingRight = -1;
+
+	for(int segment = -1; segment < segmentCount; segment++) {
+		// segment -1 only works out the start of the first segment
+		int corner = segment + 1;
+		int in = corner > 0 ? corner - 1 : segmentCount - 1;
+		int out = corner;
+
+		GLfloat x = runPoints[corner*2+0];
+		GLfloat y = runPoints[corner*2+1];
+
+		GLfloat inX = 0.0, inY = 0.0, outX = 0.0, outY = 0.0, length;
+		GLfloat inLength = 0.0, outLength = 0.0;
+
+		bool hasIn = closed || corner > 0;
+		bool hasOut = closed || corner < count - 1;
+
+		// left and right outline points where the segment coming in ends and where the one going out starts
+		const GLfloat* inEnd = NULL;
+		const GLfloat* outStart = NULL;
+
+		if (hasIn) {
+			inX = directions[in*2+0];
+			inY = directions[in*2+1];
+			inLength = lengths[in];
+			inEnd = outlines + in*8 + 4;
+		}
+		if (hasOut) {
+			outX = directions[out*2+0];
+			outY = directions[out*2+1];
+			outLength = lengths[out];
+			outStart = outlines + out*8;
+		}
+
+		// outline vertices where the segment coming in ends and where the one going out starts
+		int endLeft, endRight, startLeft, startRight;
+
+		if (!hasIn || !hasOut) {
+			// an open end, pushed back or forward by half the width for a square cap
+			GLfloat dx = hasOut ? outX : inX;
+			GLfloat dy = hasOut ? outY : inY;
+			const GLfloat* ends = hasOut ? outStart : inEnd;
+			bool capped = hasOut ? startCap : endCap;
+
+			length = 0.0;
+			if (capped && cap == CAP_SQUARE) {
+				length = hasOut ? -halfWidth : halfWidth;
+			}
+
+			endLeft = startLeft = addStrokeVertex(mesh, bounds, ends[0] + dx * length, ends[1] + dy * length);
+			endRight = startRight = addStrokeVertex(mesh, bounds, ends[2] + dx * length, ends[3] + dy * length);
+
+			if (capped && cap == CAP_ROUND) {
+				// half a circle round the back of the start or the front of the end, from the left normal (-dy, dx)
+				int center = addStrokeVertex(mesh, bounds, x, y);
+				addStrokeFan(mesh, bounds, _tessellateTolerance, center, x, y, halfWidth, atan2(dx, -dy), hasOut ? M_PI : -M_PI, endLeft, endRight);
+			}
+		} else {
+			GLfloat cross = inX * outY - inY * outX;
+			GLfloat dot = inX * outX + inY * outY;
+
+			if (fabs(cross) < 1.0e-6 && dot > 0.0) {
+				// carries straight on, so both segments share the same pair
+				endLeft = startLeft = addStrokeVertex(mesh, bounds, inEnd[0], inEnd[1]);
+				endRight = startRight = addStrokeVertex(mesh, bounds, inEnd[2], inEnd[3]);
+			} else {
+				// turning left puts the inside of the corner on the left
+				GLfloat side = cross >= 0.0 ? 1.0 : -1.0;
+				int inner = side > 0.0 ? 0 : 2;
+				int outer = 2 - inner;
+
+				// cosine of half the angle between the two normals, which stretches the miter
+				GLfloat cosHalf = sqrt((1.0 + dot) / 2.0);
+				GLfloat miterX = -inY - outY;
+				GLfloat miterY = inX + outX;
+				length = sqrt(miterX * miterX + miterY * miterY);
+				if (length > 0.0) {
+					miterX /= length;
+					miterY /= length;
+				}
+
+				int innerIn, innerOut, outerIn, outerOut;
+
+				// the inner outlines meet unless the corner is so sharp that they would cross past the ends of the segments
+				GLfloat innerReach = cosHalf > 0.0 ? halfWidth * sqrt(1.0 - cosHalf * cosHalf) / cosHalf : 1.0e30;
+				if (innerReach <= inLength && innerReach <= outLength) {
+					innerIn = innerOut = addStrokeVertex(mesh, bounds, x + side * miterX * halfWidth / cosHalf, y + side * miterY * halfWidth / cosHalf);
+				} else {
+					innerIn = addStrokeVertex(mesh, bounds, inEnd[inner], inEnd[inner+1]);
+					innerOut = addStrokeVertex(mesh, bounds, outStart[inner], outStart[inner+1]);
+				}
+
+				if (join == JOIN_MITER && cosHalf > 0.0 && 1.0 / cosHalf <= miterLimit) {
+					outerIn = outerOut = addStrokeVertex(mesh, bounds, x - side * miterX * halfWidth / cosHalf, y - side * miterY * halfWidth / cosHalf);
+				} else {
+					// bevelled, rounded, or a miter past its limit
+					outerIn = addStrokeVertex(mesh, bounds, inEnd[outer], inEnd[outer+1]);
+					outerOut = addStrokeVertex(mesh, bounds, outStart[outer], outStart[outer+1]);
+
+					// the ends of the two segments are slanted towards the inner corner, which leaves a wedge either side of the center
+					int center = addStrokeVertex(mesh, bounds, x, y);
+					addStrokeTriangle(mesh, center, innerIn, outerIn);
+					addStrokeTriangle(mesh, center, innerOut, outerOut);
+
+					if (join == JOIN_ROUND) {
+						addStrokeFan(mesh, bounds, _tessellateTolerance, center, x, y, halfWidth, atan2(-side * inX, side * inY), atan2(cross, dot), outerIn, outerOut);
+					} else {
+						addStrokeTriangle(mesh, center, outerIn, outerOut);
+					}
+				}
+
+				if (side > 0.0) {
+					endLeft = innerIn;
+					endRight = outerIn;
+					startLeft = innerOut;
+					startRight = outerOut;
+				} else {
+					endLeft = outerIn;
+					endRight = innerIn;
+					startLeft = outerOut;
+					startRight = innerOut;
+				}
 			}
 		}
+
+		if (segment < 0) {
+			// the closing segment ends where the first one starts
+			closingLeft = endLeft;
+			closingRight = endRight;
+		} else {
+			addStrokeTriangle(mesh, left, right, endRight);
+			addStrokeTriangle(mesh, left, endRight, endLeft);
+		}
+
+		left = startLeft;
+		right = startRight;
+
+		if (closed && segment == segmentCount - 2) {
+			// the last corner is the first one again, which was worked out up front, so the closing segment is drawn here
+			segment++;
+			addStrokeTriangle(mesh, left, right, closingRight);
+			addStrokeTriangle(mesh, left, closingRight, closingLeft);
+		}
 	}
+}
 
-#else
-#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+// Adds a mesh tessellated at record time to the current batch, submitting the batch first if it was built with another color or gradient.
+void Graphics2D::renderDrawMesh(RenderCommandHeader* command)
+{
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
+
+	int vertexCount = ints[0];
+	int indexCount = ints[1];
+
+	if (vertexCount <= 0 || indexCount <= 0) {
+		return;
+	}
+
+	// edge fringes carry the coverage of each vertex after its texture coordinates, and are batched apart from the geometry they fade out from
+	GLfloat* alphas = command->floatCount > vertexCount * 4 ? floats + vertexCount * 4 : NULL;
+	VertexBatch* batch = alphas ? _fringeBatch : _renderBatch;
+
+	// consecutive geometry shares one draw for as long as it uses the same program and uniforms
+	if (!_renderBatch->isEmpty() || !_fringeBatch->isEmpty()) {
+		if (_batchGradient != _renderGradient || memcmp(&_batchColor, &_renderForegroundColor, sizeof(GLColor)) != 0
+				|| !batch->hasRoomFor(vertexCount)) {
+			flushBatch();
+		}
+	}
+
+	_batchColor = _renderForegroundColor;
+	_batchGradient = _renderGradient;
+
+	batch->addMesh(floats, floats + vertexCount * 2, alphas, vertexCount, (GLushort*)(ints + 2), indexCount);
+}
+
+#ifdef GLES2
+// the bit of a vertex attribute location in the mask taken by useVertexAttribArrays, none for an attribute the program left out
+static unsigned int attribBit(GLint location)
+{
+	return location >= 0 && location < MAX_TRACKED_VERTEX_ATTRIBS ? 1 << location : 0;
+}
 #endif
+
+// Submits the batched quads and triangles, then the edge fringes batched with them.
+void Graphics2D::flushBatch()
+{
+	// the geometry is drawn unblended as it always has been, so the fringes can go over it afterwards, fading out into whatever is underneath, without showing where triangles overlap
+	drawBatch(_renderBatch, false);
+	drawBatch(_fringeBatch, true);
 }
 
-// Concatenates the current Graphics2D Transform with a shearing transform.
-void Graphics2D::renderShear(int commandCount)
+// Submits one batch with a single indexed draw, blending it by the coverage of its vertices if it holds edge fringes.
+void Graphics2D::drawBatch(VertexBatch* batch, bool fringed)
 {
-	//qDebug()  << "Graphics2D::renderShear: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1];
+	if (batch->isEmpty()) {
+		return;
+	}
 
-	GLfloat shx  = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	GLfloat shy  = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
+	//qDebug()  << "Graphics2D::drawBatch: " << batch->vertexCount() << " : " << batch->indexCount();
 
-	GLfloat shearMatrix[16];
-	memset(shearMatrix, 0, sizeof(GLfloat) * 4 * 4);
+	// the geometry is written with its own alpha as it always has been, while a fringe blends over it by its coverage alone
+	setBlending(fringed);
+	if (fringed) {
+		setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
 
-	shearMatrix[0] = 1.0f;
-	shearMatrix[1] = shy;
-	shearMatrix[4] = shx;
-	shearMatrix[5] = 1.0f;
-	shearMatrix[15] = 1.0f;
+	int vertexCount = batch->vertexCount();
+	int indexCount = batch->indexCount();
+	int coordBytes = vertexCount * 2 * sizeof(GLfloat);
+	int indexBytes = indexCount * sizeof(GLushort);
 
-	// TODO: fix this
 #ifdef GLES1
-    glMatrixMode(GL_MODELVIEW);
+	glColor4f(_batchColor.red, _batchColor.green, _batchColor.blue, _batchColor.alpha);
 
-    glLoadIdentity();
+	setTexturing(false);
+	useClientArrays(fringed ? CLIENT_VERTEX_ARRAY | CLIENT_COLOR_ARRAY : CLIENT_VERTEX_ARRAY);
+
+	_renderStream->reserve(fringed ? coordBytes * 3 : coordBytes, indexBytes);
+
+	glVertexPointer(2, GL_FLOAT, 0, _renderStream->writeVertices(batch->vertexCoords(), coordBytes));
+
+	if (fringed) {
+		glColorPointer(4, GL_FLOAT, 0, _renderStream->writeVertices(batch->vertexColors(_batchColor.red, _batchColor.green, _batchColor.blue, 1.0), coordBytes * 2));
+	}
+
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, _renderStream->writeIndices(batch->indices(), indexBytes));
 
-	glMultMatrixf(shearMatrix);
 #elif defined(GLES2)
-	GLfloat tempMatrix[16];
-	memcpy(tempMatrix, _transformMatrix, sizeof(GLfloat) * 4 * 4);
 
-	int i, j, k;
-	memset(_transformMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_transformMatrix[i * 4 + j] += tempMatrix[i * 4 + k] * shearMatrix[k * 4 + j];
-			}
+	if (_batchGradient) {
+
+		//qDebug()  << "Graphics2D::flushBatch: _batchGradient";
+
+	    useProgram(_polyGradientRenderingProgram);
+
+	    GLint pmLoc = _polyGradientLocations.projectionMatrix;
+	    GLint mvmLoc = _polyGradientLocations.modelViewMatrix;
+		GLint positionLoc = _polyGradientLocations.position;
+		GLint texcoordLoc = _polyGradientLocations.texcoord;
+		GLint alphaLoc = _polyGradientLocations.alpha;
+
+		GLint gradientLoc = _polyGradientLocations.gradient;
+		GLint radiusLoc = _polyGradientLocations.radius;
+		GLint angleLoc = _polyGradientLocations.angle;
+		GLint originLoc = _polyGradientLocations.origin;
+		GLint fringeLoc = _polyGradientLocations.fringe;
+
+		glUniformMatrix4fv(pmLoc, 1, GL_FALSE, _orthoMatrix);
+		glUniformMatrix4fv(mvmLoc, 1, GL_FALSE, _renderModelMatrix);
+
+		glActiveTexture(GL_TEXTURE0);
+		bindTexture(gradientTexture(_batchGradient));
+		glUniform1i(gradientLoc, 0);
+
+		glUniform1f(radiusLoc, _batchGradient->radius);
+		glUniform1f(angleLoc, _batchGradient->angle);
+		glUniform2f(originLoc, _batchGradient->originU, _batchGradient->originV);
+		glUniform1f(fringeLoc, fringed ? 1.0 : 0.0);
+
+		useVertexAttribArrays(attribBit(positionLoc) | attribBit(texcoordLoc) | (fringed ? attribBit(alphaLoc) : 0));
+
+		_renderStream->reserve(fringed ? coordBytes * 2 + coordBytes / 2 : coordBytes * 2, indexBytes);
+
+		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(batch->vertexCoords(), coordBytes));
+		glVertexAttribPointer(texcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(batch->textureCoords(), coordBytes));
+
+		if (fringed) {
+			glVertexAttribPointer(alphaLoc, 1, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(batch->vertexAlphas(), coordBytes / 2));
+		} else {
+			glVertexAttrib1f(alphaLoc, 1.0);
+		}
+
+		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, _renderStream->writeIndices(batch->indices(), indexBytes));
+	} else {
+	    useProgram(_polyColorRenderingProgram);
+
+	    GLint pmLoc = _polyColorLocations.projectionMatrix;
+	    GLint mvmLoc = _polyColorLocations.modelViewMatrix;
+		GLint colorLoc = _polyColorLocations.color;
+		GLint positionLoc = _polyColorLocations.position;
+		GLint alphaLoc = _polyColorLocations.alpha;
+
+		glUniformMatrix4fv(pmLoc, 1, GL_FALSE, _orthoMatrix);
+		glUniformMatrix4fv(mvmLoc, 1, GL_FALSE, _renderModelMatrix);
+		glUniform4f(colorLoc, _batchColor.red, _batchColor.green, _batchColor.blue, fringed ? 1.0 : _batchColor.alpha);
+
+		useVertexAttribArrays(attribBit(positionLoc) | (fringed ? attribBit(alphaLoc) : 0));
+
+		_renderStream->reserve(fringed ? coordBytes + coordBytes / 2 : coordBytes, indexBytes);
+
+		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(batch->vertexCoords(), coordBytes));
+
+		if (fringed) {
+			glVertexAttribPointer(alphaLoc, 1, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(batch->vertexAlphas(), coordBytes / 2));
+		} else {
+			glVertexAttrib1f(alphaLoc, 1.0);
 		}
+
+		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, _renderStream->writeIndices(batch->indices(), indexBytes));
 	}
 
-	memset(_renderModelMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_renderModelMatrix[i * 4 + j] += _transformMatrix[i * 4 + k] * _scaleMatrix[k * 4 + j];
-			}
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+
+	_drawCalls++;
+
+	batch->reset();
+}
+
+// Grows the text quad arrays to hold at least the given number of characters.
+void Graphics2D::reserveRenderCoords(int characters)
+{
+	if (characters <= _renderCoordsCapacity) {
+		return;
+	}
+
+	int capacity = _renderCoordsCapacity > 0 ? _renderCoordsCapacity : characters;
+	while (capacity < characters) {
+		capacity *= 2;
+	}
+
+	if (_renderVertexIndices) {
+		delete [] _renderVertexIndices;
+		delete [] _renderVertexCoords;
+		delete [] _renderTextureCoords;
+		delete [] _renderMaskTextureCoords;
+	}
+
+	_renderVertexIndices = new GLuint[capacity * 6];
+	_renderVertexCoords = new GLfloat[capacity * 8];
+	_renderTextureCoords = new GLfloat[capacity * 8];
+	_renderMaskTextureCoords = new GLfloat[capacity * 8];
+	_renderCoordsCapacity = capacity;
+}
+
+// Marks the pixels covered by outlines in the stencil buffer by their fill rule, then draws their covering quad over the marked pixels.
+void Graphics2D::renderFillStencil(RenderCommandHeader* command)
+{
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
+
+	int fillRule = ints[0];
+	int outlineCount = ints[1];
+	int pointCount = ints[2];
+	int* outlinePoints = ints + 3;
+	GLfloat* cover = floats + pointCount * 2;
+
+	static const GLushort coverIndices[6] = { 0, 1, 2, 0, 2, 3 };
+
+	// whatever is batched so far has to be drawn underneath
+	flushBatch();
+
+	int pointBytes = pointCount * 2 * sizeof(GLfloat);
+	_renderStream->reserve(pointBytes, 0);
+	const GLvoid* points = _renderStream->writeVertices(floats, pointBytes);
+
+	glEnable(GL_STENCIL_TEST);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glStencilFunc(GL_ALWAYS, 0, 0xff);
+
+#ifdef GLES1
+	setTexturing(false);
+	useClientArrays(CLIENT_VERTEX_ARRAY);
+
+	glVertexPointer(2, GL_FLOAT, 0, points);
+
+	if (fillRule == FILL_RULE_EVENODD) {
+		glDisable(GL_CULL_FACE);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+
+		for(int outline = 0, first = 0; outline < outlineCount; first += outlinePoints[outline++]) {
+			glDrawArrays(GL_TRIANGLE_FAN, first, outlinePoints[outline]);
 		}
+
+		glEnable(GL_CULL_FACE);
+	} else {
+		// there are no wrapping counters, so the counter clockwise fans count up before the clockwise ones count down
+		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+
+		for(int outline = 0, first = 0; outline < outlineCount; first += outlinePoints[outline++]) {
+			glDrawArrays(GL_TRIANGLE_FAN, first, outlinePoints[outline]);
+		}
+
+		glCullFace(GL_FRONT);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_DECR);
+
+		for(int outline = 0, first = 0; outline < outlineCount; first += outlinePoints[outline++]) {
+			glDrawArrays(GL_TRIANGLE_FAN, first, outlinePoints[outline]);
+		}
+
+		glCullFace(GL_BACK);
+	}
+
+#elif defined(GLES2)
+    useProgram(_polyColorRenderingProgram);
+
+    GLint pmLoc = _polyColorLocations.projectionMatrix;
+    GLint mvmLoc = _polyColorLocations.modelViewMatrix;
+	GLint positionLoc = _polyColorLocations.position;
+
+	glUniformMatrix4fv(pmLoc, 1, GL_FALSE, _orthoMatrix);
+	glUniformMatrix4fv(mvmLoc, 1, GL_FALSE, _renderModelMatrix);
+
+	useVertexAttribArrays(attribBit(positionLoc));
+	glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, points);
+
+	// both windings are drawn in one go, counting up for counter clockwise fans and down for clockwise ones
+	glDisable(GL_CULL_FACE);
+
+	if (fillRule == FILL_RULE_EVENODD) {
+		glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+	} else {
+		glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+		glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+	}
+
+	for(int outline = 0, first = 0; outline < outlineCount; first += outlinePoints[outline++]) {
+		glDrawArrays(GL_TRIANGLE_FAN, first, outlinePoints[outline]);
 	}
 
+	glEnable(GL_CULL_FACE);
+
 #else
 #error libviews should be compiled with either GLES1 or GLES2 -D flags.
 #endif
+
+	_drawCalls += outlineCount;
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	// cover the marked pixels, clearing the marks for the next stencil fill
+	glStencilFunc(GL_NOTEQUAL, 0, 0xff);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+
+	_batchColor = _renderForegroundColor;
+	_batchGradient = _renderGradient;
+
+	_renderBatch->addMesh(cover, cover + 8, NULL, 4, coverIndices, 6);
+	flushBatch();
+
+	glDisable(GL_STENCIL_TEST);
 }
 
-// Overwrites the Transform in the Graphics2D context.
-void Graphics2D::renderTransform(int commandCount)
-{
-	//qDebug()  << "Graphics2D::renderShear: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1];
-	GLfloat transformMatrix[16];
+// Draws copies of a mesh with one instanced draw, or with their vertices expanded into one array draw where there is no instancing.
+void Graphics2D::renderDrawInstances(RenderCommandHeader* command)
+{
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
+
+	int meshVertexCount = ints[0];
+	int instanceCount = ints[1];
+	GLfloat* mesh = floats;
+	GLfloat* instances = floats + meshVertexCount * 2;
+
+	setBlending(false);
+
+#ifdef GLES1
+	// there are no shaders, so every vertex of every copy is placed and colored here
+	int vertexCount = meshVertexCount * instanceCount;
+	GLfloat* coords = instanceCoords(vertexCount * 6);
+	GLfloat* colors = coords + vertexCount * 2;
+
+	for(int instance = 0, index = 0; instance < instanceCount; instance++) {
+		GLfloat* values = instances + instance * INSTANCE_FLOATS;
+
+		for(int vertex = 0; vertex < meshVertexCount; vertex++, index++) {
+			coords[index*2+0] = values[0] + values[2] * mesh[vertex*2+0];
+			coords[index*2+1] = values[1] + values[2] * mesh[vertex*2+1];
+			memcpy(colors + index * 4, values + 3, 4 * sizeof(GLfloat));
+		}
+	}
+
+	setTexturing(false);
+	useClientArrays(CLIENT_VERTEX_ARRAY | CLIENT_COLOR_ARRAY);
+
+	_renderStream->reserve(vertexCount * 6 * sizeof(GLfloat), 0);
+
+	glVertexPointer(2, GL_FLOAT, 0, _renderStream->writeVertices(coords, vertexCount * 2 * sizeof(GLfloat)));
+	glColorPointer(4, GL_FLOAT, 0, _renderStream->writeVertices(colors, vertexCount * 4 * sizeof(GLfloat)));
+
+	glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+
+#elif defined(GLES2)
+	useProgram(_instanceRenderingProgram);
+
+	GLint pmLoc = _instanceLocations.projectionMatrix;
+	GLint mvmLoc = _instanceLocations.modelViewMatrix;
+	GLint positionLoc = _instanceLocations.position;
+	GLint instanceLoc = _instanceLocations.instance;
+	GLint instanceColorLoc = _instanceLocations.instanceColor;
+
+	glUniformMatrix4fv(pmLoc, 1, GL_FALSE, _orthoMatrix);
+	glUniformMatrix4fv(mvmLoc, 1, GL_FALSE, _renderModelMatrix);
+
+	useVertexAttribArrays(attribBit(positionLoc) | attribBit(instanceLoc) | attribBit(instanceColorLoc));
+
+	int meshBytes = meshVertexCount * 2 * sizeof(GLfloat);
+
+#ifdef GLES3
+	int instanceBytes = instanceCount * INSTANCE_FLOATS * sizeof(GLfloat);
+
+	// the mesh is read for every copy, the instance values once per copy
+	_renderStream->reserve(meshBytes + instanceBytes, 0);
+
+	const GLvoid* meshOffset = _renderStream->writeVertices(mesh, meshBytes);
+	const GLubyte* valuesOffset = (const GLubyte*)_renderStream->writeVertices(instances, instanceBytes);
+
+	glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, meshOffset);
+	glVertexAttribPointer(instanceLoc, 3, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(GLfloat), valuesOffset);
+	glVertexAttribPointer(instanceColorLoc, 4, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(GLfloat), valuesOffset + 3 * sizeof(GLfloat));
 
-	transformMatrix[ 0]  = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	transformMatrix[ 1]  = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
-	transformMatrix[ 2]  = 0.0;
-	transformMatrix[ 3]  = _drawFloats[_drawFloatIndices[commandCount*2+0]+2];
-	transformMatrix[ 4]  = _drawFloats[_drawFloatIndices[commandCount*2+0]+3];
-	transformMatrix[ 5]  = _drawFloats[_drawFloatIndices[commandCount*2+0]+4];
-	transformMatrix[ 6]  = 0.0;
-	transformMatrix[ 7]  = _drawFloats[_drawFloatIndices[commandCount*2+0]+5];
-	transformMatrix[ 8]  = 0.0;
-	transformMatrix[ 9]  = 0.0;
-	transformMatrix[10]  = 1.0;
-	transformMatrix[11]  = 0.0;
-	transformMatrix[12]  = _drawFloats[_drawFloatIndices[commandCount*2+0]+6];
-	transformMatrix[13]  = _drawFloats[_drawFloatIndices[commandCount*2+0]+7];
-	transformMatrix[14]  = 0.0;
-	transformMatrix[15]  = _drawFloats[_drawFloatIndices[commandCount*2+0]+8];
+	glVertexAttribDivisor(instanceLoc, 1);
+	glVertexAttribDivisor(instanceColorLoc, 1);
 
-#ifdef GLES1
-    glMatrixMode(GL_MODELVIEW);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, meshVertexCount, instanceCount);
 
-    glLoadIdentity();
+	// divisors stay with the attribute locations, which the other programs use too
+	glVertexAttribDivisor(instanceLoc, 0);
+	glVertexAttribDivisor(instanceColorLoc, 0);
+#else
+	// without instancing the mesh and the instance values are repeated for every vertex of every copy, and drawn at once
+	int vertexCount = meshVertexCount * instanceCount;
+	GLfloat* coords = instanceCoords(vertexCount * (2 + INSTANCE_FLOATS));
+	GLfloat* values = coords + vertexCount * 2;
 
-	glMultMatrixf(transformMatrix);
-#elif defined(GLES2)
-	memcpy(transformMatrix, _transformMatrix, sizeof(GLfloat) * 4 * 4);
+	for(int instance = 0, index = 0; instance < instanceCount; instance++) {
+		memcpy(coords + instance * meshVertexCount * 2, mesh, meshBytes);
 
-	int i, j, k;
-	memset(_renderModelMatrix, 0, sizeof(GLfloat) * 4 * 4);
-	for(i = 0; i < 4; i++) {
-		for(j = 0; j < 4; j++) {
-			for(k = 0; k < 4; k++) {
-				_renderModelMatrix[i * 4 + j] += transformMatrix[i * 4 + k] * _scaleMatrix[k * 4 + j];
-			}
+		for(int vertex = 0; vertex < meshVertexCount; vertex++, index++) {
+			memcpy(values + index * INSTANCE_FLOATS, instances + instance * INSTANCE_FLOATS, INSTANCE_FLOATS * sizeof(GLfloat));
 		}
 	}
+
+	_renderStream->reserve(vertexCount * (2 + INSTANCE_FLOATS) * sizeof(GLfloat), 0);
+
+	const GLvoid* coordsOffset = _renderStream->writeVertices(coords, vertexCount * 2 * sizeof(GLfloat));
+	const GLubyte* valuesOffset = (const GLubyte*)_renderStream->writeVertices(values, vertexCount * INSTANCE_FLOATS * sizeof(GLfloat));
+
+	glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, coordsOffset);
+	glVertexAttribPointer(instanceLoc, 3, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(GLfloat), valuesOffset);
+	glVertexAttribPointer(instanceColorLoc, 4, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(GLfloat), valuesOffset + 3 * sizeof(GLfloat));
+
+	glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+#endif
+
 #else
 #error libviews should be compiled with either GLES1 or GLES2 -D flags.
 #endif
-}
-
-// Sets the background color for the Graphics2D context.
-void Graphics2D::renderSetBackground(int commandCount)
-{
-	//qDebug()  << "Graphics2D::renderSetBackground: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1];
 
-	_renderBackgroundColor.red   = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	_renderBackgroundColor.green = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
-	_renderBackgroundColor.blue  = _drawFloats[_drawFloatIndices[commandCount*2+0]+2];
-	_renderBackgroundColor.alpha = _drawFloats[_drawFloatIndices[commandCount*2+0]+3];
+	_drawCalls++;
 }
 
-// Sets this graphics context's current color to the specified color.
-void Graphics2D::renderSetColor(int commandCount)
+// Returns scratch space for count floats of expanded instance vertices, reused from one draw to the next.
+GLfloat* Graphics2D::instanceCoords(int count)
 {
-	//qDebug()  << "Graphics2D::renderSetColor: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1];
+	if (count > _instanceCapacity) {
+		int capacity = _instanceCapacity > 0 ? _instanceCapacity : 1024;
+		while (capacity < count) {
+			capacity *= 2;
+		}
+
+		if (_instanceCoords) {
+			delete [] _instanceCoords;
+		}
 
-	_renderForegroundColor.red   = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	_renderForegroundColor.green = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
-	_renderForegroundColor.blue  = _drawFloats[_drawFloatIndices[commandCount*2+0]+2];
-	_renderForegroundColor.alpha = _drawFloats[_drawFloatIndices[commandCount*2+0]+3];
+		_instanceCoords = new GLfloat[capacity];
+		_instanceCapacity = capacity;
+	}
 
-	_renderGradient = NULL;
+	return _instanceCoords;
 }
 
-// Sets this graphics context's current color to the specified color.
-void Graphics2D::renderSetFont(int commandCount)
+// returns how much a transform stretches lengths at most, which is its larger singular value
+static GLfloat affineScale(const GLfloat* affine)
 {
-	//qDebug()  << "Graphics2D::renderSetFont: " << commandCount << " : " << _drawPointerIndices[commandCount*2+0] << " " << _drawPointerIndices[commandCount*2+1];
+	GLfloat sum = affine[0] * affine[0] + affine[1] * affine[1] + affine[2] * affine[2] + affine[3] * affine[3];
+	GLfloat determinant = affine[0] * affine[3] - affine[1] * affine[2];
+	GLfloat difference = sum * sum - 4.0 * determinant * determinant;
 
-	_renderFont = (Font*)_drawPointers[_drawPointerIndices[commandCount*2+0]+0];
+	return sqrt((sum + sqrt(difference > 0.0 ? difference : 0.0)) / 2.0);
 }
 
-// Sets this graphics context's current color to the specified color.
-void Graphics2D::renderSetGradient(int commandCount)
+// Copies a list of commands, replacing lines, polylines, arcs, round rectangles, polygons and paths with the triangle meshes they are drawn with.
+void Graphics2D::tessellateCommands(CommandBuffer* commands, CommandBuffer* tessellated)
 {
-	//qDebug()  << "Graphics2D::renderSetGradient: " << commandCount << " : " << _drawPointerIndices[commandCount*2+0] << " " << _drawPointerIndices[commandCount*2+1];
+	CommandCursor cursor;
+	RenderCommandHeader* command;
 
-	_renderGradient = (Gradient*)_drawPointers[_drawPointerIndices[commandCount*2+0]+0];
-}
+	// the transform decides how finely curves need to be cut to look smooth on screen
+	GLfloat affine[6] = { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
 
-// Sets this graphics context's image texture to the specified image texture.
-void Graphics2D::renderSetImageTexture(int commandCount)
-{
-	//qDebug()  << "Graphics2D::renderSetImageTexture: " << commandCount << " : " << _drawPointerIndices[commandCount*2+0] << " " << _drawPointerIndices[commandCount*2+1];
+	// strokes and transforms brought back by a restore
+	Stroke* savedStrokes[MAX_RENDER_STATES];
+	GLfloat savedAffines[MAX_RENDER_STATES][6];
+	int saveCount = 0;
+
+	tessellated->reset();
+
+	_tessellateStroke = _defaultStroke;
+	_tessellateTolerance = _curveTolerance;
+	_tessellateFringe = _antialiasing ? 1.0 : 0.0;
+	_tessellateSimplify = _polylineTolerance;
+	_removedVertexCount = 0;
+	_tessellateMesh->reset();
+
+	commands->begin(&cursor);
+	while((command = commands->next(&cursor)) != NULL) {
+		GLfloat* floats = commandFloats(command);
+		GLfloat transform[6] = { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+		bool transformed = true;
+
+		switch(command->command) {
+		case RENDER_TRANSFORM_ROTATE:
+			transform[0] = cosf(floats[0] * M_PI / 180.0);
+			transform[1] = sinf(floats[0] * M_PI / 180.0);
+			transform[2] = -transform[1];
+			transform[3] = transform[0];
+			concatenateAffine(affine, transform);
+			break;
+		case RENDER_TRANSFORM_SCALE:
+			transform[0] = floats[0];
+			transform[3] = floats[1];
+			concatenateAffine(affine, transform);
+			break;
+		case RENDER_TRANSFORM_SHEAR:
+			transform[1] = floats[1];
+			transform[2] = floats[0];
+#ifdef GLES1
+			// replaces the model view matrix
+			memcpy(affine, transform, sizeof(transform));
+#elif defined(GLES2)
+			concatenateAffine(affine, transform);
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+			break;
+#ifdef GLES1
+		case RENDER_TRANSFORM:
+			// replaces the model view matrix
+			affine[0] = floats[0];
+			affine[1] = floats[1];
+			affine[2] = floats[3];
+			affine[3] = floats[4];
+			affine[4] = floats[6];
+			affine[5] = floats[7];
+			break;
+		case RENDER_CLIP_RECT:
+		case RENDER_CLEAR_RECT:
+			// setting up the view resets the model view matrix
+			memcpy(affine, transform, sizeof(transform));
+			break;
+#endif
+		case RENDER_RESTORE_STATE:
+			if (saveCount > 0 && saveCount <= MAX_RENDER_STATES) {
+				memcpy(affine, savedAffines[saveCount - 1], sizeof(affine));
+			}
+			break;
+		default:
+			transformed = false;
+			break;
+		}
+
+		if (transformed) {
+			GLfloat scale = affineScale(affine);
+			_tessellateTolerance = scale > 0.0 ? _curveTolerance / scale : _curveTolerance;
 
-	_renderImageTexture = (ImageTexture*)_drawPointers[_drawPointerIndices[commandCount*2+0]+0];
+			// a pixel on screen, in the same coordinates
+			if (_antialiasing) {
+				_tessellateFringe = scale > 0.0 ? 1.0 / scale : 1.0;
+			}
+			_tessellateSimplify = scale > 0.0 ? _polylineTolerance / scale : _polylineTolerance;
+		}
+
+		switch(command->command) {
+		case RENDER_SKIP:
+			break;
+		case RENDER_DRAW_LINE:
+			tessellateLine(command, tessellated);
+			emitMesh(tessellated);
+			break;
+		case RENDER_DRAW_POLYLINE:
+			tessellatePolyline(command, tessellated);
+			emitMesh(tessellated);
+			break;
+		case RENDER_DRAW_ARC:
+		case RENDER_FILL_ARC:
+		case RENDER_DRAW_ROUNDRECT:
+		case RENDER_FILL_ROUNDRECT:
+			tessellateCached(command, tessellated);
+			break;
+		case RENDER_FILL_POLYGON:
+			tessellatePolygon(command, tessellated);
+			emitMesh(tessellated);
+			break;
+		case RENDER_DRAW_PATH:
+		case RENDER_FILL_PATH:
+			tessellatePath(command, tessellated);
+			break;
+		case RENDER_SET_STROKE:
+			_tessellateStroke = (Stroke*)commandPointers(command)[0];
+			tessellated->appendCopy(command);
+			break;
+		case RENDER_SAVE_STATE:
+			if (saveCount < MAX_RENDER_STATES) {
+				savedStrokes[saveCount] = _tessellateStroke;
+				memcpy(savedAffines[saveCount], affine, sizeof(affine));
+			}
+			saveCount++;
+			tessellated->appendCopy(command);
+			break;
+		case RENDER_RESTORE_STATE:
+			if (saveCount > 0) {
+				saveCount--;
+				if (saveCount < MAX_RENDER_STATES) {
+					_tessellateStroke = savedStrokes[saveCount];
+				}
+			}
+			tessellated->appendCopy(command);
+			break;
+		default:
+			tessellated->appendCopy(command);
+			break;
+		}
+	}
 }
 
-// Sets this graphics context's current color to the specified color.
-void Graphics2D::renderSetStroke(int commandCount)
+// Tessellates the captured commands of a display list into the meshes it is replayed with.
+void Graphics2D::bakeDisplayList(DisplayList* displayList)
 {
-	//qDebug()  << "Graphics2D::renderSetStroke: " << commandCount << " : " << _drawPointerIndices[commandCount*2+0] << " " << _drawPointerIndices[commandCount*2+1];
+	// the tessellation scratch and mesh cache are shared with done()
+	_drawMutex.lock();
 
-	_renderStroke = (Stroke*)_drawPointers[_drawPointerIndices[commandCount*2+0]+0];
+	tessellateCommands(displayList->commands(), displayList->bakedCommands());
+
+	_drawMutex.unlock();
 }
 
-// Clears the specified rectangle by filling it with the background color of the current drawing surface.
-void Graphics2D::renderClearRect(int commandCount)
+// Adds quads or triangles to the mesh being tessellated, appending the mesh first if they would not fit.
+void Graphics2D::tessellateTriangles(CommandBuffer* tessellated, int renderCount, int renderPoints)
 {
-	//qDebug()  << "Graphics2D::renderClearRect: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1] << " " << _drawFloatIndices[commandCount*2+2] << " " << _drawFloatIndices[commandCount*2+3];
+	if (renderCount <= 0) {
+		return;
+	}
 
-	setupView(_drawInts[_drawIntIndices[commandCount*2+0]+0], _drawInts[_drawIntIndices[commandCount*2+0]+1], _drawInts[_drawIntIndices[commandCount*2+0]+2], _drawInts[_drawIntIndices[commandCount*2+0]+3]);
+	if (!_tessellateMesh->hasRoomFor(renderCount * renderPoints)) {
+		emitMesh(tessellated);
+	}
 
-	glClearColor(_renderBackgroundColor.red, _renderBackgroundColor.green, _renderBackgroundColor.blue, _renderBackgroundColor.alpha);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	_tessellateMesh->addStrips(_tessellateVertexCoords, _tessellateTextureCoords, renderCount, renderPoints);
 }
 
-// Intersects the current clip with the specified rectangle.
-void Graphics2D::renderClipRect(int commandCount)
+// appends a batch as a mesh command, with the coverage of each vertex after the texture coordinates if some are only partly covered
+static void appendMesh(CommandBuffer* commands, VertexBatch* mesh)
 {
-	//qDebug()  << "Graphics2D::renderClipRect: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1] << " " << _drawFloatIndices[commandCount*2+2] << " " << _drawFloatIndices[commandCount*2+3];
+	int vertexCount = mesh->vertexCount();
+	int indexCount = mesh->indexCount();
+	bool alphas = mesh->hasAlphas();
+
+	// indices are packed two to an int after the counts
+	RenderCommandHeader* command = commands->append(RENDER_DRAW_MESH, 0, vertexCount * (alphas ? 5 : 4), 2 + (indexCount + 1) / 2);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
+
+	memcpy(floats, mesh->vertexCoords(), sizeof(GLfloat) * vertexCount * 2);
+	memcpy(floats + vertexCount * 2, mesh->textureCoords(), sizeof(GLfloat) * vertexCount * 2);
+	if (alphas) {
+		memcpy(floats + vertexCount * 4, mesh->vertexAlphas(), sizeof(GLfloat) * vertexCount);
+	}
 
-	setupView(_drawInts[_drawIntIndices[commandCount*2+0]+0], _drawInts[_drawIntIndices[commandCount*2+0]+1], _drawInts[_drawIntIndices[commandCount*2+0]+2], _drawInts[_drawIntIndices[commandCount*2+0]+3]);
+	ints[0] = vertexCount;
+	ints[1] = indexCount;
+	ints[command->intCount - 1] = 0;
+	memcpy(ints + 2, mesh->indices(), sizeof(GLushort) * indexCount);
 }
 
-// Render a line, using the current color, between the points (x1, y1) and (x2, y2) in this graphics context's coordinate system.
-void Graphics2D::renderDrawLine(int commandCount)
+// Appends the mesh being tessellated as a draw command, followed by its edge fringe when antialiasing, and starts a new one.
+void Graphics2D::emitMesh(CommandBuffer* tessellated)
 {
-	//qDebug()  << "Graphics2D::renderDrawLine: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1] << " " << _drawFloatIndices[commandCount*2+2] << " " << _drawFloatIndices[commandCount*2+3];
+	if (_tessellateMesh->isEmpty()) {
+		return;
+	}
 
-	GLfloat dx, dy, length, x1, y1, x2, y2;
+	appendMesh(tessellated, _tessellateMesh);
 
-	x1 = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	y1 = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
-	x2 = _drawFloats[_drawFloatIndices[commandCount*2+0]+2];
-	y2 = _drawFloats[_drawFloatIndices[commandCount*2+0]+3];
+	if (_tessellateFringe > 0.0) {
+		emitFringe(tessellated);
+	}
 
-	dx = ((GLfloat)x2 - (GLfloat)x1);
-	dy = ((GLfloat)y2 - (GLfloat)y1);
-	length = sqrt (fabs(dx * dx) + fabs(dy * dy));
+	_tessellateMesh->reset();
+}
 
-	float* dashCoords = NULL;
-	int   dashPoints = 0;
+// orders vertex indices by where their vertices are, so that vertices in the same place end up next to each other
+class VertexPlaceLessThan {
+public:
+	VertexPlaceLessThan(const GLfloat* coords) : _coords(coords) {}
 
-	//qDebug()  << "Graphics2D::renderDrawLine: " << length;
+	bool operator()(int first, int second) const
+	{
+		if (_coords[first*2+0] != _coords[second*2+0]) {
+			return _coords[first*2+0] < _coords[second*2+0];
+		}
+		if (_coords[first*2+1] != _coords[second*2+1]) {
+			return _coords[first*2+1] < _coords[second*2+1];
+		}
+		return first < second;
+	}
 
-	if (_renderStroke->dashCount > 1) {
+protected:
+	const GLfloat* _coords;
+};
 
-		int dashIndex = -1;
-		float currentLength = 0.0;
-		if (_renderStroke->dashPhase != 0.0) {
-			currentLength = -_renderStroke->dashPhase;
-		}
+// Appends a band as wide as the current fringe around the outside edges of the mesh being tessellated, fading from covered to clear, as meshes of their own.
+void Graphics2D::emitFringe(CommandBuffer* tessellated)
+{
+	int vertexCount = _tessellateMesh->vertexCount();
+	int indexCount = _tessellateMesh->indexCount();
+	const GLfloat* coords = _tessellateMesh->vertexCoords();
+	const GLfloat* textureCoords = _tessellateMesh->textureCoords();
+	const GLushort* indices = _tessellateMesh->indices();
+
+	int* order = fringeVertices(vertexCount * 3);
+	int* welded = order + vertexCount;
+	int* normalCounts = welded + vertexCount;
+	GLfloat* normals = fringeNormals(vertexCount * 2);
+	quint64* edges = fringeEdges(indexCount * 2);
+
+	// outlines often add the same point more than once, so vertices in the same place count as the first of them when matching up edges
+	for(int index = 0; index < vertexCount; index++) {
+		order[index] = index;
+	}
+	qSort(order, order + vertexCount, VertexPlaceLessThan(coords));
 
-		do {
-			if (dashIndex >= 0) {
-				currentLength += _renderStroke->dash[dashIndex];
-				if (currentLength > length) {
-					currentLength = length;
+	for(int index = 0; index < vertexCount; index++) {
+		int vertex = order[index];
+		int previous = index > 0 ? order[index - 1] : -1;
 
-					if (dashPoints == 0 && (dashIndex % 2 == 0)) {
-						dashPoints++;
-					}
-					continue;
-				}
-			}
+		if (previous >= 0 && coords[vertex*2+0] == coords[previous*2+0] && coords[vertex*2+1] == coords[previous*2+1]) {
+			welded[vertex] = welded[previous];
+		} else {
+			welded[vertex] = vertex;
+		}
 
-			if (dashPoints == 0 && currentLength == 0.0) {
-				dashPoints++;
-			}
+		normals[vertex*2+0] = 0.0;
+		normals[vertex*2+1] = 0.0;
+		normalCounts[vertex] = 0;
+	}
 
-			if (currentLength > 0.0) {
-				dashPoints++;
-			}
+	// every triangle runs counter clockwise, so an edge is on the outside when no triangle runs back along it
+	int edgeCount = 0;
 
-			//qDebug()  << "Graphics2D::renderDrawLine: calculate array size " << currentLength << " " << dashIndex << " " << dashPoints;
+	for(int index = 0; index + 2 < indexCount; index += 3) {
+		for(int corner = 0; corner < 3; corner++) {
+			quint64 from = welded[indices[index + corner]];
+			quint64 to = welded[indices[index + (corner + 1) % 3]];
 
-			dashIndex++;
-			if (dashIndex == _renderStroke->dashCount) {
-				dashIndex = 0;
+			if (from != to) {
+				edges[edgeCount++] = (from << 32) | to;
 			}
+		}
+	}
 
-		} while (currentLength < length);
+	qSort(edges, edges + edgeCount);
 
-		if ((dashPoints % 2) == 1) {
-			dashPoints++;
-		}
+	// the outside edges go after the sorted ones
+	quint64* outside = edges + edgeCount;
+	int outsideCount = 0;
 
-		//qDebug()  << "Graphics2D::renderDrawLine: " << currentLength << " " << dashPoints;
+	for(int index = 0; index < edgeCount; index++) {
+		// triangles overlapping along the same edge count once
+		if (index > 0 && edges[index] == edges[index - 1]) {
+			continue;
+		}
 
-		dashCoords = new float[dashPoints*2];
+		int from = (int)(edges[index] >> 32);
+		int to = (int)(edges[index] & 0xffffffff);
 
-		dashIndex = -1;
-		currentLength = 0;
-		if (_renderStroke->dashPhase != 0.0) {
-			currentLength = -_renderStroke->dashPhase;
+		if (qBinaryFind(edges, edges + edgeCount, ((quint64)to << 32) | (quint64)from) != edges + edgeCount) {
+			continue;
 		}
-		//if (dashPhase != -100000.0) {
-		//	currentLength = -dashPhase;
-		//}
-		dashPoints = 0;
 
-		do {
-			if (dashIndex >= 0) {
-				currentLength += _renderStroke->dash[dashIndex];
-				if (currentLength > length) {
-					currentLength = length;
-
-					if (dashPoints == 0 && (dashIndex % 2 == 0)) {
-						dashCoords[0] = x1;
-						dashCoords[1] = y1;
-						dashPoints++;
-					}
-					continue;
-				}
-			}
+		GLfloat dx = coords[to*2+0] - coords[from*2+0];
+		GLfloat dy = coords[to*2+1] - coords[from*2+1];
+		GLfloat length = sqrt(dx * dx + dy * dy);
 
-			if (dashPoints == 0 && currentLength == 0.0) {
-				dashCoords[0] = x1;
-				dashCoords[1] = y1;
-				dashPoints++;
-			}
+		if (length <= 0.0) {
+			continue;
+		}
 
-			if (currentLength > 0.0) {
-				dashCoords[dashPoints*2+0] = x1 + currentLength * (x2 - x1) / length;
-				dashCoords[dashPoints*2+1] = y1 + currentLength * (y2 - y1) / length;
-				dashPoints++;
-			}
+		// the inside is on the left, so the outward normal is the right one
+		GLfloat nx = dy / length;
+		GLfloat ny = -dx / length;
 
-			dashIndex++;
-			if (dashIndex == _renderStroke->dashCount) {
-				dashIndex = 0;
-			}
+		normals[from*2+0] += nx;
+		normals[from*2+1] += ny;
+		normalCounts[from]++;
+		normals[to*2+0] += nx;
+		normals[to*2+1] += ny;
+		normalCounts[to]++;
 
-		} while (currentLength < length);
+		outside[outsideCount++] = edges[index];
+	}
 
-		if ((dashPoints % 2) == 1) {
-			dashCoords[dashPoints*2+0] = x2;
-			dashCoords[dashPoints*2+1] = y2;
-			dashPoints++;
+	if (outsideCount == 0) {
+		return;
+	}
+
+	// each outside vertex moves out along the miter of its edges, far enough to keep the fringe as wide as it should be along both, up to a limit for sharp corners - the normals become the offsets in place
+	for(int index = 0; index < vertexCount; index++) {
+		if (normalCounts[index] == 0) {
+			continue;
 		}
 
-	} else {
-		dashPoints = 2;
-		dashCoords = new float[dashPoints*2];
-		dashCoords[0] = x1;
-		dashCoords[1] = y1;
-		dashCoords[2] = x2;
-		dashCoords[3] = y2;
-	}
+		GLfloat nx = normals[index*2+0];
+		GLfloat ny = normals[index*2+1];
+		GLfloat squared = nx * nx + ny * ny;
 
-	int renderIndex = 0;
-	for(int index = 0; index < dashPoints; index += 2) {
-		if (fabs(dy) > fabs(dx)) {
-			_renderVertexCoords[renderIndex*4+0] = (GLfloat)dashCoords[index*2+2] - (dy * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+1] = (GLfloat)dashCoords[index*2+3] + (dx * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+2] = (GLfloat)dashCoords[index*2+0] - (dy * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+3] = (GLfloat)dashCoords[index*2+1] + (dx * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+4] = (GLfloat)dashCoords[index*2+2] + (dy * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+5] = (GLfloat)dashCoords[index*2+3] - (dx * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+6] = (GLfloat)dashCoords[index*2+0] + (dy * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+7] = (GLfloat)dashCoords[index*2+1] - (dx * _renderStroke->width / (2.0 * length));
-		} else {
-			_renderVertexCoords[renderIndex*4+0] = (GLfloat)dashCoords[index*2+0] + (dy * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+1] = (GLfloat)dashCoords[index*2+1] - (dx * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+2] = (GLfloat)dashCoords[index*2+2] + (dy * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+3] = (GLfloat)dashCoords[index*2+3] - (dx * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+4] = (GLfloat)dashCoords[index*2+0] - (dy * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+5] = (GLfloat)dashCoords[index*2+1] + (dx * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+6] = (GLfloat)dashCoords[index*2+2] - (dy * _renderStroke->width / (2.0 * length));
-			_renderVertexCoords[renderIndex*4+7] = (GLfloat)dashCoords[index*2+3] + (dx * _renderStroke->width / (2.0 * length));
+		// edges doubling straight back on themselves have no outside to move towards
+		if (squared < 1.0e-6) {
+			normals[index*2+0] = 0.0;
+			normals[index*2+1] = 0.0;
+			continue;
+		}
+
+		GLfloat scale = normalCounts[index] * _tessellateFringe / squared;
+		GLfloat reach = sqrt(squared) * scale;
+		if (reach > FRINGE_MITER_LIMIT * _tessellateFringe) {
+			scale *= FRINGE_MITER_LIMIT * _tessellateFringe / reach;
 		}
 
-		_renderTextureCoords[renderIndex*4+0] = (GLfloat)0.0;
-		_renderTextureCoords[renderIndex*4+1] = (GLfloat)1.0;
-		_renderTextureCoords[renderIndex*4+2] = (GLfloat)1.0;
-		_renderTextureCoords[renderIndex*4+3] = (GLfloat)1.0;
-		_renderTextureCoords[renderIndex*4+4] = (GLfloat)0.0;
-		_renderTextureCoords[renderIndex*4+5] = (GLfloat)0.0;
-		_renderTextureCoords[renderIndex*4+6] = (GLfloat)1.0;
-		_renderTextureCoords[renderIndex*4+7] = (GLfloat)0.0;
+		normals[index*2+0] = nx * scale;
+		normals[index*2+1] = ny * scale;
+	}
+
+	const GLfloat* offsets = normals;
 
-		renderIndex++;
+	// a quad per outside edge, covered along the edge and clear along its far side, so that the quads can be split across meshes wherever they fill up
+	_fringeMesh->reset();
 
-		if ((renderIndex*8 + 8) > MAX_VERTEX_COORDINATES) {
-			renderDrawTriangles(renderIndex, 4);
+	for(int index = 0; index < outsideCount; index++) {
+		int from = (int)(outside[index] >> 32);
+		int to = (int)(outside[index] & 0xffffffff);
 
-			renderIndex = 0;
+		if (!_fringeMesh->hasRoomFor(4)) {
+			appendMesh(tessellated, _fringeMesh);
+			_fringeMesh->reset();
 		}
-	}
 
-	renderDrawTriangles(renderIndex, 4);
+		int inFrom = _fringeMesh->addVertex(coords[from*2+0], coords[from*2+1], textureCoords[from*2+0], textureCoords[from*2+1], 1.0);
+		int inTo = _fringeMesh->addVertex(coords[to*2+0], coords[to*2+1], textureCoords[to*2+0], textureCoords[to*2+1], 1.0);
+		int outFrom = _fringeMesh->addVertex(coords[from*2+0] + offsets[from*2+0], coords[from*2+1] + offsets[from*2+1], textureCoords[from*2+0], textureCoords[from*2+1], 0.0);
+		int outTo = _fringeMesh->addVertex(coords[to*2+0] + offsets[to*2+0], coords[to*2+1] + offsets[to*2+1], textureCoords[to*2+0], textureCoords[to*2+1], 0.0);
 
-	if (dashCoords) {
-		delete dashCoords;
+		addStrokeTriangle(_fringeMesh, inFrom, outFrom, outTo);
+		addStrokeTriangle(_fringeMesh, inFrom, outTo, inTo);
 	}
 
-	//qDebug()  << "Graphics2D::renderDrawLine: " << _drawFloatIndices[commandCount*2+0]/2;
+	if (!_fringeMesh->isEmpty()) {
+		appendMesh(tessellated, _fringeMesh);
+	}
+	_fringeMesh->reset();
 }
 
-// Draws a sequence of connected lines defined by arrays of x and y coordinates.
-void Graphics2D::renderDrawPolyline(int commandCount)
+// Returns scratch space for count fringe vertex indices, reused from one call to the next.
+int* Graphics2D::fringeVertices(int count)
 {
-	//qDebug()  << "Graphics2D::renderDrawPolyline: " << commandCount;
+	if (count > _fringeVertexCapacity) {
+		int capacity = _fringeVertexCapacity > 0 ? _fringeVertexCapacity : 256;
+		while (capacity < count) {
+			capacity *= 2;
+		}
 
-	GLfloat dx, dy, dx1, dy1, length, lineLength, x1, y1, x2, y2, xl1, yl1, xl2, yl2;
+		if (_fringeVertices) {
+			delete [] _fringeVertices;
+		}
 
-	int numberPoints = _drawInts[_drawIntIndices[commandCount*2+0]+0];
+		_fringeVertices = new int[capacity];
+		_fringeVertexCapacity = capacity;
+	}
 
-	float* dashCoords = NULL;
-	int   dashPoints = 0;
+	return _fringeVertices;
+}
 
+// Returns scratch space for count fringe vertex normal coordinates, reused from one call to the next.
+GLfloat* Graphics2D::fringeNormals(int count)
+{
+	if (count > _fringeNormalCapacity) {
+		int capacity = _fringeNormalCapacity > 0 ? _fringeNormalCapacity : 256;
+		while (capacity < count) {
+			capacity *= 2;
+		}
 
-	if (_renderStroke->dashCount > 1) {
+		if (_fringeNormals) {
+			delete [] _fringeNormals;
+		}
 
-		length = 0;
-		for(int index = 0; index < (numberPoints-1); index++) {
-			x1 = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+0];
-			y1 = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+1];
-			x2 = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+2];
-			y2 = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+3];
+		_fringeNormals = new GLfloat[capacity];
+		_fringeNormalCapacity = capacity;
+	}
 
-			dx = ((GLfloat)x2 - (GLfloat)x1);
-			dy = ((GLfloat)y2 - (GLfloat)y1);
-			lineLength = sqrt (fabs(dx * dx) + fabs(dy * dy));
-			dx /= lineLength;
-			dy /= lineLength;
+	return _fringeNormals;
+}
 
-			length += lineLength;
+// Returns scratch space for count fringe edges, reused from one call to the next.
+quint64* Graphics2D::fringeEdges(int count)
+{
+	if (count > _fringeEdgeCapacity) {
+		int capacity = _fringeEdgeCapacity > 0 ? _fringeEdgeCapacity : 256;
+		while (capacity < count) {
+			capacity *= 2;
 		}
 
-
-		int dashIndex = -1;
-		float currentLength = 0.0;
-		if (_renderStroke->dashPhase != 0.0) {
-			currentLength = -_renderStroke->dashPhase;
+		if (_fringeEdges) {
+			delete [] _fringeEdges;
 		}
-		do {
-			if (dashIndex >= 0) {
-				currentLength += _renderStroke->dash[dashIndex];
-				if (currentLength > length) {
-					currentLength = length;
 
-					if (dashPoints == 0 && (dashIndex % 2 == 0)) {
-						dashPoints++;
-					}
-					continue;
-				}
-			}
-
-			if (dashPoints == 0 && currentLength == 0.0) {
-				dashPoints++;
-			}
+		_fringeEdges = new quint64[capacity];
+		_fringeEdgeCapacity = capacity;
+	}
 
-			if (currentLength > 0.0) {
-				dashPoints++;
-			}
+	return _fringeEdges;
+}
 
-			dashIndex++;
-			if (dashIndex == _renderStroke->dashCount) {
-				dashIndex = 0;
-			}
+// appends a copy of a mesh command with its vertices moved by x and y
+static void appendTranslatedMesh(CommandBuffer* commands, const RenderCommandHeader* mesh, GLfloat x, GLfloat y)
+{
+	RenderCommandHeader* copy = commands->appendCopy(mesh);
+	GLfloat* coords = commandFloats(copy);
+	GLfloat translation[6] = { 1.0, 0.0, 0.0, 1.0, x, y };
 
-		} while (currentLength < length);
+	transformPoints(translation, coords, commandInts(copy)[0], coords);
+}
 
-		if ((dashPoints % 2) == 1) {
-			dashPoints++;
-		}
+// Tessellates an arc or round rectangle at the origin, or reuses the cached meshes for the same shape and stroke, and appends them moved into place.
+void Graphics2D::tessellateCached(RenderCommandHeader* command, CommandBuffer* tessellated)
+{
+	GLfloat* floats = commandFloats(command);
+	GLfloat x = floats[0];
+	GLfloat y = floats[1];
+
+	// the shape is everything but its position, along with the tolerance and fringe it was drawn to, and the whole stroke is part of it since fills also look at the width
+	QByteArray key;
+	key.append((const char*)&command->command, sizeof(command->command));
+	key.append((const char*)(floats + 2), sizeof(GLfloat) * (command->floatCount - 2));
+	key.append((const char*)&_tessellateTolerance, sizeof(GLfloat));
+	key.append((const char*)&_tessellateFringe, sizeof(GLfloat));
+	key.append((const char*)&_tessellateStroke->width, sizeof(GLfloat));
+	key.append((const char*)&_tessellateStroke->cap, sizeof(int));
+	key.append((const char*)&_tessellateStroke->join, sizeof(int));
+	key.append((const char*)&_tessellateStroke->miterLimit, sizeof(GLfloat));
+	key.append((const char*)&_tessellateStroke->dashPhase, sizeof(GLfloat));
+	key.append((const char*)&_tessellateStroke->dashCount, sizeof(int));
+	if (_tessellateStroke->dashCount > 0) {
+		key.append((const char*)_tessellateStroke->dash, sizeof(GLfloat) * _tessellateStroke->dashCount);
+	}
 
-		dashCoords = new float[dashPoints*2];
+	QByteArray* meshes = _meshCache.object(key);
 
-		dashIndex = -1;
-		currentLength = 0;
-		if (_renderStroke->dashPhase != 0.0) {
-			currentLength = -_renderStroke->dashPhase;
-		}
-		dashPoints = 0;
+	if (meshes) {
+		_meshCacheHits++;
+	} else {
+		_meshCacheMisses++;
 
-		x1 = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-		y1 = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
-		x2 = _drawFloats[_drawFloatIndices[commandCount*2+0]+(numberPoints-1)*2+0];
-		y2 = _drawFloats[_drawFloatIndices[commandCount*2+0]+(numberPoints-1)*2+1];
+		_meshCacheCommands->reset();
 
-		do {
-			if (dashIndex >= 0) {
-				currentLength += _renderStroke->dash[dashIndex];
-				if (currentLength > length) {
-					currentLength = length;
-
-					if (dashPoints == 0 && (dashIndex % 2 == 0)) {
-						dashCoords[0] = x1;
-						dashCoords[1] = y1;
-						dashPoints++;
-					}
-					continue;
-				}
-			}
+		RenderCommandHeader* origin = _meshCacheCommands->appendCopy(command);
+		commandFloats(origin)[0] = 0.0;
+		commandFloats(origin)[1] = 0.0;
 
-			if (dashPoints == 0 && currentLength == 0.0) {
-				dashCoords[0] = x1;
-				dashCoords[1] = y1;
-				dashPoints++;
-			}
+		if (command->command == RENDER_DRAW_ARC || command->command == RENDER_FILL_ARC) {
+			tessellateArc(origin, _meshCacheCommands);
+		} else {
+			tessellateRoundRect(origin, _meshCacheCommands);
+		}
+		emitMesh(_meshCacheCommands);
 
-			if (currentLength > 0.0) {
-				float linesLength = 0;
-				for(int index = 0; index < (numberPoints-1); index++) {
-					xl1 = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+0];
-					yl1 = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+1];
-					xl2 = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+2];
-					yl2 = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+3];
-
-					dx = ((GLfloat)xl2 - (GLfloat)xl1);
-					dy = ((GLfloat)yl2 - (GLfloat)yl1);
-					lineLength = sqrt (fabs(dx * dx) + fabs(dy * dy));
-					dx /= lineLength;
-					dy /= lineLength;
-
-					if ((linesLength + lineLength) >= currentLength) {
-						break;
-					}
+		// keep the mesh records back to back, leaving out the origin command they were made from
+		meshes = new QByteArray();
 
-					linesLength += lineLength;
-				}
+		CommandCursor cursor;
+		RenderCommandHeader* mesh;
 
-				dashCoords[dashPoints*2+0] = xl1 + (currentLength - linesLength) * (xl2 - xl1) / lineLength;
-				dashCoords[dashPoints*2+1] = yl1 + (currentLength - linesLength) * (yl2 - yl1) / lineLength;
-				dashPoints++;
-			}
+		_meshCacheCommands->begin(&cursor);
+		_meshCacheCommands->next(&cursor);
+		while((mesh = _meshCacheCommands->next(&cursor)) != NULL) {
+			meshes->append((const char*)mesh, mesh->size);
+		}
 
-			dashIndex++;
-			if (dashIndex == _renderStroke->dashCount) {
-				dashIndex = 0;
+		if (!_meshCache.insert(key, meshes, meshes->size())) {
+			// too big to ever be cached - QCache has already deleted it, so move the scratch copy into place instead
+			_meshCacheCommands->begin(&cursor);
+			_meshCacheCommands->next(&cursor);
+			while((mesh = _meshCacheCommands->next(&cursor)) != NULL) {
+				appendTranslatedMesh(tessellated, mesh, x, y);
 			}
-
-		} while (currentLength < length);
-
-		if ((dashPoints % 2) == 1) {
-			dashCoords[dashPoints*2+0] = x2;
-			dashCoords[dashPoints*2+1] = y2;
-			dashPoints++;
+			return;
 		}
+	}
 
-	} else {
-		dashPoints = (numberPoints-1)*2;
-		dashCoords = new float[dashPoints*2];
+	int offset = 0;
+	while (offset < meshes->size()) {
+		const RenderCommandHeader* mesh = (const RenderCommandHeader*)(meshes->constData() + offset);
+		appendTranslatedMesh(tessellated, mesh, x, y);
+		offset += mesh->size;
+	}
+}
 
-		for(int index = 0; index < (numberPoints-1); index++) {
-			dashCoords[index*4+0] = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+0];
-			dashCoords[index*4+1] = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+1];
-			dashCoords[index*4+2] = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+2];
-			dashCoords[index*4+3] = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+3];
+// appends the outlines of a flattened path and the quad covering them, to be filled through the stencil buffer
+static void appendStencilFill(CommandBuffer* commands, Path2D* path, int subpathCount, int pointCount, const GLfloat* bounds)
+{
+	RenderCommandHeader* command = commands->append(RENDER_FILL_STENCIL, 0, pointCount * 2 + 16, 3 + subpathCount);
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
+	const GLfloat* points;
+	int count;
+
+	// turning every outline round leaves either rule filling the same pixels, and without wrapping stencil counters only
+	// windings above zero are counted, so the path is turned to wind counter clockwise around most of its area
+	GLfloat area = 0.0;
+	for(int subpath = 0; subpath < subpathCount; subpath++) {
+		points = path->subpath(subpath, &count);
+		for(int index = 0; index < count; index++) {
+			int following = (index + 1) % count;
+			area += points[index*2+0] * points[following*2+1] - points[following*2+0] * points[index*2+1];
 		}
 	}
 
-	int renderIndex = 0;
-	double xPoints[4], yPoints[4], uPoints[4], vPoints[4];
-
+	bool reverse = area < 0.0;
 
-	// calculate u,v texture bounds
-	float x = 0.0, y = 0.0, minX = 1.0e6, minY = 1.0e6, maxX = -1.0e6, maxY = -1.0e6;
+	ints[0] = path->fillRule();
+	ints[1] = subpathCount;
+	ints[2] = pointCount;
 
-	for(int index = 0; index < dashPoints-1; index += 2) {
-		dx = ((GLfloat)dashCoords[index*2+2] - (GLfloat)dashCoords[index*2+0]);
-		dy = ((GLfloat)dashCoords[index*2+3] - (GLfloat)dashCoords[index*2+1]);
-		lineLength = sqrt (fabs(dx * dx) + fabs(dy * dy));
-		dx /= lineLength;
-		dy /= lineLength;
-
-		xPoints[0] = dashCoords[index*2+0] - (dy * _renderStroke->width / 2.0);
-		yPoints[0] = dashCoords[index*2+1] + (dx * _renderStroke->width / 2.0);
-		xPoints[1] = dashCoords[index*2+2] + (dy * _renderStroke->width / 2.0);
-		yPoints[1] = dashCoords[index*2+3] - (dx * _renderStroke->width / 2.0);
-		xPoints[2] = dashCoords[index*2+0] + (dy * _renderStroke->width / 2.0);
-		yPoints[2] = dashCoords[index*2+1] - (dx * _renderStroke->width / 2.0);
-		xPoints[3] = dashCoords[index*2+2] - (dy * _renderStroke->width / 2.0);
-		yPoints[3] = dashCoords[index*2+3] + (dx * _renderStroke->width / 2.0);
-
-		for(int index1 = 0; index1 < 4; index1++) {
-			x += xPoints[index1];
-			y += yPoints[index1];
-			renderIndex ++;
-
-			if (xPoints[index1] < minX) {
-				minX = xPoints[index1];
-			}
-			if (xPoints[index1] > maxX) {
-				maxX = xPoints[index1];
-			}
+	GLfloat* coords = floats;
+	for(int subpath = 0; subpath < subpathCount; subpath++) {
+		points = path->subpath(subpath, &count);
+		ints[3 + subpath] = count;
 
-			if (yPoints[index1] < minY) {
-				minY = yPoints[index1];
-			}
-			if (yPoints[index1] > maxY) {
-				maxY = yPoints[index1];
-			}
+		for(int index = 0; index < count; index++) {
+			int point = reverse ? count - 1 - index : index;
+			*coords++ = points[point*2+0];
+			*coords++ = points[point*2+1];
 		}
 	}
 
-	x /= renderIndex;
-	y /= renderIndex;
-
-
-
-	renderIndex = 0;
-	for(int index = 0; index < dashPoints-1; index += 2) {
-		dx = ((GLfloat)dashCoords[index*2+2] - (GLfloat)dashCoords[index*2+0]);
-		dy = ((GLfloat)dashCoords[index*2+3] - (GLfloat)dashCoords[index*2+1]);
-		lineLength = sqrt (fabs(dx * dx) + fabs(dy * dy));
-		dx /= lineLength;
-		dy /= lineLength;
+	// the covering quad, counter clockwise, with the texture spread over it
+	GLfloat cover[16] = {
+		bounds[0], bounds[1], bounds[2], bounds[1], bounds[2], bounds[3], bounds[0], bounds[3],
+		0.0, 0.0, 1.0, 0.0, 1.0, 1.0, 0.0, 1.0
+	};
+	memcpy(coords, cover, sizeof(cover));
+}
 
-		xPoints[0] = dashCoords[index*2+0] - (dy * _renderStroke->width / 2.0);
-		yPoints[0] = dashCoords[index*2+1] + (dx * _renderStroke->width / 2.0);
-		xPoints[1] = dashCoords[index*2+2] + (dy * _renderStroke->width / 2.0);
-		yPoints[1] = dashCoords[index*2+3] - (dx * _renderStroke->width / 2.0);
-		xPoints[2] = dashCoords[index*2+0] + (dy * _renderStroke->width / 2.0);
-		yPoints[2] = dashCoords[index*2+1] - (dx * _renderStroke->width / 2.0);
-		xPoints[3] = dashCoords[index*2+2] - (dy * _renderStroke->width / 2.0);
-		yPoints[3] = dashCoords[index*2+3] + (dx * _renderStroke->width / 2.0);
+#ifdef GLES1
+// returns true if a path has subpaths winding both ways with none overlapping another - the clamping stencil counters of GLES1
+// lose whichever way winds against the rest, while filling each subpath on its own draws them all, since nothing overlaps
+static bool separateWindings(Path2D* path, int subpathCount)
+{
+	bool clockwise = false;
+	bool counterClockwise = false;
+	QVector<GLfloat> subpathBounds(subpathCount * 4);
+	const GLfloat* points;
+	int count;
+
+	for(int subpath = 0; subpath < subpathCount; subpath++) {
+		GLfloat* bounds = &subpathBounds[subpath * 4];
+		GLfloat area = 0.0;
+
+		bounds[0] = 1.0e30;
+		bounds[1] = 1.0e30;
+		bounds[2] = -1.0e30;
+		bounds[3] = -1.0e30;
+
+		points = path->subpath(subpath, &count);
+		for(int index = 0; index < count; index++) {
+			int following = (index + 1) % count;
+			area += points[index*2+0] * points[following*2+1] - points[following*2+0] * points[index*2+1];
+			includePoint(bounds, points[index*2+0], points[index*2+1]);
+		}
 
+		if (area < 0.0) {
+			clockwise = true;
+		} else if (area > 0.0) {
+			counterClockwise = true;
+		}
 
-		for(int index1 = 0; index1 < 4; index1++) {
-			if (minX == maxX) {
-				uPoints[index1] = 0.0;
-			} else {
-				uPoints[index1] = (xPoints[index1] - minX) / (maxX - minX);
-			}
-			if (minY == maxY) {
-				vPoints[index1] = 0.0;
-			} else {
-				vPoints[index1] = (yPoints[index1] - minY) / (maxY - minY);
+		// nested subpaths are holes or islands, which the stencil counts right as long as the outermost winds counter clockwise
+		for(int other = 0; other < subpath; other++) {
+			if (boundsOverlap(bounds, &subpathBounds[other * 4])) {
+				return false;
 			}
 		}
+	}
 
-		if (index > 0 && index < (dashPoints-2)) {
+	return clockwise && counterClockwise;
+}
+#endif
 
-			//qDebug()  << "Graphics2D::renderDrawPolyline: before: " << xPoints[1] << " " << yPoints[1]  << " " << xPoints[3]  << " " << xPoints[3];
+// Flattens, strokes or fills a path to the current tolerance, or reuses the meshes cached on it for the same tolerance and stroke, and appends them.
+void Graphics2D::tessellatePath(RenderCommandHeader* command, CommandBuffer* tessellated)
+{
+	Path2D* path = (Path2D*)commandPointers(command)[0];
+	bool stroked = command->command == RENDER_DRAW_PATH;
+
+	// the path keeps its own meshes, so the key is only how it was drawn - fills do not depend on the stroke
+	QByteArray key;
+	key.append((const char*)&command->command, sizeof(command->command));
+	key.append((const char*)&_tessellateTolerance, sizeof(GLfloat));
+	key.append((const char*)&_tessellateFringe, sizeof(GLfloat));
+	if (!stroked) {
+		key.append((const char*)&_stencilThreshold, sizeof(int));
+	}
+	if (stroked) {
+		key.append((const char*)&_tessellateStroke->width, sizeof(GLfloat));
+		key.append((const char*)&_tessellateStroke->cap, sizeof(int));
+		key.append((const char*)&_tessellateStroke->join, sizeof(int));
+		key.append((const char*)&_tessellateStroke->miterLimit, sizeof(GLfloat));
+		key.append((const char*)&_tessellateStroke->dashPhase, sizeof(GLfloat));
+		key.append((const char*)&_tessellateStroke->dashCount, sizeof(int));
+		if (_tessellateStroke->dashCount > 0) {
+			key.append((const char*)_tessellateStroke->dash, sizeof(GLfloat) * _tessellateStroke->dashCount);
+		}
+	}
 
-			if (dashCoords[index*2+4] == dashCoords[index*2+2] && dashCoords[index*2+5] == dashCoords[index*2+3]) {
+	QByteArray* meshes = path->meshes(key);
 
-				//qDebug()  << "Graphics2D::renderDrawPolyline: before: " << xPoints[1] << " " << yPoints[1]  << " " << xPoints[3]  << " " << xPoints[3];
+	if (meshes) {
+		_meshCacheHits++;
+	} else {
+		_meshCacheMisses++;
 
-				dx1 = ((GLfloat)dashCoords[index*2+6] - (GLfloat)dashCoords[index*2+4]);
-				dy1 = ((GLfloat)dashCoords[index*2+7] - (GLfloat)dashCoords[index*2+5]);
-				lineLength = sqrt (fabs(dx1 * dx1) + fabs(dy1 * dy1));
-				dx1 /= lineLength;
-				dy1 /= lineLength;
+		_meshCacheCommands->reset();
 
-				xPoints[1] = dashCoords[index*2+2] + (dy * _renderStroke->width / 4.0) + (dy1 * _renderStroke->width / 4.0);
-				yPoints[1] = dashCoords[index*2+3] - (dx * _renderStroke->width / 4.0) - (dx1 * _renderStroke->width / 4.0);
-				xPoints[3] = dashCoords[index*2+2] - (dy * _renderStroke->width / 4.0) - (dy1 * _renderStroke->width / 4.0);
-				yPoints[3] = dashCoords[index*2+3] + (dx * _renderStroke->width / 4.0) + (dx1 * _renderStroke->width / 4.0);
+		int subpathCount = path->flatten(_tessellateTolerance);
+		int pointCount = 0;
+		const GLfloat* points;
+		int count;
 
-				//qDebug()  << "Graphics2D::renderDrawPolyline: after: " << xPoints[1] << " " << yPoints[1]  << " " << xPoints[3]  << " " << xPoints[3];
+		// the gradient or texture is spread over the whole path rather than over each subpath
+		GLfloat bounds[4] = { 1.0e30, 1.0e30, -1.0e30, -1.0e30 };
+		for(int subpath = 0; subpath < subpathCount; subpath++) {
+			points = path->subpath(subpath, &count);
+			for(int index = 0; index < count; index++) {
+				includePoint(bounds, points[index*2+0], points[index*2+1]);
 			}
+			pointCount += count;
 		}
 
-		//qDebug()  << "Graphics2D::renderDrawPolyline: : " << xPoints[0] << " " << yPoints[0]  << " " << xPoints[1] << " " << yPoints[1] << " "  << xPoints[2] << " " << yPoints[2]  << " " << xPoints[3]  << " " << xPoints[3];
-
-		if (fabs(dy) > fabs(dx)) {
-			_renderVertexCoords[renderIndex*8+0] = (GLfloat)xPoints[3];
-			_renderVertexCoords[renderIndex*8+1] = (GLfloat)yPoints[3];
-			_renderVertexCoords[renderIndex*8+2] = (GLfloat)xPoints[0];
-			_renderVertexCoords[renderIndex*8+3] = (GLfloat)yPoints[0];
-			_renderVertexCoords[renderIndex*8+4] = (GLfloat)xPoints[1];
-			_renderVertexCoords[renderIndex*8+5] = (GLfloat)yPoints[1];
-			_renderVertexCoords[renderIndex*8+6] = (GLfloat)xPoints[2];
-			_renderVertexCoords[renderIndex*8+7] = (GLfloat)yPoints[2];
-
-			_renderTextureCoords[renderIndex*8+0] = (GLfloat)uPoints[3];
-			_renderTextureCoords[renderIndex*8+1] = (GLfloat)vPoints[3];
-			_renderTextureCoords[renderIndex*8+2] = (GLfloat)uPoints[0];
-			_renderTextureCoords[renderIndex*8+3] = (GLfloat)vPoints[0];
-			_renderTextureCoords[renderIndex*8+4] = (GLfloat)uPoints[1];
-			_renderTextureCoords[renderIndex*8+5] = (GLfloat)vPoints[1];
-			_renderTextureCoords[renderIndex*8+6] = (GLfloat)uPoints[2];
-			_renderTextureCoords[renderIndex*8+7] = (GLfloat)vPoints[2];
-		} else {
-			_renderVertexCoords[renderIndex*8+0] = (GLfloat)xPoints[2];
-			_renderVertexCoords[renderIndex*8+1] = (GLfloat)yPoints[2];
-			_renderVertexCoords[renderIndex*8+2] = (GLfloat)xPoints[1];
-			_renderVertexCoords[renderIndex*8+3] = (GLfloat)yPoints[1];
-			_renderVertexCoords[renderIndex*8+4] = (GLfloat)xPoints[0];
-			_renderVertexCoords[renderIndex*8+5] = (GLfloat)yPoints[0];
-			_renderVertexCoords[renderIndex*8+6] = (GLfloat)xPoints[3];
-			_renderVertexCoords[renderIndex*8+7] = (GLfloat)yPoints[3];
-
-			_renderTextureCoords[renderIndex*8+0] = (GLfloat)uPoints[2];
-			_renderTextureCoords[renderIndex*8+1] = (GLfloat)vPoints[2];
-			_renderTextureCoords[renderIndex*8+2] = (GLfloat)uPoints[1];
-			_renderTextureCoords[renderIndex*8+3] = (GLfloat)vPoints[1];
-			_renderTextureCoords[renderIndex*8+4] = (GLfloat)uPoints[0];
-			_renderTextureCoords[renderIndex*8+5] = (GLfloat)vPoints[0];
-			_renderTextureCoords[renderIndex*8+6] = (GLfloat)uPoints[3];
-			_renderTextureCoords[renderIndex*8+7] = (GLfloat)vPoints[3];
+		// outlines that may overlap, cross themselves or take long to triangulate go through the stencil buffer when there is one
+		bool stencilled = false;
+		if (!stroked && _eglStencilSize > 0 && pointCount > 0) {
+			switch(path->fillMode()) {
+			case FILL_MODE_STENCIL:
+				stencilled = true;
+				break;
+			case FILL_MODE_AUTO:
+				stencilled = subpathCount > 1 || path->fillRule() == FILL_RULE_EVENODD || pointCount > _stencilThreshold;
+				break;
+			default:
+				break;
+			}
 		}
 
-		renderIndex++;
-		//qDebug()  << "Graphics2D::renderDrawPolyline: " << numberPoints << " " << index  << " " << renderIndex  << " " << (renderIndex*8 + 8)   << " " << MAX_VERTEX_COORDINATES;
+#ifdef GLES1
+		// without wrapping stencil counters, subpaths winding the other way from the rest are better triangulated one by one
+		if (stencilled && path->fillRule() == FILL_RULE_NONZERO && separateWindings(path, subpathCount)) {
+			stencilled = false;
+		}
+#endif
 
-		if ((renderIndex*8 + 8) > MAX_VERTEX_COORDINATES) {
-			renderDrawTriangles(renderIndex, 4);
+		if (stroked) {
+			GLfloat halfWidth = _tessellateStroke->width / 2.0;
 
-			renderIndex = 0;
+			bounds[0] -= halfWidth;
+			bounds[1] -= halfWidth;
+			bounds[2] += halfWidth;
+			bounds[3] += halfWidth;
 		}
-	}
 
-	renderDrawTriangles(renderIndex, 4);
-
-	if (dashCoords) {
-		delete dashCoords;
-	}
+		if (stencilled) {
+			appendStencilFill(_meshCacheCommands, path, subpathCount, pointCount, bounds);
+			subpathCount = 0;
+		}
 
-	//qDebug()  << "Graphics2D::renderDrawLine: " << _drawFloatIndices[commandCount*2+0]/2;
-}
+		for(int subpath = 0; subpath < subpathCount; subpath++) {
+			points = path->subpath(subpath, &count);
 
-void Graphics2D::renderDrawTriangles(int renderCount, int renderPoints)
-{
-#ifdef GLES1
-	glColor4f(_renderForegroundColor.red, _renderForegroundColor.green, _renderForegroundColor.blue, _renderForegroundColor.alpha);
+			// a subpath that only moves draws nothing
+			if (count < 2) {
+				continue;
+			}
 
-	glEnableClientState(GL_VERTEX_ARRAY);
+			if (stroked) {
+				strokeDashed(_meshCacheCommands, points, count, path->subpathClosed(subpath), bounds);
+			} else {
+				GLfloat* textureCoords = tessellateStrokeCoords(count * 2);
 
-	glVertexPointer(2, GL_FLOAT, 0, _renderVertexCoords);
+				for(int index = 0; index < count; index++) {
+					textureCoords[index*2+0] = bounds[2] > bounds[0] ? (points[index*2+0] - bounds[0]) / (bounds[2] - bounds[0]) : 0.0;
+					textureCoords[index*2+1] = bounds[3] > bounds[1] ? (points[index*2+1] - bounds[1]) / (bounds[3] - bounds[1]) : 0.0;
+				}
 
-	for(int index = 0; index < renderCount; index++) {
-		glDrawArrays(GL_TRIANGLE_STRIP, index*renderPoints, renderPoints);
-	}
+				fillOutline(_meshCacheCommands, points, textureCoords, count);
+			}
+		}
+		emitMesh(_meshCacheCommands);
 
-	glDisableClientState(GL_VERTEX_ARRAY);
+		meshes = new QByteArray();
 
-#elif defined(GLES2)
+		CommandCursor cursor;
+		RenderCommandHeader* mesh;
 
-	if (_renderGradient) {
+		_meshCacheCommands->begin(&cursor);
+		while((mesh = _meshCacheCommands->next(&cursor)) != NULL) {
+			meshes->append((const char*)mesh, mesh->size);
+		}
 
-		//qDebug()  << "Graphics2D::renderDrawTriangles: _renderGradient";
+		if (!path->cacheMeshes(key, meshes)) {
+			// too big to keep - the path has already deleted it, so copy the scratch meshes instead
+			_meshCacheCommands->begin(&cursor);
+			while((mesh = _meshCacheCommands->next(&cursor)) != NULL) {
+				tessellated->appendCopy(mesh);
+			}
+			return;
+		}
+	}
 
-	    glUseProgram(_polyGradientRenderingProgram);
+	int offset = 0;
+	while (offset < meshes->size()) {
+		const RenderCommandHeader* mesh = (const RenderCommandHeader*)(meshes->constData() + offset);
+		tessellated->appendCopy(mesh);
+		offset += mesh->size;
+	}
+}
 
-	    GLint pmLoc = glGetUniformLocation(_polyGradientRenderingProgram, "u_projectionMatrix");
-	    GLint mvmLoc = glGetUniformLocation(_polyGradientRenderingProgram, "u_modelViewMatrix");
-		GLint positionLoc = glGetAttribLocation(_polyGradientRenderingProgram, "a_position");
-		GLint texcoordLoc = glGetAttribLocation(_polyGradientRenderingProgram, "a_texcoord");
+// Returns scratch space for count dash coordinates, reused from one call to the next.
+float* Graphics2D::tessellateDashCoords(int count)
+{
+	if (count > _tessellateDashCapacity) {
+		int capacity = _tessellateDashCapacity > 0 ? _tessellateDashCapacity : 64;
+		while (capacity < count) {
+			capacity *= 2;
+		}
 
-	    GLint segmentsLoc = glGetUniformLocation(_polyGradientRenderingProgram, "u_segments");
-		GLint colorsLoc = glGetUniformLocation(_polyGradientRenderingProgram, "u_colors");
-		GLint percentagesLoc = glGetUniformLocation(_polyGradientRenderingProgram, "u_percentages");
-		GLint radiusLoc = glGetUniformLocation(_polyGradientRenderingProgram, "u_radius");
-		GLint angleLoc = glGetUniformLocation(_polyGradientRenderingProgram, "u_angle");
-		GLint originLoc = glGetUniformLocation(_polyGradientRenderingProgram, "u_origin");
+		if (_tessellateDashCoords) {
+			delete [] _tessellateDashCoords;
+		}
 
-		glUniformMatrix4fv(pmLoc, 1, GL_FALSE, _orthoMatrix);
-		glUniformMatrix4fv(mvmLoc, 1, GL_FALSE, _renderModelMatrix);
+		_tessellateDashCoords = new float[capacity];
+		_tessellateDashCapacity = capacity;
+	}
 
-		glUniform1i(segmentsLoc, _renderGradient->segments);
+	return _tessellateDashCoords;
+}
 
-		GLfloat gradientColors[400];
-		for(int index = 0; index < _renderGradient->segments+1; index++) {
-			gradientColors[index*4+0] = _renderGradient->colors[index].red;
-			gradientColors[index*4+1] = _renderGradient->colors[index].green;
-			gradientColors[index*4+2] = _renderGradient->colors[index].blue;
-			gradientColors[index*4+3] = _renderGradient->colors[index].alpha;
+// Returns scratch space for count polygon or polyline corner indices, reused from one call to the next.
+int* Graphics2D::tessellatePolygonLinks(int count)
+{
+	if (count > _tessellatePolygonCapacity) {
+		int capacity = _tessellatePolygonCapacity > 0 ? _tessellatePolygonCapacity : 64;
+		while (capacity < count) {
+			capacity *= 2;
 		}
-		glUniform4fv(colorsLoc, _renderGradient->segments+1, gradientColors);
-		glUniform1fv(percentagesLoc, _renderGradient->segments*2+1, _renderGradient->percentages);
-		glUniform1f(radiusLoc, _renderGradient->radius);
-		glUniform1f(angleLoc, _renderGradient->angle);
-		glUniform2f(originLoc, _renderGradient->originU, _renderGradient->originV);
 
-		glEnableVertexAttribArray(positionLoc);
-		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderVertexCoords);
+		if (_tessellatePolygonLinks) {
+			delete [] _tessellatePolygonLinks;
+		}
 
-		glEnableVertexAttribArray(texcoordLoc);
-		glVertexAttribPointer(texcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderTextureCoords);
+		_tessellatePolygonLinks = new int[capacity];
+		_tessellatePolygonCapacity = capacity;
+	}
 
+	return _tessellatePolygonLinks;
+}
 
-		for(int index = 0; index < renderCount; index++) {
-			glDrawArrays(GL_TRIANGLE_STRIP, index*renderPoints, renderPoints);
+// Returns scratch space for count floats of stroke points, directions and outlines, reused from one call to the next.
+GLfloat* Graphics2D::tessellateStrokeCoords(int count)
+{
+	if (count > _tessellateStrokeCapacity) {
+		int capacity = _tessellateStrokeCapacity > 0 ? _tessellateStrokeCapacity : 256;
+		while (capacity < count) {
+			capacity *= 2;
 		}
 
-		glDisableVertexAttribArray(texcoordLoc);
-		glDisableVertexAttribArray(positionLoc);
-	} else {
-	    glUseProgram(_polyColorRenderingProgram);
+		if (_tessellateStrokeCoords) {
+			delete [] _tessellateStrokeCoords;
+		}
 
-	    GLint pmLoc = glGetUniformLocation(_polyColorRenderingProgram, "u_projectionMatrix");
-	    GLint mvmLoc = glGetUniformLocation(_polyColorRenderingProgram, "u_modelViewMatrix");
-		GLint colorLoc = glGetUniformLocation(_polyColorRenderingProgram, "u_color");
-		GLint positionLoc = glGetAttribLocation(_polyColorRenderingProgram, "a_position");
+		_tessellateStrokeCoords = new GLfloat[capacity];
+		_tessellateStrokeCapacity = capacity;
+	}
 
-		glUniformMatrix4fv(pmLoc, 1, GL_FALSE, _orthoMatrix);
-		glUniformMatrix4fv(mvmLoc, 1, GL_FALSE, _renderModelMatrix);
-		glUniform4f(colorLoc, _renderForegroundColor.red, _renderForegroundColor.green, _renderForegroundColor.blue, _renderForegroundColor.alpha);
+	return _tessellateStrokeCoords;
+}
 
-		glEnableVertexAttribArray(positionLoc);
-		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderVertexCoords);
+// Returns scratch space for count simplified polyline coordinates, reused from one call to the next.
+GLfloat* Graphics2D::tessellateSimplifyCoords(int count)
+{
+	if (count > _tessellateSimplifyCapacity) {
+		int capacity = _tessellateSimplifyCapacity > 0 ? _tessellateSimplifyCapacity : 256;
+		while (capacity < count) {
+			capacity *= 2;
+		}
 
-		for(int index = 0; index < renderCount; index++) {
-			glDrawArrays(GL_TRIANGLE_STRIP, index*renderPoints, renderPoints);
+		if (_tessellateSimplifyCoords) {
+			delete [] _tessellateSimplifyCoords;
 		}
 
-		glDisableVertexAttribArray(positionLoc);
+		_tessellateSimplifyCoords = new GLfloat[capacity];
+		_tessellateSimplifyCapacity = capacity;
 	}
 
-#else
-#error libviews should be compiled with either GLES1 or GLES2 -D flags.
-#endif
+	return _tessellateSimplifyCoords;
 }
 
 
 // Render a line, using the current color, between the points (x1, y1) and (x2, y2) in this graphics context's coordinate system.
-void Graphics2D::renderDrawFillArc(int commandCount)
+void Graphics2D::tessellateArc(RenderCommandHeader* command, CommandBuffer* tessellated)
 {
-	//qDebug()  << "Graphics2D::renderDrawFillArc: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1] << " " << _drawFloatIndices[commandCount*2+2] << " " << _drawFloatIndices[commandCount*2+3] << " " << _drawFloatIndices[commandCount*2+4] << " " << _drawFloatIndices[commandCount*2+5];
+	//qDebug()  << "Graphics2D::tessellateArc: " << command->command << " : " << command->size;
+
+	GLfloat* floats = commandFloats(command);
 
 	double x, y, width, height, startAngle, arcAngle;
 	double radiusX, radiusY, endAngle, drawAngle, endAngle1, drawAngle1, angleStep, temp;
 	GLfloat dx, dy, dx1, dy1, dx2, dy2, length, length1;
 
 	bool fillArc = false;
-	if (_master2D->_drawCommands[commandCount] == RENDER_FILL_ARC) {
+	if (command->command == RENDER_FILL_ARC) {
 		fillArc = true;
 	}
 
-	x          = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	y          = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
-	width      = _drawFloats[_drawFloatIndices[commandCount*2+0]+2];
-	height     = _drawFloats[_drawFloatIndices[commandCount*2+0]+3];
-	startAngle = _drawFloats[_drawFloatIndices[commandCount*2+0]+4];
-	arcAngle   = _drawFloats[_drawFloatIndices[commandCount*2+0]+5];
+	x          = floats[0];
+	y          = floats[1];
+	width      = floats[2];
+	height     = floats[3];
+	startAngle = floats[4];
+	arcAngle   = floats[5];
 
 	radiusX = width / 2.0;
 	radiusY = height / 2.0;
@@ -3099,130 +6591,49 @@ void Graphics2D::renderDrawFillArc(int commandCount)
 
 	length = (endAngle - startAngle) * M_PI * sqrt(radiusX * radiusX + radiusY * radiusY) / 180.0;
 
-	angleStep = asin (1.0 / (height + width)) * 180.0 / M_PI;
+	// the arc is traced at width and height away from (x,y), and the outside edge of a drawn arc is half the stroke width further out
+	if (fillArc) {
+		angleStep = curveAngleStep(fabs(width) > fabs(height) ? fabs(width) : fabs(height), _tessellateTolerance);
+	} else {
+		angleStep = curveAngleStep((fabs(width) > fabs(height) ? fabs(width) : fabs(height)) + _tessellateStroke->width / 2.0, _tessellateTolerance);
+	}
 
 	//qDebug()  << "Graphics2D::renderDrawArc: " << startAngle << " " << endAngle << " " << angleStep;
 
-	double drawX, drawY, drawX1, drawY1, lastX, lastY, drawU, drawV, drawU1, drawV1, lastU, lastV, angle, angle1, currentLength, dashLength;
+	double drawX, drawY, drawX1, drawY1, lastX, lastY, drawU, drawV, drawU1, drawV1, lastU, lastV, angle, angle1;
 	int drawCount = 0;
 
-	currentLength = 0.0;
-	dashLength = 0.0;
-	if (_renderStroke->dashCount > 1) {
-		for(int index = 0; index < _renderStroke->dashCount; index++) {
-			dashLength += _renderStroke->dash[index];
-		}
+	// dashes are laid along the length of the arc and drawn as the angles they cover
+	double arcStartAngle = startAngle;
+	double arcEndAngle = endAngle;
+	GLfloat arcLength = length;
+	GLfloat dashFrom = 0.0, dashTo = arcLength;
+
+	DashIterator dashes;
+	bool dashed = false;
+	if (fillArc == false && arcLength > 0.0) {
+		dashed = dashes.begin(_tessellateStroke->dash, _tessellateStroke->dashCount, _tessellateStroke->dashPhase);
+		dashes.nextSegment(arcLength);
 	}
 
-
-	float* dashCoords = NULL;
-	int   dashPoints = 0;
-
 	//qDebug()  << "Graphics2D::renderDrawArc: " << length;
 
-	if (_renderStroke->dashCount > 1 && fillArc == false) {
-
-		int dashIndex = -1;
-		float currentLength = 0.0;
-		if (_renderStroke->dashPhase != 0.0) {
-			currentLength = -_renderStroke->dashPhase;
-		}
-
-		do {
-			if (dashIndex >= 0) {
-				currentLength += _renderStroke->dash[dashIndex];
-				if (currentLength > length) {
-					currentLength = length;
-
-					if (dashPoints == 0 && (dashIndex % 2 == 0)) {
-						dashPoints++;
-					}
-					continue;
-				}
-			}
-
-			if (dashPoints == 0 && currentLength == 0.0) {
-				dashPoints++;
-			}
-
-			if (currentLength > 0.0) {
-				dashPoints++;
-			}
-
-			//qDebug()  << "Graphics2D::renderDrawArc: calculate array size " << currentLength << " " << dashIndex << " " << dashPoints;
-
-			dashIndex++;
-			if (dashIndex == _renderStroke->dashCount) {
-				dashIndex = 0;
-			}
-
-		} while (currentLength < length);
-
-		if ((dashPoints % 2) == 1) {
-			dashPoints++;
-		}
-
-		//qDebug()  << "Graphics2D::renderDrawArc: " << currentLength << " " << dashPoints;
-
-		dashCoords = new float[dashPoints];
-
-		dashIndex = -1;
-		currentLength = 0;
-		if (_renderStroke->dashPhase != 0.0) {
-			currentLength = -_renderStroke->dashPhase;
-		}
-		dashPoints = 0;
-
-		do {
-			if (dashIndex >= 0) {
-				currentLength += _renderStroke->dash[dashIndex];
-				if (currentLength > length) {
-					currentLength = length;
-
-					if (dashPoints == 0 && (dashIndex % 2 == 0)) {
-						dashCoords[0] = startAngle;
-						dashPoints++;
-					}
-					continue;
-				}
-			}
-
-			if (dashPoints == 0 && currentLength == 0.0) {
-				dashCoords[0] = startAngle;
-				dashPoints++;
-			}
-
-			if (currentLength > 0.0) {
-				dashCoords[dashPoints] = startAngle + currentLength * (endAngle - startAngle) / length;
-				dashPoints++;
-			}
+	int renderIndex = 0;
+	double xPoints[4], yPoints[4];
 
-			dashIndex++;
-			if (dashIndex == _renderStroke->dashCount) {
-				dashIndex = 0;
-			}
+	bool whole = true;
 
-		} while (currentLength < length);
+	while (dashed ? dashes.nextSpan(&dashFrom, &dashTo) : whole) {
+		whole = false;
 
-		if ((dashPoints % 2) == 1) {
-			dashCoords[dashPoints] = endAngle;
-			dashPoints++;
+		if (dashed) {
+			drawAngle = arcStartAngle + dashFrom * (arcEndAngle - arcStartAngle) / arcLength;
+			endAngle = arcStartAngle + dashTo * (arcEndAngle - arcStartAngle) / arcLength;
+		} else {
+			drawAngle = arcStartAngle;
+			endAngle = arcEndAngle;
 		}
 
-	} else {
-		dashPoints = 2;
-		dashCoords = new float[dashPoints];
-		dashCoords[0] = startAngle;
-		dashCoords[1] = endAngle;
-	}
-
-	int renderIndex = 0;
-	double xPoints[4], yPoints[4];
-
-	for(int index = 0; index < dashPoints; index += 2) {
-		drawAngle = dashCoords[index+0];
-		endAngle = dashCoords[index+1];
-
 		//qDebug()  << "Graphics2D::renderDrawArc: " << index << " " << drawAngle << " " << endAngle;
 
 		drawCount = 0;
@@ -3262,40 +6673,37 @@ void Graphics2D::renderDrawFillArc(int commandCount)
 				dx /= length;
 				dy /= length;
 
-				currentLength += length;
-
 				GLfloat dx1 = ((GLfloat)drawX - (GLfloat)x);
 				GLfloat dy1 = ((GLfloat)drawY - (GLfloat)y);
 				length1 = sqrt (fabs(dx1 * dx1) + fabs(dy1 * dy1));
 				dx1 /= length1;
 				dy1 /= length1;
 
-
-				if (!(fabs(dx) < 1.0 || fabs(dy) < 1.0) || length > 20.0 || drawAngle == endAngle) {
+				if (length > 0.0) {
 					if (fillArc) {
-						_renderVertexCoords[renderIndex*6+0] = (GLfloat)x;
-						_renderVertexCoords[renderIndex*6+1] = (GLfloat)y;
-						_renderVertexCoords[renderIndex*6+2] = (GLfloat)lastX;
-						_renderVertexCoords[renderIndex*6+3] = (GLfloat)lastY;
-						_renderVertexCoords[renderIndex*6+4] = (GLfloat)drawX;
-						_renderVertexCoords[renderIndex*6+5] = (GLfloat)drawY;
-
-						_renderTextureCoords[renderIndex*6+0] = (GLfloat)0.5;
-						_renderTextureCoords[renderIndex*6+1] = (GLfloat)0.5;
-						_renderTextureCoords[renderIndex*6+2] = (GLfloat)lastU;
-						_renderTextureCoords[renderIndex*6+3] = (GLfloat)lastV;
-						_renderTextureCoords[renderIndex*6+4] = (GLfloat)drawU;
-						_renderTextureCoords[renderIndex*6+5] = (GLfloat)drawV;
+						_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)x;
+						_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)y;
+						_tessellateVertexCoords[renderIndex*6+2] = (GLfloat)lastX;
+						_tessellateVertexCoords[renderIndex*6+3] = (GLfloat)lastY;
+						_tessellateVertexCoords[renderIndex*6+4] = (GLfloat)drawX;
+						_tessellateVertexCoords[renderIndex*6+5] = (GLfloat)drawY;
+
+						_tessellateTextureCoords[renderIndex*6+0] = (GLfloat)0.5;
+						_tessellateTextureCoords[renderIndex*6+1] = (GLfloat)0.5;
+						_tessellateTextureCoords[renderIndex*6+2] = (GLfloat)lastU;
+						_tessellateTextureCoords[renderIndex*6+3] = (GLfloat)lastV;
+						_tessellateTextureCoords[renderIndex*6+4] = (GLfloat)drawU;
+						_tessellateTextureCoords[renderIndex*6+5] = (GLfloat)drawV;
 					} else {
 						//qDebug()  << "Graphics2D::renderDrawArc: renderIndex: " << renderIndex*8 << " " << (renderIndex*8+8);
-						xPoints[0] = lastX - (dy * _renderStroke->width / 2.0);
-						yPoints[0] = lastY + (dx * _renderStroke->width / 2.0);
-						xPoints[1] = drawX + (dy * _renderStroke->width / 2.0);
-						yPoints[1] = drawY - (dx * _renderStroke->width / 2.0);
-						xPoints[2] = lastX + (dy * _renderStroke->width / 2.0);
-						yPoints[2] = lastY - (dx * _renderStroke->width / 2.0);
-						xPoints[3] = drawX - (dy * _renderStroke->width / 2.0);
-						yPoints[3] = drawY + (dx * _renderStroke->width / 2.0);
+						xPoints[0] = lastX - (dy * _tessellateStroke->width / 2.0);
+						yPoints[0] = lastY + (dx * _tessellateStroke->width / 2.0);
+						xPoints[1] = drawX + (dy * _tessellateStroke->width / 2.0);
+						yPoints[1] = drawY - (dx * _tessellateStroke->width / 2.0);
+						xPoints[2] = lastX + (dy * _tessellateStroke->width / 2.0);
+						yPoints[2] = lastY - (dx * _tessellateStroke->width / 2.0);
+						xPoints[3] = drawX - (dy * _tessellateStroke->width / 2.0);
+						yPoints[3] = drawY + (dx * _tessellateStroke->width / 2.0);
 
 						drawAngle1 = drawAngle + angleStep;
 						if (drawAngle1 > endAngle) {
@@ -3338,36 +6746,35 @@ void Graphics2D::renderDrawFillArc(int commandCount)
 							dx2 /= length1;
 							dy2 /= length1;
 
-							xPoints[1] = drawX + (dy * _renderStroke->width / 4.0) + (dy2 * _renderStroke->width / 4.0);
-							yPoints[1] = drawY - (dx * _renderStroke->width / 4.0) - (dx2 * _renderStroke->width / 4.0);
-							xPoints[3] = drawX - (dy * _renderStroke->width / 4.0) - (dy2 * _renderStroke->width / 4.0);
-							yPoints[3] = drawY + (dx * _renderStroke->width / 4.0) + (dx2 * _renderStroke->width / 4.0);
+							xPoints[1] = drawX + (dy * _tessellateStroke->width / 4.0) + (dy2 * _tessellateStroke->width / 4.0);
+							yPoints[1] = drawY - (dx * _tessellateStroke->width / 4.0) - (dx2 * _tessellateStroke->width / 4.0);
+							xPoints[3] = drawX - (dy * _tessellateStroke->width / 4.0) - (dy2 * _tessellateStroke->width / 4.0);
+							yPoints[3] = drawY + (dx * _tessellateStroke->width / 4.0) + (dx2 * _tessellateStroke->width / 4.0);
 						}
 
-
 						if (fabs(dy) > fabs(dx)) {
-							_renderVertexCoords[renderIndex*8+0] = (GLfloat)xPoints[3];
-							_renderVertexCoords[renderIndex*8+1] = (GLfloat)yPoints[3];
-							_renderVertexCoords[renderIndex*8+2] = (GLfloat)xPoints[0];
-							_renderVertexCoords[renderIndex*8+3] = (GLfloat)yPoints[0];
-							_renderVertexCoords[renderIndex*8+4] = (GLfloat)xPoints[1];
-							_renderVertexCoords[renderIndex*8+5] = (GLfloat)yPoints[1];
-							_renderVertexCoords[renderIndex*8+6] = (GLfloat)xPoints[2];
-							_renderVertexCoords[renderIndex*8+7] = (GLfloat)yPoints[2];
+							_tessellateVertexCoords[renderIndex*8+0] = (GLfloat)xPoints[3];
+							_tessellateVertexCoords[renderIndex*8+1] = (GLfloat)yPoints[3];
+							_tessellateVertexCoords[renderIndex*8+2] = (GLfloat)xPoints[0];
+							_tessellateVertexCoords[renderIndex*8+3] = (GLfloat)yPoints[0];
+							_tessellateVertexCoords[renderIndex*8+4] = (GLfloat)xPoints[1];
+							_tessellateVertexCoords[renderIndex*8+5] = (GLfloat)yPoints[1];
+							_tessellateVertexCoords[renderIndex*8+6] = (GLfloat)xPoints[2];
+							_tessellateVertexCoords[renderIndex*8+7] = (GLfloat)yPoints[2];
 						} else {
-							_renderVertexCoords[renderIndex*8+0] = (GLfloat)xPoints[2];
-							_renderVertexCoords[renderIndex*8+1] = (GLfloat)yPoints[2];
-							_renderVertexCoords[renderIndex*8+2] = (GLfloat)xPoints[1];
-							_renderVertexCoords[renderIndex*8+3] = (GLfloat)yPoints[1];
-							_renderVertexCoords[renderIndex*8+4] = (GLfloat)xPoints[0];
-							_renderVertexCoords[renderIndex*8+5] = (GLfloat)yPoints[0];
-							_renderVertexCoords[renderIndex*8+6] = (GLfloat)xPoints[3];
-							_renderVertexCoords[renderIndex*8+7] = (GLfloat)yPoints[3];
+							_tessellateVertexCoords[renderIndex*8+0] = (GLfloat)xPoints[2];
+							_tessellateVertexCoords[renderIndex*8+1] = (GLfloat)yPoints[2];
+							_tessellateVertexCoords[renderIndex*8+2] = (GLfloat)xPoints[1];
+							_tessellateVertexCoords[renderIndex*8+3] = (GLfloat)yPoints[1];
+							_tessellateVertexCoords[renderIndex*8+4] = (GLfloat)xPoints[0];
+							_tessellateVertexCoords[renderIndex*8+5] = (GLfloat)yPoints[0];
+							_tessellateVertexCoords[renderIndex*8+6] = (GLfloat)xPoints[3];
+							_tessellateVertexCoords[renderIndex*8+7] = (GLfloat)yPoints[3];
 						}
 					}
 
 					//qDebug()  << "Graphics2D::renderDrawArc: " << drawCount << " " << renderIndex << drawAngle << " " << endAngle << " " << drawX << " " << drawY << " " << lastX << " " << lastY;
-					//qDebug()  << "Graphics2D::renderDrawArc: " << renderIndex << " " << _renderVertexCoords[renderIndex*8+0] << " " << _renderVertexCoords[renderIndex*8+1] << " " << _renderVertexCoords[renderIndex*8+2] << " " << _renderVertexCoords[renderIndex*8+3] << " " << _renderVertexCoords[renderIndex*8+4] << " " << _renderVertexCoords[renderIndex*8+5] << " " << _renderVertexCoords[renderIndex*8+6] << " " << _renderVertexCoords[renderIndex*8+7];
+					//qDebug()  << "Graphics2D::renderDrawArc: " << renderIndex << " " << _tessellateVertexCoords[renderIndex*8+0] << " " << _tessellateVertexCoords[renderIndex*8+1] << " " << _tessellateVertexCoords[renderIndex*8+2] << " " << _tessellateVertexCoords[renderIndex*8+3] << " " << _tessellateVertexCoords[renderIndex*8+4] << " " << _tessellateVertexCoords[renderIndex*8+5] << " " << _tessellateVertexCoords[renderIndex*8+6] << " " << _tessellateVertexCoords[renderIndex*8+7];
 
 					lastX = drawX;
 					lastY = drawY;
@@ -3379,9 +6786,9 @@ void Graphics2D::renderDrawFillArc(int commandCount)
 
 					if ((renderIndex*8 + 8) > MAX_VERTEX_COORDINATES) {
 						if (fillArc) {
-							renderDrawTriangles(renderIndex, 3);
+							tessellateTriangles(tessellated, renderIndex, 3);
 						} else {
-							renderDrawTriangles(renderIndex, 4);
+							tessellateTriangles(tessellated, renderIndex, 4);
 						}
 
 						renderIndex = 0;
@@ -3411,144 +6818,136 @@ void Graphics2D::renderDrawFillArc(int commandCount)
 	}
 
 	if (fillArc) {
-		renderDrawTriangles(renderIndex, 3);
+		tessellateTriangles(tessellated, renderIndex, 3);
 	} else {
-		renderDrawTriangles(renderIndex, 4);
+		tessellateTriangles(tessellated, renderIndex, 4);
 	}
 
-	if (dashCoords) {
-		delete dashCoords;
-	}
-
-	//qDebug()  << "Graphics2D::renderDrawArc: " << _drawFloatIndices[commandCount*2+0]/2;
+	//qDebug()  << "Graphics2D::renderDrawArc: " << command->floatCount / 2;
 }
 
 // Draws as much of the specified area of the specified image as is currently available, scaling it on the fly to fit inside the specified area of the destination drawable surface.
-void Graphics2D::renderDrawImage(int commandCount)
+void Graphics2D::renderDrawImage(RenderCommandHeader* command)
 {
-	qDebug()  << "Graphics2D::renderDrawImage: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1];
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
+
+	qDebug()  << "Graphics2D::renderDrawImage: " << command->command << " : " << command->size;
 
 	GLuint  photo = 0;
 	GLfloat imageVertices[8];
 	GLfloat imageTexCoord[8];
 
-	photo = _drawInts[_drawIntIndices[commandCount*2+0]+0];
+	photo = ints[0];
 
 	qDebug()  << "Graphics2D::renderDrawImage: " << photo;
 
-	imageTexCoord[0] = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	imageTexCoord[1] = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
-	imageTexCoord[2] = _drawFloats[_drawFloatIndices[commandCount*2+0]+2];
-	imageTexCoord[3] = _drawFloats[_drawFloatIndices[commandCount*2+0]+3];
-	imageTexCoord[4] = _drawFloats[_drawFloatIndices[commandCount*2+0]+4];
-	imageTexCoord[5] = _drawFloats[_drawFloatIndices[commandCount*2+0]+5];
-	imageTexCoord[6] = _drawFloats[_drawFloatIndices[commandCount*2+0]+6];
-	imageTexCoord[7] = _drawFloats[_drawFloatIndices[commandCount*2+0]+7];
-
-	imageVertices[0] = _drawFloats[_drawFloatIndices[commandCount*2+0]+8];
-	imageVertices[1] = _drawFloats[_drawFloatIndices[commandCount*2+0]+9];
-	imageVertices[2] = _drawFloats[_drawFloatIndices[commandCount*2+0]+10];
-	imageVertices[3] = _drawFloats[_drawFloatIndices[commandCount*2+0]+11];
-	imageVertices[4] = _drawFloats[_drawFloatIndices[commandCount*2+0]+12];
-	imageVertices[5] = _drawFloats[_drawFloatIndices[commandCount*2+0]+13];
-	imageVertices[6] = _drawFloats[_drawFloatIndices[commandCount*2+0]+14];
-	imageVertices[7] = _drawFloats[_drawFloatIndices[commandCount*2+0]+15];
-
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-	//glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	imageTexCoord[0] = floats[0];
+	imageTexCoord[1] = floats[1];
+	imageTexCoord[2] = floats[2];
+	imageTexCoord[3] = floats[3];
+	imageTexCoord[4] = floats[4];
+	imageTexCoord[5] = floats[5];
+	imageTexCoord[6] = floats[6];
+	imageTexCoord[7] = floats[7];
+
+	imageVertices[0] = floats[8];
+	imageVertices[1] = floats[9];
+	imageVertices[2] = floats[10];
+	imageVertices[3] = floats[11];
+	imageVertices[4] = floats[12];
+	imageVertices[5] = floats[13];
+	imageVertices[6] = floats[14];
+	imageVertices[7] = floats[15];
 
 	if (photo > 0) {
+		setBlending(true);
+		setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		//setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
 #ifdef GLES1
-		glEnable(GL_TEXTURE_2D);
+		setTexturing(true);
 
 		glColor4f(COLOR_WHITE.red, COLOR_WHITE.green, COLOR_WHITE.blue, COLOR_WHITE.alpha);
 
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		useClientArrays(CLIENT_VERTEX_ARRAY | CLIENT_TEXTURE_COORD_ARRAY);
 
-		glVertexPointer(2, GL_FLOAT, 0, imageVertices);
-		glTexCoordPointer(2, GL_FLOAT, 0, imageTexCoord);
+		_renderStream->reserve(sizeof(imageVertices) + sizeof(imageTexCoord), 0);
 
-		glBindTexture(GL_TEXTURE_2D, photo);
+		glVertexPointer(2, GL_FLOAT, 0, _renderStream->writeVertices(imageVertices, sizeof(imageVertices)));
+		glTexCoordPointer(2, GL_FLOAT, 0, _renderStream->writeVertices(imageTexCoord, sizeof(imageTexCoord)));
 
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
+		bindTexture(photo);
 
-		glDisable(GL_TEXTURE_2D);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
 #elif defined(GLES2)
 
 		qDebug()  << "Graphics2D::renderDrawImage: program: " << _polyTextureRenderingProgram;
 
 	    //First render background and menu if it is enabled
-	    glUseProgram(_polyTextureRenderingProgram);
-
-		GLint positionLoc = glGetAttribLocation(_polyTextureRenderingProgram, "a_position");
-		GLint texcoordLoc = glGetAttribLocation(_polyTextureRenderingProgram, "a_texcoord");
-		GLint textureLoc = glGetUniformLocation(_polyTextureRenderingProgram, "u_texture");
-	    GLint pmLoc = glGetUniformLocation(_polyTextureRenderingProgram, "u_projectionMatrix");
-	    GLint mvmLoc = glGetUniformLocation(_polyTextureRenderingProgram, "u_modelViewMatrix");
+	    useProgram(_polyTextureRenderingProgram);
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		GLint positionLoc = _polyTextureLocations.position;
+		GLint texcoordLoc = _polyTextureLocations.texcoord;
+		GLint textureLoc = _polyTextureLocations.texture;
+	    GLint pmLoc = _polyTextureLocations.projectionMatrix;
+	    GLint mvmLoc = _polyTextureLocations.modelViewMatrix;
 
 	    glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, photo);
+		bindTexture(photo);
 		glUniform1i(textureLoc, 0);
 
 		glUniformMatrix4fv(pmLoc, 1, GL_FALSE, _orthoMatrix);
 		glUniformMatrix4fv(mvmLoc, 1, GL_FALSE, _renderModelMatrix);
 
-		glEnableVertexAttribArray(positionLoc);
-		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, imageVertices);
+		useVertexAttribArrays(attribBit(positionLoc) | attribBit(texcoordLoc));
 
-		glEnableVertexAttribArray(texcoordLoc);
-		glVertexAttribPointer(texcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, imageTexCoord);
+		_renderStream->reserve(sizeof(imageVertices) + sizeof(imageTexCoord), 0);
+
+		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(imageVertices, sizeof(imageVertices)));
+		glVertexAttribPointer(texcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(imageTexCoord, sizeof(imageTexCoord)));
 		qDebug() << "imageTexCoord: " << imageTexCoord[0] << " " << imageTexCoord[1] << " " << imageTexCoord[2] << " " << imageTexCoord[3] << " " << imageTexCoord[4] << " " << imageTexCoord[5] << " " << imageTexCoord[6] << " " << imageTexCoord[7];
 
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-		glDisableVertexAttribArray(texcoordLoc);
-		glDisableVertexAttribArray(positionLoc);
-
 #else
 #error libviews should be compiled with either GLES1 or GLES2 -D flags.
 #endif
-	}
 
-	glDisable(GL_BLEND);
+		_drawCalls++;
+	}
 
-	//qDebug()  << "Graphics2D::renderDrawImage: " << _drawFloatIndices[commandCount*2+0]/2;
+	//qDebug()  << "Graphics2D::renderDrawImage: " << command->floatCount / 2;
 }
 
 // Draws a sequence of connected lines defined by arrays of x and y coordinates.
-void Graphics2D::renderDrawFillRoundRect(int commandCount)
+void Graphics2D::tessellateRoundRect(RenderCommandHeader* command, CommandBuffer* tessellated)
 {
-	//qDebug()  << "Graphics2D::renderDrawRoundRect: " << commandCount;
+	//qDebug()  << "Graphics2D::renderDrawRoundRect: " << command->command;
+
+	GLfloat* floats = commandFloats(command);
 
 	double x, y, width, height, arcWidth, arcHeight, startAngle, arcAngle;
 	double radiusX, radiusY, endAngle, drawAngle, angleStep, temp;
 	GLfloat dx, dy, length;
 
 	bool fill = false;
-	if (_master2D->_drawCommands[commandCount] == RENDER_FILL_ROUNDRECT) {
+	if (command->command == RENDER_FILL_ROUNDRECT) {
 		fill = true;
 	}
 
 	//qDebug()  << "Graphics2D::renderDrawRoundRect: " << fill;
 
-	x          = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	y          = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
-	width      = _drawFloats[_drawFloatIndices[commandCount*2+0]+2];
-	height     = _drawFloats[_drawFloatIndices[commandCount*2+0]+3];
-	arcWidth   = _drawFloats[_drawFloatIndices[commandCount*2+0]+4];
-	arcHeight  = _drawFloats[_drawFloatIndices[commandCount*2+0]+5];
+	x          = floats[0];
+	y          = floats[1];
+	width      = floats[2];
+	height     = floats[3];
+	arcWidth   = floats[4];
+	arcHeight  = floats[5];
 	startAngle = 0.0;
 	arcAngle   = 360.0;
 
-
 	// calculate u,v texture bounds
 	float minX = 1.0e6, minY = 1.0e6, maxX = -1.0e6, maxY = -1.0e6;
 
@@ -3562,11 +6961,11 @@ void Graphics2D::renderDrawFillRoundRect(int commandCount)
 		minY = y;
 		maxX = x + width;
 		maxY = y + height;
-		if (_renderStroke->width > 0) {
-			minX -= _renderStroke->width / 2.0;
-			minY -= _renderStroke->width / 2.0;
-			maxX += _renderStroke->width / 2.0;
-			maxY += _renderStroke->width / 2.0;
+		if (_tessellateStroke->width > 0) {
+			minX -= _tessellateStroke->width / 2.0;
+			minY -= _tessellateStroke->width / 2.0;
+			maxX += _tessellateStroke->width / 2.0;
+			maxY += _tessellateStroke->width / 2.0;
 		}
 	}
 
@@ -3592,140 +6991,54 @@ void Graphics2D::renderDrawFillRoundRect(int commandCount)
 
 	length = 4.0 * arcLength + 2.0 * horizLength + 2.0 * vertLength;
 
-	angleStep = asin (1.0 / (arcHeight + arcWidth)) * 180.0 / M_PI;
+	if (fill) {
+		angleStep = curveAngleStep(fabs(radiusX) > fabs(radiusY) ? fabs(radiusX) : fabs(radiusY), _tessellateTolerance);
+	} else {
+		angleStep = curveAngleStep((fabs(radiusX) > fabs(radiusY) ? fabs(radiusX) : fabs(radiusY)) + _tessellateStroke->width / 2.0, _tessellateTolerance);
+	}
 
-	double drawX, drawY, lastX, lastY, angle, currentLength, dashLength;
+	double drawX, drawY, lastX, lastY, angle;
 	int drawCount = 0;
 
-	currentLength = 0.0;
-	dashLength = 0.0;
-	if (_renderStroke->dashCount > 1) {
-		for(int index = 0; index < _renderStroke->dashCount; index++) {
-			dashLength += _renderStroke->dash[index];
-		}
+	// undashed, the outline is drawn as its corner arcs and sides in turn, anticlockwise from the top right corner
+	GLfloat sideCoords[16];
+	sideCoords[ 0] = 0.0;
+	sideCoords[ 1] = arcLength;
+	sideCoords[ 2] = arcLength;
+	sideCoords[ 3] = arcLength + horizLength;
+	sideCoords[ 4] = arcLength + horizLength;
+	sideCoords[ 5] = arcLength*2.0 + horizLength;
+	sideCoords[ 6] = arcLength*2.0 + horizLength;
+	sideCoords[ 7] = arcLength*2.0 + horizLength + vertLength;
+	sideCoords[ 8] = arcLength*2.0 + horizLength + vertLength;
+	sideCoords[ 9] = arcLength*3.0 + horizLength + vertLength;
+	sideCoords[10] = arcLength*3.0 + horizLength + vertLength;
+	sideCoords[11] = arcLength*3.0 + 2.0*horizLength + vertLength;
+	sideCoords[12] = arcLength*3.0 + 2.0*horizLength + vertLength;
+	sideCoords[13] = arcLength*4.0 + 2.0*horizLength + vertLength;
+	sideCoords[14] = arcLength*4.0 + 2.0*horizLength + vertLength;
+	sideCoords[15] = arcLength*4.0 + 2.0*horizLength + 2.0*vertLength;
+	int sideIndex = 0;
+
+	DashIterator dashes;
+	bool dashed = false;
+	if (fill == false && length > 0.0) {
+		dashed = dashes.begin(_tessellateStroke->dash, _tessellateStroke->dashCount, _tessellateStroke->dashPhase);
+		dashes.nextSegment(length);
 	}
 
-
-	float* dashCoords = NULL;
-	int   dashPoints = 0;
-
 	//qDebug()  << "Graphics2D::renderDrawRoundRect: " << length;
 
-	if (_renderStroke->dashCount > 1 && fill == false) {
-
-		int dashIndex = -1;
-		float currentLength = 0.0;
-		if (_renderStroke->dashPhase != 0.0) {
-			currentLength = -_renderStroke->dashPhase;
-		}
-
-		do {
-			if (dashIndex >= 0) {
-				currentLength += _renderStroke->dash[dashIndex];
-				if (currentLength > length) {
-					currentLength = length;
-
-					if (dashPoints == 0 && (dashIndex % 2 == 0)) {
-						dashPoints++;
-					}
-					continue;
-				}
-			}
-
-			if (dashPoints == 0 && currentLength == 0.0) {
-				dashPoints++;
-			}
-
-			if (currentLength > 0.0) {
-				dashPoints++;
-			}
-
-			dashIndex++;
-			if (dashIndex == _renderStroke->dashCount) {
-				dashIndex = 0;
-			}
-
-		} while (currentLength < length);
-
-		if ((dashPoints % 2) == 1) {
-			dashPoints++;
-		}
-
-		//qDebug()  << "Graphics2D::renderDrawRoundRect: " << currentLength << " " << dashPoints;
-
-		dashCoords = new float[dashPoints];
-
-		dashIndex = -1;
-		currentLength = 0;
-		if (_renderStroke->dashPhase != 0.0) {
-			currentLength = -_renderStroke->dashPhase;
-		}
-		dashPoints = 0;
-
-		do {
-			if (dashIndex >= 0) {
-				currentLength += _renderStroke->dash[dashIndex];
-				if (currentLength > length) {
-					currentLength = length;
-
-					if (dashPoints == 0 && (dashIndex % 2 == 0)) {
-						dashCoords[0] = 0;
-						dashPoints++;
-					}
-					continue;
-				}
-			}
-
-			if (dashPoints == 0 && currentLength == 0.0) {
-				dashCoords[0] = 0;
-				dashPoints++;
-			}
-
-			if (currentLength > 0.0) {
-				dashCoords[dashPoints] = currentLength;
-				dashPoints++;
-			}
-
-			dashIndex++;
-			if (dashIndex == _renderStroke->dashCount) {
-				dashIndex = 0;
-			}
-
-		} while (currentLength < length);
-
-		if ((dashPoints % 2) == 1) {
-			dashCoords[dashPoints] = length;
-			dashPoints++;
-		}
-
-	} else {
-		dashPoints = 16;
-		dashCoords = new float[dashPoints];
-		dashCoords[ 0] = 0.0;
-		dashCoords[ 1] = arcLength;
-		dashCoords[ 2] = arcLength;
-		dashCoords[ 3] = arcLength + horizLength;
-		dashCoords[ 4] = arcLength + horizLength;
-		dashCoords[ 5] = arcLength*2.0 + horizLength;
-		dashCoords[ 6] = arcLength*2.0 + horizLength;
-		dashCoords[ 7] = arcLength*2.0 + horizLength + vertLength;
-		dashCoords[ 8] = arcLength*2.0 + horizLength + vertLength;
-		dashCoords[ 9] = arcLength*3.0 + horizLength + vertLength;
-		dashCoords[10] = arcLength*3.0 + horizLength + vertLength;
-		dashCoords[11] = arcLength*3.0 + 2.0*horizLength + vertLength;
-		dashCoords[12] = arcLength*3.0 + 2.0*horizLength + vertLength;
-		dashCoords[13] = arcLength*4.0 + 2.0*horizLength + vertLength;
-		dashCoords[14] = arcLength*4.0 + 2.0*horizLength + vertLength;
-		dashCoords[15] = arcLength*4.0 + 2.0*horizLength + 2.0*vertLength;
-	}
-
 	int renderIndex = 0;
 	float drawLength, endLength;
 	float x1, y1, x2, y2;
 
-	for(int index = 0; index < dashPoints; index += 2) {
-		drawLength = dashCoords[index+0];
-		endLength = dashCoords[index+1];
+	while (dashed ? dashes.nextSpan(&drawLength, &endLength) : sideIndex < 16) {
+		if (!dashed) {
+			drawLength = sideCoords[sideIndex+0];
+			endLength = sideCoords[sideIndex+1];
+			sideIndex += 2;
+		}
 
 		//qDebug()  << "Graphics2D::renderDrawRoundRect: " << index << " " << drawAngle << " " << endAngle;
 
@@ -3913,76 +7226,76 @@ void Graphics2D::renderDrawFillRoundRect(int commandCount)
 					dy = ((GLfloat)drawY - (GLfloat)lastY);
 					length = sqrt (fabs(dx * dx) + fabs(dy * dy));
 
-					if (!(fabs(dx) < 1.0 || fabs(dy) < 1.0) || length > 20.0 || drawAngle == endAngle) {
+					if (length > 0.0) {
 						if (fill) {
 							switch (quadrant) {
 							case 0:
-								_renderVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth + horizLength);
-								_renderVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight + vertLength);
+								_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth + horizLength);
+								_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight + vertLength);
 								break;
 							case 1:
-								_renderVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth);
-								_renderVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight + vertLength);
+								_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth);
+								_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight + vertLength);
 								break;
 							case 2:
-								_renderVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth);
-								_renderVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight);
+								_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth);
+								_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight);
 								break;
 							case 3:
-								_renderVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth + horizLength);
-								_renderVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight);
+								_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth + horizLength);
+								_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight);
 								break;
 							}
 
-							_renderVertexCoords[renderIndex*6+2] = (GLfloat)lastX;
-							_renderVertexCoords[renderIndex*6+3] = (GLfloat)lastY;
-							_renderVertexCoords[renderIndex*6+4] = (GLfloat)drawX;
-							_renderVertexCoords[renderIndex*6+5] = (GLfloat)drawY;
+							_tessellateVertexCoords[renderIndex*6+2] = (GLfloat)lastX;
+							_tessellateVertexCoords[renderIndex*6+3] = (GLfloat)lastY;
+							_tessellateVertexCoords[renderIndex*6+4] = (GLfloat)drawX;
+							_tessellateVertexCoords[renderIndex*6+5] = (GLfloat)drawY;
 
 							for(int index1 = 0; index1 < 6; index1 += 2) {
 								if (minX == maxX) {
-									_renderTextureCoords[renderIndex*6+index1] = 0.0;
+									_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 								} else {
-									_renderTextureCoords[renderIndex*6+index1] = (_renderVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
+									_tessellateTextureCoords[renderIndex*6+index1] = (_tessellateVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
 								}
 								if (minY == maxY) {
-									_renderTextureCoords[renderIndex*6+index1] = 0.0;
+									_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 								} else {
-									_renderTextureCoords[renderIndex*6+index1+1] = (_renderVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
+									_tessellateTextureCoords[renderIndex*6+index1+1] = (_tessellateVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
 								}
 							}
 
 						} else {
 							if (fabs(dy) > fabs(dx)) {
-								_renderVertexCoords[renderIndex*8+0] = (GLfloat)drawX - (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+1] = (GLfloat)drawY + (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+2] = (GLfloat)lastX - (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+3] = (GLfloat)lastY + (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+4] = (GLfloat)drawX + (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+5] = (GLfloat)drawY - (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+6] = (GLfloat)lastX + (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+7] = (GLfloat)lastY - (dx * _renderStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+0] = (GLfloat)drawX - (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+1] = (GLfloat)drawY + (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+2] = (GLfloat)lastX - (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+3] = (GLfloat)lastY + (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+4] = (GLfloat)drawX + (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+5] = (GLfloat)drawY - (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+6] = (GLfloat)lastX + (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+7] = (GLfloat)lastY - (dx * _tessellateStroke->width / (2.0 * length));
 							} else {
-								_renderVertexCoords[renderIndex*8+0] = (GLfloat)lastX + (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+1] = (GLfloat)lastY - (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+2] = (GLfloat)drawX + (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+3] = (GLfloat)drawY - (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+4] = (GLfloat)lastX - (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+5] = (GLfloat)lastY + (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+6] = (GLfloat)drawX - (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+7] = (GLfloat)drawY + (dx * _renderStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+0] = (GLfloat)lastX + (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+1] = (GLfloat)lastY - (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+2] = (GLfloat)drawX + (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+3] = (GLfloat)drawY - (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+4] = (GLfloat)lastX - (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+5] = (GLfloat)lastY + (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+6] = (GLfloat)drawX - (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+7] = (GLfloat)drawY + (dx * _tessellateStroke->width / (2.0 * length));
 							}
 
 							for(int index1 = 0; index1 < 8; index1 += 2) {
 								if (minX == maxX) {
-									_renderTextureCoords[renderIndex*8+index1] = 0.0;
+									_tessellateTextureCoords[renderIndex*8+index1] = 0.0;
 								} else {
-									_renderTextureCoords[renderIndex*8+index1] = (_renderVertexCoords[renderIndex*8+index1] - minX) / (maxX - minX);
+									_tessellateTextureCoords[renderIndex*8+index1] = (_tessellateVertexCoords[renderIndex*8+index1] - minX) / (maxX - minX);
 								}
 								if (minY == maxY) {
-									_renderTextureCoords[renderIndex*8+index1] = 0.0;
+									_tessellateTextureCoords[renderIndex*8+index1] = 0.0;
 								} else {
-									_renderTextureCoords[renderIndex*8+index1+1] = (_renderVertexCoords[renderIndex*8+index1+1] - minY) / (maxY - minY);
+									_tessellateTextureCoords[renderIndex*8+index1+1] = (_tessellateVertexCoords[renderIndex*8+index1+1] - minY) / (maxY - minY);
 								}
 							}
 						}
@@ -3990,6 +7303,14 @@ void Graphics2D::renderDrawFillRoundRect(int commandCount)
 						lastX = drawX;
 						lastY = drawY;
 						renderIndex++;
+						if ((renderIndex*8 + 8) > MAX_VERTEX_COORDINATES) {
+							if (fill) {
+								tessellateTriangles(tessellated, renderIndex, 3);
+							} else {
+								tessellateTriangles(tessellated, renderIndex, 4);
+							}
+							renderIndex = 0;
+						}
 					}
 				} else {
 					lastX = drawX;
@@ -4014,174 +7335,181 @@ void Graphics2D::renderDrawFillRoundRect(int commandCount)
 			dy = ((GLfloat)y2 - (GLfloat)y1);
 			length = sqrt (fabs(dx * dx) + fabs(dy * dy));
 
-
 			if (fill) {
 				//qDebug()  << "Graphics2D::renderDrawRoundRect: " << fill << ":" << x1 << ":" << y1 << ":" << x2 << ":" << y2;
 
 				if (x2 < x1 && y1 == y2) {
-					_renderVertexCoords[renderIndex*6+0] = (GLfloat)x2;
-					_renderVertexCoords[renderIndex*6+1] = (GLfloat)y2 - height;
-					_renderVertexCoords[renderIndex*6+2] = (GLfloat)x1;
-					_renderVertexCoords[renderIndex*6+3] = (GLfloat)y1;
-					_renderVertexCoords[renderIndex*6+4] = (GLfloat)x2;
-					_renderVertexCoords[renderIndex*6+5] = (GLfloat)y2;
+					_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)x2;
+					_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)y2 - height;
+					_tessellateVertexCoords[renderIndex*6+2] = (GLfloat)x1;
+					_tessellateVertexCoords[renderIndex*6+3] = (GLfloat)y1;
+					_tessellateVertexCoords[renderIndex*6+4] = (GLfloat)x2;
+					_tessellateVertexCoords[renderIndex*6+5] = (GLfloat)y2;
 
 					for(int index1 = 0; index1 < 6; index1 += 2) {
 						if (minX == maxX) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1] = (_renderVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
+							_tessellateTextureCoords[renderIndex*6+index1] = (_tessellateVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
 						}
 						if (minY == maxY) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1+1] = (_renderVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
+							_tessellateTextureCoords[renderIndex*6+index1+1] = (_tessellateVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
 						}
 					}
 
 					renderIndex++;
 
-					_renderVertexCoords[renderIndex*6+0] = (GLfloat)x2;
-					_renderVertexCoords[renderIndex*6+1] = (GLfloat)y2 - height;
-					_renderVertexCoords[renderIndex*6+2] = (GLfloat)x1;
-					_renderVertexCoords[renderIndex*6+3] = (GLfloat)y1 - height;
-					_renderVertexCoords[renderIndex*6+4] = (GLfloat)x1;
-					_renderVertexCoords[renderIndex*6+5] = (GLfloat)y1;
+					_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)x2;
+					_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)y2 - height;
+					_tessellateVertexCoords[renderIndex*6+2] = (GLfloat)x1;
+					_tessellateVertexCoords[renderIndex*6+3] = (GLfloat)y1 - height;
+					_tessellateVertexCoords[renderIndex*6+4] = (GLfloat)x1;
+					_tessellateVertexCoords[renderIndex*6+5] = (GLfloat)y1;
 
 					for(int index1 = 0; index1 < 6; index1 += 2) {
 						if (minX == maxX) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1] = (_renderVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
+							_tessellateTextureCoords[renderIndex*6+index1] = (_tessellateVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
 						}
 						if (minY == maxY) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1+1] = (_renderVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
+							_tessellateTextureCoords[renderIndex*6+index1+1] = (_tessellateVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
 						}
 					}
 				}
 
 				if (y2 < y1 && x1 == x2) {
-					_renderVertexCoords[renderIndex*6+0] = (GLfloat)x1;
-					_renderVertexCoords[renderIndex*6+1] = (GLfloat)y1;
-					_renderVertexCoords[renderIndex*6+2] = (GLfloat)x2;
-					_renderVertexCoords[renderIndex*6+3] = (GLfloat)y2;
-					_renderVertexCoords[renderIndex*6+4] = (GLfloat)x2 + arcWidth;
-					_renderVertexCoords[renderIndex*6+5] = (GLfloat)y2;
+					_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)x1;
+					_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)y1;
+					_tessellateVertexCoords[renderIndex*6+2] = (GLfloat)x2;
+					_tessellateVertexCoords[renderIndex*6+3] = (GLfloat)y2;
+					_tessellateVertexCoords[renderIndex*6+4] = (GLfloat)x2 + arcWidth;
+					_tessellateVertexCoords[renderIndex*6+5] = (GLfloat)y2;
 
 					for(int index1 = 0; index1 < 6; index1 += 2) {
 						if (minX == maxX) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1] = (_renderVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
+							_tessellateTextureCoords[renderIndex*6+index1] = (_tessellateVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
 						}
 						if (minY == maxY) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1+1] = (_renderVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
+							_tessellateTextureCoords[renderIndex*6+index1+1] = (_tessellateVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
 						}
 					}
 					renderIndex++;
 
-					_renderVertexCoords[renderIndex*6+0] = (GLfloat)x2 + arcWidth;
-					_renderVertexCoords[renderIndex*6+1] = (GLfloat)y2;
-					_renderVertexCoords[renderIndex*6+2] = (GLfloat)x1 + arcWidth;
-					_renderVertexCoords[renderIndex*6+3] = (GLfloat)y1;
-					_renderVertexCoords[renderIndex*6+4] = (GLfloat)x1;
-					_renderVertexCoords[renderIndex*6+5] = (GLfloat)y1;
+					_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)x2 + arcWidth;
+					_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)y2;
+					_tessellateVertexCoords[renderIndex*6+2] = (GLfloat)x1 + arcWidth;
+					_tessellateVertexCoords[renderIndex*6+3] = (GLfloat)y1;
+					_tessellateVertexCoords[renderIndex*6+4] = (GLfloat)x1;
+					_tessellateVertexCoords[renderIndex*6+5] = (GLfloat)y1;
 
 					for(int index1 = 0; index1 < 6; index1 += 2) {
 						if (minX == maxX) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1] = (_renderVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
+							_tessellateTextureCoords[renderIndex*6+index1] = (_tessellateVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
 						}
 						if (minY == maxY) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1+1] = (_renderVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
+							_tessellateTextureCoords[renderIndex*6+index1+1] = (_tessellateVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
 						}
 					}
 				}
 
 				if (y2 > y1 && x1 == x2) {
-					_renderVertexCoords[renderIndex*6+0] = (GLfloat)x1;
-					_renderVertexCoords[renderIndex*6+1] = (GLfloat)y1;
-					_renderVertexCoords[renderIndex*6+2] = (GLfloat)x2;
-					_renderVertexCoords[renderIndex*6+3] = (GLfloat)y2;
-					_renderVertexCoords[renderIndex*6+4] = (GLfloat)x2 - arcWidth;
-					_renderVertexCoords[renderIndex*6+5] = (GLfloat)y2;
+					_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)x1;
+					_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)y1;
+					_tessellateVertexCoords[renderIndex*6+2] = (GLfloat)x2;
+					_tessellateVertexCoords[renderIndex*6+3] = (GLfloat)y2;
+					_tessellateVertexCoords[renderIndex*6+4] = (GLfloat)x2 - arcWidth;
+					_tessellateVertexCoords[renderIndex*6+5] = (GLfloat)y2;
 
 					for(int index1 = 0; index1 < 6; index1 += 2) {
 						if (minX == maxX) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1] = (_renderVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
+							_tessellateTextureCoords[renderIndex*6+index1] = (_tessellateVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
 						}
 						if (minY == maxY) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1+1] = (_renderVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
+							_tessellateTextureCoords[renderIndex*6+index1+1] = (_tessellateVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
 						}
 					}
 					renderIndex++;
 
-					_renderVertexCoords[renderIndex*6+0] = (GLfloat)x2 - arcWidth;
-					_renderVertexCoords[renderIndex*6+1] = (GLfloat)y2;
-					_renderVertexCoords[renderIndex*6+2] = (GLfloat)x1 - arcWidth;
-					_renderVertexCoords[renderIndex*6+3] = (GLfloat)y1;
-					_renderVertexCoords[renderIndex*6+4] = (GLfloat)x1;
-					_renderVertexCoords[renderIndex*6+5] = (GLfloat)y1;
+					_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)x2 - arcWidth;
+					_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)y2;
+					_tessellateVertexCoords[renderIndex*6+2] = (GLfloat)x1 - arcWidth;
+					_tessellateVertexCoords[renderIndex*6+3] = (GLfloat)y1;
+					_tessellateVertexCoords[renderIndex*6+4] = (GLfloat)x1;
+					_tessellateVertexCoords[renderIndex*6+5] = (GLfloat)y1;
 
 					for(int index1 = 0; index1 < 6; index1 += 2) {
 						if (minX == maxX) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1] = (_renderVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
+							_tessellateTextureCoords[renderIndex*6+index1] = (_tessellateVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
 						}
 						if (minY == maxY) {
-							_renderTextureCoords[renderIndex*6+index1] = 0.0;
+							_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 						} else {
-							_renderTextureCoords[renderIndex*6+index1+1] = (_renderVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
+							_tessellateTextureCoords[renderIndex*6+index1+1] = (_tessellateVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
 						}
 					}
 				}
 			} else {
 				if (fabs(dy) > fabs(dx)) {
-					_renderVertexCoords[renderIndex*8+0] = (GLfloat)x2 - (dy * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+1] = (GLfloat)y2 + (dx * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+2] = (GLfloat)x1 - (dy * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+3] = (GLfloat)y1 + (dx * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+4] = (GLfloat)x2 + (dy * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+5] = (GLfloat)y2 - (dx * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+6] = (GLfloat)x1 + (dy * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+7] = (GLfloat)y1 - (dx * _renderStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+0] = (GLfloat)x2 - (dy * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+1] = (GLfloat)y2 + (dx * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+2] = (GLfloat)x1 - (dy * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+3] = (GLfloat)y1 + (dx * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+4] = (GLfloat)x2 + (dy * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+5] = (GLfloat)y2 - (dx * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+6] = (GLfloat)x1 + (dy * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+7] = (GLfloat)y1 - (dx * _tessellateStroke->width / (2.0 * length));
 				} else {
-					_renderVertexCoords[renderIndex*8+0] = (GLfloat)x1 + (dy * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+1] = (GLfloat)y1 - (dx * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+2] = (GLfloat)x2 + (dy * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+3] = (GLfloat)y2 - (dx * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+4] = (GLfloat)x1 - (dy * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+5] = (GLfloat)y1 + (dx * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+6] = (GLfloat)x2 - (dy * _renderStroke->width / (2.0 * length));
-					_renderVertexCoords[renderIndex*8+7] = (GLfloat)y2 + (dx * _renderStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+0] = (GLfloat)x1 + (dy * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+1] = (GLfloat)y1 - (dx * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+2] = (GLfloat)x2 + (dy * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+3] = (GLfloat)y2 - (dx * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+4] = (GLfloat)x1 - (dy * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+5] = (GLfloat)y1 + (dx * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+6] = (GLfloat)x2 - (dy * _tessellateStroke->width / (2.0 * length));
+					_tessellateVertexCoords[renderIndex*8+7] = (GLfloat)y2 + (dx * _tessellateStroke->width / (2.0 * length));
 				}
 
 				for(int index1 = 0; index1 < 8; index1 += 2) {
 					if (minX == maxX) {
-						_renderTextureCoords[renderIndex*8+index1] = 0.0;
+						_tessellateTextureCoords[renderIndex*8+index1] = 0.0;
 					} else {
-						_renderTextureCoords[renderIndex*8+index1] = (_renderVertexCoords[renderIndex*8+index1] - minX) / (maxX - minX);
+						_tessellateTextureCoords[renderIndex*8+index1] = (_tessellateVertexCoords[renderIndex*8+index1] - minX) / (maxX - minX);
 					}
 					if (minY == maxY) {
-						_renderTextureCoords[renderIndex*8+index1] = 0.0;
+						_tessellateTextureCoords[renderIndex*8+index1] = 0.0;
 					} else {
-						_renderTextureCoords[renderIndex*8+index1+1] = (_renderVertexCoords[renderIndex*8+index1+1] - minY) / (maxY - minY);
+						_tessellateTextureCoords[renderIndex*8+index1+1] = (_tessellateVertexCoords[renderIndex*8+index1+1] - minY) / (maxY - minY);
 					}
 				}
 			}
 			renderIndex++;
+			if ((renderIndex*8 + 8) > MAX_VERTEX_COORDINATES) {
+				if (fill) {
+					tessellateTriangles(tessellated, renderIndex, 3);
+				} else {
+					tessellateTriangles(tessellated, renderIndex, 4);
+				}
+				renderIndex = 0;
+			}
 		}
 
 		if (drawSecondArc) {
@@ -4205,7 +7533,6 @@ void Graphics2D::renderDrawFillRoundRect(int commandCount)
 					drawY = -sin((360.0 - angle) * M_PI / 180.0);
 				}
 
-
 				drawX *= arcWidth;
 				drawY *= arcHeight;
 
@@ -4233,75 +7560,75 @@ void Graphics2D::renderDrawFillRoundRect(int commandCount)
 					dy = ((GLfloat)drawY - (GLfloat)lastY);
 					length = sqrt (fabs(dx * dx) + fabs(dy * dy));
 
-					if (!(fabs(dx) < 1.0 || fabs(dy) < 1.0) || length > 20.0 || drawAngle == endAngle) {
+					if (length > 0.0) {
 						if (fill) {
 							switch (quadrant) {
 							case 0:
-								_renderVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth + horizLength);
-								_renderVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight + vertLength);
+								_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth + horizLength);
+								_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight + vertLength);
 								break;
 							case 1:
-								_renderVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth);
-								_renderVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight + vertLength);
+								_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth);
+								_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight + vertLength);
 								break;
 							case 2:
-								_renderVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth);
-								_renderVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight);
+								_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth);
+								_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight);
 								break;
 							case 3:
-								_renderVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth + horizLength);
-								_renderVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight);
+								_tessellateVertexCoords[renderIndex*6+0] = (GLfloat)(x + arcWidth + horizLength);
+								_tessellateVertexCoords[renderIndex*6+1] = (GLfloat)(y + arcHeight);
 								break;
 							}
 
-							_renderVertexCoords[renderIndex*6+2] = (GLfloat)lastX;
-							_renderVertexCoords[renderIndex*6+3] = (GLfloat)lastY;
-							_renderVertexCoords[renderIndex*6+4] = (GLfloat)drawX;
-							_renderVertexCoords[renderIndex*6+5] = (GLfloat)drawY;
+							_tessellateVertexCoords[renderIndex*6+2] = (GLfloat)lastX;
+							_tessellateVertexCoords[renderIndex*6+3] = (GLfloat)lastY;
+							_tessellateVertexCoords[renderIndex*6+4] = (GLfloat)drawX;
+							_tessellateVertexCoords[renderIndex*6+5] = (GLfloat)drawY;
 
 							for(int index1 = 0; index1 < 6; index1 += 2) {
 								if (minX == maxX) {
-									_renderTextureCoords[renderIndex*6+index1] = 0.0;
+									_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 								} else {
-									_renderTextureCoords[renderIndex*6+index1] = (_renderVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
+									_tessellateTextureCoords[renderIndex*6+index1] = (_tessellateVertexCoords[renderIndex*6+index1] - minX) / (maxX - minX);
 								}
 								if (minY == maxY) {
-									_renderTextureCoords[renderIndex*6+index1] = 0.0;
+									_tessellateTextureCoords[renderIndex*6+index1] = 0.0;
 								} else {
-									_renderTextureCoords[renderIndex*6+index1+1] = (_renderVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
+									_tessellateTextureCoords[renderIndex*6+index1+1] = (_tessellateVertexCoords[renderIndex*6+index1+1] - minY) / (maxY - minY);
 								}
 							}
 						} else {
 							if (fabs(dy) > fabs(dx)) {
-								_renderVertexCoords[renderIndex*8+0] = (GLfloat)drawX - (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+1] = (GLfloat)drawY + (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+2] = (GLfloat)lastX - (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+3] = (GLfloat)lastY + (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+4] = (GLfloat)drawX + (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+5] = (GLfloat)drawY - (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+6] = (GLfloat)lastX + (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+7] = (GLfloat)lastY - (dx * _renderStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+0] = (GLfloat)drawX - (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+1] = (GLfloat)drawY + (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+2] = (GLfloat)lastX - (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+3] = (GLfloat)lastY + (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+4] = (GLfloat)drawX + (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+5] = (GLfloat)drawY - (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+6] = (GLfloat)lastX + (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+7] = (GLfloat)lastY - (dx * _tessellateStroke->width / (2.0 * length));
 							} else {
-								_renderVertexCoords[renderIndex*8+0] = (GLfloat)lastX + (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+1] = (GLfloat)lastY - (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+2] = (GLfloat)drawX + (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+3] = (GLfloat)drawY - (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+4] = (GLfloat)lastX - (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+5] = (GLfloat)lastY + (dx * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+6] = (GLfloat)drawX - (dy * _renderStroke->width / (2.0 * length));
-								_renderVertexCoords[renderIndex*8+7] = (GLfloat)drawY + (dx * _renderStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+0] = (GLfloat)lastX + (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+1] = (GLfloat)lastY - (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+2] = (GLfloat)drawX + (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+3] = (GLfloat)drawY - (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+4] = (GLfloat)lastX - (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+5] = (GLfloat)lastY + (dx * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+6] = (GLfloat)drawX - (dy * _tessellateStroke->width / (2.0 * length));
+								_tessellateVertexCoords[renderIndex*8+7] = (GLfloat)drawY + (dx * _tessellateStroke->width / (2.0 * length));
 							}
 
 							for(int index1 = 0; index1 < 8; index1 += 2) {
 								if (minX == maxX) {
-									_renderTextureCoords[renderIndex*8+index1] = 0.0;
+									_tessellateTextureCoords[renderIndex*8+index1] = 0.0;
 								} else {
-									_renderTextureCoords[renderIndex*8+index1] = (_renderVertexCoords[renderIndex*8+index1] - minX) / (maxX - minX);
+									_tessellateTextureCoords[renderIndex*8+index1] = (_tessellateVertexCoords[renderIndex*8+index1] - minX) / (maxX - minX);
 								}
 								if (minY == maxY) {
-									_renderTextureCoords[renderIndex*8+index1] = 0.0;
+									_tessellateTextureCoords[renderIndex*8+index1] = 0.0;
 								} else {
-									_renderTextureCoords[renderIndex*8+index1+1] = (_renderVertexCoords[renderIndex*8+index1+1] - minY) / (maxY - minY);
+									_tessellateTextureCoords[renderIndex*8+index1+1] = (_tessellateVertexCoords[renderIndex*8+index1+1] - minY) / (maxY - minY);
 								}
 							}
 						}
@@ -4309,6 +7636,14 @@ void Graphics2D::renderDrawFillRoundRect(int commandCount)
 						lastX = drawX;
 						lastY = drawY;
 						renderIndex++;
+						if ((renderIndex*8 + 8) > MAX_VERTEX_COORDINATES) {
+							if (fill) {
+								tessellateTriangles(tessellated, renderIndex, 3);
+							} else {
+								tessellateTriangles(tessellated, renderIndex, 4);
+							}
+							renderIndex = 0;
+						}
 					}
 				} else {
 					lastX = drawX;
@@ -4330,32 +7665,30 @@ void Graphics2D::renderDrawFillRoundRect(int commandCount)
 	}
 
 	if (fill) {
-		renderDrawTriangles(renderIndex, 3);
+		tessellateTriangles(tessellated, renderIndex, 3);
 	} else {
-		renderDrawTriangles(renderIndex, 4);
-	}
-
-	if (dashCoords) {
-		delete dashCoords;
+		tessellateTriangles(tessellated, renderIndex, 4);
 	}
 }
 
 // Draws the text given by the specified string, using this graphics context's current font and color.
-void Graphics2D::renderDrawString(int commandCount)
+void Graphics2D::renderDrawString(RenderCommandHeader* command)
 {
-	//qDebug()  << "Graphics2D::renderDrawString: " << commandCount << " : " << _drawFloatIndices[commandCount*2+0] << " " << _drawFloatIndices[commandCount*2+1];
+	//qDebug()  << "Graphics2D::renderDrawString: " << command->command << " : " << command->size;
 
-	QString *text;
-	wchar_t *wtext;
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
+
+	int textLength;
+	int* characters;
 	double x, y;
 
-	text = (QString*)_drawPointers[_drawPointerIndices[commandCount*2+0]+0];
-	wtext = new wchar_t[text->size()+1];
-	int length = text->toWCharArray(wtext);
-	wtext[text->size()] = 0;
+	// the text is stored as a count followed by the UCS-4 code points
+	textLength = ints[0];
+	characters = ints + 1;
 
-	x = _drawFloats[_drawFloatIndices[commandCount*2+0]+0];
-	y = _drawFloats[_drawFloatIndices[commandCount*2+0]+1];
+	x = floats[0];
+	y = floats[1];
 
 	//qDebug()  << "Graphics2D::renderDrawString: x,y: " << x << " : " << y;
 
@@ -4371,18 +7704,16 @@ void Graphics2D::renderDrawString(int commandCount)
         return;
     }
 
-    if (!text || !wtext) {
+    if (textLength == 0) {
         return;
     }
 
-    int textLength = wcslen(wtext);
-
+    reserveRenderCoords(textLength);
 
     int charMapIndex;
 	int previousCharMapIndex;
     float pen_x = 0.0f;
 
-
 	// calculate u,v texture bounds
 	float minX = 1.0e6, minY = 1.0e6, maxX = -1.0e6, maxY = -1.0e6;
 
@@ -4401,7 +7732,7 @@ void Graphics2D::renderDrawString(int commandCount)
 	}
 
     for(i = 0; i < textLength; ++i) {
-		c = (int)wtext[i];
+		c = (int)characters[i];
 
 		charMapIndex = 0;
 		for(j = 0; j < _renderFont->numberCharacters; j++) {
@@ -4414,7 +7745,7 @@ void Graphics2D::renderDrawString(int commandCount)
 		if (i > 0) {
 			previousCharMapIndex = 0;
 			for(j = 0; j < _renderFont->numberCharacters; j++) {
-				if (_renderFont->charMap[j] == wtext[i-1]) {
+				if (_renderFont->charMap[j] == characters[i-1]) {
 					previousCharMapIndex = j;
 					break;
 				}
@@ -4463,7 +7794,7 @@ void Graphics2D::renderDrawString(int commandCount)
 
     pen_x = 0.0f;
     for(i = 0; i < textLength; ++i) {
-		c = (int)wtext[i];
+		c = (int)characters[i];
 
 		charMapIndex = 0;
 		for(j = 0; j < _renderFont->numberCharacters; j++) {
@@ -4476,7 +7807,7 @@ void Graphics2D::renderDrawString(int commandCount)
 		if (i > 0) {
 			previousCharMapIndex = 0;
 			for(j = 0; j < _renderFont->numberCharacters; j++) {
-				if (_renderFont->charMap[j] == wtext[i-1]) {
+				if (_renderFont->charMap[j] == characters[i-1]) {
 					previousCharMapIndex = j;
 					break;
 				}
@@ -4545,357 +7876,267 @@ void Graphics2D::renderDrawString(int commandCount)
 		pen_x += _renderFont->advance[charMapIndex];
     }
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	setBlending(true);
+	setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	int coordBytes = textLength * 8 * sizeof(GLfloat);
+	int indexBytes = textLength * 6 * sizeof(GLuint);
 
 #ifdef GLES1
-	glEnable(GL_TEXTURE_2D);
+	setTexturing(true);
 
 	glColor4f(_renderForegroundColor.red, _renderForegroundColor.green, _renderForegroundColor.blue, _renderForegroundColor.alpha);
 
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	useClientArrays(CLIENT_VERTEX_ARRAY | CLIENT_TEXTURE_COORD_ARRAY);
 
-	glVertexPointer(2, GL_FLOAT, 0, _renderVertexCoords);
-	glTexCoordPointer(2, GL_FLOAT, 0, _renderMaskTextureCoords);
-	glBindTexture(GL_TEXTURE_2D, _renderFont->fontTexture);
+	_renderStream->reserve(coordBytes * 2, indexBytes);
 
-	glDrawElements(GL_TRIANGLES, 6 * textLength, GL_UNSIGNED_INT, _renderVertexIndices);
+	glVertexPointer(2, GL_FLOAT, 0, _renderStream->writeVertices(_renderVertexCoords, coordBytes));
+	glTexCoordPointer(2, GL_FLOAT, 0, _renderStream->writeVertices(_renderMaskTextureCoords, coordBytes));
+	bindTexture(_renderFont->fontTexture);
 
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisable(GL_TEXTURE_2D);
+	glDrawElements(GL_TRIANGLES, 6 * textLength, GL_UNSIGNED_INT, _renderStream->writeIndices(_renderVertexIndices, indexBytes));
 
 #elif defined GLES2
 
 	if (_renderGradient) {
 		//Render text
-		glUseProgram(_textGradientRenderingProgram);
+		useProgram(_textGradientRenderingProgram);
 
 		// Store the locations of the shader variables we need later
-		GLint positionLoc = glGetAttribLocation(_textGradientRenderingProgram, "a_position");
-		GLint maskTextcoordLoc = glGetAttribLocation(_textGradientRenderingProgram, "a_maskTexcoord");
-		GLint texcoordLoc = glGetAttribLocation(_textGradientRenderingProgram, "a_texcoord");
-		GLint textureLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_texture");
-		GLint colorLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_color");
-		GLint pmLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_projectionMatrix");
-		GLint mvmLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_modelViewMatrix");
-
-	    GLint segmentsLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_segments");
-		GLint colorsLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_colors");
-		GLint percentagesLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_percentages");
-		GLint radiusLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_radius");
-		GLint angleLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_angle");
-		GLint originLoc = glGetUniformLocation(_textGradientRenderingProgram, "u_origin");
-
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-
+		GLint positionLoc = _textGradientLocations.position;
+		GLint maskTextcoordLoc = _textGradientLocations.maskTexcoord;
+		GLint texcoordLoc = _textGradientLocations.texcoord;
+		GLint textureLoc = _textGradientLocations.texture;
+		GLint colorLoc = _textGradientLocations.color;
+		GLint pmLoc = _textGradientLocations.projectionMatrix;
+		GLint mvmLoc = _textGradientLocations.modelViewMatrix;
+
+		GLint gradientLoc = _textGradientLocations.gradient;
+		GLint radiusLoc = _textGradientLocations.radius;
+		GLint angleLoc = _textGradientLocations.angle;
+		GLint originLoc = _textGradientLocations.origin;
+
+		// the glyphs are on the first texture unit, which is the one tracked, and the gradient colors on the second
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, _renderFont->fontTexture);
+		GLuint lookupTexture = gradientTexture(_renderGradient);
+		bindTexture(_renderFont->fontTexture);
 		glUniform1i(textureLoc, 0);
 
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, lookupTexture);
+		glUniform1i(gradientLoc, 1);
+		glActiveTexture(GL_TEXTURE0);
+
 		glUniformMatrix4fv(pmLoc, 1, GL_FALSE, _orthoMatrix);
 		glUniformMatrix4fv(mvmLoc, 1, GL_FALSE, _renderModelMatrix);
 		glUniform4f(colorLoc, _renderForegroundColor.red, _renderForegroundColor.green, _renderForegroundColor.blue, _renderForegroundColor.alpha);
-		glUniform1i(segmentsLoc, _renderGradient->segments);
-
-		GLfloat gradientColors[400];
-		for(int index = 0; index < _renderGradient->segments+1; index++) {
-			gradientColors[index*4+0] = _renderGradient->colors[index].red;
-			gradientColors[index*4+1] = _renderGradient->colors[index].green;
-			gradientColors[index*4+2] = _renderGradient->colors[index].blue;
-			gradientColors[index*4+3] = _renderGradient->colors[index].alpha;
-		}
-		glUniform4fv(colorsLoc, _renderGradient->segments+1, gradientColors);
-		glUniform1fv(percentagesLoc, _renderGradient->segments*2+1, _renderGradient->percentages);
 		glUniform1f(radiusLoc, _renderGradient->radius);
 		glUniform1f(angleLoc, _renderGradient->angle);
 		glUniform2f(originLoc, _renderGradient->originU, _renderGradient->originV);
 
+		useVertexAttribArrays(attribBit(positionLoc) | attribBit(maskTextcoordLoc) | attribBit(texcoordLoc));
 
-		glEnableVertexAttribArray(positionLoc);
-		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderVertexCoords);
-
-		glEnableVertexAttribArray(maskTextcoordLoc);
-		glVertexAttribPointer(maskTextcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderMaskTextureCoords);
+		_renderStream->reserve(coordBytes * 3, indexBytes);
 
-		glEnableVertexAttribArray(texcoordLoc);
-		glVertexAttribPointer(texcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderTextureCoords);
+		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(_renderVertexCoords, coordBytes));
+		glVertexAttribPointer(maskTextcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(_renderMaskTextureCoords, coordBytes));
+		glVertexAttribPointer(texcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(_renderTextureCoords, coordBytes));
 
 		   //Draw the string
-		glDrawElements(GL_TRIANGLES, 6 * textLength, GL_UNSIGNED_INT, _renderVertexIndices);
-
-		glDisableVertexAttribArray(texcoordLoc);
-		glDisableVertexAttribArray(maskTextcoordLoc);
-		glDisableVertexAttribArray(positionLoc);
+		glDrawElements(GL_TRIANGLES, 6 * textLength, GL_UNSIGNED_INT, _renderStream->writeIndices(_renderVertexIndices, indexBytes));
 
 	} else {
 		//Render text
-		glUseProgram(_textRenderingProgram);
+		useProgram(_textRenderingProgram);
 
 		// Store the locations of the shader variables we need later
-		GLint positionLoc = glGetAttribLocation(_textRenderingProgram, "a_position");
-		GLint texcoordLoc = glGetAttribLocation(_textRenderingProgram, "a_texcoord");
-		GLint textureLoc = glGetUniformLocation(_textRenderingProgram, "u_texture");
-		GLint colorLoc = glGetUniformLocation(_textRenderingProgram, "u_color");
-		GLint pmLoc = glGetUniformLocation(_textRenderingProgram, "u_projectionMatrix");
-		GLint mvmLoc = glGetUniformLocation(_textRenderingProgram, "u_modelViewMatrix");
-
-
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		GLint positionLoc = _textLocations.position;
+		GLint texcoordLoc = _textLocations.texcoord;
+		GLint textureLoc = _textLocations.texture;
+		GLint colorLoc = _textLocations.color;
+		GLint pmLoc = _textLocations.projectionMatrix;
+		GLint mvmLoc = _textLocations.modelViewMatrix;
 
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, _renderFont->fontTexture);
+		bindTexture(_renderFont->fontTexture);
 		glUniform1i(textureLoc, 0);
 
 		glUniformMatrix4fv(pmLoc, 1, GL_FALSE, _orthoMatrix);
 		glUniformMatrix4fv(mvmLoc, 1, GL_FALSE, _renderModelMatrix);
 		glUniform4f(colorLoc, _renderForegroundColor.red, _renderForegroundColor.green, _renderForegroundColor.blue, _renderForegroundColor.alpha);
 
-		glEnableVertexAttribArray(positionLoc);
-		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderVertexCoords);
+		useVertexAttribArrays(attribBit(positionLoc) | attribBit(texcoordLoc));
 
-		glEnableVertexAttribArray(texcoordLoc);
-		glVertexAttribPointer(texcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderMaskTextureCoords);
+		_renderStream->reserve(coordBytes * 2, indexBytes);
 
-		   //Draw the string
-		glDrawElements(GL_TRIANGLES, 6 * textLength, GL_UNSIGNED_INT, _renderVertexIndices);
+		glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(_renderVertexCoords, coordBytes));
+		glVertexAttribPointer(texcoordLoc, 2, GL_FLOAT, GL_FALSE, 0, _renderStream->writeVertices(_renderMaskTextureCoords, coordBytes));
 
-		glDisableVertexAttribArray(texcoordLoc);
-		glDisableVertexAttribArray(positionLoc);
+		   //Draw the string
+		glDrawElements(GL_TRIANGLES, 6 * textLength, GL_UNSIGNED_INT, _renderStream->writeIndices(_renderVertexIndices, indexBytes));
 	}
 #else
 #error libviews should be compiled with either GLES1 or GLES2 -D flags.
 #endif
-	glDisable(GL_BLEND);
+
+	_drawCalls++;
 }
 
-// Draws a sequence of connected lines defined by arrays of x and y coordinates.
-void Graphics2D::renderFillPolygon(int commandCount)
+// twice the signed area of the triangle a, b, c - positive when it turns counter clockwise
+static GLfloat polygonCross(const GLfloat* coords, int a, int b, int c)
 {
-	qDebug()  << "Graphics2D::renderFillPolygon: " << commandCount;
+	return (coords[b*2+0] - coords[a*2+0]) * (coords[c*2+1] - coords[a*2+1]) - (coords[b*2+1] - coords[a*2+1]) * (coords[c*2+0] - coords[a*2+0]);
+}
 
-	GLfloat dx, dy, lineLength;
+// returns true if point lies inside or on the edge of the triangle a, b, c wound the given way
+static bool polygonContains(const GLfloat* coords, int a, int b, int c, int point, GLfloat winding)
+{
+	return polygonCross(coords, a, b, point) * winding >= 0.0
+			&& polygonCross(coords, b, c, point) * winding >= 0.0
+			&& polygonCross(coords, c, a, point) * winding >= 0.0;
+}
 
-	int nPoints = _drawInts[_drawIntIndices[commandCount*2+0]+0];
+// Fills the specified polygon, as a fan if it is convex and by clipping ears off it otherwise.
+void Graphics2D::tessellatePolygon(RenderCommandHeader* command, CommandBuffer* tessellated)
+{
+	GLfloat* floats = commandFloats(command);
+	int* ints = commandInts(command);
 
-	qDebug()  << "Graphics2D::renderFillPolygon: numberPoints: " << nPoints;
+	int nPoints = ints[0];
 
-	float* xPoints = NULL;
-	float* yPoints = NULL;
-	float* uPoints = NULL;
-	float* vPoints = NULL;
+	//qDebug()  << "Graphics2D::tessellatePolygon: numberPoints: " << nPoints;
 
-	xPoints = new float[nPoints];
-	yPoints = new float[nPoints];
-	uPoints = new float[nPoints];
-	vPoints = new float[nPoints];
+	fillOutline(tessellated, floats, floats + nPoints * 2, nPoints);
+}
 
-	float x = 0.0, y = 0.0, u, v, minX = 1.0e6, minY = 1.0e6, maxX = -1.0e6, maxY = -1.0e6;
+// Fills an outline of count (x,y) points with the given texture coordinates into the mesh being tessellated.
+void Graphics2D::fillOutline(CommandBuffer* tessellated, const GLfloat* polygon, const GLfloat* textureCoords, int nPoints)
+{
+	if (nPoints < 3) {
+		return;
+	}
 
-	for(int index = 0; index < nPoints; index++) {
-		xPoints[index] = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+0];
-		yPoints[index] = _drawFloats[_drawFloatIndices[commandCount*2+0]+index*2+1];
-		uPoints[index] = _drawFloats[_drawFloatIndices[commandCount*2+0]+nPoints*2+index*2+0];
-		vPoints[index] = _drawFloats[_drawFloatIndices[commandCount*2+0]+nPoints*2+index*2+1];
+	if (nPoints > VERTEX_BATCH_MAX_VERTICES) {
+		qCritical() << "Graphics2D::fillOutline: too many points: " << nPoints;
+		return;
+	}
 
-		x += xPoints[index];
-		y += yPoints[index];
+	// outline, previous and next point of each corner still to be clipped
+	int* points = tessellatePolygonLinks(nPoints * 3);
+	int* previous = points + nPoints;
+	int* next = previous + nPoints;
 
-		if (xPoints[index] < minX) {
-			minX = xPoints[index];
-		}
-		if (xPoints[index] > maxX) {
-			maxX = xPoints[index];
+	// repeated points, the closing one included, would make empty ears
+	int count = 0;
+	for(int index = 0; index < nPoints; index++) {
+		if (count > 0 && polygon[index*2+0] == polygon[points[count-1]*2+0] && polygon[index*2+1] == polygon[points[count-1]*2+1]) {
+			continue;
 		}
+		points[count++] = index;
+	}
+	if (count > 1 && polygon[points[0]*2+0] == polygon[points[count-1]*2+0] && polygon[points[0]*2+1] == polygon[points[count-1]*2+1]) {
+		count--;
+	}
 
-		if (yPoints[index] < minY) {
-			minY = yPoints[index];
-		}
-		if (yPoints[index] > maxY) {
-			maxY = yPoints[index];
-		}
+	if (count < 3) {
+		return;
 	}
 
-	x /= nPoints;
-	y /= nPoints;
+	GLfloat area = 0.0;
+	for(int index = 0; index < count; index++) {
+		int point = points[index];
+		int following = points[(index + 1) % count];
+		area += polygon[point*2+0] * polygon[following*2+1] - polygon[following*2+0] * polygon[point*2+1];
+	}
 
-	if (minX == maxX) {
-		u = 0.0;
-	} else {
-		u = (x - minX) / (maxX - minX);
+	if (area == 0.0) {
+		return;
 	}
-	if (minY == maxY) {
-		v = 0.0;
-	} else {
-		v = (y - minY) / (maxY - minY);
+
+	// triangles are emitted counter clockwise whichever way the outline runs, so none of them is culled
+	GLfloat winding = area > 0.0 ? 1.0 : -1.0;
+
+	if (!_tessellateMesh->hasRoomFor(count)) {
+		emitMesh(tessellated);
 	}
 
-	int renderIndex = 0;
+	int first = _tessellateMesh->vertexCount();
+	for(int index = 0; index < count; index++) {
+		int point = points[index];
+		_tessellateMesh->addVertex(polygon[point*2+0], polygon[point*2+1], textureCoords[point*2+0], textureCoords[point*2+1]);
+	}
 
-	switch (nPoints) {
-	case 3:
-		dx = ((GLfloat)xPoints[1] - (GLfloat)xPoints[0]);
-		dy = ((GLfloat)yPoints[1] - (GLfloat)yPoints[0]);
-		lineLength = sqrt (fabs(dx * dx) + fabs(dy * dy));
-		dx /= lineLength;
-		dy /= lineLength;
-
-
-		qDebug()  << "Graphics2D::renderFillPolygon: dx/dy: " << dx << " " << dy;
-
-		if (fabs(dy) > fabs(dx)) {
-			_renderVertexCoords[0] = (GLfloat)xPoints[1];
-			_renderVertexCoords[1] = (GLfloat)yPoints[1];
-			_renderVertexCoords[2] = (GLfloat)xPoints[0];
-			_renderVertexCoords[3] = (GLfloat)yPoints[0];
-			_renderVertexCoords[4] = (GLfloat)xPoints[2];
-			_renderVertexCoords[5] = (GLfloat)yPoints[2];
-
-			_renderTextureCoords[0] = (GLfloat)uPoints[1];
-			_renderTextureCoords[1] = (GLfloat)vPoints[1];
-			_renderTextureCoords[2] = (GLfloat)uPoints[0];
-			_renderTextureCoords[3] = (GLfloat)vPoints[0];
-			_renderTextureCoords[4] = (GLfloat)uPoints[2];
-			_renderTextureCoords[5] = (GLfloat)vPoints[2];
-		} else {
-			_renderVertexCoords[2] = (GLfloat)xPoints[0];
-			_renderVertexCoords[3] = (GLfloat)yPoints[0];
-			_renderVertexCoords[0] = (GLfloat)xPoints[1];
-			_renderVertexCoords[1] = (GLfloat)yPoints[1];
-			_renderVertexCoords[4] = (GLfloat)xPoints[2];
-			_renderVertexCoords[5] = (GLfloat)yPoints[2];
-
-			_renderTextureCoords[2] = (GLfloat)uPoints[0];
-			_renderTextureCoords[3] = (GLfloat)vPoints[0];
-			_renderTextureCoords[0] = (GLfloat)uPoints[1];
-			_renderTextureCoords[1] = (GLfloat)vPoints[1];
-			_renderTextureCoords[4] = (GLfloat)uPoints[2];
-			_renderTextureCoords[5] = (GLfloat)vPoints[2];
-		}
-		break;
+	GLfloat* coords = _tessellateMesh->vertexCoords() + first * 2;
 
-	case 4:
-		dx = ((GLfloat)xPoints[1] - (GLfloat)xPoints[0]);
-		dy = ((GLfloat)yPoints[2] - (GLfloat)yPoints[1]);
-		lineLength = sqrt (fabs(dx * dx) + fabs(dy * dy));
-		dx /= lineLength;
-		dy /= lineLength;
-
-		if (fabs(dy) > fabs(dx)) {
-			_renderVertexCoords[0] = (GLfloat)xPoints[1];
-			_renderVertexCoords[1] = (GLfloat)yPoints[1];
-			_renderVertexCoords[2] = (GLfloat)xPoints[0];
-			_renderVertexCoords[3] = (GLfloat)yPoints[0];
-			_renderVertexCoords[4] = (GLfloat)xPoints[3];
-			_renderVertexCoords[5] = (GLfloat)yPoints[3];
-			_renderVertexCoords[6] = (GLfloat)xPoints[2];
-			_renderVertexCoords[7] = (GLfloat)yPoints[2];
-
-			_renderTextureCoords[0] = (GLfloat)uPoints[1];
-			_renderTextureCoords[1] = (GLfloat)vPoints[1];
-			_renderTextureCoords[2] = (GLfloat)uPoints[0];
-			_renderTextureCoords[3] = (GLfloat)vPoints[0];
-			_renderTextureCoords[4] = (GLfloat)uPoints[3];
-			_renderTextureCoords[5] = (GLfloat)vPoints[3];
-			_renderTextureCoords[6] = (GLfloat)uPoints[2];
-			_renderTextureCoords[7] = (GLfloat)vPoints[2];
-		} else {
-			_renderVertexCoords[2] = (GLfloat)xPoints[0];
-			_renderVertexCoords[3] = (GLfloat)yPoints[0];
-			_renderVertexCoords[0] = (GLfloat)xPoints[1];
-			_renderVertexCoords[1] = (GLfloat)yPoints[1];
-			_renderVertexCoords[4] = (GLfloat)xPoints[3];
-			_renderVertexCoords[5] = (GLfloat)yPoints[3];
-			_renderVertexCoords[6] = (GLfloat)xPoints[2];
-			_renderVertexCoords[7] = (GLfloat)yPoints[2];
-
-			_renderTextureCoords[2] = (GLfloat)uPoints[0];
-			_renderTextureCoords[3] = (GLfloat)vPoints[0];
-			_renderTextureCoords[0] = (GLfloat)uPoints[1];
-			_renderTextureCoords[1] = (GLfloat)vPoints[1];
-			_renderTextureCoords[4] = (GLfloat)uPoints[3];
-			_renderTextureCoords[5] = (GLfloat)vPoints[3];
-			_renderTextureCoords[6] = (GLfloat)uPoints[2];
-			_renderTextureCoords[7] = (GLfloat)vPoints[2];
+	bool convex = true;
+	for(int index = 0; index < count; index++) {
+		if (polygonCross(coords, (index + count - 1) % count, index, (index + 1) % count) * winding < 0.0) {
+			convex = false;
+			break;
 		}
-		break;
+	}
 
-	default:
-		for(int index = 0; index < nPoints-1; index ++) {
-			dx = ((GLfloat)xPoints[index+1] - (GLfloat)xPoints[index]);
-			dy = ((GLfloat)yPoints[index+1] - (GLfloat)yPoints[index]);
-			lineLength = sqrt (fabs(dx * dx) + fabs(dy * dy));
-			dx /= lineLength;
-			dy /= lineLength;
-
-			if (fabs(dy) > fabs(dx)) {
-				_renderVertexCoords[renderIndex*6+0] = (GLfloat)xPoints[index+1];
-				_renderVertexCoords[renderIndex*6+1] = (GLfloat)yPoints[index+1];
-				_renderVertexCoords[renderIndex*6+2] = (GLfloat)xPoints[index];
-				_renderVertexCoords[renderIndex*6+3] = (GLfloat)yPoints[index];
-				_renderVertexCoords[renderIndex*6+4] = (GLfloat)x;
-				_renderVertexCoords[renderIndex*6+5] = (GLfloat)y;
-
-				_renderTextureCoords[renderIndex*6+0] = (GLfloat)uPoints[index+1];
-				_renderTextureCoords[renderIndex*6+1] = (GLfloat)vPoints[index+1];
-				_renderTextureCoords[renderIndex*6+2] = (GLfloat)uPoints[index];
-				_renderTextureCoords[renderIndex*6+3] = (GLfloat)vPoints[index];
-				_renderTextureCoords[renderIndex*6+4] = (GLfloat)u;
-				_renderTextureCoords[renderIndex*6+5] = (GLfloat)v;
+	if (convex) {
+		for(int index = 1; index < count - 1; index++) {
+			if (winding > 0.0) {
+				_tessellateMesh->addTriangle(first, first + index, first + index + 1);
 			} else {
-				_renderVertexCoords[renderIndex*6+2] = (GLfloat)xPoints[index];
-				_renderVertexCoords[renderIndex*6+3] = (GLfloat)vPoints[index];
-				_renderVertexCoords[renderIndex*6+0] = (GLfloat)xPoints[index+1];
-				_renderVertexCoords[renderIndex*6+1] = (GLfloat)vPoints[index+1];
-				_renderVertexCoords[renderIndex*6+4] = (GLfloat)x;
-				_renderVertexCoords[renderIndex*6+5] = (GLfloat)v;
-
-				_renderTextureCoords[renderIndex*6+2] = (GLfloat)uPoints[index];
-				_renderTextureCoords[renderIndex*6+3] = (GLfloat)vPoints[index];
-				_renderTextureCoords[renderIndex*6+0] = (GLfloat)uPoints[index+1];
-				_renderTextureCoords[renderIndex*6+1] = (GLfloat)vPoints[index+1];
-				_renderTextureCoords[renderIndex*6+4] = (GLfloat)u;
-				_renderTextureCoords[renderIndex*6+5] = (GLfloat)v;
+				_tessellateMesh->addTriangle(first, first + index + 1, first + index);
 			}
+		}
+		return;
+	}
 
-			renderIndex++;
-
-			if ((renderIndex*6 + 6) > MAX_VERTEX_COORDINATES) {
-				renderDrawTriangles(renderIndex, 3);
+	for(int index = 0; index < count; index++) {
+		previous[index] = (index + count - 1) % count;
+		next[index] = (index + 1) % count;
+	}
 
-				renderIndex = 0;
-			}
+	int remaining = count;
+	int vertex = 0;
+	int stalled = 0;
 
-		}
-		break;
-	}
+	while (remaining > 3) {
+		int before = previous[vertex];
+		int after = next[vertex];
 
-	switch (nPoints) {
-	case 3:
+		bool ear = polygonCross(coords, before, vertex, after) * winding > 0.0;
 
-		qDebug()  << "Graphics2D::renderFillPolygon: render for 3: ";
-		renderDrawTriangles(1, 3);
-		break;
+		// an ear may not have any other corner inside it, though one lying on the diagonal that closes it is fine
+		for(int other = next[after]; ear && other != before; other = next[other]) {
+			if (polygonContains(coords, before, vertex, after, other, winding)
+					&& polygonCross(coords, before, other, after) != 0.0) {
+				ear = false;
+			}
+		}
 
-	case 4:
-		renderDrawTriangles(1, 4);
-		break;
+		// a self intersecting outline can run out of ears, so go round once more before clipping regardless
+		if (ear || stalled > remaining) {
+			if (winding > 0.0) {
+				_tessellateMesh->addTriangle(first + before, first + vertex, first + after);
+			} else {
+				_tessellateMesh->addTriangle(first + before, first + after, first + vertex);
+			}
 
-	default:
-		renderDrawTriangles(renderIndex, 3);
-		break;
+			next[before] = after;
+			previous[after] = before;
+			remaining--;
+			stalled = 0;
+			vertex = after;
+		} else {
+			stalled++;
+			vertex = after;
+		}
 	}
 
-	if (xPoints) {
-		delete xPoints;
-	}
-	if (yPoints) {
-		delete yPoints;
+	if (winding > 0.0) {
+		_tessellateMesh->addTriangle(first + previous[vertex], first + vertex, first + next[vertex]);
+	} else {
+		_tessellateMesh->addTriangle(first + previous[vertex], first + next[vertex], first + vertex);
 	}
 }
 
-
 	}
 }
 
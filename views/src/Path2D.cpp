@@ -0,0 +1,439 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Path2D.hpp"
+
+#include <math.h>
+
+#include <QDebug>
+
+namespace views {
+	namespace graphics {
+
+// versions are handed out from one counter so a path freed and another made at the same address never look the same
+static int lastPathVersion = 0;
+
+Path2D::Path2D()
+{
+	_startX = 0.0;
+	_startY = 0.0;
+	_currentX = 0.0;
+	_currentY = 0.0;
+
+	_fillRule = FILL_RULE_NONZERO;
+	_fillMode = FILL_MODE_AUTO;
+
+	_version = ++lastPathVersion;
+
+	_flatVersion = 0;
+	_flatTolerance = 0.0;
+
+	_meshCache.setMaxCost(PATH_MESH_CACHE_SIZE);
+}
+
+Path2D::~Path2D()
+{
+}
+
+void Path2D::moveTo(double x, double y)
+{
+	GLfloat coords[2] = { (GLfloat)x, (GLfloat)y };
+
+	// a subpath with nothing in it yet just moves
+	if (!_segments.isEmpty() && _segments.last() == SEG_MOVETO) {
+		_coords[_coords.size() - 2] = coords[0];
+		_coords[_coords.size() - 1] = coords[1];
+		_currentX = coords[0];
+		_currentY = coords[1];
+		changed();
+	} else {
+		appendSegment(SEG_MOVETO, coords, 1);
+	}
+
+	_startX = coords[0];
+	_startY = coords[1];
+}
+
+void Path2D::lineTo(double x, double y)
+{
+	GLfloat coords[2] = { (GLfloat)x, (GLfloat)y };
+
+	beginSegment(x, y);
+	appendSegment(SEG_LINETO, coords, 1);
+}
+
+void Path2D::quadTo(double cx, double cy, double x, double y)
+{
+	GLfloat coords[4] = { (GLfloat)cx, (GLfloat)cy, (GLfloat)x, (GLfloat)y };
+
+	beginSegment(cx, cy);
+	appendSegment(SEG_QUADTO, coords, 2);
+}
+
+void Path2D::cubicTo(double c1x, double c1y, double c2x, double c2y, double x, double y)
+{
+	GLfloat coords[6] = { (GLfloat)c1x, (GLfloat)c1y, (GLfloat)c2x, (GLfloat)c2y, (GLfloat)x, (GLfloat)y };
+
+	beginSegment(c1x, c1y);
+	appendSegment(SEG_CUBICTO, coords, 3);
+}
+
+void Path2D::arcTo(double x1, double y1, double x2, double y2, double radius)
+{
+	if (radius < 0.0) {
+		qCritical() << "Path2D::arcTo: negative radius " << radius;
+		return;
+	}
+
+	beginSegment(x1, y1);
+
+	// unit directions from the corner back to the current point and on to the end point
+	double ux = _currentX - x1;
+	double uy = _currentY - y1;
+	double vx = x2 - x1;
+	double vy = y2 - y1;
+	double uLength = sqrt(ux * ux + uy * uy);
+	double vLength = sqrt(vx * vx + vy * vy);
+
+	if (radius == 0.0 || uLength == 0.0 || vLength == 0.0) {
+		lineTo(x1, y1);
+		return;
+	}
+
+	ux /= uLength;
+	uy /= uLength;
+	vx /= vLength;
+	vy /= vLength;
+
+	// lines running straight on or doubling back have no arc between them
+	double cross = ux * vy - uy * vx;
+	if (fabs(cross) < 1.0e-6) {
+		lineTo(x1, y1);
+		return;
+	}
+
+	double corner = acos(qBound(-1.0, ux * vx + uy * vy, 1.0));
+	double tangent = radius / tan(corner / 2.0);
+	double centre = radius / sin(corner / 2.0);
+
+	double bx = ux + vx;
+	double by = uy + vy;
+	double bLength = sqrt(bx * bx + by * by);
+
+	double cx = x1 + bx / bLength * centre;
+	double cy = y1 + by / bLength * centre;
+
+	double startX = x1 + ux * tangent;
+	double startY = y1 + uy * tangent;
+	double endX = x1 + vx * tangent;
+	double endY = y1 + vy * tangent;
+
+	lineTo(startX, startY);
+
+	// the arc turns through less than half a circle, so the shorter way round is the right one
+	double startAngle = atan2(startY - cy, startX - cx);
+	double sweep = atan2(endY - cy, endX - cx) - startAngle;
+	if (sweep > M_PI) {
+		sweep -= 2.0 * M_PI;
+	} else if (sweep < -M_PI) {
+		sweep += 2.0 * M_PI;
+	}
+
+	appendArc(cx, cy, radius, startAngle, sweep);
+}
+
+void Path2D::close()
+{
+	if (_segments.isEmpty() || _segments.last() == SEG_CLOSE) {
+		return;
+	}
+
+	appendSegment(SEG_CLOSE, NULL, 0);
+
+	_currentX = _startX;
+	_currentY = _startY;
+}
+
+void Path2D::clear()
+{
+	_segments.resize(0);
+	_coords.resize(0);
+
+	_startX = 0.0;
+	_startY = 0.0;
+	_currentX = 0.0;
+	_currentY = 0.0;
+
+	changed();
+}
+
+bool Path2D::isEmpty()
+{
+	return _segments.isEmpty();
+}
+
+void Path2D::setFillRule(int fillRule)
+{
+	if (fillRule != _fillRule) {
+		_fillRule = fillRule;
+		changed();
+	}
+}
+
+int Path2D::fillRule()
+{
+	return _fillRule;
+}
+
+void Path2D::setFillMode(int fillMode)
+{
+	if (fillMode != _fillMode) {
+		_fillMode = fillMode;
+		changed();
+	}
+}
+
+int Path2D::fillMode()
+{
+	return _fillMode;
+}
+
+int Path2D::version()
+{
+	return _version;
+}
+
+bool Path2D::bounds(GLfloat* bounds)
+{
+	if (_coords.isEmpty()) {
+		return false;
+	}
+
+	// curves never leave the hull of their control points
+	const GLfloat* coords = _coords.constData();
+
+	bounds[0] = coords[0];
+	bounds[1] = coords[1];
+	bounds[2] = coords[0];
+	bounds[3] = coords[1];
+
+	for(int index = 1; index < _coords.size() / 2; index++) {
+		bounds[0] = qMin(bounds[0], coords[index*2+0]);
+		bounds[1] = qMin(bounds[1], coords[index*2+1]);
+		bounds[2] = qMax(bounds[2], coords[index*2+0]);
+		bounds[3] = qMax(bounds[3], coords[index*2+1]);
+	}
+
+	return true;
+}
+
+// returns how many straight lines a curve needs to stay within tolerance, from the largest second difference of its points
+static int curveSteps(GLfloat difference, GLfloat scale, GLfloat tolerance)
+{
+	// a curve cut into n even steps strays from them by at most its second derivative over 8 n squared
+	int steps = (int)ceil(sqrt(scale * difference / (8.0 * tolerance)));
+
+	return qBound(1, steps, PATH_MAX_CURVE_STEPS);
+}
+
+// returns the length of p0 - 2 p1 + p2
+static GLfloat secondDifference(const GLfloat* p0, const GLfloat* p1, const GLfloat* p2)
+{
+	GLfloat dx = p0[0] - 2.0 * p1[0] + p2[0];
+	GLfloat dy = p0[1] - 2.0 * p1[1] + p2[1];
+
+	return sqrt(dx * dx + dy * dy);
+}
+
+int Path2D::flatten(GLfloat tolerance)
+{
+	if (_flatVersion == _version && _flatTolerance == tolerance) {
+		return _flatSubpaths.size() / 3;
+	}
+
+	_flatVersion = _version;
+	_flatTolerance = tolerance;
+	_flatPoints.resize(0);
+	_flatSubpaths.resize(0);
+
+	if (tolerance <= 0.0) {
+		qCritical() << "Path2D::flatten: invalid tolerance " << tolerance;
+		return 0;
+	}
+
+	const GLfloat* coords = _coords.constData();
+	int first = -1;
+
+	for(int index = 0; index < _segments.size(); index++) {
+		// every segment but a move carries on from the last point
+		GLfloat x0 = _flatPoints.isEmpty() ? 0.0 : _flatPoints[_flatPoints.size() - 2];
+		GLfloat y0 = _flatPoints.isEmpty() ? 0.0 : _flatPoints[_flatPoints.size() - 1];
+
+		switch(_segments[index]) {
+		case SEG_MOVETO:
+			if (first >= 0) {
+				_flatSubpaths.append(first);
+				_flatSubpaths.append(_flatPoints.size() / 2 - first);
+				_flatSubpaths.append(0);
+			}
+			first = _flatPoints.size() / 2;
+
+			_flatPoints.append(coords[0]);
+			_flatPoints.append(coords[1]);
+			coords += 2;
+			break;
+		case SEG_LINETO:
+			_flatPoints.append(coords[0]);
+			_flatPoints.append(coords[1]);
+			coords += 2;
+			break;
+		case SEG_QUADTO:
+		{
+			GLfloat p0[2] = { x0, y0 };
+			int steps = curveSteps(secondDifference(p0, coords, coords + 2), 2.0, tolerance);
+
+			for(int step = 1; step <= steps; step++) {
+				GLfloat t = (GLfloat)step / steps;
+				GLfloat s = 1.0 - t;
+
+				_flatPoints.append(s * s * x0 + 2.0 * s * t * coords[0] + t * t * coords[2]);
+				_flatPoints.append(s * s * y0 + 2.0 * s * t * coords[1] + t * t * coords[3]);
+			}
+			coords += 4;
+		}
+			break;
+		case SEG_CUBICTO:
+		{
+			GLfloat p0[2] = { x0, y0 };
+			GLfloat difference = qMax(secondDifference(p0, coords, coords + 2), secondDifference(coords, coords + 2, coords + 4));
+			int steps = curveSteps(difference, 6.0, tolerance);
+
+			for(int step = 1; step <= steps; step++) {
+				GLfloat t = (GLfloat)step / steps;
+				GLfloat s = 1.0 - t;
+
+				_flatPoints.append(s * s * s * x0 + 3.0 * s * s * t * coords[0] + 3.0 * s * t * t * coords[2] + t * t * t * coords[4]);
+				_flatPoints.append(s * s * s * y0 + 3.0 * s * s * t * coords[1] + 3.0 * s * t * t * coords[3] + t * t * t * coords[5]);
+			}
+			coords += 6;
+		}
+			break;
+		case SEG_CLOSE:
+			// the line back to the first point, which the stroker joins rather than caps
+			_flatPoints.append(_flatPoints[first * 2 + 0]);
+			_flatPoints.append(_flatPoints[first * 2 + 1]);
+
+			_flatSubpaths.append(first);
+			_flatSubpaths.append(_flatPoints.size() / 2 - first);
+			_flatSubpaths.append(1);
+			first = -1;
+			break;
+		default:
+			break;
+		}
+	}
+
+	// a subpath left open stays open, even if it ends where it started
+	if (first >= 0) {
+		_flatSubpaths.append(first);
+		_flatSubpaths.append(_flatPoints.size() / 2 - first);
+		_flatSubpaths.append(0);
+	}
+
+	return _flatSubpaths.size() / 3;
+}
+
+const GLfloat* Path2D::subpath(int index, int* count)
+{
+	*count = _flatSubpaths[index * 3 + 1];
+
+	return _flatPoints.constData() + _flatSubpaths[index * 3 + 0] * 2;
+}
+
+bool Path2D::subpathClosed(int index)
+{
+	return _flatSubpaths[index * 3 + 2] != 0;
+}
+
+QByteArray* Path2D::meshes(const QByteArray& key)
+{
+	return _meshCache.object(key);
+}
+
+bool Path2D::cacheMeshes(const QByteArray& key, QByteArray* meshes)
+{
+	return _meshCache.insert(key, meshes, meshes->size());
+}
+
+void Path2D::beginSegment(double x, double y)
+{
+	if (_segments.isEmpty()) {
+		moveTo(x, y);
+	} else if (_segments.last() == SEG_CLOSE) {
+		moveTo(_startX, _startY);
+	}
+}
+
+void Path2D::appendSegment(int segment, const GLfloat* coords, int count)
+{
+	_segments.append(segment);
+
+	for(int index = 0; index < count; index++) {
+		_coords.append(coords[index*2+0]);
+		_coords.append(coords[index*2+1]);
+	}
+
+	if (count > 0) {
+		_currentX = coords[count*2-2];
+		_currentY = coords[count*2-1];
+	}
+
+	changed();
+}
+
+void Path2D::appendArc(double cx, double cy, double radius, double startAngle, double sweep)
+{
+	int pieces = (int)ceil(fabs(sweep) / (M_PI / 2.0) - 1.0e-6);
+	if (pieces < 1) {
+		return;
+	}
+
+	// control points a third of the way along the tangents, scaled so the middle of each piece lies on the circle
+	double step = sweep / pieces;
+	double handle = 4.0 / 3.0 * tan(step / 4.0) * radius;
+
+	for(int piece = 0; piece < pieces; piece++) {
+		double from = startAngle + step * piece;
+		double to = from + step;
+
+		GLfloat coords[6] = {
+			(GLfloat)(cx + radius * cos(from) - handle * sin(from)), (GLfloat)(cy + radius * sin(from) + handle * cos(from)),
+			(GLfloat)(cx + radius * cos(to) + handle * sin(to)), (GLfloat)(cy + radius * sin(to) - handle * cos(to)),
+			(GLfloat)(cx + radius * cos(to)), (GLfloat)(cy + radius * sin(to))
+		};
+
+		appendSegment(SEG_CUBICTO, coords, 3);
+	}
+}
+
+void Path2D::changed()
+{
+	_version = ++lastPathVersion;
+	_meshCache.clear();
+}
+
+	}
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VectorMath.hpp"
+
+#include <math.h>
+#include <string.h>
+
+// VECTORMATH_SCALAR leaves the vector kernels out, so that the benchmark can time and check the plain loops on the same machine
+#if defined(__ARM_NEON__) && !defined(VECTORMATH_SCALAR)
+#define VECTORMATH_NEON
+#include <arm_neon.h>
+#elif defined(__SSE__) && !defined(VECTORMATH_SCALAR)
+#define VECTORMATH_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace views {
+	namespace graphics {
+
+void multiplyMatrix(const GLfloat* first, const GLfloat* second, GLfloat* result)
+{
+	GLfloat product[16];
+
+#if defined(VECTORMATH_NEON)
+	float32x4_t row0 = vld1q_f32(second + 0);
+	float32x4_t row1 = vld1q_f32(second + 4);
+	float32x4_t row2 = vld1q_f32(second + 8);
+	float32x4_t row3 = vld1q_f32(second + 12);
+
+	for(int i = 0; i < 4; i++) {
+		float32x4_t row = vmulq_n_f32(row0, first[i * 4 + 0]);
+		row = vmlaq_n_f32(row, row1, first[i * 4 + 1]);
+		row = vmlaq_n_f32(row, row2, first[i * 4 + 2]);
+		row = vmlaq_n_f32(row, row3, first[i * 4 + 3]);
+		vst1q_f32(product + i * 4, row);
+	}
+#elif defined(VECTORMATH_SSE)
+	__m128 row0 = _mm_loadu_ps(second + 0);
+	__m128 row1 = _mm_loadu_ps(second + 4);
+	__m128 row2 = _mm_loadu_ps(second + 8);
+	__m128 row3 = _mm_loadu_ps(second + 12);
+
+	for(int i = 0; i < 4; i++) {
+		__m128 row = _mm_mul_ps(row0, _mm_set1_ps(first[i * 4 + 0]));
+		row = _mm_add_ps(row, _mm_mul_ps(row1, _mm_set1_ps(first[i * 4 + 1])));
+		row = _mm_add_ps(row, _mm_mul_ps(row2, _mm_set1_ps(first[i * 4 + 2])));
+		row = _mm_add_ps(row, _mm_mul_ps(row3, _mm_set1_ps(first[i * 4 + 3])));
+		_mm_storeu_ps(product + i * 4, row);
+	}
+#else
+	for(int i = 0; i < 4; i++) {
+		for(int j = 0; j < 4; j++) {
+			product[i * 4 + j] = first[i * 4 + 0] * second[0 * 4 + j] + first[i * 4 + 1] * second[1 * 4 + j]
+					+ first[i * 4 + 2] * second[2 * 4 + j] + first[i * 4 + 3] * second[3 * 4 + j];
+		}
+	}
+#endif
+
+	memcpy(result, product, sizeof(product));
+}
+
+void transformPoints(const GLfloat* affine, const GLfloat* points, int count, GLfloat* result)
+{
+	int index = 0;
+
+#if defined(VECTORMATH_NEON)
+	// four points at a time, split into their x and y lanes on the way in and zipped back together on the way out
+	for(; index + 4 <= count; index += 4) {
+		float32x4x2_t coords = vld2q_f32(points + index * 2);
+		float32x4x2_t transformed;
+
+		transformed.val[0] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(affine[4]), coords.val[0], affine[0]), coords.val[1], affine[2]);
+		transformed.val[1] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(affine[5]), coords.val[0], affine[1]), coords.val[1], affine[3]);
+
+		vst2q_f32(result + index * 2, transformed);
+	}
+#elif defined(VECTORMATH_SSE)
+	// two points at a time, as x0 y0 x1 y1
+	__m128 columnX = _mm_setr_ps(affine[0], affine[1], affine[0], affine[1]);
+	__m128 columnY = _mm_setr_ps(affine[2], affine[3], affine[2], affine[3]);
+	__m128 offset = _mm_setr_ps(affine[4], affine[5], affine[4], affine[5]);
+
+	for(; index + 2 <= count; index += 2) {
+		__m128 coords = _mm_loadu_ps(points + index * 2);
+		__m128 x = _mm_shuffle_ps(coords, coords, _MM_SHUFFLE(2, 2, 0, 0));
+		__m128 y = _mm_shuffle_ps(coords, coords, _MM_SHUFFLE(3, 3, 1, 1));
+
+		_mm_storeu_ps(result + index * 2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, columnX), _mm_mul_ps(y, columnY)), offset));
+	}
+#endif
+
+	for(; index < count; index++) {
+		GLfloat x = points[index * 2 + 0];
+		GLfloat y = points[index * 2 + 1];
+
+		result[index * 2 + 0] = affine[0] * x + affine[2] * y + affine[4];
+		result[index * 2 + 1] = affine[1] * x + affine[3] * y + affine[5];
+	}
+}
+
+void segmentDirections(const GLfloat* points, int count, GLfloat* directions, GLfloat* lengths)
+{
+	int index = 0;
+
+#if defined(VECTORMATH_NEON)
+	float32x4_t zero = vdupq_n_f32(0.0);
+
+	for(; index + 4 <= count; index += 4) {
+		float32x4x2_t from = vld2q_f32(points + index * 2);
+		float32x4x2_t to = vld2q_f32(points + index * 2 + 2);
+
+		float32x4_t dx = vsubq_f32(to.val[0], from.val[0]);
+		float32x4_t dy = vsubq_f32(to.val[1], from.val[1]);
+		float32x4_t squared = vmlaq_f32(vmulq_f32(dx, dx), dy, dy);
+
+		// there is no divide or square root, so the reciprocal square root estimate is refined twice, which is good to the last bit or so
+		float32x4_t inverse = vrsqrteq_f32(squared);
+		inverse = vmulq_f32(inverse, vrsqrtsq_f32(vmulq_f32(squared, inverse), inverse));
+		inverse = vmulq_f32(inverse, vrsqrtsq_f32(vmulq_f32(squared, inverse), inverse));
+
+		// empty segments would come out as infinity times zero
+		uint32x4_t empty = vceqq_f32(squared, zero);
+		inverse = vbslq_f32(empty, zero, inverse);
+
+		float32x4x2_t direction;
+		direction.val[0] = vmulq_f32(dx, inverse);
+		direction.val[1] = vmulq_f32(dy, inverse);
+
+		vst2q_f32(directions + index * 2, direction);
+		vst1q_f32(lengths + index, vmulq_f32(squared, inverse));
+	}
+#elif defined(VECTORMATH_SSE)
+	__m128 zero = _mm_setzero_ps();
+
+	for(; index + 4 <= count; index += 4) {
+		__m128 from01 = _mm_loadu_ps(points + index * 2);
+		__m128 from23 = _mm_loadu_ps(points + index * 2 + 4);
+		__m128 to01 = _mm_loadu_ps(points + index * 2 + 2);
+		__m128 to23 = _mm_loadu_ps(points + index * 2 + 6);
+
+		__m128 dx = _mm_sub_ps(_mm_shuffle_ps(to01, to23, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(from01, from23, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128 dy = _mm_sub_ps(_mm_shuffle_ps(to01, to23, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(from01, from23, _MM_SHUFFLE(3, 1, 3, 1)));
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+
+		// empty segments would come out as zero over zero
+		__m128 filled = _mm_cmpgt_ps(length, zero);
+		dx = _mm_and_ps(_mm_div_ps(dx, length), filled);
+		dy = _mm_and_ps(_mm_div_ps(dy, length), filled);
+
+		_mm_storeu_ps(directions + index * 2, _mm_unpacklo_ps(dx, dy));
+		_mm_storeu_ps(directions + index * 2 + 4, _mm_unpackhi_ps(dx, dy));
+		_mm_storeu_ps(lengths + index, length);
+	}
+#endif
+
+	for(; index < count; index++) {
+		GLfloat dx = points[index * 2 + 2] - points[index * 2 + 0];
+		GLfloat dy = points[index * 2 + 3] - points[index * 2 + 1];
+		GLfloat length = sqrt(dx * dx + dy * dy);
+
+		if (length > 0.0) {
+			dx /= length;
+			dy /= length;
+		} else {
+			dx = 0.0;
+			dy = 0.0;
+		}
+
+		directions[index * 2 + 0] = dx;
+		directions[index * 2 + 1] = dy;
+		lengths[index] = length;
+	}
+}
+
+void extrudeSegments(const GLfloat* points, const GLfloat* directions, int count, GLfloat halfWidth, GLfloat* outlines)
+{
+	int index = 0;
+
+#if defined(VECTORMATH_NEON)
+	// the left normal of (dx, dy) is (-dy, dx)
+	float32x2_t widths = { -halfWidth, halfWidth };
+
+	for(; index < count; index++) {
+		float32x2_t normal = vmul_f32(vrev64_f32(vld1_f32(directions + index * 2)), widths);
+		float32x2_t from = vld1_f32(points + index * 2);
+		float32x2_t to = vld1_f32(points + index * 2 + 2);
+
+		vst1q_f32(outlines + index * 8 + 0, vcombine_f32(vadd_f32(from, normal), vsub_f32(from, normal)));
+		vst1q_f32(outlines + index * 8 + 4, vcombine_f32(vadd_f32(to, normal), vsub_f32(to, normal)));
+	}
+#elif defined(VECTORMATH_SSE)
+	// the left normal of (dx, dy) is (-dy, dx), added on the left and taken off on the right
+	__m128 widths = _mm_setr_ps(-halfWidth, halfWidth, halfWidth, -halfWidth);
+
+	for(; index + 1 < count; index++) {
+		__m128 direction = _mm_loadu_ps(directions + index * 2);
+		__m128 normal = _mm_mul_ps(_mm_shuffle_ps(direction, direction, _MM_SHUFFLE(0, 1, 0, 1)), widths);
+		__m128 ends = _mm_loadu_ps(points + index * 2);
+
+		_mm_storeu_ps(outlines + index * 8 + 0, _mm_add_ps(_mm_shuffle_ps(ends, ends, _MM_SHUFFLE(1, 0, 1, 0)), normal));
+		_mm_storeu_ps(outlines + index * 8 + 4, _mm_add_ps(_mm_shuffle_ps(ends, ends, _MM_SHUFFLE(3, 2, 3, 2)), normal));
+	}
+#endif
+
+	for(; index < count; index++) {
+		GLfloat nx = -directions[index * 2 + 1] * halfWidth;
+		GLfloat ny = directions[index * 2 + 0] * halfWidth;
+
+		outlines[index * 8 + 0] = points[index * 2 + 0] + nx;
+		outlines[index * 8 + 1] = points[index * 2 + 1] + ny;
+		outlines[index * 8 + 2] = points[index * 2 + 0] - nx;
+		outlines[index * 8 + 3] = points[index * 2 + 1] - ny;
+		outlines[index * 8 + 4] = points[index * 2 + 2] + nx;
+		outlines[index * 8 + 5] = points[index * 2 + 3] + ny;
+		outlines[index * 8 + 6] = points[index * 2 + 2] - nx;
+		outlines[index * 8 + 7] = points[index * 2 + 3] - ny;
+	}
+}
+
+	}
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VertexBatch.hpp"
+
+#include <string.h>
+
+#include <QDebug>
+
+namespace views {
+	namespace graphics {
+
+VertexBatch::VertexBatch()
+{
+	_vertexCount = 0;
+	_vertexCapacity = VERTEX_BATCH_INITIAL_VERTICES;
+	_indexCount = 0;
+	_indexCapacity = VERTEX_BATCH_INITIAL_VERTICES * 3 / 2;
+	_colorCapacity = 0;
+	_hasAlphas = false;
+
+	_vertexCoords = new GLfloat[_vertexCapacity * 2];
+	_textureCoords = new GLfloat[_vertexCapacity * 2];
+	_vertexAlphas = new GLfloat[_vertexCapacity];
+	_vertexColors = NULL;
+	_indices = new GLushort[_indexCapacity];
+}
+
+VertexBatch::~VertexBatch()
+{
+	delete [] _vertexCoords;
+	delete [] _textureCoords;
+	delete [] _vertexAlphas;
+	if (_vertexColors) {
+		delete [] _vertexColors;
+	}
+	delete [] _indices;
+}
+
+void VertexBatch::reset()
+{
+	_vertexCount = 0;
+	_indexCount = 0;
+	_hasAlphas = false;
+}
+
+bool VertexBatch::isEmpty()
+{
+	return _indexCount == 0;
+}
+
+int VertexBatch::vertexCount()
+{
+	return _vertexCount;
+}
+
+int VertexBatch::indexCount()
+{
+	return _indexCount;
+}
+
+bool VertexBatch::hasRoomFor(int vertexCount)
+{
+	return _vertexCount + vertexCount <= VERTEX_BATCH_MAX_VERTICES;
+}
+
+GLfloat* VertexBatch::vertexCoords()
+{
+	return _vertexCoords;
+}
+
+GLfloat* VertexBatch::textureCoords()
+{
+	return _textureCoords;
+}
+
+bool VertexBatch::hasAlphas()
+{
+	return _hasAlphas;
+}
+
+GLfloat* VertexBatch::vertexAlphas()
+{
+	return _vertexAlphas;
+}
+
+GLfloat* VertexBatch::vertexColors(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	if (_colorCapacity < _vertexCapacity) {
+		if (_vertexColors) {
+			delete [] _vertexColors;
+		}
+		_vertexColors = new GLfloat[_vertexCapacity * 4];
+		_colorCapacity = _vertexCapacity;
+	}
+
+	for(int index = 0; index < _vertexCount; index++) {
+		_vertexColors[index * 4 + 0] = red;
+		_vertexColors[index * 4 + 1] = green;
+		_vertexColors[index * 4 + 2] = blue;
+		_vertexColors[index * 4 + 3] = alpha * _vertexAlphas[index];
+	}
+
+	return _vertexColors;
+}
+
+GLushort* VertexBatch::indices()
+{
+	return _indices;
+}
+
+// grows the vertex arrays to hold at least count more vertices
+void VertexBatch::reserveVertices(int count)
+{
+	if (_vertexCount + count <= _vertexCapacity) {
+		return;
+	}
+
+	int capacity = _vertexCapacity * 2;
+	while (capacity < _vertexCount + count) {
+		capacity *= 2;
+	}
+
+	GLfloat* vertexCoords = new GLfloat[capacity * 2];
+	GLfloat* textureCoords = new GLfloat[capacity * 2];
+	GLfloat* vertexAlphas = new GLfloat[capacity];
+
+	memcpy(vertexCoords, _vertexCoords, sizeof(GLfloat) * _vertexCount * 2);
+	memcpy(textureCoords, _textureCoords, sizeof(GLfloat) * _vertexCount * 2);
+	memcpy(vertexAlphas, _vertexAlphas, sizeof(GLfloat) * _vertexCount);
+
+	delete [] _vertexCoords;
+	delete [] _textureCoords;
+	delete [] _vertexAlphas;
+
+	_vertexCoords = vertexCoords;
+	_textureCoords = textureCoords;
+	_vertexAlphas = vertexAlphas;
+	_vertexCapacity = capacity;
+}
+
+// grows the index array to hold at least count more indices
+void VertexBatch::reserveIndices(int count)
+{
+	if (_indexCount + count <= _indexCapacity) {
+		return;
+	}
+
+	int capacity = _indexCapacity * 2;
+	while (capacity < _indexCount + count) {
+		capacity *= 2;
+	}
+
+	GLushort* indices = new GLushort[capacity];
+
+	memcpy(indices, _indices, sizeof(GLushort) * _indexCount);
+
+	delete [] _indices;
+
+	_indices = indices;
+	_indexCapacity = capacity;
+}
+
+int VertexBatch::addVertex(GLfloat x, GLfloat y, GLfloat u, GLfloat v, GLfloat alpha)
+{
+	reserveVertices(1);
+
+	_vertexCoords[_vertexCount * 2 + 0] = x;
+	_vertexCoords[_vertexCount * 2 + 1] = y;
+	_textureCoords[_vertexCount * 2 + 0] = u;
+	_textureCoords[_vertexCount * 2 + 1] = v;
+	_vertexAlphas[_vertexCount] = alpha;
+
+	if (alpha < 1.0) {
+		_hasAlphas = true;
+	}
+
+	return _vertexCount++;
+}
+
+void VertexBatch::addTriangle(int index1, int index2, int index3)
+{
+	reserveIndices(3);
+
+	_indices[_indexCount++] = index1;
+	_indices[_indexCount++] = index2;
+	_indices[_indexCount++] = index3;
+}
+
+void VertexBatch::addStrips(const GLfloat* vertexCoords, const GLfloat* textureCoords, int stripCount, int stripPoints)
+{
+	if (stripCount <= 0 || stripPoints < 3) {
+		return;
+	}
+
+	int count = stripCount * stripPoints;
+
+	reserveVertices(count);
+	reserveIndices(stripCount * (stripPoints - 2) * 3);
+
+	int first = _vertexCount;
+
+	memcpy(_vertexCoords + first * 2, vertexCoords, sizeof(GLfloat) * count * 2);
+	if (textureCoords) {
+		memcpy(_textureCoords + first * 2, textureCoords, sizeof(GLfloat) * count * 2);
+	} else {
+		memset(_textureCoords + first * 2, 0, sizeof(GLfloat) * count * 2);
+	}
+	for(int index = 0; index < count; index++) {
+		_vertexAlphas[first + index] = 1.0;
+	}
+
+	_vertexCount += count;
+
+	for(int strip = 0; strip < stripCount; strip++) {
+		int base = first + strip * stripPoints;
+
+		// a strip flips every other triangle so that they all keep the winding of the first one
+		for(int index = 0; index < stripPoints - 2; index++) {
+			if ((index % 2) == 0) {
+				_indices[_indexCount++] = base + index;
+				_indices[_indexCount++] = base + index + 1;
+			} else {
+				_indices[_indexCount++] = base + index + 1;
+				_indices[_indexCount++] = base + index;
+			}
+			_indices[_indexCount++] = base + index + 2;
+		}
+	}
+}
+
+void VertexBatch::addMesh(const GLfloat* vertexCoords, const GLfloat* textureCoords, const GLfloat* alphas, int vertexCount, const GLushort* indices, int indexCount)
+{
+	if (vertexCount <= 0 || indexCount <= 0) {
+		return;
+	}
+
+	reserveVertices(vertexCount);
+	reserveIndices(indexCount);
+
+	int first = _vertexCount;
+
+	memcpy(_vertexCoords + first * 2, vertexCoords, sizeof(GLfloat) * vertexCount * 2);
+	memcpy(_textureCoords + first * 2, textureCoords, sizeof(GLfloat) * vertexCount * 2);
+	if (alphas) {
+		memcpy(_vertexAlphas + first, alphas, sizeof(GLfloat) * vertexCount);
+		_hasAlphas = true;
+	} else {
+		for(int index = 0; index < vertexCount; index++) {
+			_vertexAlphas[first + index] = 1.0;
+		}
+	}
+
+	_vertexCount += vertexCount;
+
+	for(int index = 0; index < indexCount; index++) {
+		_indices[_indexCount++] = first + indices[index];
+	}
+}
+
+	}
+}
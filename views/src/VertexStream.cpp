@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VertexStream.hpp"
+
+#include <QDebug>
+
+namespace views {
+	namespace graphics {
+
+// GLES1 has no stream usage, dynamic is the nearest hint
+#ifdef GLES1
+#define VERTEX_STREAM_USAGE GL_DYNAMIC_DRAW
+#elif defined(GLES2)
+#define VERTEX_STREAM_USAGE GL_STREAM_DRAW
+#else
+#error libviews should be compiled with either GLES1 or GLES2 -D flags.
+#endif
+
+VertexStream::VertexStream()
+{
+	_vertexBuffer = 0;
+	_indexBuffer = 0;
+
+	_vertexCapacity = VERTEX_STREAM_INITIAL_VERTEX_BYTES;
+	_vertexUsed = 0;
+	_indexCapacity = VERTEX_STREAM_INITIAL_INDEX_BYTES;
+	_indexUsed = 0;
+	_orphanCount = 0;
+}
+
+// the buffers go with the GL context they were made in
+VertexStream::~VertexStream()
+{
+}
+
+void VertexStream::create()
+{
+	glGenBuffers(1, &_vertexBuffer);
+	glGenBuffers(1, &_indexBuffer);
+
+	bind();
+
+	glBufferData(GL_ARRAY_BUFFER, _vertexCapacity, NULL, VERTEX_STREAM_USAGE);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indexCapacity, NULL, VERTEX_STREAM_USAGE);
+
+	_vertexUsed = 0;
+	_indexUsed = 0;
+
+	if (_vertexBuffer == 0 || _indexBuffer == 0) {
+		qCritical() << "VertexStream::create: glGenBuffers failed";
+	}
+}
+
+void VertexStream::bind()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+}
+
+void VertexStream::reserve(int vertexBytes, int indexBytes)
+{
+	// as written, on float boundaries
+	vertexBytes = (vertexBytes + 3) & ~3;
+	indexBytes = (indexBytes + 3) & ~3;
+
+	if (_vertexUsed + vertexBytes > _vertexCapacity) {
+		orphan(GL_ARRAY_BUFFER, &_vertexCapacity, &_vertexUsed, vertexBytes);
+	}
+
+	if (_indexUsed + indexBytes > _indexCapacity) {
+		orphan(GL_ELEMENT_ARRAY_BUFFER, &_indexCapacity, &_indexUsed, indexBytes);
+	}
+}
+
+const GLvoid* VertexStream::writeVertices(const GLvoid* data, int bytes)
+{
+	return write(GL_ARRAY_BUFFER, &_vertexCapacity, &_vertexUsed, data, bytes);
+}
+
+const GLvoid* VertexStream::writeIndices(const GLvoid* data, int bytes)
+{
+	return write(GL_ELEMENT_ARRAY_BUFFER, &_indexCapacity, &_indexUsed, data, bytes);
+}
+
+int VertexStream::orphanCount()
+{
+	return _orphanCount;
+}
+
+// hands the full storage back to the driver, which keeps it for the draws still reading it, and starts again at the front of fresh storage
+void VertexStream::orphan(GLenum target, int* capacity, int* used, int bytes)
+{
+	while (*capacity < bytes) {
+		*capacity *= 2;
+	}
+
+	glBufferData(target, *capacity, NULL, VERTEX_STREAM_USAGE);
+
+	*used = 0;
+	_orphanCount++;
+}
+
+const GLvoid* VertexStream::write(GLenum target, int* capacity, int* used, const GLvoid* data, int bytes)
+{
+	// keep every array on a float boundary
+	int aligned = (bytes + 3) & ~3;
+
+	if (*used + aligned > *capacity) {
+		orphan(target, capacity, used, aligned);
+	}
+
+	GLintptr offset = *used;
+
+	glBufferSubData(target, offset, bytes, data);
+	*used += aligned;
+
+	return (const GLvoid*)offset;
+}
+
+	}
+}
@@ -300,6 +300,11 @@ void View::setVisible(bool visible)
 {
 	_viewMutex.lock();
 
+	// the window may not have kept its contents while hidden
+	if (visible && !_visible && _renderGraphics) {
+		_renderGraphics->invalidate();
+	}
+
 	_visible = visible;
 
 	_viewMutex.unlock();
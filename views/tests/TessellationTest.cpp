@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2011-2012 Research In Motion Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Records shapes through the public Graphics2D calls, tessellates them the way done() does, and checks the meshes that come out.
+//
+// Tessellation runs on the CPU alone, so no window or GL context is needed.
+
+#include "Graphics2D.hpp"
+#include "CommandBuffer.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace views::graphics;
+
+// limits
+#define CHECK_TOLERANCE		0.25
+#define CHECK_SLACK			1.0e-3		// relative, for the float coordinates the meshes are kept in
+#define MAX_CHECK_VERTICES	65536
+
+// a Graphics2D whose recorded commands can be tessellated on demand
+class TessellationTest : public Graphics2D {
+
+public:
+	TessellationTest() : Graphics2D(0) {}
+
+	// tessellates everything recorded since the last call, as done() would
+	void tessellate(CommandBuffer* tessellated)
+	{
+		tessellateCommands(_recordCommands, tessellated);
+		_recordCommands->reset();
+	}
+};
+
+// gathers the vertices of every mesh in a tessellated list, returning how many there are
+static int meshVertices(CommandBuffer* tessellated, GLfloat* vertices, int capacity)
+{
+	CommandCursor cursor;
+	RenderCommandHeader* command;
+	int count = 0;
+
+	tessellated->begin(&cursor);
+	while((command = tessellated->next(&cursor)) != NULL) {
+		if (command->command != RENDER_DRAW_MESH) {
+			continue;
+		}
+
+		GLfloat* floats = commandFloats(command);
+		int vertexCount = commandInts(command)[0];
+
+		for(int index = 0; index < vertexCount && count < capacity; index++, count++) {
+			vertices[count * 2 + 0] = floats[index * 2 + 0];
+			vertices[count * 2 + 1] = floats[index * 2 + 1];
+		}
+	}
+
+	return count;
+}
+
+static int compareAngles(const void* first, const void* second)
+{
+	double difference = *(const double*)first - *(const double*)second;
+
+	return difference < 0.0 ? -1 : (difference > 0.0 ? 1 : 0);
+}
+
+// fills a whole circle of the given radius, drawn scale times larger, and checks that no chord strays further than the tolerance from it on screen
+static bool checkArcChords(TessellationTest* graphics, double radius, double scale)
+{
+	CommandBuffer tessellated;
+	GLfloat* vertices = new GLfloat[MAX_CHECK_VERTICES * 2];
+	double* angles = new double[MAX_CHECK_VERTICES];
+	double centerX = 500.0, centerY = 400.0;
+	bool passed = true;
+
+	graphics->setTolerance(CHECK_TOLERANCE);
+
+	// each tessellation starts again from no transform
+	graphics->scale(scale, scale);
+	graphics->fillArc(centerX, centerY, radius, radius, 0.0, 360.0);
+
+	graphics->tessellate(&tessellated);
+
+	int vertexCount = meshVertices(&tessellated, vertices, MAX_CHECK_VERTICES);
+	int rimCount = 0;
+
+	// the arc is traced at width away from its corner, and everything else is the center its triangles fan from
+	for(int index = 0; index < vertexCount; index++) {
+		double dx = vertices[index * 2 + 0] - centerX;
+		double dy = vertices[index * 2 + 1] - centerY;
+		double distance = sqrt(dx * dx + dy * dy);
+
+		if (distance < radius / 2.0) {
+			continue;
+		}
+
+		if (fabs(distance - radius) > CHECK_SLACK * radius) {
+			printf("arc of radius %g: vertex %g,%g is %g from the center\n", radius, dx, dy, distance);
+			passed = false;
+		}
+
+		angles[rimCount++] = atan2(dy, dx);
+	}
+
+	qsort(angles, rimCount, sizeof(double), compareAngles);
+
+	// the chord between neighbouring rim vertices sags furthest from the circle at its middle
+	double worst = 0.0;
+
+	for(int index = 0; index < rimCount; index++) {
+		double sweep = index + 1 < rimCount ? angles[index + 1] - angles[index] : angles[0] + 2.0 * M_PI - angles[index];
+		double error = radius * (1.0 - cos(sweep / 2.0)) * scale;
+
+		if (error > worst) {
+			worst = error;
+		}
+	}
+
+	if (rimCount < 3 || worst > CHECK_TOLERANCE * (1.0 + CHECK_SLACK)) {
+		printf("arc of radius %g at scale %g: %d rim vertices, chords stray %g from the circle against a tolerance of %g\n", radius, scale, rimCount, worst, CHECK_TOLERANCE);
+		passed = false;
+	}
+
+	delete [] vertices;
+	delete [] angles;
+
+	return passed;
+}
+
+// draws and fills a round rect whose corners need several times as many quads as the tessellation scratch arrays hold, and checks that every vertex stays on it
+static bool checkLargeRoundRect(TessellationTest* graphics, bool fill)
+{
+	CommandBuffer tessellated;
+	GLfloat* vertices = new GLfloat[MAX_CHECK_VERTICES * 2];
+	double x = 100.0, y = 50.0, width = 4000.0, height = 3000.0, arc = 1000.0;
+	double margin = 10.0;
+	bool passed = true;
+
+	graphics->setTolerance(0.05);
+
+	if (fill) {
+		graphics->fillRoundRect(x, y, width, height, arc, arc);
+	} else {
+		graphics->drawRoundRect(x, y, width, height, arc, arc);
+	}
+
+	graphics->tessellate(&tessellated);
+
+	int vertexCount = meshVertices(&tessellated, vertices, MAX_CHECK_VERTICES);
+
+	// four corners cut finely enough for the tolerance come to over a hundred segments each
+	if (vertexCount < MAX_VERTEX_COORDINATES / 2) {
+		printf("%s round rect: only %d vertices\n", fill ? "filled" : "drawn", vertexCount);
+		passed = false;
+	}
+
+	for(int index = 0; index < vertexCount; index++) {
+		GLfloat vertexX = vertices[index * 2 + 0];
+		GLfloat vertexY = vertices[index * 2 + 1];
+
+		if (!(vertexX >= x - margin && vertexX <= x + width + margin && vertexY >= y - margin && vertexY <= y + height + margin)) {
+			printf("%s round rect: vertex %g,%g is off the shape\n", fill ? "filled" : "drawn", vertexX, vertexY);
+			passed = false;
+			break;
+		}
+	}
+
+	delete [] vertices;
+
+	return passed;
+}
+
+// captures a stroked circle into a display list under a wide stroke, and checks that it is replayed as meshes as wide as that stroke
+static bool checkBakedDisplayList(TessellationTest* graphics)
+{
+	DisplayList displayList;
+	CommandBuffer tessellated;
+	CommandCursor cursor;
+	RenderCommandHeader* command;
+	GLfloat* vertices = new GLfloat[MAX_CHECK_VERTICES * 2];
+	Stroke* wide = graphics->createStroke(20.0);
+	Stroke* thin = graphics->createStroke(1.0);
+	double radius = 100.0;
+	bool passed = true;
+
+	graphics->setTolerance(CHECK_TOLERANCE);
+	graphics->setStroke(wide);
+
+	graphics->beginDisplayList(&displayList);
+	graphics->drawArc(-radius, -radius, radius * 2.0, radius * 2.0, 0.0, 360.0);
+	graphics->endDisplayList();
+
+	displayList.bakedCommands()->begin(&cursor);
+	while((command = displayList.bakedCommands()->next(&cursor)) != NULL) {
+		if (command->command == RENDER_DRAW_ARC) {
+			printf("display list: arc left in the baked commands\n");
+			passed = false;
+		}
+	}
+
+	// the stroke in effect when the list is replayed does not change what was baked
+	graphics->setStroke(thin);
+	graphics->drawDisplayList(&displayList);
+	graphics->tessellate(&tessellated);
+
+	int vertexCount = meshVertices(&tessellated, vertices, MAX_CHECK_VERTICES);
+	double outer = 0.0;
+
+	for(int index = 0; index < vertexCount; index++) {
+		outer = qMax(outer, (double)hypot(vertices[index * 2 + 0], vertices[index * 2 + 1]));
+	}
+
+	if (vertexCount == 0 || outer < radius + 10.0 - CHECK_TOLERANCE) {
+		printf("display list: %d vertices reaching %g, expected the outside of a 20 wide stroke at %g\n", vertexCount, outer, radius + 10.0);
+		passed = false;
+	}
+
+	delete wide;
+	delete thin;
+	delete [] vertices;
+
+	return passed;
+}
+
+// strokes a square path that ends where it started, left open or closed, with square caps and bevel joins - only the open
+// one is capped at the start and end, which puts a vertex on the outside corner the bevel cuts off
+static bool checkPathClosing(TessellationTest* graphics, bool close)
+{
+	Path2D path;
+	CommandBuffer tessellated;
+	GLfloat* vertices = new GLfloat[MAX_CHECK_VERTICES * 2];
+	Stroke* stroke = graphics->createStroke(10.0, CAP_SQUARE, JOIN_BEVEL);
+	bool cornered = false;
+
+	path.moveTo(0.0, 0.0);
+	path.lineTo(100.0, 0.0);
+	path.lineTo(100.0, 100.0);
+	path.lineTo(0.0, 100.0);
+	path.lineTo(0.0, 0.0);
+	if (close) {
+		path.close();
+	}
+
+	graphics->setTolerance(CHECK_TOLERANCE);
+	graphics->setStroke(stroke);
+	graphics->drawPath(&path);
+	graphics->tessellate(&tessellated);
+
+	int vertexCount = meshVertices(&tessellated, vertices, MAX_CHECK_VERTICES);
+
+	for(int index = 0; index < vertexCount; index++) {
+		if (fabs(vertices[index * 2 + 0] + 5.0) < CHECK_SLACK && fabs(vertices[index * 2 + 1] + 5.0) < CHECK_SLACK) {
+			cornered = true;
+		}
+	}
+
+	bool passed = vertexCount > 0 && cornered != close;
+	if (!passed) {
+		printf("%s path: %d vertices, %s at the capped corner\n", close ? "closed" : "open", vertexCount, cornered ? "one" : "none");
+	}
+
+	delete stroke;
+	delete [] vertices;
+
+	return passed;
+}
+
+int main(int argc, char** argv)
+{
+	(void)argc;
+	(void)argv;
+
+	TessellationTest graphics;
+	bool passed = true;
+
+	passed = checkArcChords(&graphics, 8.0, 1.0) && passed;
+	passed = checkArcChords(&graphics, 100.0, 1.0) && passed;
+	passed = checkArcChords(&graphics, 400.0, 1.0) && passed;
+	passed = checkArcChords(&graphics, 50.0, 4.0) && passed;
+	passed = checkLargeRoundRect(&graphics, true) && passed;
+	passed = checkLargeRoundRect(&graphics, false) && passed;
+	passed = checkBakedDisplayList(&graphics) && passed;
+	passed = checkPathClosing(&graphics, false) && passed;
+	passed = checkPathClosing(&graphics, true) && passed;
+
+	printf("tessellation: %s\n", passed ? "passed" : "FAILED");
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,31 @@
+# Checks of the tessellation, linked against the library the way an application is.
+#
+#   qmake tests.pro                   GLES2
+#   qmake tests.pro GLAPI=gles1       GLES1
+#   qmake tests.pro GLAPI=gles3       GLES3
+#
+# The run exits with a failure if any check fails.
+
+TEMPLATE = app
+TARGET = views-tests
+
+isEmpty(GLAPI) {
+	GLAPI = gles2
+}
+
+CONFIG += console qt warn_on cascades10 views
+LIBS += -lscreen -lbb
+
+contains(GLAPI, gles1) {
+	DEFINES += GLES1
+} else:contains(GLAPI, gles3) {
+	DEFINES += GLES3 GLES2
+} else {
+	DEFINES += GLES2
+}
+
+INCLUDEPATH += $$quote($$PWD/../include/views/graphics)
+
+SOURCES += $$quote($$PWD/TessellationTest.cpp)
+
+include(../views.pri)